@@ -0,0 +1,65 @@
+#include "bench.h"
+#include <stdio.h>
+#include <time.h>
+
+static int metrics = 0;
+volatile double benchSink;
+
+unsigned long long Bench_NowNs(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long long)t.tv_sec * 1000000000ULL + (unsigned long long)t.tv_nsec;
+}
+
+double Bench_NsPerCall(BenchCall fn, void *arg)
+{
+    unsigned long long calls = 1;
+    double best = 0.0;
+
+    // Grow the batch until one run takes long enough to time
+    for(;;){
+        unsigned long long start = Bench_NowNs();
+        for(unsigned long long i=0; i<calls; i++){
+            fn(arg);
+        }
+        if(Bench_NowNs() - start >= BENCH_RUN_NS / 4){
+            break;
+        }
+        calls *= 2;
+    }
+    calls *= 4;
+
+    for(int run=0; run<BENCH_REPEATS; run++){
+        unsigned long long start = Bench_NowNs();
+        for(unsigned long long i=0; i<calls; i++){
+            fn(arg);
+        }
+        double ns = (double)(Bench_NowNs() - start) / (double)calls;
+        if(run == 0 || ns < best){
+            best = ns;
+        }
+    }
+    return best;
+}
+
+void Bench_Begin(void)
+{
+    metrics = 0;
+    printf("{");
+}
+
+void Bench_Metric(const char *name, double value)
+{
+    printf("%s\n  \"%s\": %.6g", metrics++ ? "," : "", name, value);
+}
+
+void Bench_End(void)
+{
+    printf("\n}\n");
+}
+
+void Bench_Consume(double value)
+{
+    benchSink = value;
+}
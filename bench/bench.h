@@ -0,0 +1,34 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * @file bench.h
+ * @brief Host microbenchmarks (see bench/Makefile):
+ *        - Each bench_*.c program prints one flat JSON object of metrics on stdout,
+ *          bench/run.py merges them and compares the result with bench/baseline.json
+ *        - Every metric is lower-is-better. *_ns metrics are wall-clock nanoseconds per call,
+ *          the fastest of BENCH_REPEATS runs. Simulated metrics (cycles, bus accesses, errors)
+ *          come from the host stand-ins in tools/ and are the same on every run. Only those gate,
+ *          the *_ns ones are reported for information (run.py)
+ */
+
+#define BENCH_REPEATS   15
+#define BENCH_RUN_NS    5000000ULL   // Each run repeats the call for at least this long
+
+typedef void (*BenchCall)(void *arg);
+
+/// Nanoseconds per call of fn, fastest of BENCH_REPEATS runs
+double Bench_NsPerCall(BenchCall fn, void *arg);
+
+/// Monotonic wall clock, for timing part of a call that Bench_NsPerCall cannot isolate
+unsigned long long Bench_NowNs(void);
+
+/// Starts the JSON object, one metric per Bench_Metric, Bench_End closes it
+void Bench_Begin(void);
+void Bench_Metric(const char *name, double value);
+void Bench_End(void);
+
+/// Keeps a result alive so the compiler cannot drop the call that made it
+void Bench_Consume(double value);
+
+#endif // BENCH_H
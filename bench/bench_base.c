@@ -0,0 +1,60 @@
+/*
+Programmer mode conversions (Base_Format in base.c): 64-bit words per call in
+each base, with snprintf's conversion of the same words alongside for scale.
+*/
+
+#include "bench.h"
+#include "base.h"
+#include <inttypes.h>
+#include <stdio.h>
+
+#define WORD_COUNT 256   // Power of two, cycled through
+
+typedef struct {
+    int      base;
+    unsigned next;
+} FormatCase;
+
+static unsigned long long words[WORD_COUNT];
+
+static void formatCall(void *arg)
+{
+    FormatCase *c = (FormatCase *)arg;
+    char text[BASE_TEXT_MAX];
+    Bench_Consume(Base_Format(words[c->next++ & (WORD_COUNT - 1)], c->base, 64, text));
+}
+
+static void printfCall(void *arg)
+{
+    FormatCase *c = (FormatCase *)arg;
+    char text[BASE_TEXT_MAX];
+    Bench_Consume(snprintf(text, sizeof(text), "%" PRId64, (int64_t)words[c->next++ & (WORD_COUNT - 1)]));
+}
+
+static double nsPerCall(BenchCall call, int base)
+{
+    FormatCase c = {base, 0};
+    return Bench_NsPerCall(call, &c);
+}
+
+int main(void)
+{
+    unsigned long long x = 88172645463325252ULL;
+
+    // Every magnitude, so DEC sees short and long numbers
+    for(int i=0; i<WORD_COUNT; i++){
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        words[i] = x >> (i % 64);
+    }
+
+    Bench_Begin();
+    Bench_Metric("base_format_bin_ns", nsPerCall(formatCall, 2));
+    Bench_Metric("base_format_oct_ns", nsPerCall(formatCall, 8));
+    Bench_Metric("base_format_dec_ns", nsPerCall(formatCall, 10));
+    Bench_Metric("base_format_hex_ns", nsPerCall(formatCall, 16));
+    Bench_Metric("printf_format_dec_ns", nsPerCall(printfCall, 10));
+    Bench_End();
+    return 0;
+}
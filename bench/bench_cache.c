@@ -0,0 +1,125 @@
+/*
+Result cache on a replayed keystroke workload (sessions.txt).
+
+Every line is typed key by key and evaluated, as from the keypad, once with the
+cache and once emptying it before each evaluation. The results must match
+exactly. cache_session_miss_pct is the share of evaluations the cache could
+not answer in one replay from an empty cache. The two *_ns metrics are the
+time spent in Calc_Evaluate per line with and without it.
+*/
+
+#include "bench.h"
+#include "calc.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_LINES 512
+#define REPLAYS   100   // Per timed batch
+
+static char   lines[MAX_LINES][128];
+static int    lineCount = 0;
+static int    evaluations = 0;
+static double values[2][MAX_LINES];   // [cache on][line]
+static int    errors[2][MAX_LINES];
+static unsigned long long evaluateNs; // Spent in Calc_Evaluate by replay()
+
+static void loadSessions(const char *path)
+{
+    char  text[sizeof(lines[0])];
+    FILE *f = fopen(path, "r");
+
+    if(f == NULL){
+        perror(path);
+        return;
+    }
+    while(fgets(text, sizeof(text), f) != NULL && lineCount < MAX_LINES){
+        text[strcspn(text, "\r\n")] = '\0';
+        if(text[0] == '#'){
+            continue;
+        }
+        snprintf(lines[lineCount++], sizeof(lines[0]), "%s", text);  // Blank: new session
+        evaluations += (text[0] != '\0');
+    }
+    fclose(f);
+}
+
+/**
+ * @brief Replays every session from an empty cache, keeping each result. arg: cache on (int)
+ */
+static void replay(void *arg)
+{
+    int useCache = *(const int *)arg;
+
+    Calc_CacheClear();
+    for(int i=0; i<lineCount; i++){
+        if(lines[i][0] == '\0'){
+            continue;
+        }
+        Calc_ClearExpression();
+        for(const char *k = lines[i]; *k; k++){
+            Calc_AddChar(*k);
+        }
+        if(!useCache){
+            Calc_CacheClear();
+        }
+        unsigned long long start = Bench_NowNs();
+        values[useCache][i] = Calc_Evaluate();
+        evaluateNs += Bench_NowNs() - start;
+        errors[useCache][i] = Calc_HadError();
+    }
+}
+
+/**
+ * @brief Nanoseconds per evaluation over the workload, the fastest of BENCH_REPEATS batches of replays
+ */
+static double replayNs(int useCache)
+{
+    double best = 0.0;
+
+    for(int run=0; run<BENCH_REPEATS; run++){
+        evaluateNs = 0;
+        for(int i=0; i<REPLAYS; i++){
+            replay(&useCache);
+        }
+        double ns = (double)evaluateNs / (double)(REPLAYS * evaluations);
+        if(run == 0 || ns < best){
+            best = ns;
+        }
+    }
+    return best;
+}
+
+int main(void)
+{
+    int on = 1;
+
+    loadSessions("sessions.txt");
+    if(evaluations == 0){
+        return 1;
+    }
+    Calc_Init();
+
+    replay(&on);
+    const CalcCacheStats *stats = Calc_GetCacheStats();
+    double missPct = 100.0 * (double)(stats->lookups - stats->hits) / (double)stats->lookups;
+
+    Bench_Begin();
+    Bench_Metric("cache_session_miss_pct", missPct);
+    Bench_Metric("cache_session_eval_ns", replayNs(1));
+    Bench_Metric("cache_session_eval_uncached_ns", replayNs(0));
+    Bench_End();
+
+    int mismatches = 0;
+    for(int i=0; i<lineCount; i++){
+        if(errors[0][i] != errors[1][i] ||
+           (!errors[0][i] && memcmp(&values[0][i], &values[1][i], sizeof(double)) != 0)){
+            fprintf(stderr, "bench_cache: \"%s\" gives a different result from the cache\n", lines[i]);
+            mismatches++;
+        }
+        else if(errors[1][i]){
+            fprintf(stderr, "bench_cache: \"%s\" does not evaluate\n", lines[i]);
+            mismatches++;
+        }
+    }
+    return mismatches != 0;
+}
@@ -0,0 +1,106 @@
+/*
+Calculator core on the host: typing, evaluation, functions and formatting.
+Wall-clock nanoseconds, so compare only against a baseline from the same machine.
+*/
+
+#include "bench.h"
+#include "calc.h"
+#include "func.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char typedKeys[] = "12.5*3+4-7/2^2";   // Keys as they come from the keypad
+static const char trigKeys[]  = "s30+c60*t45";
+static const char intKeys[]   = "123456*789+42-7";
+static const char powKeys[]   = "3^39-2^61+7";       // Exact in 64-bit, near the top of its range
+static const char spillKeys[] = "3^39*3+2^62";       // Overflows at the multiply, falls back to double
+static const char chainKeys[] = "+0.1";              // Continues from Ans, which changes every call
+
+static void typeKeys(const char *keys)
+{
+    Calc_ClearExpression();
+    for(const char *k=keys; *k; k++){
+        Calc_AddChar(*k);
+    }
+}
+
+static void typeCall(void *arg)
+{
+    typeKeys((const char *)arg);
+}
+
+static void evaluateMiss(void *arg)
+{
+    (void)arg;
+    Calc_CacheClear();
+    Bench_Consume(Calc_Evaluate());
+}
+
+static void evaluateHit(void *arg)
+{
+    (void)arg;
+    Bench_Consume(Calc_Evaluate());
+}
+
+static void sinCall(void *arg)
+{
+    static double x = 0.0;
+    (void)arg;
+    x += 7.25;
+    if(x > 720.0){
+        x -= 1440.0;
+    }
+    Bench_Consume(Func_Apply(FUNC_SIN, x));
+}
+
+static void formatCall(void *arg)
+{
+    char text[64];
+    Calc_FormatResult(*(const double *)arg, text);
+    Bench_Consume(text[0]);
+}
+
+static void formatLastCall(void *arg)
+{
+    char text[64];
+    (void)arg;
+    Calc_FormatLastResult(text);
+    Bench_Consume(text[0]);
+}
+
+static double evaluateNs(const char *keys, BenchCall call)
+{
+    typeKeys(keys);
+    Calc_Evaluate();
+    if(Calc_HadError()){
+        fprintf(stderr, "bench_calc: \"%s\" does not evaluate\n", keys);
+        return -1.0;
+    }
+    return Bench_NsPerCall(call, NULL);
+}
+
+int main(void)
+{
+    double fraction = 3.14159265358979;
+    double integer = 97402346.0;
+
+    Calc_Init();
+
+    Bench_Begin();
+    Bench_Metric("calc_addchar_ns", Bench_NsPerCall(typeCall, (void *)typedKeys) / (double)strlen(typedKeys));
+    Bench_Metric("calc_evaluate_ns", evaluateNs(typedKeys, evaluateMiss));
+    Bench_Metric("calc_evaluate_cached_ns", evaluateNs(typedKeys, evaluateHit));
+    Bench_Metric("calc_evaluate_int_ns", evaluateNs(intKeys, evaluateMiss));
+    Bench_Metric("calc_evaluate_pow_int_ns", evaluateNs(powKeys, evaluateMiss));
+    Bench_Metric("calc_format_last_int_ns", Bench_NsPerCall(formatLastCall, NULL));  // 19 exact digits
+    Bench_Metric("calc_evaluate_int_overflow_ns", evaluateNs(spillKeys, evaluateMiss));
+    Bench_Metric("calc_evaluate_trig_ns", evaluateNs(trigKeys, evaluateMiss));
+    typeKeys("0.5");
+    Calc_Evaluate();
+    Bench_Metric("calc_evaluate_ans_chain_ns", evaluateNs(chainKeys, evaluateHit));  // Misses, Ans moves on
+    Bench_Metric("func_sin_ns", Bench_NsPerCall(sinCall, NULL));
+    Bench_Metric("calc_format_ns", Bench_NsPerCall(formatCall, &fraction));
+    Bench_Metric("calc_format_int_ns", Bench_NsPerCall(formatCall, &integer));
+    Bench_End();
+    return 0;
+}
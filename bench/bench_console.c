@@ -0,0 +1,106 @@
+/*
+UART console throughput: lines evaluated and answered per second, as ns per line.
+
+console.c runs on the UART/uDMA model (tools/uart_host.c). console_line_ns feeds
+the model directly, so it is the firmware side alone: DMA blocks, ring, streamed
+evaluation and the reply. console_pty_line_ns goes through a pseudo-terminal in
+raw mode, with lines written and replies read on its terminal end as a PC
+would, 64 lines in flight. Lines per second = 1e9 / the metric.
+*/
+
+#define _GNU_SOURCE
+#include "bench.h"
+#include "host.h"
+#include "console.h"
+#include "calc.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define PTY_LINES 64
+
+static const char line[] = "12.5*3+4-7/2^2\n";
+static const char reply[] = "39.75\r\n";
+
+static int  terminal = -1;   // The PC's end of the pseudo-terminal
+static int  failed = 0;
+
+static void direct(void *arg)
+{
+    char text[64];
+    (void)arg;
+
+    UartHost_Receive(line, (int)sizeof(line) - 1);
+    UartHost_Idle();
+    Console_Poll();
+    UartHost_Transmit((int)sizeof(text));
+    UartHost_TakeSent(text, (int)sizeof(text));
+    if(strcmp(text, reply) != 0){
+        failed = 1;
+    }
+}
+
+static void overPty(void *arg)
+{
+    static char batch[PTY_LINES * sizeof(line)];
+    char   text[512];
+    int    lines = 0;
+    size_t written = 0;
+    (void)arg;
+
+    if(batch[0] == '\0'){
+        for(int i=0; i<PTY_LINES; i++){
+            strcat(batch, line);
+        }
+    }
+    while(lines < PTY_LINES){
+        if(written < strlen(batch)){
+            ssize_t n = write(terminal, batch + written, strlen(batch) - written);
+            if(n > 0){
+                written += (size_t)n;
+            }
+        }
+        UartHost_Pump();
+        Console_Poll();
+        UartHost_Pump();
+        ssize_t n = read(terminal, text, sizeof(text));
+        for(ssize_t i=0; i<n; i++){
+            lines += (text[i] == '\n');
+            failed |= (text[i] == 'E');   // "Error"
+        }
+    }
+}
+
+static void openTerminal(void)
+{
+    struct termios raw;
+
+    terminal = open(UartHost_OpenPty(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(terminal < 0){
+        perror("bench_console: pty");
+        exit(2);
+    }
+    tcgetattr(terminal, &raw);
+    cfmakeraw(&raw);
+    tcsetattr(terminal, TCSANOW, &raw);
+}
+
+int main(void)
+{
+    Calc_Init();
+    Console_Init();
+
+    Bench_Begin();
+    Bench_Metric("console_line_ns", Bench_NsPerCall(direct, NULL));
+    openTerminal();
+    Bench_Metric("console_pty_line_ns", Bench_NsPerCall(overPty, NULL) / PTY_LINES);
+    Bench_End();
+
+    if(failed){
+        fprintf(stderr, "bench_console: wrong reply\n");
+    }
+    return failed;
+}
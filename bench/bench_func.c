@@ -0,0 +1,58 @@
+/*
+Function kernels (func.c) against the host's libm, per call over a spread of arguments.
+The registry uses libm unless built with FUNC_KERNELS, since the kernels lose
+here. Where they win on the target (PERF_FUNCTION cycles), that build uses them;
+their accuracy is checked in tests/test_func.c either way.
+*/
+
+#include "bench.h"
+#include "func.h"
+#include <math.h>
+
+#define ARG_COUNT 256   // Power of two, cycled through so no argument repeats back to back
+
+typedef struct {
+    double (*fn)(double);
+    double   args[ARG_COUNT];
+    unsigned next;
+} FuncCase;
+
+static void call(void *arg)
+{
+    FuncCase *c = (FuncCase *)arg;
+    Bench_Consume(c->fn(c->args[c->next++ & (ARG_COUNT - 1)]));
+}
+
+/// Arguments from lo to hi, spaced evenly on a log scale when logScale is set
+static void spread(FuncCase *c, double lo, double hi, int logScale)
+{
+    for(int i=0; i<ARG_COUNT; i++){
+        double t = lo + (hi - lo) * (i * 157 % ARG_COUNT) / ARG_COUNT;   // Shuffled order
+        c->args[i] = logScale ? exp(t) : t;
+    }
+    c->next = 0;
+}
+
+static double nsPerCall(double (*fn)(double), double lo, double hi, int logScale)
+{
+    static FuncCase c;
+
+    c.fn = fn;
+    spread(&c, lo, hi, logScale);
+    return Bench_NsPerCall(call, &c);
+}
+
+int main(void)
+{
+    Bench_Begin();
+    Bench_Metric("func_sqrt_ns",  nsPerCall(Func_Sqrt,  -30.0, 30.0, 1));
+    Bench_Metric("libm_sqrt_ns",  nsPerCall(sqrt,       -30.0, 30.0, 1));
+    Bench_Metric("func_exp_ns",   nsPerCall(Func_Exp,   -30.0, 30.0, 0));
+    Bench_Metric("libm_exp_ns",   nsPerCall(exp,        -30.0, 30.0, 0));
+    Bench_Metric("func_ln_ns",    nsPerCall(Func_Ln,    -30.0, 30.0, 1));
+    Bench_Metric("libm_ln_ns",    nsPerCall(log,        -30.0, 30.0, 1));
+    Bench_Metric("func_log_ns",   nsPerCall(Func_Log10, -30.0, 30.0, 1));
+    Bench_Metric("libm_log_ns",   nsPerCall(log10,      -30.0, 30.0, 1));
+    Bench_End();
+    return 0;
+}
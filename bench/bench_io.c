@@ -0,0 +1,96 @@
+/*
+LCD and keypad drivers against the simulated pins and clock (tools/gpio_host.c, clock_host.c).
+Every metric is simulated time or bus accesses, so it is the same on every run.
+*/
+
+#include "bench.h"
+#include "host.h"
+#include "lcd.h"
+#include "keypad.h"
+#include "clock.h"
+#include "gpio.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char rowText[] = "-1234.5678e-9 ok";
+
+static int failed = 0;
+
+/**
+ * @brief The nibble write lcd.c used before address masking, for comparison:
+ *        GPIO_PORTB_DATA_R &= ~LCD_DATA_MASK; GPIO_PORTB_DATA_R |= nibble;
+ */
+static void rmwNibble(unsigned char nibble)
+{
+    GpioHost_Write(GPIO_PORTB_BASE, 0xFF, GpioHost_Read(GPIO_PORTB_BASE, 0xFF) & ~LCD_DATA_MASK);
+    GpioHost_Write(GPIO_PORTB_BASE, 0xFF, GpioHost_Read(GPIO_PORTB_BASE, 0xFF) | nibble);
+}
+
+static void expectRow(int row, const char *text)
+{
+    if(strncmp(GpioHost_LcdRow(row), text, strlen(text)) != 0){
+        fprintf(stderr, "bench_io: LCD row %d shows \"%.16s\", expected \"%s\"\n", row, GpioHost_LcdRow(row), text);
+        failed = 1;
+    }
+}
+
+int main(void)
+{
+    unsigned long long start;
+    char shown[LCD_ROW_CELLS + 1];
+
+    Bench_Begin();
+
+    // Power-on sequence at boot speed
+    Clock_SetSpeed(CLOCK_SLOW);
+    start = Host_TimeNs();
+    LCD_Init();
+    Bench_Metric("lcd_init_us", (double)(Host_TimeNs() - start) / 1000.0);
+
+    // Full row at the evaluation speed
+    Clock_SetSpeed(CLOCK_FAST);
+    unsigned long bytes = GpioHost_LcdBytes();
+    unsigned long accesses = GpioHost_GetStats()->writes + GpioHost_GetStats()->reads;
+    start = Host_TimeNs();
+    LCD_WriteRow(1, rowText);
+    Bench_Metric("lcd_write_row_us", (double)(Host_TimeNs() - start) / 1000.0);
+    bytes = GpioHost_LcdBytes() - bytes;
+    accesses = GpioHost_GetStats()->writes + GpioHost_GetStats()->reads - accesses;
+    Bench_Metric("lcd_bus_accesses_per_byte", (double)accesses / (double)bytes);
+    expectRow(1, rowText);
+
+    // Putting a nibble on DB4-DB7: one masked store against the old read-modify-write
+    unsigned long long cycles = Host_Cycles();
+    GPIO_WritePins(GPIO_PORTB_BASE, LCD_DATA_MASK, 0x5);
+    Bench_Metric("gpio_nibble_masked_cycles", (double)(Host_Cycles() - cycles));
+    cycles = Host_Cycles();
+    rmwNibble(0xA);
+    Bench_Metric("gpio_nibble_rmw_cycles", (double)(Host_Cycles() - cycles));
+
+    // One character changed: the patch only rewrites that cell
+    strcpy(shown, rowText);
+    start = Host_TimeNs();
+    LCD_PatchRow(1, shown, "-1234.5678e-9 OK");
+    Bench_Metric("lcd_patch_one_us", (double)(Host_TimeNs() - start) / 1000.0);
+    expectRow(1, "-1234.5678e-9 OK");
+
+    // Idle scan (no key held) at the idle speed
+    Clock_SetSpeed(CLOCK_SLOW);
+    cycles = Host_Cycles();
+    accesses = GpioHost_GetStats()->writes + GpioHost_GetStats()->reads;
+    Keypad_Scan();
+    Bench_Metric("keypad_scan_idle_cycles", (double)(Host_Cycles() - cycles));
+    Bench_Metric("keypad_scan_idle_accesses",
+                 (double)(GpioHost_GetStats()->writes + GpioHost_GetStats()->reads - accesses));
+
+    // A held key is debounced and queued once released
+    GpioHost_HoldKey(1, 2, 30000);   // '6', held 30 ms
+    Keypad_Scan();
+    if(Keypad_Pop(NULL) != '6'){
+        fprintf(stderr, "bench_io: held key was not decoded as '6'\n");
+        failed = 1;
+    }
+
+    Bench_End();
+    return failed;
+}
@@ -0,0 +1,115 @@
+/*
+Key-to-display latency of the firmware main loop under bursty input, in simulated time.
+
+src/main.c runs unchanged (its main renamed) on the host stand-ins. Bursts of
+1 to KEY_QUEUE_SIZE - 1 keys are queued at once, as a scripted feed or a fast
+typist would, and the latency is the time from queueing to the end of the
+loop pass that has drawn them all, as PERF_KEY_LATENCY measures it on the
+target (the live preview, when due, is drawn in that same pass). The LCD is
+checked to show the burst.
+
+Only delays and pin accesses take simulated time, the evaluation itself is
+free, so this measures what the coalesced LCD update costs per burst.
+*/
+
+#include "bench.h"
+#include "host.h"
+#include "keypad.h"
+#include "gpio.h"
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+int Firmware_Main(void);
+
+#define BOOT_NS      60000000ULL   // LCD power-on sequence finished by then
+#define SETTLE_NS   100000000ULL   // Idle gap between bursts, the preview is drawn in it
+
+static const int bursts[] = {1, 2, 4, 8, KEY_QUEUE_SIZE - 1};
+#define BURST_COUNT (sizeof(bursts) / sizeof(bursts[0]))
+
+static const char digits[] = "123456789012345";
+
+typedef enum {
+    STEP_WAIT,      // Idle until waitUntil
+    STEP_DRAIN      // Burst queued, waiting for the pass that drew it
+} Step;
+
+static jmp_buf            done;
+static Step               step = STEP_WAIT;
+static unsigned long long waitUntil = BOOT_NS;
+static unsigned long long queuedAt;
+static unsigned           burst = 0;
+static int                clearing = 0;     // The queued key is 'C' between bursts
+static double             latencyUs[BURST_COUNT];
+static int                failed = 0;
+
+static void queueBurst(void)
+{
+    for(int i=0; i<bursts[burst]; i++){
+        Keypad_Push(digits[i]);
+    }
+    queuedAt = Host_TimeNs();
+    step = STEP_DRAIN;
+}
+
+/**
+ * @brief Runs at the start of every main loop pass (the scan's first column read)
+ */
+static void onPass(unsigned long base, unsigned long mask)
+{
+    if(base != GPIO_PORTE_BASE || mask != KEYPAD_ROW_MASK ||
+       (GpioHost_Pins(GPIO_PORTD_BASE) & KEYPAD_COL_MASK) != 0x0E){
+        return;
+    }
+    unsigned long long now = Host_TimeNs();
+
+    if(step == STEP_WAIT){
+        if(now >= waitUntil){
+            queueBurst();
+        }
+        return;
+    }
+    if(Keypad_HasKey()){
+        return;  // Still draining (cannot happen, the loop drains all)
+    }
+
+    if(clearing){
+        clearing = 0;
+        step = STEP_WAIT;
+        waitUntil = now + SETTLE_NS;
+        return;
+    }
+
+    latencyUs[burst] = (double)(now - queuedAt) / 1000.0;
+    if(strncmp(GpioHost_LcdRow(1), digits, (size_t)bursts[burst]) != 0){
+        fprintf(stderr, "bench_latency: burst of %d shows \"%.16s\"\n", bursts[burst], GpioHost_LcdRow(1));
+        failed = 1;
+    }
+    if(++burst == BURST_COUNT){
+        longjmp(done, 1);
+    }
+    Keypad_Push('C');
+    clearing = 1;
+}
+
+int main(void)
+{
+    char name[40];
+
+    GpioHost_SetReadHook(onPass);
+    if(!setjmp(done)){
+        Firmware_Main();
+    }
+    GpioHost_SetReadHook(NULL);
+
+    Bench_Begin();
+    for(unsigned i=0; i<BURST_COUNT; i++){
+        snprintf(name, sizeof(name), "key_latency_burst%d_us", bursts[i]);
+        Bench_Metric(name, latencyUs[i]);
+    }
+    Bench_Metric("key_latency_per_extra_key_us",
+                 (latencyUs[BURST_COUNT - 1] - latencyUs[0]) / (bursts[BURST_COUNT - 1] - bursts[0]));
+    Bench_End();
+    return failed;
+}
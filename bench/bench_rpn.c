@@ -0,0 +1,136 @@
+/*
+Per-keystroke latency of RPN mode against infix (COMP) mode, for the same
+calculation typed into the firmware main loop on the host stand-ins.
+
+src/main.c runs unchanged (its main renamed), as in bench_latency.c. Keys
+come one at a time, a typist's gap apart, and each one is timed from
+Keypad_Push to the start of the loop pass after the one that handled and
+drew it. Two clocks:
+- wall-clock ns, where the evaluation counts: infix tokenises and
+  evaluates at '=', RPN computes at every operator key
+- simulated us, where only delays and pin accesses count, i.e. what the
+  LCD update costs
+
+12.5*3+4-7/2^2 (39.75 with this calculator's precedence) in each mode,
+with the 'C' that clears it afterwards.
+*/
+
+#include "bench.h"
+#include "host.h"
+#include "keypad.h"
+#include "gpio.h"
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+int Firmware_Main(void);
+
+#define BOOT_NS      60000000ULL   // LCD power-on sequence finished by then
+#define KEY_GAP_NS   50000000ULL   // Between key presses, any preview is drawn in it
+#define ROUNDS       20
+
+typedef struct {
+    const char *name;
+    const char *select;    // MODE and the digit that enters it
+    const char *keys;
+} Session;
+
+static const Session sessions[] = {
+    {"infix", "O1", "12.5*3+4-7/2^2=C"},
+    {"rpn",   "O7", "12.5=3*4+7=2=2^/-C"}
+};
+#define SESSION_COUNT (sizeof(sessions) / sizeof(sessions[0]))
+
+static jmp_buf            done;
+static unsigned           session = 0;
+static const char        *next;             // Next key of the session, NULL while selecting the mode
+static int                roundsDone = 0;
+static int                selecting = 0;    // Keys of the mode selection still to send
+static unsigned long long waitUntil = BOOT_NS;
+static int                pending = 0;      // A timed key was pushed and has not been drawn yet
+static unsigned long long pushedWallNs, pushedSimNs;
+static double             wallNs[SESSION_COUNT], simUs[SESSION_COUNT];
+static long               keyCount[SESSION_COUNT];
+static int                failed = 0;
+
+/**
+ * @brief Runs at the start of every main loop pass (the scan's first column read)
+ */
+static void onPass(unsigned long base, unsigned long mask)
+{
+    if(base != GPIO_PORTE_BASE || mask != KEYPAD_ROW_MASK ||
+       (GpioHost_Pins(GPIO_PORTD_BASE) & KEYPAD_COL_MASK) != 0x0E){
+        return;
+    }
+    unsigned long long now = Host_TimeNs();
+
+    if(pending){
+        if(Keypad_HasKey()){
+            return;
+        }
+        wallNs[session] += (double)(Bench_NowNs() - pushedWallNs);
+        simUs[session] += (double)(now - pushedSimNs) / 1000.0;
+        keyCount[session]++;
+        pending = 0;
+        waitUntil = now + KEY_GAP_NS;
+
+        // Before its 'C', the round must show the result
+        if(next[0] == 'C' && strstr(GpioHost_LcdRow(0), "39.75") == NULL &&
+           strstr(GpioHost_LcdRow(1), "39.75") == NULL){
+            fprintf(stderr, "bench_rpn: %s shows \"%.16s\" \"%.16s\"\n", sessions[session].name,
+                    GpioHost_LcdRow(0), GpioHost_LcdRow(1));
+            failed = 1;
+        }
+        return;
+    }
+    if(now < waitUntil){
+        return;
+    }
+
+    if(next == NULL){
+        Keypad_Push(sessions[session].select[selecting++]);
+        waitUntil = now + KEY_GAP_NS;
+        if(sessions[session].select[selecting] == '\0'){
+            selecting = 0;
+            next = sessions[session].keys;
+        }
+        return;
+    }
+    if(*next == '\0'){
+        next = sessions[session].keys;
+        if(++roundsDone == ROUNDS){
+            roundsDone = 0;
+            next = NULL;
+            if(++session == SESSION_COUNT){
+                longjmp(done, 1);
+            }
+            return;
+        }
+    }
+
+    pushedSimNs = now;
+    pushedWallNs = Bench_NowNs();
+    Keypad_Push(*next++);
+    pending = 1;
+}
+
+int main(void)
+{
+    char name[40];
+
+    GpioHost_SetReadHook(onPass);
+    if(!setjmp(done)){
+        Firmware_Main();
+    }
+    GpioHost_SetReadHook(NULL);
+
+    Bench_Begin();
+    for(unsigned i=0; i<SESSION_COUNT; i++){
+        snprintf(name, sizeof(name), "%s_key_ns", sessions[i].name);
+        Bench_Metric(name, wallNs[i] / keyCount[i]);
+        snprintf(name, sizeof(name), "%s_key_latency_us", sessions[i].name);
+        Bench_Metric(name, simUs[i] / keyCount[i]);
+    }
+    Bench_End();
+    return failed;
+}
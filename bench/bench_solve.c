@@ -0,0 +1,132 @@
+/*
+Solver mode (solve.c, safeguarded Newton on dual numbers) against a plain
+secant method on the same compiled f(X): time per solve, from typing f(X) to
+the root, and how many evaluations of f each needs.
+
+A Newton iteration is one dual-number run (f and f' together, about twice
+the work of a plain run), a secant iteration one plain run, so the count
+alone does not decide it. The secant here has no safeguard, the cases all
+converge for it from these starts.
+*/
+
+#include "bench.h"
+#include "calc.h"
+#include "host.h"
+#include "lcd.h"
+#include "solve.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_ITER 100
+
+typedef struct {
+    const char *keys;      // f(X)
+    const char *ends;      // a=b=
+    double      a, b;
+} SolveCase;
+
+static const SolveCase cases[] = {
+    {"X^2-2",     "1=2=",  1.0, 2.0},
+    {"X^3-2*X-5", "2=3=",  2.0, 3.0},
+    {"eX-10",     "0=5=",  0.0, 5.0},
+    {"cX-0.5",    "0=89=", 0.0, 89.0}
+};
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+static int    evaluations;
+static double root;
+
+static void typeKeys(const char *keys, int toSolver)
+{
+    for(const char *k=keys; *k; k++){
+        if(!toSolver || !Solve_HandleKey(*k)){
+            Calc_AddChar(*k);
+        }
+    }
+}
+
+static void newtonCall(void *arg)
+{
+    const SolveCase *c = arg;
+
+    Solve_Enter();
+    typeKeys(c->keys, 1);
+    Solve_HandleKey('=');
+    typeKeys(c->ends, 1);
+    while(Solve_IsBusy()){
+        Solve_Step();
+    }
+    root = Calc_RecallVariable(CALC_VAR_X);
+    Bench_Consume(root);
+}
+
+/**
+ * @brief Evaluations the last Newton solve made, from the iteration count it shows (not timed)
+ */
+static int newtonEvaluations(void)
+{
+    int iterations = 0;
+
+    Solve_Draw();
+    sscanf(strchr(GpioHost_LcdRow(0), '(') + 1, "%d", &iterations);
+    return iterations + 2;   // Both ends first
+}
+
+static void secantCall(void *arg)
+{
+    const SolveCase *c = arg;
+    static CalcProgram program;
+    double x0 = c->a, x1 = c->b, f0, f1;
+
+    Calc_ClearExpression();
+    typeKeys(c->keys, 0);
+    Calc_Compile(&program);
+    Calc_ClearExpression();
+    Calc_EvaluateBatch(&program, &x0, &f0, 1);
+    Calc_EvaluateBatch(&program, &x1, &f1, 1);
+    evaluations = 2;
+    while(evaluations < MAX_ITER + 2 && f1 != 0.0 && f1 != f0){
+        double x2 = x1 - f1 * (x1 - x0) / (f1 - f0);
+        x0 = x1;
+        f0 = f1;
+        x1 = x2;
+        Calc_EvaluateBatch(&program, &x1, &f1, 1);
+        evaluations++;
+        if(fabs(x1 - x0) <= 4.0 * DBL_EPSILON * fabs(x1)){
+            break;
+        }
+    }
+    root = x1;
+    Bench_Consume(root);
+}
+
+int main(void)
+{
+    double newtonNs = 0.0, secantNs = 0.0;
+    int    newtonEvals = 0, secantEvals = 0, failed = 0;
+
+    Calc_Init();
+    LCD_Init();
+    for(unsigned i=0; i<CASE_COUNT; i++){
+        newtonNs += Bench_NsPerCall(newtonCall, (void *)&cases[i]);
+        newtonEvals += newtonEvaluations();
+        double newtonRoot = root;
+
+        secantNs += Bench_NsPerCall(secantCall, (void *)&cases[i]);
+        secantEvals += evaluations;
+        if(fabs(root - newtonRoot) > 8.0 * DBL_EPSILON * fabs(root)){
+            fprintf(stderr, "bench_solve: %s: Newton %.17g, secant %.17g\n", cases[i].keys, newtonRoot, root);
+            failed = 1;
+        }
+    }
+
+    Bench_Begin();
+    Bench_Metric("solve_newton_ns", newtonNs / CASE_COUNT);
+    Bench_Metric("solve_secant_ns", secantNs / CASE_COUNT);
+    Bench_Metric("solve_newton_evaluations", (double)newtonEvals / CASE_COUNT);
+    Bench_Metric("solve_secant_evaluations", (double)secantEvals / CASE_COUNT);
+    Bench_End();
+    return failed;
+}
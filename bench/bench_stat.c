@@ -0,0 +1,39 @@
+/*
+Statistics accumulators (stat.c): cost of one entry and of reading the results back.
+*/
+
+#include "bench.h"
+#include "stat.h"
+#include <stddef.h>
+
+static StatAccumulator acc;
+
+static void pushCall(void *arg)
+{
+    static double x = 1e9;
+    (void)arg;
+    x += 0.37;
+    StatAcc_Push(&acc, x, 2.5 * x - 7.0);
+}
+
+static void resultsCall(void *arg)
+{
+    double value, sum = 0.0;
+    (void)arg;
+    for(int which = STAT_N; which < STAT_RESULT_COUNT; which++){
+        if(StatAcc_Result(&acc, (StatResult)which, &value)){
+            sum += value;
+        }
+    }
+    Bench_Consume(sum);
+}
+
+int main(void)
+{
+    StatAcc_Clear(&acc);
+    Bench_Begin();
+    Bench_Metric("stat_push_ns", Bench_NsPerCall(pushCall, NULL));
+    Bench_Metric("stat_all_results_ns", Bench_NsPerCall(resultsCall, NULL));
+    Bench_End();
+    return 0;
+}
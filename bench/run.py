@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Runs the host benchmarks and fails on a regression (see bench/bench.h).
+
+    python3 bench/run.py [--threshold PCT] [--runs N] [--baseline FILE] [--output FILE] [--update]
+                         [--wall-clock] PROGRAM...
+
+Each PROGRAM prints one JSON object of lower-is-better metrics. Every program
+runs --runs times and each metric keeps its lowest value, which filters out
+runs slowed by other load on the machine. The objects are merged into --output
+and compared with the baseline. A simulated metric more than PCT percent above
+its baseline value is a regression and the exit status is 1, as it is when a
+baseline metric is no longer produced (rename it with --update). New metrics
+are listed but do not fail. --update writes the merged results as the new
+baseline instead of comparing.
+
+Only the simulated metrics (cycles, bus accesses, simulated time, counts) gate:
+they come from the host stand-ins and are the same on every machine. Wall-clock
+*_ns metrics depend on the machine the baseline was recorded on, so they are
+listed as "info" and never fail, unless --wall-clock is given on the machine
+that recorded the baseline.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+WALL_CLOCK_SUFFIX = "_ns"
+
+
+def run(programs, runs):
+    results = {}
+    for program in programs:
+        best = {}
+        for _ in range(runs):
+            out = subprocess.run([program], check=True, stdout=subprocess.PIPE, text=True).stdout
+            for name, value in json.loads(out).items():
+                best[name] = min(value, best.get(name, value))
+        for name, value in best.items():
+            if name in results:
+                sys.exit("%s: metric %s is reported twice" % (program, name))
+            results[name] = value
+    return results
+
+
+def compare(results, baseline, threshold, wall_clock):
+    failed = False
+    for name in sorted(set(results) | set(baseline)):
+        if name not in results:
+            print("MISSING  %-34s baseline %g" % (name, baseline[name]))
+            failed = True
+            continue
+        value = results[name]
+        if name not in baseline:
+            print("NEW      %-34s %g" % (name, value))
+            continue
+        base = baseline[name]
+        change = (value - base) / base * 100.0 if base else (0.0 if value == base else float("inf"))
+        worse = value > base * (1.0 + threshold / 100.0) if base > 0 else value > base
+        gated = wall_clock or not name.endswith(WALL_CLOCK_SUFFIX)
+        status = ("REGRESS" if worse else "ok") if gated else "info"
+        print("%-8s %-34s %12g -> %-12g %+7.1f%%" % (status, name, base, value, change))
+        failed = failed or (worse and gated)
+    return failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--threshold", type=float, default=float(os.environ.get("THRESHOLD", 25)),
+                        help="allowed increase in percent (default 25, or $THRESHOLD)")
+    parser.add_argument("--runs", type=int, default=5, help="runs per program, lowest value kept (default 5)")
+    parser.add_argument("--baseline", default=os.path.join(HERE, "baseline.json"))
+    parser.add_argument("--output", default=os.path.join(HERE, "results.json"))
+    parser.add_argument("--update", action="store_true", help="write the results as the new baseline")
+    parser.add_argument("--wall-clock", action="store_true",
+                        help="gate the *_ns metrics too (only with a baseline recorded on this machine)")
+    parser.add_argument("programs", nargs="+")
+    args = parser.parse_args()
+
+    results = run(args.programs, args.runs)
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+    if args.update:
+        with open(args.baseline, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline written to %s (%d metrics)" % (args.baseline, len(results)))
+        return 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    if compare(results, baseline, args.threshold, args.wall_clock):
+        print("FAIL: regression beyond %g%% (see above)" % args.threshold)
+        return 1
+    gated = [name for name in results if args.wall_clock or not name.endswith(WALL_CLOCK_SUFFIX)]
+    print("PASS: %d gated metrics within %g%% of the baseline (%d wall-clock for information)"
+          % (len(gated), args.threshold, len(results) - len(gated)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,37 @@
+#ifndef BASE_H
+#define BASE_H
+
+#include <stdbool.h>
+
+/**
+ * @file base.h
+ * @brief Programmer (BASE-N) mode on 8/16/32/64-bit words:
+ *        - The keypad switches to its BASE layout (keypad.h): hex digits on ALT,
+ *          AND/OR/XOR/NOT, shifts, base and word size on SHIFT
+ *        - Operators run as they are typed, left to right (no precedence), '=' finishes.
+ *          Everything is unsigned 64-bit integer arithmetic masked to the word, no floating point
+ *        - Values are two's complement: DEC shows the signed value, HEX/OCT/BIN show every
+ *          digit of the word. / is signed and truncates, >> is arithmetic, / by 0 is an error
+ *        - A wider word size sign-extends, a narrower one truncates
+ *        - Left/right scroll numbers longer than the LCD (BIN above 16 bits, OCT 64)
+ */
+
+#define BASE_TEXT_MAX 65   // Longest formatted word (64 binary digits) plus '\0'
+
+/// Enters the mode: DEC, 32-bit, value 0
+void Base_Enter(void);
+
+/// Applies a key, every key is consumed
+void Base_HandleKey(char key);
+
+/// Formats the low bits of value in base 2, 8, 10 or 16 with table lookups. out needs BASE_TEXT_MAX chars.
+/// Returns the length
+int  Base_Format(unsigned long long value, int base, int bits, char *out);
+
+/// Marks the rows as overwritten by something else, so the next Base_Draw rewrites them
+void Base_ForgetDisplay(void);
+
+/// Row 0: base, word size, pending operator and the digits in view. Row 1: the value
+void Base_Draw(void);
+
+#endif // BASE_H
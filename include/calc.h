@@ -1,36 +1,307 @@
 #ifndef CALC_H
 #define CALC_H
 
+#include <stdbool.h>
+
 /**
  * @file calc.h
  * @brief Pure C Calculator logic module:
- *        - Expression buffer
+ *        - Expression buffer, a gap buffer edited at a cursor that moves by whole units
  *        - Trig in degrees typed like sin30 (no parentheses for angles)
  *        - Exponent '^', plus + - * /
  *        - If first token is an operator, we use the last result
+ *        - Variables A-F and X, memory register M and Ans, usable anywhere a number is
+ *        - Evaluation streams: each token is folded into a bounded operator/value stack as soon as
+ *          it is lexed, so any length evaluates in the same RAM (CalcStream). The console feeds one
+ *          per line; the keypad context feeds its own with each unit typed at the end of the text,
+ *          and Calc_Evaluate only finishes it. The integer, fixed-point and double evaluations run
+ *          side by side in it
+ *        - The text is re-read only after an edit before the end, a DEL, or a change to a variable
+ *          the stream has already read (once to hash it for the result cache, once more on a miss).
+ *          Past MAX_EXPR_LEN the text keeps only its tail for the LCD; the expression is then
+ *          append-only (no DEL or cursor moves) and is never re-read
+ *        - The same fold can compile to postfix (CalcProgram) instead, to run for a batch of X values
+ *          or with dual numbers for f(X) and f'(X) together
+ *        - Integer-only expressions (literals with + - * ^) are evaluated exactly in 64-bit,
+ *          falling back to double on overflow
+ *        - With CALC_FIXED defined, other expressions run in Q32.32 fixed point (fixed.h) and only
+ *          fall back to double when a value leaves its range
  *        - Strips trailing zeros up to 3 decimal places
  *        - No bracket logic, bracket => error
  */
 
+#define M_PI 3.14159265358979323846
+#define MAX_EXPR_LEN 255  // Keypad text kept for the LCD and editing (CalcHistory offsets are 8-bit), not an entry limit
+#define MAX_TOKENS   32   // Instructions in a compiled CalcProgram. A deliberate cap: Prog/Table/Solve keep
+                          // programs whole in RAM and flash, and a batch runs each instruction over CALC_BATCH values
+#define CALC_MAX_DEPTH   8   // Values held at once: one per precedence level pending, plus the operand
+#define CALC_MAX_NESTING 16  // Operators and functions waiting at once (nested functions add one each)
+#define CALC_NUMBER_MAX  32  // Longest literal plus '\0'
+#define CALC_BATCH   8    // X values evaluated per pass of Calc_EvaluateBatch
+
+/// Variable / register slots. Tokens refer to these by index, never by name
+typedef enum {
+    CALC_VAR_A,
+    CALC_VAR_B,
+    CALC_VAR_C,
+    CALC_VAR_D,
+    CALC_VAR_E,
+    CALC_VAR_F,
+    CALC_VAR_X,
+    CALC_VAR_M,    // Memory register (M+, M-, MR, MC)
+    CALC_VAR_ANS,  // Read-only, always the last result
+    CALC_VAR_COUNT
+} CalcVariable;
+
+#define CALC_PARTIAL_VALUES CALC_MAX_DEPTH
+#define CALC_PARTIAL_OPS    CALC_MAX_NESTING
+#define CALC_NO_NUMBER      0xFF  // CalcPartial.numberStart when no number is being typed
+
+/// Running evaluation of the typed prefix, for the live preview. Operands and operators are folded
+/// in as they are typed and reduced as soon as precedence allows, so a key costs O(1) amortised
+/// instead of a re-parse of the whole buffer.
+typedef struct {
+    double        values[CALC_PARTIAL_VALUES];
+    unsigned char ops[CALC_PARTIAL_OPS];     // CalcOpcode waiting for its right operand
+    unsigned char opSlot[CALC_PARTIAL_OPS];  // FuncId for CALC_OP_FUNC
+    unsigned char valueTop;
+    unsigned char opTop;
+    unsigned char scanned;       // Characters of expressionBuffer folded so far
+    unsigned char numberStart;   // Start of the number still being typed, or CALC_NO_NUMBER
+    unsigned char tokenCount;
+    bool          expectOperand;
+    bool          failed;        // The prefix can no longer be a valid expression
+} CalcPartial;
+
+/// Stack tops before one folded unit (digit, operator, function name or variable)
+typedef struct {
+    unsigned char scanned;       // Buffer length before the unit
+    unsigned char numberStart;
+    unsigned char valueTop;
+    unsigned char opTop;
+    unsigned char tokenCount;
+    unsigned char undoTop;       // Reductions logged before the unit
+    bool          expectOperand;
+    bool          failed;
+} CalcCheckpoint;
+
+/// Operands and operator consumed by one reduction, put back by Calc_Delete
+typedef struct {
+    double        left;          // Unused for CALC_OP_FUNC
+    double        right;
+    unsigned char op;
+    unsigned char slot;
+    unsigned char opIndex;
+    unsigned char valueIndex;    // Index of right
+} CalcUndo;
+
+/// Undo history of the partial evaluation, one checkpoint per unit
+typedef struct {
+    CalcCheckpoint checkpoints[MAX_EXPR_LEN];
+    CalcUndo       undo[MAX_EXPR_LEN / 2];  // A reduction needs an operator or function and an operand
+    unsigned char  checkpointCount;
+    unsigned char  undoTop;
+} CalcHistory;
+
+typedef struct CalcContext CalcContext;
+
+/// Result cache counters; the hit rate is hits / lookups
+typedef struct {
+    unsigned long lookups;
+    unsigned long hits;
+} CalcCacheStats;
+
+/// Opcodes of a compiled (postfix) expression
+typedef enum {
+    CALC_OP_CONST,   // Push value
+    CALC_OP_VAR,     // Push variable slot (X comes from the batch input)
+    CALC_OP_ADD,
+    CALC_OP_SUB,
+    CALC_OP_MUL,
+    CALC_OP_DIV,
+    CALC_OP_POW,
+    CALC_OP_FUNC     // Scientific function, slot = FuncId (see func.h)
+} CalcOpcode;
+
+typedef struct {
+    unsigned char opcode;    // CalcOpcode
+    unsigned char slot;      // CalcVariable for CALC_OP_VAR, FuncId for CALC_OP_FUNC
+    double        value;     // Constant for CALC_OP_CONST
+    long long     intValue;  // Exact constant, used when the whole expression is integer-only
+#ifdef CALC_FIXED
+    long long     fixValue;  // Q32.32 constant for the fixed-point backend (see fixed.h)
+#endif
+} CalcInstr;
+
+/// An expression tokenised and compiled once, ready to evaluate for many values of X
+typedef struct {
+    CalcInstr code[MAX_TOKENS];
+    int       length;
+} CalcProgram;
+
+/// An expression read one character at a time. Each token is folded as soon as it is lexed, so the
+/// size depends on how deeply operators and functions nest, never on how long the expression is.
+/// The integer, fixed-point and double evaluations run side by side until the end picks one.
+typedef struct {
+    CalcContext  *context;                 // Supplies Ans and takes the result
+    CalcProgram  *program;                 // Compiling: instructions go here instead of being run
+    unsigned char mode;                    // What the fold does (see calc.c)
+    unsigned char backends;                // Evaluations still running, bit per backend (see calc.c)
+    char          number[CALC_NUMBER_MAX]; // Literal being lexed
+    char          name[5];                 // Letters of a function name, "Ans" or a variable
+    unsigned char numberLength;
+    unsigned char nameLength;
+    unsigned char ops[CALC_MAX_NESTING];   // CalcOpcode waiting for its right operand
+    unsigned char opSlot[CALC_MAX_NESTING];
+    unsigned char opTop;
+    unsigned char valueTop;
+    double        values[CALC_MAX_DEPTH];
+    long long     intValues[CALC_MAX_DEPTH];
+#ifdef CALC_FIXED
+    long long     fixValues[CALC_MAX_DEPTH];
+    unsigned long fixErrors[CALC_MAX_DEPTH];  // Bound on each value's error in steps (fixed.h)
+    unsigned char fixStatus;               // FixStatus of the first step that left Q32.32
+    bool          fixedLiterals;           // Every literal so far fits Q32.32
+#endif
+    bool          integerOnly;             // Only integer literals and + - * ^ so far
+    bool          continueAns;             // A leading operator continues from Ans
+    bool          expectOperand;
+    bool          failed;                  // Can no longer be a valid expression
+    bool          readsVariables;          // A variable or Ans was folded in ...
+    unsigned long variableVersion;         // ... with the values of this version (see calc.c)
+    unsigned long tokenCount;
+    unsigned long long hash;               // Of the tokens with their values, for the result cache
+} CalcStream;
+
+/// Expression buffer, error flag and last result. The keypad uses a built-in one through Calc_*,
+/// other inputs (e.g. the UART console) keep their own and use CalcCtx_*. Variables are shared.
+struct CalcContext {
+    char      expressionBuffer[MAX_EXPR_LEN];  // Gap buffer: text before the gap, '\0's, text after it
+    int       exprIndex;       // Length of the text
+    int       gapStart;        // Where the gap is, the text after it ends at MAX_EXPR_LEN - 1
+    int       cursor;          // Where the next unit is inserted, always on a unit boundary
+    bool      errorFlag;
+    double    lastResult;
+    bool      hasLastResult;
+    long long lastInteger;     // Exact copy of lastResult when it came from the 64-bit integer path
+    bool      lastIsInteger;
+    CalcPartial partial;       // Live preview state of expressionBuffer
+    CalcHistory *history;      // Checkpoints for Calc_Delete, NULL to delete by re-folding
+    CalcStream  stream;        // Fed each unit typed at the end of the text, finished by Calc_Evaluate
+    bool        streamLive;    // stream has read exactly the text, else Calc_Evaluate re-reads it
+    bool        truncated;     // The text only keeps the tail of a longer expression (see Calc_AddChar)
+};
+
 /// Initialises the calculator state (clears expression buffer, error flags)
 void   Calc_Init(void);
 
-/// Adds one character. If 's','c','t' => expands to "sin","cos","tan". If '?' => ignore. If buffer is near full => return -1
+/// Inserts one character at the cursor. A function key (see func.h) expands to its name, e.g. 's' => "sin". If '?' => ignore.
+/// At the end of a full buffer the oldest text is dropped (see CalcContext.truncated); elsewhere a full buffer => return -1
 int    Calc_AddChar(char inputChar);
 
+/// Inserts a variable name ("A".."F", "X", "M", "Ans") at the cursor. Returns -1 if buffer is near full
+int    Calc_AddVariable(CalcVariable var);
+
+/// Stores a value into a variable slot (Ans is read-only and ignored)
+void   Calc_StoreVariable(CalcVariable var, double value);
+
+/// Returns the value held in a variable slot
+double Calc_RecallVariable(CalcVariable var);
+
+/// M+ / M- : adds delta to the memory register
+void   Calc_MemoryAdd(double delta);
+
+/// MC : clears the memory register
+void   Calc_MemoryClear(void);
+
+/// Compiles the current expression into prog (no Ans continuation). Returns -1 on error,
+/// including more than MAX_TOKENS instructions or a truncated expression
+int    Calc_Compile(CalcProgram *prog);
+
+/// Compiles the current expression onto the end of prog. If prog already holds instructions the
+/// expression must start with an operator, and continues from the value they leave (a chained step,
+/// as a key sequence continues from Ans after '='). Returns -1 on error, leaving prog as it was
+int    Calc_CompileStep(CalcProgram *prog);
+
+/// Evaluates prog for n values of X. Points that fail (e.g. divide by zero) give NAN in out[]
+void   Calc_EvaluateBatch(const CalcProgram *prog, const double *x, double *out, int n);
+
+/// Evaluates prog at X = x together with its derivative d/dX (dual numbers). value is NAN where the program fails
+void   Calc_EvaluateDual(const CalcProgram *prog, double x, double *value, double *slope);
+
+/// a^b as every evaluator (and RPN) does it: integral exponents up to 64 by squaring, others through libm
+double Calc_Power(double a, double b);
+
+/// Formats a result for the LCD: up to 3 decimals, trailing zeros stripped. out needs 32 chars
+void   Calc_FormatResult(double value, char *out);
+
+/// Formats the last successful Calc_Evaluate result, exact to all digits if it came from the integer path
+void   Calc_FormatLastResult(char *out);
+
 /// Clears the current expression
 void   Calc_ClearExpression(void);
 
-/// Evaluates with multi-pass approach. If first token is operator & we have last result => prepend that. Returns final value or 0 if error
+/// Deletes the unit before the cursor (a digit, operator, variable or a whole function name such as "sin")
+/// by rolling back to its checkpoint. Returns the number of characters removed, 0 for a truncated expression
+int    Calc_Delete(void);
+
+/// Moves the cursor one unit left (direction < 0) or right. Returns 1 if it moved.
+/// Needs the checkpoints, so a context without history (or a truncated expression) keeps its cursor at the end
+int    Calc_MoveCursor(int direction);
+
+/// Cursor position in characters from the start of the expression
+int    Calc_GetCursor(void);
+
+/// Copies up to count characters of the expression from position first into out (count + 1 chars)
+/// without moving the gap. Returns the number copied
+int    Calc_CopyExpression(char *out, int first, int count);
+
+/// Evaluates the expression. If it starts with an operator & we have a last result => continues from Ans (exact, not reformatted). Returns final value or 0 if error.
+/// Finishes a copy of the context's stream, so typing can carry on. Re-reads the text only when the
+/// stream is stale (see the file comment), once to hash it and once more on a cache miss
 double Calc_Evaluate(void);
 
+/// Evaluates the expression as a value typed at a mode's prompt (a table limit, a tolerance ...).
+/// Same as Calc_Evaluate, but Ans keeps the result of the last calculation
+double Calc_EvaluateInput(void);
+
 /// Returns 1 if error, 0 if no error
 int    Calc_HadError(void);
 
-/// Returns pointer to the expression buffer (for LCD)
+/// Value the expression typed so far would give, from the running partial evaluation (a copy of the
+/// stream once the expression is truncated). Returns 1 and sets value if it is complete and finite, 0 otherwise
+int    Calc_Preview(double *value);
+
+/// Returns the expression as one string. Closes the gap, so while editing prefer Calc_CopyExpression
 const char* Calc_GetExpression(void);
 
-#define M_PI 3.14159265358979323846
-#define MAX_EXPR_LEN 64
+/// Result cache statistics for Calc_Evaluate
+const CalcCacheStats* Calc_GetCacheStats(void);
+
+/// Empties the result cache and zeroes its statistics
+void   Calc_CacheClear(void);
+
+/// Clears a separate context (expression, error and last result)
+void   CalcCtx_Init(CalcContext *c);
+
+/// Replaces the context's expression with raw text (no key expansion). Returns -1 if too long
+int    CalcCtx_SetExpression(CalcContext *c, const char *text);
+
+/// Calc_Evaluate / Calc_HadError / Calc_FormatLastResult on a separate context
+double CalcCtx_Evaluate(CalcContext *c);
+int    CalcCtx_HadError(const CalcContext *c);
+void   CalcCtx_FormatLastResult(CalcContext *c, char *out);
+
+/// Starts an expression that arrives one character at a time (e.g. from the UART), nothing is
+/// stored. Ans and the result belong to c
+void   CalcStream_Begin(CalcStream *s, CalcContext *c);
+
+/// Lexes one character, folding any token it completes. Returns -1 once the expression can no
+/// longer be valid; the rest can still be fed and is ignored
+int    CalcStream_Feed(CalcStream *s, char ch);
+
+/// Ends the expression: the value Calc_Evaluate would give for the same text, with c's error flag
+/// and last result updated the same way
+double CalcStream_Finish(CalcStream *s);
 
 #endif // CALC_H
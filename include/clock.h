@@ -11,10 +11,40 @@
 #define NVIC_ST_RELOAD_R       (*((volatile unsigned long *)0xE000E014))
 #define NVIC_ST_CURRENT_R      (*((volatile unsigned long *)0xE000E018))
 
+#define SYSCTL_RCC2_BYPASS2    0x00000800  // Run from the oscillator, not the PLL
+#define SYSCTL_RIS_PLLLRIS     0x00000040  // PLL locked
+
+/**
+ * @brief Core clock speeds. The PLL stays powered and locked, so switching is just the BYPASS2 bit:
+ *        CLOCK_SLOW runs straight from the 16MHz main oscillator, CLOCK_FAST from the PLL.
+ */
+typedef enum {
+    CLOCK_SLOW,   // 16 MHz, used while waiting for keys
+    CLOCK_FAST,   // 80 MHz, used for evaluation and LCD bursts
+    CLOCK_SPEED_COUNT
+} ClockSpeed;
+
 void SysTick_init(void);
+
+/// Configures and starts the PLL but does not wait for lock: the core keeps running from the
+/// 16MHz oscillator (CLOCK_SLOW) and the first Clock_SetSpeed(CLOCK_FAST) after lock engages it
 void PLL_init(void);
 void SysTick_wait(unsigned long delay);
 void delay_ms(unsigned long delay);
 void delay_us(unsigned long delay);
 
+/// Switches the core clock. Delays always use the current frequency. Cheap if already at that speed.
+/// CLOCK_FAST is ignored until the PLL has locked.
+void Clock_SetSpeed(ClockSpeed speed);
+
+/// Returns the current speed / frequency in Hz
+ClockSpeed    Clock_GetSpeed(void);
+unsigned long Clock_GetHz(void);
+
+/// Milliseconds spent at a speed since PLL_init (needs Perf_Init for the cycle counter)
+unsigned long Clock_TimeAtMs(ClockSpeed speed);
+
+/// Microseconds since PLL_init, correct across speed changes
+unsigned long Clock_UptimeUs(void);
+
 #endif 
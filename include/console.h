@@ -0,0 +1,83 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+/**
+ * @file console.h
+ * @brief UART0 command console on the ICDI virtual COM port (PA0 RX, PA1 TX, 115200 8N1):
+ *        - Each newline-terminated line is evaluated as an expression, the reply is the result or "Error"
+ *        - Lines are streamed into the evaluator (CalcStream) as the bytes arrive, so there is no
+ *          line length limit. Spaces are ignored; a backspace cannot be taken back out of the
+ *          stream, so it makes the line an Error, as does a line that lost bytes to a full ring
+ *          (if its end was lost with them, the Error covers the next line too)
+ *        - RX is uDMA ping-pong into two blocks; the UART interrupt only runs per block (or on
+ *          an idle line timeout for the tail), moving the bytes into a ring for the main loop.
+ *          A tail that ended on a whole burst raises no timeout, Console_Poll collects it
+ *        - TX replies are queued into two buffers, one being filled while uDMA sends the other
+ *        - Uses its own CalcContext, so it never disturbs what is typed on the keypad
+ */
+
+// System Control Registers
+#define SYSCTL_RCGCUART_R       (*((volatile unsigned long *)0x400FE618))
+#define SYSCTL_RCGCDMA_R        (*((volatile unsigned long *)0x400FE60C))
+#define SYSCTL_PRUART_R         (*((volatile unsigned long *)0x400FEA18))
+
+// UART0 Registers
+#define UART0_DR_R              (*((volatile unsigned long *)0x4000C000))
+#define UART0_FR_R              (*((volatile unsigned long *)0x4000C018))
+#define UART0_IBRD_R            (*((volatile unsigned long *)0x4000C024))
+#define UART0_FBRD_R            (*((volatile unsigned long *)0x4000C028))
+#define UART0_LCRH_R            (*((volatile unsigned long *)0x4000C02C))
+#define UART0_CTL_R             (*((volatile unsigned long *)0x4000C030))
+#define UART0_IFLS_R            (*((volatile unsigned long *)0x4000C034))
+#define UART0_IM_R              (*((volatile unsigned long *)0x4000C038))
+#define UART0_MIS_R             (*((volatile unsigned long *)0x4000C040))
+#define UART0_ICR_R             (*((volatile unsigned long *)0x4000C044))
+#define UART0_DMACTL_R          (*((volatile unsigned long *)0x4000C048))
+#define UART0_CC_R              (*((volatile unsigned long *)0x4000CFC8))
+
+#define UART_FR_RXFE            0x00000010  // Receive FIFO empty
+#define UART_IM_RTIM            0x00000040  // Receive timeout interrupt
+#define UART_CC_PIOSC           0x00000005  // Baud clock from the 16MHz PIOSC, independent of the core clock
+
+// uDMA Registers
+#define UDMA_CFG_R              (*((volatile unsigned long *)0x400FF004))
+#define UDMA_CTLBASE_R          (*((volatile unsigned long *)0x400FF008))
+#define UDMA_USEBURSTSET_R      (*((volatile unsigned long *)0x400FF018))
+#define UDMA_REQMASKCLR_R       (*((volatile unsigned long *)0x400FF024))
+#define UDMA_ENASET_R           (*((volatile unsigned long *)0x400FF028))
+#define UDMA_ENACLR_R           (*((volatile unsigned long *)0x400FF02C))
+#define UDMA_ALTSET_R           (*((volatile unsigned long *)0x400FF030))
+#define UDMA_ALTCLR_R           (*((volatile unsigned long *)0x400FF034))
+#define UDMA_PRIOSET_R          (*((volatile unsigned long *)0x400FF038))
+#define UDMA_CHIS_R             (*((volatile unsigned long *)0x400FF504))
+#define UDMA_CHMAP1_R           (*((volatile unsigned long *)0x400FF514))
+
+#define UDMA_CHAN_UART0RX       8
+#define UDMA_CHAN_UART0TX       9
+
+// NVIC
+#define NVIC_EN0_R              (*((volatile unsigned long *)0xE000E100))
+#define NVIC_DIS0_R             (*((volatile unsigned long *)0xE000E180))
+#define NVIC_EN0_UART0          0x00000020  // IRQ 5
+
+#define CONSOLE_DMA_BLOCK       16   // Bytes per RX ping-pong block
+#define CONSOLE_RX_RING         256  // Received bytes waiting for the main loop
+#define CONSOLE_TX_BUFFER       128  // Bytes per TX buffer
+
+#ifdef UART_MOCK
+// Host builds read the RX FIFO and poll the TX channel through the model in tools/uart_host.c
+int  UartHost_RxEmpty(void);
+char UartHost_RxRead(void);
+int  UartHost_TxBusy(void);
+#endif
+
+/// Configures PA0/PA1, UART0 and the uDMA channels, then starts receiving
+void Console_Init(void);
+
+/// Returns 1 if received bytes are waiting
+int  Console_HasWork(void);
+
+/// Streams the received bytes into the evaluator and queues a reply per complete line. Call from the main loop.
+void Console_Poll(void);
+
+#endif // CONSOLE_H
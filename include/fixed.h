@@ -0,0 +1,77 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+/**
+ * @file fixed.h
+ * @brief Q32.32 fixed-point arithmetic for FPU-less builds:
+ *        - CalcFixed is a 64-bit integer holding value * 2^32 (range +-2^31, step 2.3e-10)
+ *        - Every operation saturates and reports FIX_RANGE when the result does not fit,
+ *          FIX_DOMAIN for divide by zero, sqrt/ln of a negative and the like
+ *        - Integer-only: no double, no libm. Products and quotients use 32-bit halves,
+ *          so nothing needs a 128-bit type
+ *        - Trig in degrees from a quarter-wave table, interpolated with the angle-addition formula
+ *        - A non-zero result that rounds to 0 is FIX_RANGE too (underflow), e.g. 0.00001*0.00001
+ *        - With CALC_FIXED defined Calc_Evaluate runs its programs here first. It falls back to double
+ *          when a value leaves the Q32.32 range, or when the error bound it carries (Fix_OpError,
+ *          Fix_ApplyError) passes FIX_ERROR_SHOWN. A step is absolute, so a rounded fraction scaled
+ *          up (0.0001*10^8) or a chain of roundings would otherwise show in the digits
+ *        - Literals are parsed straight to Q32.32 (Fix_FromString). Variables and Ans are stored as
+ *          double and converted. The result goes back to the API as a double, exact below 2^21 and
+ *          within 2^-22 above, and Calc_FormatResult formats it with Fix_Format
+ *
+ *        Accuracy (host, against the double kernels, tests/test_fixed.c): + - exact, * / sqrt rounded
+ *        to the step, sin/cos within 1e-9, ln/log/exp within a few 1e-9 (exp relative),
+ *        asin/acos/atan within 2e-7 degrees. A result shown differs from double only on a decimal tie.
+ */
+
+typedef long long CalcFixed;
+
+#define FIX_FRAC_BITS 32
+#define FIX_ONE       ((CalcFixed)1 << FIX_FRAC_BITS)
+#define FIX_MAX       ((CalcFixed)0x7FFFFFFFFFFFFFFFLL)
+#define FIX_MIN       (-FIX_MAX - 1)
+
+typedef enum {
+    FIX_OK,
+    FIX_RANGE,       // Result saturated, the caller may redo it in double
+    FIX_DOMAIN       // No result (the double engine gives NAN or infinity here too)
+} FixStatus;
+
+/// Integer n as Q32.32, saturating outside +-2^31
+CalcFixed Fix_FromInt(long long n, FixStatus *status);
+
+/// Parses a decimal literal such as "12.5" or "-.25", rounding the fraction to the nearest step
+CalcFixed Fix_FromString(const char *text, FixStatus *status);
+
+/// Conversions at the boundary with the double API
+CalcFixed Fix_FromDouble(double value, FixStatus *status);
+double    Fix_ToDouble(CalcFixed value);
+
+/// Arithmetic. status is only ever raised (FIX_OK => FIX_RANGE/FIX_DOMAIN), so one can cover a sequence
+CalcFixed Fix_Add(CalcFixed a, CalcFixed b, FixStatus *status);
+CalcFixed Fix_Sub(CalcFixed a, CalcFixed b, FixStatus *status);
+CalcFixed Fix_Mul(CalcFixed a, CalcFixed b, FixStatus *status);
+CalcFixed Fix_Div(CalcFixed a, CalcFixed b, FixStatus *status);
+CalcFixed Fix_Pow(CalcFixed a, CalcFixed b, FixStatus *status);
+
+/// Registry function (func.h FuncId) in fixed point, same domains as Func_Apply
+CalcFixed Fix_Apply(int func, CalcFixed x, FixStatus *status);
+
+/// Error bounds in steps, to tell when a result could differ from double in the digits shown.
+/// Each takes the bounds of the inputs (0 for an exact value) and saturates at FIX_ERROR_MAX
+#define FIX_ERROR_MAX   0xFFFFFFFFUL
+#define FIX_ERROR_SHOWN 32768UL     // 7.6e-6, far inside the 3 decimals shown
+
+/// A value just rounded into Q32.32 (a literal or a double): 1 if it has fraction bits, else exact
+unsigned long Fix_RoundingError(CalcFixed value);
+
+/// r = a op b, op one of + - * / ^
+unsigned long Fix_OpError(char op, CalcFixed a, unsigned long ea, CalcFixed b, unsigned long eb, CalcFixed r);
+
+/// r = Fix_Apply(func, x)
+unsigned long Fix_ApplyError(int func, CalcFixed x, unsigned long ex, CalcFixed r);
+
+/// Formats like Calc_FormatResult (up to 3 decimals, trailing zeros stripped) with integer arithmetic only. out needs 16 chars
+void      Fix_Format(CalcFixed value, char *out);
+
+#endif // FIXED_H
@@ -0,0 +1,40 @@
+#ifndef FLASH_H
+#define FLASH_H
+
+/**
+ * @file flash.h
+ * @brief Internal flash as non-volatile storage:
+ *        - The last 1 KB page (FLASH_STORE_PAGE) is kept out of the image for saved data
+ *        - Erase sets every byte of a page to 0xFF, a write can only clear bits, so a
+ *          word is rewritten by erasing its whole page first
+ *        - Writes go one word at a time through FMA/FMD/FMC. The CPU stalls on flash
+ *          fetches while a write or erase runs, so it only happens on an explicit save
+ *        - tools/flash_host.c implements the same functions on a file for host builds
+ */
+
+// Flash memory control registers
+#define FLASH_FMA_R             (*((volatile unsigned long *)0x400FD000))
+#define FLASH_FMD_R             (*((volatile unsigned long *)0x400FD004))
+#define FLASH_FMC_R             (*((volatile unsigned long *)0x400FD008))
+#define FLASH_FCRIS_R           (*((volatile unsigned long *)0x400FD00C))
+#define FLASH_FCMISC_R          (*((volatile unsigned long *)0x400FD014))
+
+#define FLASH_FMC_WRKEY         0xA4420000  // Key in the upper half of every FMC write
+#define FLASH_FMC_ERASE         0x00000002
+#define FLASH_FMC_WRITE         0x00000001
+#define FLASH_FCRIS_ARIS        0x00000001  // Access violation (protected or out of range)
+
+#define FLASH_SIZE              0x00040000  // 256 KB
+#define FLASH_PAGE_SIZE         1024
+#define FLASH_STORE_PAGE        (FLASH_SIZE - FLASH_PAGE_SIZE)
+
+/// Erases the page starting at address (a multiple of FLASH_PAGE_SIZE). Returns -1 on an access violation
+int         Flash_ErasePage(unsigned long address);
+
+/// Programs length bytes (a multiple of 4, word-aligned address) from data. Returns -1 on an access violation
+int         Flash_Write(unsigned long address, const void *data, int length);
+
+/// Readable copy of flash at address: the address itself on the target, the file image on the host
+const void* Flash_Read(unsigned long address);
+
+#endif // FLASH_H
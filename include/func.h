@@ -0,0 +1,65 @@
+#ifndef FUNC_H
+#define FUNC_H
+
+/**
+ * @file func.h
+ * @brief Scientific function registry. Each entry maps a function id to its name in the expression,
+ *        the key that inserts it, its arity, its kernel, its derivative and its domain. Angles are in degrees.
+ *
+ * The registry applies libm's sqrt, exp, ln and log10, which the host bench measures faster than
+ * the kernels below. Building with FUNC_KERNELS applies the kernels instead; do that only where
+ * PERF_FUNCTION cycle counts on the target show them ahead.
+ *
+ * Kernel accuracy (worst error seen against libm double over 2e6 arguments across the full range):
+ *   sqrt        <= 1 ulp  (VSQRT.F32 estimate + 2 Newton steps in double)
+ *   exp         <= 1 ulp  (Cody-Waite reduction by ln2, degree-5 minimax in r^2)
+ *   ln          <= 1 ulp  (reduction to [sqrt(1/2), sqrt(2)), degree-7 minimax in s^2)
+ *   log         <= 2 ulp  (ln of the same reduced mantissa, log10(2) split in two)
+ *   sin/cos/tan, asin/acos/atan: libm, plus one rounding for the degree conversion
+ */
+
+typedef enum {
+    FUNC_SIN,
+    FUNC_COS,
+    FUNC_TAN,
+    FUNC_SQRT,
+    FUNC_LN,
+    FUNC_LOG,    // Base 10
+    FUNC_EXP,
+    FUNC_ASIN,   // Results in degrees
+    FUNC_ACOS,
+    FUNC_ATAN,
+    FUNC_COUNT
+} FuncId;
+
+typedef struct {
+    const char   *name;              // As shown in the expression
+    char          key;               // Key code that inserts it
+    unsigned char arity;             // Operands taken from the value stack
+    double      (*kernel)(double);
+    double      (*slope)(double x, double fx);  // d kernel / dx, given fx = kernel(x)
+    int         (*inDomain)(double); // NULL => every finite value
+} FuncInfo;
+
+/// Registry entry for a function id
+const FuncInfo* Func_Get(FuncId id);
+
+/// Function inserted by a key code, or -1 if the key is not a function key
+int    Func_FromKey(char key);
+
+/// Longest function name at the start of text, or -1. length receives the name length
+int    Func_Match(const char *text, int *length);
+
+/// Applies a function, giving NAN outside its domain (the evaluator turns that into an error)
+double Func_Apply(FuncId id, double x);
+
+/// Derivative at x given fx = Func_Apply(id, x), for forward-mode differentiation. Infinite where the slope is vertical
+double Func_Slope(FuncId id, double x, double fx);
+
+/// Kernels, usable directly, and in the registry with FUNC_KERNELS
+double Func_Sqrt(double x);
+double Func_Exp(double x);
+double Func_Ln(double x);
+double Func_Log10(double x);
+
+#endif // FUNC_H
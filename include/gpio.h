@@ -53,12 +53,56 @@
 #define GPIO_PORTE_AMSEL_R      (*((volatile unsigned long *)0x40024528))
 #define GPIO_PORTE_PCTL_R       (*((volatile unsigned long *)0x4002452C))
 
+// GPIO Port Base Addresses (APB aperture)
+#define GPIO_PORTA_BASE         0x40004000
+#define GPIO_PORTB_BASE         0x40005000
+#define GPIO_PORTD_BASE         0x40007000
+#define GPIO_PORTE_BASE         0x40024000
+
 // GPIO Masks
 #define LCD_CTRL_MASK           0x0C  // PA2 (EN), PA3 (RS)
 #define LCD_DATA_MASK           0x0F  // PB0-PB3
 #define KEYPAD_COL_MASK         0x0F  // PD0-PD3
 #define KEYPAD_ROW_MASK         0x0F  // PE0-PE3
 
+#define LCD_EN_PIN              0x04  // PA2: Enable pin
+#define LCD_RS_PIN              0x08  // PA3: Register Select (1 for data, 0 for command)
+
+/**
+ * @brief Address-masked DATA register.
+ *        Address bits [9:2] of a GPIODATA access select which pins it touches,
+ *        so a store only changes the pins in mask and a load reads 0 for the rest.
+ *        This replaces volatile read-modify-write sequences with one bus write,
+ *        which is interrupt-safe and never glitches the other pins.
+ */
+#define GPIO_DATA_BITS(base, mask) (*((volatile unsigned long *)((base) + ((mask) << 2))))
+
+#ifdef GPIO_MOCK
+// Host builds route every pin access to the port model in tools/gpio_host.c
+void          GpioHost_Write(unsigned long base, unsigned long mask, unsigned long value);
+unsigned long GpioHost_Read(unsigned long base, unsigned long mask);
+#endif
+
+/// Writes value to the pins in mask (one store). With constant base/mask this is a single STR.
+static inline void GPIO_WritePins(unsigned long base, unsigned long mask, unsigned long value)
+{
+#ifdef GPIO_MOCK
+    GpioHost_Write(base, mask, value);
+#else
+    GPIO_DATA_BITS(base, mask) = value;
+#endif
+}
+
+/// Reads the pins in mask (one load), other bits read as 0
+static inline unsigned long GPIO_ReadPins(unsigned long base, unsigned long mask)
+{
+#ifdef GPIO_MOCK
+    return GpioHost_Read(base, mask);
+#else
+    return GPIO_DATA_BITS(base, mask);
+#endif
+}
+
 // Function Prototype
 void GPIO_Init(void);
 
@@ -0,0 +1,47 @@
+#ifndef INTEG_H
+#define INTEG_H
+
+#include <stdbool.h>
+
+/**
+ * @file integ.h
+ * @brief Integration / summation mode:
+ *        - User types f(X) and '=', then the limits a and b (and Tol for integration)
+ *        - f(X) is compiled once; every sample is a batched run of the compiled program
+ *        - Integration: adaptive 7/15-point Gauss-Kronrod, non-recursive (fixed interval stack)
+ *        - Summation: f(a) + f(a+1) + ... up to b, compensated (Kahan) sum
+ *        - The limits and Tol may use Ans, and do not change it. A range too wide to work through
+ *          (an infinite width, or a sum of more than INTEG_MAX_TERMS terms) is an error at b
+ *        - Work is done a slice per Integ_Step() so the main loop keeps scanning keys:
+ *          progress shows on row 1 and 'C' aborts
+ */
+
+#define INTEG_MAX_TERMS 1000000000L  // Longest sum, fits a 32-bit long with room for the index
+
+typedef enum {
+    INTEG_INTEGRATE,
+    INTEG_SUM
+} IntegKind;
+
+/// Enters the mode at the f(X) prompt
+void Integ_Enter(IntegKind kind);
+
+/// Returns true if the key was consumed. Otherwise main applies it as normal expression editing
+bool Integ_HandleKey(char key);
+
+/// Row 0 text while f(X) or a limit is being typed
+const char* Integ_Prompt(void);
+
+/// Returns true while a calculation is running
+bool Integ_IsBusy(void);
+
+/// Does one slice of work. Returns true if the display needs redrawing (progress moved or finished)
+bool Integ_Step(void);
+
+/// Returns true while running or showing a result (Integ_Draw owns both rows)
+bool Integ_OwnsDisplay(void);
+
+/// Draws progress or the result
+void Integ_Draw(void);
+
+#endif // INTEG_H
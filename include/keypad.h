@@ -2,12 +2,73 @@
 #define KEYPAD_H
 
 /**
- * SHIFT-latching keypad in pure C:
+ * SHIFT-latching keypad in pure C. 'S' cycles Normal => SHIFT => ALT => Normal:
  * Normal: digits + . + basic ops + '='
- * SHIFT:  trig letters, exponent '^', 'C' clear, ignoring '?' 
+ * SHIFT:  trig letters, exponent '^', 'C' clear, RCL/STO, MODE, cursor left/right, DEL,
+ *         SWAP/ROLL/LASTx (RPN mode), ignoring '?' 
+ * ALT:    sqrt, ln, log, exp / asin, acos, atan, memory register keys M+, M-, MR, MC
+ *
+ * BASE mode switches to its own layout (Keypad_SetLayout), Normal is unchanged:
+ * SHIFT:  AND, OR, XOR, '/', NOT, <<, >>, 'C', BASE, WORD, MODE, cursor left/right, DEL
+ * ALT:    hex digits 'a'-'f'
+ *
+ * RCL or STO followed by a digit picks a variable:
+ * 1-6 => A-F, 7 => X, 8 => M, 0 => Ans (RCL only)
+ * MODE followed by a digit picks the mode: 1 => COMP, 2 => TABLE, 3 => INTEGRATE, 4 => SUM,
+ * 5 => STAT, 6 => REG, 7 => RPN, 8 => PRGM, 9 => RUN, 0 => SOLVE, '.' => BASE. MODE again shows the next page of the menu
+ *
+ * Decoded keys go through a small FIFO so input can arrive (from the matrix
+ * or a scripted feed) faster than the main loop redraws the LCD.
  */
 
+#define KEY_QUEUE_SIZE 16
+
+// Key codes for keys that are not typed into the expression
+#define KEY_RCL     'R'  // Next digit inserts a variable
+#define KEY_STO     'T'  // Evaluate, next digit stores the result into a variable
+#define KEY_MPLUS   'P'  // Evaluate, add result to M
+#define KEY_MMINUS  'N'  // Evaluate, subtract result from M
+#define KEY_MR      'Q'  // Insert M
+#define KEY_MC      'Z'  // Clear M
+#define KEY_MODE    'O'  // Next digit selects the calculator mode
+#define KEY_DEL     'K'  // Delete the digit, operator, variable or function name before the cursor
+#define KEY_LEFT    '<'  // Move the cursor one unit left
+#define KEY_RIGHT   '>'  // Move the cursor one unit right
+#define KEY_SWAP    'W'  // RPN: exchange X and Y
+#define KEY_ROLL    'V'  // RPN: rotate the stack down
+#define KEY_LASTX   'L'  // RPN: recall X from before the last operation
+#define KEY_AND     '&'  // BASE: bitwise operators
+#define KEY_OR      '|'
+#define KEY_XOR     '#'
+#define KEY_NOT     '~'  // BASE: complement the value shown, straight away
+#define KEY_SHL     '['  // BASE: shift left
+#define KEY_SHR     ']'  // BASE: arithmetic shift right
+#define KEY_BASE    '$'  // BASE: DEC => HEX => BIN => OCT
+#define KEY_WORD    '%'  // BASE: 8 => 16 => 32 => 64 bits
+
+typedef enum {
+    KEYPAD_LAYOUT_NORMAL,
+    KEYPAD_LAYOUT_BASE
+} KeypadLayout;
+
 void Keypad_Init(void);
+
+/// Selects the key maps. The SHIFT/ALT latch is left where it is
+void Keypad_SetLayout(KeypadLayout layout);
+
+/// Scans the matrix once. A debounced key is pushed onto the queue (SHIFT is handled here)
+void Keypad_Scan(void);
+
+/// Queues a key as if it had been pressed. Returns -1 if the queue is full, 0 on success
+int  Keypad_Push(char key);
+
+/// Returns 1 if a key is waiting in the queue
+int  Keypad_HasKey(void);
+
+/// Removes the oldest queued key, or returns '\0' if empty. queuedAt (may be NULL) receives its cycle timestamp
+char Keypad_Pop(unsigned long *queuedAt);
+
+/// Scans once and returns the oldest queued key, or '\0' if none
 char Keypad_GetKey(void);
 
 #endif // KEYPAD_H
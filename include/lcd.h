@@ -1,6 +1,9 @@
 #ifndef LCD_H
 #define LCD_H
 
+#define LCD_COLUMNS 16
+#define LCD_ROW_CELLS 40   // DDRAM cells per row, only the first LCD_COLUMNS are visible
+
 // Function prototypes for LCD operations
 
 /**
@@ -9,6 +12,17 @@
  */
 void LCD_Init(void);
 
+/**
+ * @brief Starts the same initialisation without blocking. Call LCD_Poll() until it returns 1.
+ */
+void LCD_InitStart(void);
+
+/**
+ * @brief Runs the next initialisation step once its delay has passed.
+ * @return 1 once the LCD is ready for commands, 0 while initialisation is still running.
+ */
+int LCD_Poll(void);
+
 /**
  * @brief Sends a command to the LCD.
  * @param command The command byte to be sent.
@@ -30,7 +44,7 @@ void LCD_Clear(void);
  * @brief Displays a string of characters on the LCD.
  * @param str Pointer to the null-terminated string to be displayed.
  */
-void LCD_String(char *str);
+void LCD_String(const char *str);
 
 /**
  * @brief Moves the cursor to the specified position on the LCD.
@@ -39,4 +53,39 @@ void LCD_String(char *str);
  */
 void LCD_SetCursor(unsigned char row, unsigned char col);
 
+/**
+ * @brief Blanks a whole row and writes a string from column 0.
+ * @param row The row number (0-based index).
+ * @param str Pointer to the null-terminated string to be displayed.
+ */
+void LCD_WriteRow(unsigned char row, const char *str);
+
+/**
+ * @brief Brings a row from the text in shown to str, writing only the cells that differ
+ *        (a delete or append touches one or two cells instead of the whole row).
+ * @param row   The row number (0-based index).
+ * @param shown Caller's copy of what the row holds (LCD_ROW_CELLS + 1 chars), updated to str.
+ *              LCD_ForgetRow() marks it unknown so the next patch rewrites every visible cell.
+ * @param str   Pointer to the null-terminated string to be displayed.
+ */
+void LCD_PatchRow(unsigned char row, char *shown, const char *str);
+
+/**
+ * @brief Shows the blinking cursor at a position. Data writes move the cursor with them,
+ *        so call it again after writing anything else.
+ * @param row The row number (0-based index).
+ * @param col The column number (0-based index).
+ */
+void LCD_ShowCursor(unsigned char row, unsigned char col);
+
+/**
+ * @brief Hides the cursor again.
+ */
+void LCD_HideCursor(void);
+
+/**
+ * @brief Marks a shown-row copy as unknown, e.g. after the row was written some other way.
+ */
+void LCD_ForgetRow(char *shown);
+
 #endif // LCD_H
@@ -0,0 +1,80 @@
+#ifndef PERF_H
+#define PERF_H
+
+/**
+ * @file perf.h
+ * @brief Cycle-accurate profiling using the Cortex-M4 DWT cycle counter (CYCCNT):
+ *        - Cycles_Now() returns the free-running 32-bit core cycle count
+ *        - Each PerfMetric keeps count / total / min / max cycles
+ *        - PERF_BEGIN / PERF_END compile to nothing unless CALC_PROFILE is defined,
+ *          so release builds carry no instrumentation cost
+ *        - Results live in RAM and can be read from the debugger watch window
+ */
+
+// Debug / DWT Register Definitions
+#define CORE_DEMCR_R           (*((volatile unsigned long *)0xE000EDFC))
+#define DWT_CTRL_R             (*((volatile unsigned long *)0xE0001000))
+#define DWT_CYCCNT_R           (*((volatile unsigned long *)0xE0001004))
+
+#define CORE_DEMCR_TRCENA      0x01000000  // Enable DWT/ITM blocks
+#define DWT_CTRL_CYCCNTENA     0x00000001  // Enable cycle counter
+
+typedef enum {
+    PERF_CALC_ADDCHAR,   // Calc_AddChar()
+    PERF_TOKENISE,       // Lexing pass of Calc_Evaluate(), for the cache key
+    PERF_PROCESS,        // Streamed evaluation on a cache miss
+    PERF_FUNCTION,       // Func_Apply() over a batch (sin, sqrt, ln, ...)
+    PERF_FORMAT,         // Result formatting for the LCD
+    PERF_LCD_BYTE,       // One LCD command/data byte
+    PERF_KEYPAD_SCAN,    // One full keypad scan
+    PERF_KEY_LATENCY,    // Key queued => its LCD update finished
+    PERF_METRIC_COUNT
+} PerfMetric;
+
+/// Boot milestones, timed in microseconds from Perf_Init (first thing in main)
+typedef enum {
+    BOOT_FIRST_KEY,    // First key accepted from the queue
+    BOOT_FIRST_DRAW,   // First character drawn on the LCD
+    BOOT_MARK_COUNT
+} BootMark;
+
+typedef struct {
+    unsigned long count;
+    unsigned long total;
+    unsigned long min;
+    unsigned long max;
+} PerfStat;
+
+/// Enables the DWT cycle counter and clears all metrics
+void Perf_Init(void);
+
+/// Returns the current core cycle count (wraps every 2^32 cycles, ~53s at 80MHz)
+unsigned long Cycles_Now(void);
+
+/// Adds one sample (in cycles) to the given metric
+void Perf_Record(PerfMetric metric, unsigned long cycles);
+
+/// Returns the accumulated statistics for a metric
+const PerfStat* Perf_Get(PerfMetric metric);
+
+/// Clears all metrics
+void Perf_Reset(void);
+
+/// Records a boot milestone the first time it happens and reports it through Perf_OnBootMark
+void Perf_BootMark(BootMark mark);
+
+/// Microseconds from boot to the milestone, 0 if it has not happened yet
+unsigned long Perf_BootTimeUs(BootMark mark);
+
+/// Instrumentation hook called once per milestone. Weak and empty by default; override to log it.
+void Perf_OnBootMark(BootMark mark, unsigned long microseconds);
+
+#ifdef CALC_PROFILE
+#define PERF_BEGIN(metric)  unsigned long perfStart_##metric = DWT_CYCCNT_R
+#define PERF_END(metric)    Perf_Record(metric, DWT_CYCCNT_R - perfStart_##metric)
+#else
+#define PERF_BEGIN(metric)
+#define PERF_END(metric)
+#endif
+
+#endif // PERF_H
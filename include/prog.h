@@ -0,0 +1,52 @@
+#ifndef PROG_H
+#define PROG_H
+
+#include <stdbool.h>
+#include "calc.h"
+
+/**
+ * @file prog.h
+ * @brief Stored programs:
+ *        - PRGM (MODE 8): pick a slot 1-6 and type the calculation as it would be keyed, one step
+ *          per '=', with variables (RCL) as placeholders for its inputs. A step after the first
+ *          starts with an operator and continues from the one before, as keys typed after '='
+ *          continue from Ans ("X*1.2=" then "+5=" is (X*1.2)+5). Each step is compiled onto the
+ *          end of the program as it is entered; '=' with nothing typed saves it to flash
+ *        - RUN (MODE 9): pick a slot, type each input at its prompt ("A?", "X?" ...) and '='.
+ *          The saved program runs as compiled, nothing is dispatched as keys or tokenised again
+ *        - While a result is shown '=' (or the first digit of the next input) starts the next run
+ *        - Every variable except Ans is an input, asked for in the order A-F, X, M. Ans typed in
+ *          a step is the last calculation's result when the program runs, not the step before
+ *        - All steps share the program's MAX_TOKENS instructions
+ *        - Programs live in the flash store page (see flash.h), PROG_SLOTS at a time
+ */
+
+#define PROG_SLOTS 6
+
+typedef enum {
+    PROG_RECORD,      // MODE 8: save into a slot
+    PROG_RUN          // MODE 9: run a slot
+} ProgKind;
+
+/// Packs a compiled program into a slot and writes it to flash. Returns -1 if it does not fit or the write failed
+int  Prog_Save(int slot, const CalcProgram *prog);
+
+/// Unpacks a slot. inputs receives a bit per CalcVariable the program reads. Returns -1 if the slot is empty
+int  Prog_Load(int slot, CalcProgram *prog, unsigned *inputs);
+
+/// Enters the mode at the slot prompt
+void Prog_Enter(ProgKind kind);
+
+/// Returns true if the key was consumed. Otherwise main applies it as normal expression editing
+bool Prog_HandleKey(char key);
+
+/// Row 0 text while a slot, the program or an input is being typed
+const char* Prog_Prompt(void);
+
+/// Returns true while a result is shown (Prog_Draw owns both rows)
+bool Prog_OwnsDisplay(void);
+
+/// Draws the result of the last run
+void Prog_Draw(void);
+
+#endif // PROG_H
@@ -0,0 +1,35 @@
+#ifndef RPN_H
+#define RPN_H
+
+#include <stdbool.h>
+
+/**
+ * @file rpn.h
+ * @brief RPN mode with an X/Y/Z/T stack:
+ *        - Digits and '.' type a number into X, '=' is ENTER (copies X into Y)
+ *        - + - * / ^ and the function keys act on the stack at once, so there is no
+ *          expression and nothing to parse. T is copied down as the stack drops
+ *        - SWAP exchanges X and Y, ROLL rotates the stack down, LASTx recalls X from before the last operation
+ *        - DEL erases the last digit typed, otherwise clears X. 'C' clears the whole stack
+ *        - Row 0 shows Y, row 1 shows X
+ */
+
+/// Enters the mode with an empty (all zero) stack
+void   Rpn_Enter(void);
+
+/// Returns true if the key was consumed. RCL, STO and the memory keys are left to main
+bool   Rpn_HandleKey(char key);
+
+/// Ends any number being typed and returns X (for STO, M+ and M-)
+double Rpn_X(void);
+
+/// Pushes a value into X, lifting the stack (for RCL and MR)
+void   Rpn_Push(double value);
+
+/// Marks the rows as overwritten by something else, so the next Rpn_Draw rewrites them
+void   Rpn_ForgetDisplay(void);
+
+/// Draws Y and X, writing only the cells that changed
+void   Rpn_Draw(void);
+
+#endif // RPN_H
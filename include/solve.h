@@ -0,0 +1,43 @@
+#ifndef SOLVE_H
+#define SOLVE_H
+
+#include <stdbool.h>
+
+/**
+ * @file solve.h
+ * @brief Equation solver mode, f(X) = 0:
+ *        - User types f(X) and '=', then the ends of a search interval a and b
+ *          (the same value twice is a single starting guess)
+ *        - f(X) is compiled once; each iteration is one dual-number run giving f and f' together
+ *        - Safeguarded Newton: while a and b bracket a sign change, a Newton step that leaves the
+ *          bracket or does not at least halve the previous step is replaced by bisection, so it
+ *          always converges. Without a sign change it is plain Newton from the better end, and
+ *          bisection takes over as soon as a sign change turns up
+ *        - At most SOLVE_MAX_ITER iterations, one per Solve_Step() so 'C' aborts
+ *        - The root is stored in X
+ */
+
+#define SOLVE_MAX_ITER 100
+
+/// Enters the mode at the f(X) prompt
+void Solve_Enter(void);
+
+/// Returns true if the key was consumed. Otherwise main applies it as normal expression editing
+bool Solve_HandleKey(char key);
+
+/// Row 0 text while f(X) or an interval end is being typed
+const char* Solve_Prompt(void);
+
+/// Returns true while iterating
+bool Solve_IsBusy(void);
+
+/// Does one iteration. Returns true if the display needs redrawing (finished)
+bool Solve_Step(void);
+
+/// Returns true while iterating or showing a result (Solve_Draw owns both rows)
+bool Solve_OwnsDisplay(void);
+
+/// Draws progress or the root
+void Solve_Draw(void);
+
+#endif // SOLVE_H
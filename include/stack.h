@@ -0,0 +1,63 @@
+#ifndef STACK_H
+#define STACK_H
+
+#include <stdbool.h>
+
+/**
+ * @file stack.h
+ * @brief Main stack usage (Stack_Mem in startup_TM4C123.s, Stack_Size bytes):
+ *        - Reset_Handler paints every word of the stack with STACK_PAINT before anything runs,
+ *          so the high-water mark is the lowest word that no longer holds it
+ *        - The lowest STACK_GUARD_BYTES are a guard band nothing should reach. Stack_Check()
+ *          runs every main loop pass and calls Stack_OnOverflow once if any of it was written.
+ *          A single frame larger than the band could step over it without touching it
+ *        - STACK_BEGIN / STACK_END give each StackPath its own peak: the free stack is
+ *          repainted at BEGIN and scanned at END. Paths may nest, an outer one is credited with
+ *          everything inside it. Interrupts count towards whichever path is open.
+ *          They compile to nothing unless CALC_STACK is defined
+ *        - Results live in RAM and can be read from the debugger watch window
+ *        - tools/stack_report.py gives the static worst case from the linker call graph
+ */
+
+#define STACK_PAINT        0xDEADBEEFUL  // Same as Stack_Paint in startup_TM4C123.s
+#define STACK_GUARD_BYTES  64
+
+typedef enum {
+    STACK_PATH_KEY,       // handleKey(): editing, evaluating, mode keys
+    STACK_PATH_CONSOLE,   // Console_Poll(): UART lines
+    STACK_PATH_STEP,      // Integ_Step() / Solve_Step() slices
+    STACK_PATH_RENDER,    // render() and the live preview
+    STACK_PATH_COUNT
+} StackPath;
+
+/// Stack bytes reserved in startup_TM4C123.s, guard band included
+unsigned long Stack_Capacity(void);
+
+/// Most bytes ever used, measured from the top of the stack
+unsigned long Stack_HighWater(void);
+
+/// Most bytes used while the path was open, 0 if it has not run (or CALC_STACK is off)
+unsigned long Stack_PathPeak(StackPath path);
+
+/// Returns false once the guard band has been written, calling Stack_OnOverflow the first time
+bool Stack_Check(void);
+
+/// Opens a path: credits the stack used so far, then repaints everything below the caller (nothing if it is not on the stack)
+void Stack_PathBegin(StackPath path);
+
+/// Closes a path and records its peak
+void Stack_PathEnd(StackPath path);
+
+/// Called once on overflow with the high-water mark. Weak; by default stops in a loop for the
+/// debugger, as whatever lies below the stack is already corrupt
+void Stack_OnOverflow(unsigned long highWater);
+
+#ifdef CALC_STACK
+#define STACK_BEGIN(path)  Stack_PathBegin(path)
+#define STACK_END(path)    Stack_PathEnd(path)
+#else
+#define STACK_BEGIN(path)
+#define STACK_END(path)
+#endif
+
+#endif // STACK_H
@@ -0,0 +1,80 @@
+#ifndef STAT_H
+#define STAT_H
+
+#include <stdbool.h>
+
+/**
+ * @file stat.h
+ * @brief Statistics mode:
+ *        - STAT: each value typed and '=' is one x. REG: x then y, one (x, y) pair per two '='
+ *        - Entries go straight into running accumulators (Welford mean, M2 and co-moment, min, max,
+ *          sums), so memory is constant however many values are entered
+ *        - Function keys show a result: sin n, cos mean, tan sigma, sqrt s, ln min, log max, exp Sum x,
+ *          asin a, acos b, atan r (regression y = a + bx)
+ *        - While a result is shown '+' / '-' step through the others, any other key goes back to entry
+ *        - MODE 5 / MODE 6 again starts a new data set
+ */
+
+typedef enum {
+    STAT_SINGLE,      // One variable
+    STAT_PAIRED       // Two variables with linear regression
+} StatKind;
+
+typedef enum {
+    STAT_N,
+    STAT_MEAN,
+    STAT_SIGMA,       // Population standard deviation
+    STAT_S,           // Sample standard deviation
+    STAT_MIN,
+    STAT_MAX,
+    STAT_SUM_X,
+    STAT_SUM_X2,
+    STAT_MEAN_Y,      // STAT_MEAN_Y onwards need pairs
+    STAT_SIGMA_Y,
+    STAT_SUM_Y,
+    STAT_SUM_Y2,
+    STAT_SUM_XY,
+    STAT_A,           // Intercept
+    STAT_B,           // Slope
+    STAT_R,           // Correlation coefficient
+    STAT_RESULT_COUNT
+} StatResult;
+
+/// Running accumulators. Spreads come from the Welford sums of squared deviations, not from the
+/// raw sums, so they stay accurate when the values share a large offset
+typedef struct {
+    long   n;
+    double originX, originY;    // First entry, the Welford sums work relative to it
+    double meanX, m2X;          // Running mean (relative to originX) and sum of (x - mean)^2
+    double meanY, m2Y;
+    double cXY;                 // Sum of (x - meanX)(y - meanY)
+    double minX, maxX;
+    double sumX, sumX2;
+    double sumY, sumY2, sumXY;
+} StatAccumulator;
+
+/// Empties the accumulators
+void StatAcc_Clear(StatAccumulator *acc);
+
+/// Adds one entry in O(1). Pass y = 0 for single-variable data
+void StatAcc_Push(StatAccumulator *acc, double x, double y);
+
+/// Computes one result. Returns false if it is undefined for the data so far (e.g. s with n < 2)
+bool StatAcc_Result(const StatAccumulator *acc, StatResult which, double *value);
+
+/// Enters the mode at the first x prompt with no data
+void Stat_Enter(StatKind kind);
+
+/// Returns true if the key was consumed. Otherwise main applies it as normal expression editing
+bool Stat_HandleKey(char key);
+
+/// Row 0 text while an entry is being typed
+const char* Stat_Prompt(void);
+
+/// Returns true while a result is shown (Stat_Draw owns both rows)
+bool Stat_OwnsDisplay(void);
+
+/// Draws the selected result
+void Stat_Draw(void);
+
+#endif // STAT_H
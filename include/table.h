@@ -0,0 +1,34 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <stdbool.h>
+
+/**
+ * @file table.h
+ * @brief Function table mode:
+ *        - User types f(X) and '=', then Start, End and Step (each an expression + '=')
+ *        - f(X) is tokenised/compiled once, then evaluated CALC_BATCH X values per pass
+ *        - Row 0 shows X, row 1 shows f(X)
+ *        - '+' / '-' step one row, '*' jumps a page forward, '/' a page back, 'C' edits f(X) again
+ *        - A range longer than TABLE_MAX_ROWS rows stops there
+ *        - Start, End and Step may use Ans, and do not change it
+ */
+
+#define TABLE_MAX_ROWS 1000000000L  // Fits a 32-bit long with room for row + page arithmetic
+
+/// Enters table mode at the f(X) prompt
+void Table_Enter(void);
+
+/// Returns true if the key was consumed. Otherwise main applies it as normal expression editing
+bool Table_HandleKey(char key);
+
+/// Row 0 text while f(X), Start, End or Step is being typed
+const char* Table_Prompt(void);
+
+/// Returns true once the table is being shown (Table_Draw owns both rows)
+bool Table_IsViewing(void);
+
+/// Draws the current X and f(X)
+void Table_Draw(void);
+
+#endif // TABLE_H
@@ -0,0 +1,63 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * @file trace.h
+ * @brief Binary event trace for keypress-to-pixel timelines:
+ *        - Each event is two words: CYCCNT, then (event << 24 | 24-bit argument)
+ *        - Events go into a power-of-two ring; the slot is claimed with one atomic
+ *          increment (LDREX/STREX), so interrupt handlers can record too
+ *        - TRACE() compiles to nothing unless CALC_TRACE is defined
+ *        - Halt, dump traceBuffer from the debugger and convert it with tools/trace2json.py
+ */
+
+#define TRACE_MAGIC    0x31435254  // "TRC1" in memory
+#ifndef TRACE_RECORDS
+#define TRACE_RECORDS  256         // Must be a power of two. A host simulation may define more
+#endif
+#define TRACE_MIN_DELAY_US 10      // Shorter delays (keypad column settling) are not recorded
+
+typedef enum {
+    TRACE_CLOCK,           // Core clock changed, argument = MHz (the exporter uses it to convert cycles)
+    TRACE_KEY_PRESSED,     // Matrix read a closed switch, argument = row << 4 | column
+    TRACE_KEY_DEBOUNCED,   // Key confirmed and released, argument = key code
+    TRACE_ADDCHAR,         // Calc_AddChar(), argument = character
+    TRACE_TOKENISE_BEGIN,
+    TRACE_TOKENISE_END,
+    TRACE_EVALUATE_BEGIN,
+    TRACE_EVALUATE_END,    // argument = 1 on error
+    TRACE_LCD_COMMAND,     // argument = command byte
+    TRACE_LCD_DATA,        // argument = character
+    TRACE_DELAY_BEGIN,     // argument = requested microseconds
+    TRACE_DELAY_END,
+    TRACE_EVENT_COUNT
+} TraceEvent;
+
+typedef struct {
+    unsigned long cycles;
+    unsigned long word;    // event << 24 | argument
+} TraceRecord;
+
+/// Layout read by the host exporter
+typedef struct {
+    unsigned long magic;
+    unsigned long capacity;            // TRACE_RECORDS
+    volatile unsigned long head;       // Events ever recorded; the newest is at (head - 1) % capacity
+    TraceRecord   records[TRACE_RECORDS];
+} TraceBuffer;
+
+extern TraceBuffer traceBuffer;
+
+/// Clears the ring and records the current clock. Call after Perf_Init.
+void Trace_Init(void);
+
+/// Appends one event. Safe from interrupt handlers.
+void Trace_Record(TraceEvent event, unsigned long arg);
+
+#ifdef CALC_TRACE
+#define TRACE(event, arg)  Trace_Record((event), (unsigned long)(arg))
+#else
+#define TRACE(event, arg)
+#endif
+
+#endif // TRACE_H
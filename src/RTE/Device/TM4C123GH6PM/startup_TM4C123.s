@@ -30,11 +30,17 @@
 ;   <o> Stack Size (in Bytes) <0x0-0xFFFFFFFF:8>
 ; </h>
 
-Stack_Size      EQU     0x00000200
+Stack_Size      EQU     0x00000800
+
+; Painted with this word at reset so stack.c can find the deepest word ever written
+Stack_Paint     EQU     0xDEADBEEF
 
                 AREA    STACK, NOINIT, READWRITE, ALIGN=3
+                EXPORT  Stack_Mem
+                EXPORT  Stack_Top
 Stack_Mem       SPACE   Stack_Size
 __initial_sp
+Stack_Top
 
 
 ; <h> Heap Configuration
@@ -232,6 +238,15 @@ Reset_Handler   PROC
                 EXPORT  Reset_Handler             [WEAK]
                 IMPORT  SystemInit
                 IMPORT  __main
+                ; Paint the whole stack before anything has used it (include/stack.h)
+                LDR     R0, =Stack_Mem
+                LDR     R1, =__initial_sp
+                LDR     R2, =Stack_Paint
+Paint_Loop      CMP     R0, R1
+                BHS     Paint_Done
+                STR     R2, [R0], #4
+                B       Paint_Loop
+Paint_Done
                 LDR     R0, =SystemInit
                 BLX     R0
                 LDR     R0, =__main
@@ -0,0 +1,325 @@
+#include "base.h"
+#include "keypad.h"
+#include "lcd.h"
+#include <stdio.h>
+#include <string.h>
+
+static int  base = 10;
+static int  bits = 32;
+static unsigned long long mask = 0xFFFFFFFFULL;
+
+// Operands: acc is the left side of pendingOp, entry the number being typed or the last result
+static unsigned long long acc = 0;
+static unsigned long long entry = 0;
+static char pendingOp = '\0';
+static bool entering = false;
+static bool error = false;
+static int  scroll = 0;  // Digits hidden off the right-hand end of row 1
+
+static char rowShown[2][LCD_ROW_CELLS + 1];
+
+/**
+ * @brief Conversion tables: one character per digit, four binary digits per nibble and two
+ *        decimal digits per step of the division, so BIN and DEC need a quarter and half the loop passes
+ */
+static const char digitChars[16] = {
+    '0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'
+};
+static const char nibbleBits[16][4] = {
+    "0000","0001","0010","0011","0100","0101","0110","0111",
+    "1000","1001","1010","1011","1100","1101","1110","1111"
+};
+static const char decimalPairs[200] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char* const baseNames[17] = { [2]="BIN", [8]="OCT", [10]="DEC", [16]="HEX" };
+
+static unsigned long long maskFor(int wordBits)
+{
+    return (wordBits==64) ? ~0ULL : (1ULL << wordBits) - 1;
+}
+
+/**
+ * @brief Two's-complement value of the low wordBits bits
+ */
+static long long signExtend(unsigned long long value, int wordBits)
+{
+    unsigned long long sign= 1ULL << (wordBits - 1);
+    value&= maskFor(wordBits);
+    return (long long)((value ^ sign) - sign);
+}
+
+int Base_Format(unsigned long long value, int toBase, int wordBits, char *out)
+{
+    int length= 0;
+
+    value&= maskFor(wordBits);
+    if(toBase==2){
+        for(int shift= wordBits - 4; shift>=0; shift-=4){
+            memcpy(&out[length], nibbleBits[(value >> shift) & 0xF], 4);
+            length+= 4;
+        }
+    }
+    else if(toBase==16 || toBase==8){
+        int digitBits= (toBase==16) ? 4 : 3;
+        int digits= (wordBits + digitBits - 1) / digitBits;
+        for(int i= digits - 1; i>=0; i--){
+            out[length++]= digitChars[(value >> (i*digitBits)) & (unsigned)(toBase - 1)];
+        }
+    }
+    else{
+        // Signed: the magnitude two digits per division, written backwards then reversed
+        long long          signedValue= signExtend(value, wordBits);
+        unsigned long long magnitude= (signedValue < 0) ? 0 - (unsigned long long)signedValue
+                                                        : (unsigned long long)signedValue;
+        char digits[20];
+        int  n= 0;
+        while(magnitude >= 100){
+            int pair= (int)(magnitude % 100);
+            magnitude/= 100;
+            digits[n++]= decimalPairs[2*pair + 1];
+            digits[n++]= decimalPairs[2*pair];
+        }
+        if(magnitude >= 10){
+            digits[n++]= decimalPairs[2*magnitude + 1];
+            digits[n++]= decimalPairs[2*magnitude];
+        }
+        else{
+            digits[n++]= digitChars[magnitude];
+        }
+        if(signedValue < 0){
+            out[length++]= '-';
+        }
+        while(n > 0){
+            out[length++]= digits[--n];
+        }
+    }
+    out[length]= '\0';
+    return length;
+}
+
+/**
+ * @brief a op b on the word. Returns false when there is no result (divide by zero)
+ */
+static bool apply(char op, unsigned long long a, unsigned long long b, unsigned long long *result)
+{
+    long long sa= signExtend(a, bits);
+    long long sb= signExtend(b, bits);
+    unsigned long long r;
+
+    switch(op){
+        case '+':      r= a + b; break;
+        case '-':      r= a - b; break;
+        case '*':      r= a * b; break;
+        case KEY_AND:  r= a & b; break;
+        case KEY_OR:   r= a | b; break;
+        case KEY_XOR:  r= a ^ b; break;
+        case KEY_SHL:  r= (b >= (unsigned)bits) ? 0 : a << b; break;
+        case KEY_SHR:
+            // Arithmetic: the sign bit fills in from the left
+            if(b >= (unsigned)bits) r= (sa < 0) ? ~0ULL : 0;
+            else                    r= (sa < 0) ? ~(~(unsigned long long)sa >> b) : (unsigned long long)sa >> b;
+            break;
+        default:  // '/'
+            if(b==0){
+                return false;
+            }
+            // Most negative / -1 overflows a signed divide, negating wraps to the same word
+            r= (sb==-1) ? 0 - a : (unsigned long long)(sa / sb);
+            break;
+    }
+    *result= r & mask;
+    return true;
+}
+
+/**
+ * @brief The value on row 1: the operand being typed, else the left side of a pending operator
+ */
+static unsigned long long* valueInView(void)
+{
+    return (pendingOp!='\0' && !entering) ? &acc : &entry;
+}
+
+static int digitValue(char key)
+{
+    if(key>='0' && key<='9') return key - '0';
+    if(key>='a' && key<='f') return key - 'a' + 10;  // Hex digit keys of the BASE layout
+    return -1;
+}
+
+static void typeDigit(int digit)
+{
+    if(!entering){
+        entry= 0;
+        entering= true;
+    }
+    // Typed as an unsigned word: a digit that would not fit is ignored
+    if(entry > (mask - (unsigned long long)digit) / (unsigned long long)base){
+        return;
+    }
+    entry= entry*(unsigned long long)base + (unsigned long long)digit;
+}
+
+void Base_Enter(void)
+{
+    base= 10;
+    bits= 32;
+    mask= maskFor(bits);
+    acc= 0;
+    entry= 0;
+    pendingOp= '\0';
+    entering= false;
+    error= false;
+    scroll= 0;
+    Base_ForgetDisplay();
+}
+
+void Base_HandleKey(char key)
+{
+    int digit= digitValue(key);
+
+    error= false;
+
+    if(digit>=0){
+        if(digit < base){
+            typeDigit(digit);
+        }
+        return;
+    }
+
+    switch(key){
+        case '+': case '-': case '*': case '/':
+        case KEY_AND: case KEY_OR: case KEY_XOR: case KEY_SHL: case KEY_SHR:
+            // Left to right: finish the pending operator first
+            if(pendingOp!='\0' && entering){
+                error= !apply(pendingOp, acc, entry, &acc);
+            }
+            else if(pendingOp=='\0'){
+                acc= entry;
+            }
+            pendingOp= error ? '\0' : key;
+            entering= false;
+            break;
+
+        case '=':
+            if(pendingOp!='\0' && entering){
+                error= !apply(pendingOp, acc, entry, &entry);
+            }
+            else if(pendingOp!='\0'){
+                entry= acc;
+            }
+            pendingOp= '\0';
+            entering= false;
+            break;
+
+        case KEY_NOT: {
+            unsigned long long *value= valueInView();
+            *value= ~*value & mask;
+            entering= false;
+            break;
+        }
+
+        case KEY_DEL:
+            if(entering){
+                entry/= (unsigned long long)base;
+            }
+            break;
+
+        case 'C':
+            acc= 0;
+            entry= 0;
+            pendingOp= '\0';
+            entering= false;
+            scroll= 0;
+            break;
+
+        case KEY_BASE:
+            base= (base==10) ? 16 : (base==16) ? 2 : (base==2) ? 8 : 10;
+            scroll= 0;
+            break;
+
+        case KEY_WORD: {
+            int wider= (bits==64) ? 8 : bits*2;
+            acc=   (unsigned long long)signExtend(acc, bits) & maskFor(wider);
+            entry= (unsigned long long)signExtend(entry, bits) & maskFor(wider);
+            bits= wider;
+            mask= maskFor(bits);
+            scroll= 0;
+            break;
+        }
+
+        case KEY_LEFT:
+            scroll+= LCD_COLUMNS / 2;  // Clamped to the length in Base_Draw
+            break;
+
+        case KEY_RIGHT:
+            scroll= (scroll > LCD_COLUMNS / 2) ? scroll - LCD_COLUMNS / 2 : 0;
+            break;
+
+        default:
+            break;  // Nothing else means anything here
+    }
+}
+
+void Base_ForgetDisplay(void)
+{
+    LCD_ForgetRow(rowShown[0]);
+    LCD_ForgetRow(rowShown[1]);
+}
+
+/**
+ * @brief Operator name for row 0
+ */
+static const char* opName(char op)
+{
+    switch(op){
+        case KEY_AND: return "AND";
+        case KEY_OR:  return "OR";
+        case KEY_XOR: return "XOR";
+        case KEY_SHL: return "<<";
+        case KEY_SHR: return ">>";
+        default: {
+            static char text[2];
+            text[0]= op;
+            return text;
+        }
+    }
+}
+
+void Base_Draw(void)
+{
+    char text[BASE_TEXT_MAX];
+    char row[LCD_COLUMNS + 8];
+    char cells[LCD_COLUMNS + 1];
+    int  length= Base_Format(*valueInView(), base, bits, text);
+    int  first;
+
+    // Window of at most LCD_COLUMNS digits, scroll digits in from the right-hand end
+    if(scroll > length - LCD_COLUMNS){
+        scroll= (length > LCD_COLUMNS) ? length - LCD_COLUMNS : 0;
+    }
+    first= (length > LCD_COLUMNS) ? length - LCD_COLUMNS - scroll : 0;
+
+    int n= snprintf(row, sizeof(row), "%s%d", baseNames[base], bits);
+    if(pendingOp!='\0'){
+        n+= snprintf(&row[n], sizeof(row) - (size_t)n, " %s", opName(pendingOp));
+    }
+    if(length > LCD_COLUMNS && base==2){
+        // Bit numbers in view
+        snprintf(&row[n], sizeof(row) - (size_t)n, " %d-%d", length - 1 - first, scroll);
+    }
+    LCD_PatchRow(0, rowShown[0], row);
+
+    memset(cells, ' ', LCD_COLUMNS);
+    if(error){
+        memcpy(cells, "Error!", 6);
+    }
+    else{
+        int shown= (length > LCD_COLUMNS) ? LCD_COLUMNS : length;
+        memcpy(&cells[LCD_COLUMNS - shown], &text[first], (size_t)shown);
+    }
+    cells[LCD_COLUMNS]= '\0';
+    LCD_PatchRow(1, rowShown[1], cells);
+}
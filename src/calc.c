@@ -1,4 +1,8 @@
 #include "calc.h"
+#include "perf.h"
+#include "trace.h"
+#include "func.h"
+#include "fixed.h"
 #include <string.h>   // for strlen, strcpy, etc.
 #include <stdlib.h>   // for atof
 #include <stdbool.h>
@@ -8,25 +12,148 @@
 
 
 /**
- * @brief Holds the user-typed expression"
+ * @brief Expression, error flag and last result of the keypad. The Calc_* API works on the active
+ *        context, which is this one except during a CalcCtx_* call (e.g. from the UART console).
  */
-static char expressionBuffer[MAX_EXPR_LEN];
+static CalcHistory  keypadHistory;
+static CalcContext  keypadContext = { .history = &keypadHistory };
+static CalcContext *ctx = &keypadContext;
 
-static int  exprIndex = 0;
-static bool errorFlag = false;
+static long long integerResult   = 0;      // Set by streamResult
+static bool      resultIsInteger = false;
 
 /**
- * @brief Stores last result to allow user to start a new expression with an operator (e.g. +5 => lastResult+5).
+ * @brief Variable and memory register slots, indexed by CalcVariable. Ans is read from lastResult.
  */
-static double lastResult   = 0.0;
-static bool   hasLastResult= false;
+static double variables[CALC_VAR_COUNT];
+
+static const char* const variableNames[CALC_VAR_COUNT] = {
+    "A", "B", "C", "D", "E", "F", "X", "M", "Ans"
+};
+
+/**
+ * @brief Bumped whenever a variable, M or an Ans changes. A stream that has folded one in is stale
+ *        once this moves on from the version it read (CalcStream.variableVersion).
+ */
+static unsigned long variablesVersion = 0;
+
+static void partialReset(CalcPartial *p);
+static void partialFold(void);
+static void partialRollback(int count);
+static int  unitsBefore(int pos);
+static void streamRestart(void);
+static void streamResync(void);
+static void streamUnit(const char *text);
+static bool streamCurrent(void);
+
+/**
+ * @brief A value folded into the preview or a stream may be out of date
+ */
+static void variablesChanged(void)
+{
+    variablesVersion++;
+    partialReset(&ctx->partial);
+}
+
+//////////////////// Gap buffer ////////////////////
+
+/// expressionBuffer holds the text before the gap at [0, gapStart) and the rest at
+/// [gapStart + gap, MAX_EXPR_LEN - 1). The gap and the last byte stay '\0', so a unit read
+/// on either side stops at the gap. The gap only moves when an edit lands somewhere else
+/// or the text is needed as one string, so typing at the cursor copies nothing.
+
+static int gapLength(void)
+{
+    return (MAX_EXPR_LEN - 1) - ctx->exprIndex;
+}
 
 /**
- * @brief Convert degrees to radians for trig
+ * @brief Address of the character at text position i
  */
-static double degToRad(double deg)
+static const char* textAt(int i)
 {
-    return deg*(M_PI/180.0);
+    return &ctx->expressionBuffer[(i < ctx->gapStart) ? i : i + gapLength()];
+}
+
+/**
+ * @brief Moves the gap to text position pos, copying only the characters in between
+ */
+static void moveGap(int pos)
+{
+    char *buffer= ctx->expressionBuffer;
+    int   gap= gapLength();
+
+    if(pos < ctx->gapStart){
+        memmove(&buffer[pos + gap], &buffer[pos], ctx->gapStart - pos);
+    }
+    else if(pos > ctx->gapStart){
+        memmove(&buffer[ctx->gapStart], &buffer[ctx->gapStart + gap], pos - ctx->gapStart);
+    }
+    else{
+        return;
+    }
+    memset(&buffer[pos], 0, gap);
+    ctx->gapStart= pos;
+}
+
+/**
+ * @brief Drops the first count characters to make room at the end. The stream has read them, so
+ *        the text left is only the tail shown on the LCD (units at the front may be cut).
+ */
+static void dropOldest(int count)
+{
+    char *buffer= ctx->expressionBuffer;
+
+    moveGap(ctx->exprIndex);
+    memmove(buffer, &buffer[count], ctx->exprIndex - count);
+    ctx->exprIndex-= count;
+    ctx->gapStart= ctx->exprIndex;
+    ctx->cursor= ctx->exprIndex;
+    memset(&buffer[ctx->exprIndex], 0, MAX_EXPR_LEN - ctx->exprIndex);
+    ctx->truncated= true;
+    partialReset(&ctx->partial);  // The checkpoints point into the dropped text
+}
+
+/**
+ * @brief Inserts one unit at the cursor. The partial evaluation rolls back to the cursor's
+ *        checkpoint and only the units from there on are folded again. At the end of the text the
+ *        unit also goes into the context's stream; anywhere else the stream is left stale.
+ */
+static int insertText(const char *text)
+{
+    int  length= (int)strlen(text);
+    bool atEnd= (ctx->cursor==ctx->exprIndex);
+
+    // Room for the longest unit (a four-letter function name) is always kept
+    if(ctx->exprIndex >= (MAX_EXPR_LEN - 4)) {
+        if(!atEnd) {
+            return -1; // No space
+        }
+        // Typing on at the end: the stream carries the expression, the text only its tail
+        if(!streamCurrent()) {
+            streamResync();
+        }
+        dropOldest(length);
+    }
+    if(ctx->history!=NULL && !atEnd){
+        partialFold();
+        partialRollback(unitsBefore(ctx->cursor));
+    }
+
+    moveGap(ctx->cursor);
+    memcpy(&ctx->expressionBuffer[ctx->gapStart], text, length);
+    ctx->gapStart+= length;
+    ctx->exprIndex+= length;
+    ctx->cursor+= length;
+
+    if(atEnd && ctx->streamLive) {
+        streamUnit(text);
+    }
+    else {
+        ctx->streamLive= false;
+    }
+    partialFold();
+    return 0;
 }
 
 /**
@@ -35,55 +162,80 @@ static double degToRad(double deg)
  */
 void Calc_Init(void)
 {
-    memset(expressionBuffer, 0, sizeof(expressionBuffer));
-    exprIndex=0;
-    errorFlag=false;
+    memset(ctx->expressionBuffer, 0, sizeof(ctx->expressionBuffer));
+    ctx->exprIndex=0;
+    ctx->gapStart=0;
+    ctx->cursor=0;
+    ctx->errorFlag=false;
+    partialReset(&ctx->partial);
+    streamRestart();
 }
 
 /**
  * @brief Function to insert into the expression buffer
- *        Expand 's','c','t' => "sin","cos","tan". If '?' => ignore. Otherwise store char. 
+ *        Function keys expand to the function name ('s' => "sin"). If '?' => ignore. Otherwise store char. 
  *        Return -1 if near full. Return 0 if success.
  */
 int Calc_AddChar(char inputChar)
 {
+    TRACE(TRACE_ADDCHAR, inputChar);
     if(inputChar == '?') {
         // Ignore placeholders
         return 0;
     }
 
-    // Check if adding three characters would exceed buffer
-    if(exprIndex >= (MAX_EXPR_LEN - 4)) {
-        return -1; // No space
+    // Expand function keys to their name, e.g. 's' to "sin", 'r' to "sqrt"
+    int func = Func_FromKey(inputChar);
+    if(func >= 0) {
+        return insertText(Func_Get((FuncId)func)->name);
     }
 
-    // Expand 's' to "sin", 'c' to "cos", 't' to "tan"
-    const char *expansion = NULL;
-    
-    if(inputChar == 's') {
-        expansion = "sin";
-    } 
-    else if(inputChar == 'c') {
-        expansion = "cos";
-    } 
-    else if(inputChar == 't') {
-        expansion = "tan";
-    }
+    // For normal characters, insert directly
+    char text[2] = {inputChar, '\0'};
+    return insertText(text);
+}
 
-    if(expansion) {
-        // Append each character of the expansion
-        for(int i = 0; expansion[i] != '\0'; i++) {
-            expressionBuffer[exprIndex++] = expansion[i];
-        }
-        expressionBuffer[exprIndex] = '\0'; // Null-terminate the string
+/**
+ * @brief Inserts the name of a variable so it shows on the LCD and tokenises to its slot
+ */
+int Calc_AddVariable(CalcVariable var)
+{
+    if(var<0 || var>=CALC_VAR_COUNT) {
         return 0;
     }
+    return insertText(variableNames[var]);
+}
 
-    // For normal characters, add to buffer directly
-    expressionBuffer[exprIndex++] = inputChar;
-    expressionBuffer[exprIndex] = '\0';
+void Calc_StoreVariable(CalcVariable var, double value)
+{
+    if(var<0 || var>=CALC_VAR_ANS) {
+        return; // Ans (and out of range) is read-only
+    }
+    variables[var] = value;
+    variablesChanged();
+}
 
-    return 0;
+double Calc_RecallVariable(CalcVariable var)
+{
+    if(var == CALC_VAR_ANS) {
+        return ctx->hasLastResult ? ctx->lastResult : 0.0;
+    }
+    if(var<0 || var>=CALC_VAR_COUNT) {
+        return 0.0;
+    }
+    return variables[var];
+}
+
+void Calc_MemoryAdd(double delta)
+{
+    variables[CALC_VAR_M] += delta;
+    variablesChanged();
+}
+
+void Calc_MemoryClear(void)
+{
+    variables[CALC_VAR_M] = 0.0;
+    variablesChanged();
 }
 
 /**
@@ -91,263 +243,1591 @@ int Calc_AddChar(char inputChar)
  */
 void Calc_ClearExpression(void)
 {
-    memset(expressionBuffer,0,sizeof(expressionBuffer));
-    exprIndex=0;
-    errorFlag=false;
+    memset(ctx->expressionBuffer,0,sizeof(ctx->expressionBuffer));
+    ctx->exprIndex=0;
+    ctx->gapStart=0;
+    ctx->cursor=0;
+    ctx->errorFlag=false;
+    partialReset(&ctx->partial);
+    streamRestart();
 }
 
-static double parseAndEvaluate(void);
+static double evaluateText(void);
 
 /**
  * @brief Evaluate the expression. 
  *        If empty => return last result (or 0)
- *        If first char is operator & we have lastResult => prepend lastResult
+ *        If first char is operator & we have lastResult => continue from an Ans token
  */
 
 double Calc_Evaluate(void)
 {
-    errorFlag=false;
+    ctx->errorFlag=false;
+
+    // The cursor goes to the end as after typing the last key. The text is streamed where it
+    // lies, either side of the gap
+    ctx->cursor=ctx->exprIndex;
 
-    if(exprIndex==0){
+    if(ctx->exprIndex==0){
         // no typed expression
-        return hasLastResult ? lastResult : 0.0;
+        return ctx->hasLastResult ? ctx->lastResult : 0.0;
     }
 
-    // If the first character is an operator, then use the previous answer at the start of the expression
-    {
-    char c = expressionBuffer[0];  // Get the first character of the expression
+    // Ans is about to change, so the preview restarts
+    partialReset(&ctx->partial);
+
+    double val= evaluateText();
+    if(!ctx->errorFlag){
+        ctx->lastResult   = val;
+        ctx->hasLastResult= true;
+        ctx->lastInteger  = integerResult;
+        ctx->lastIsInteger= resultIsInteger;
+        variablesVersion++;  // Ans
+        return val;
+    }
+    return 0.0;
+}
+
+double Calc_EvaluateInput(void)
+{
+    double    lastResult   = ctx->lastResult;
+    bool      hasLastResult= ctx->hasLastResult;
+    long long lastInteger  = ctx->lastInteger;
+    bool      lastIsInteger= ctx->lastIsInteger;
+
+    double value= Calc_Evaluate();
+    ctx->lastResult   = lastResult;
+    ctx->hasLastResult= hasLastResult;
+    ctx->lastInteger  = lastInteger;
+    ctx->lastIsInteger= lastIsInteger;
+    variablesChanged();  // The preview may have folded the input's result in as Ans
+    return value;
+}
 
-    // Check if the first character is an operator and if we have a previous result
-    if ((c == '+' || c == '-' || c == '*' || c == '/' || c == '^') && hasLastResult) {
-        
-        char temp[128];  // Temporary buffer to construct the new expression
-        
-        // Create a new expression by appending the last result, the operator, and the rest of the expression
-        sprintf(temp, "%.6f", lastResult);  // Convert lastResult to a string with 6 decimal places
-        temp[strlen(temp)] = c;             // Append the operator
-        temp[strlen(temp) + 1] = '\0';      // Null-terminate after the operator
+int Calc_HadError(void)
+{
+    return (ctx->errorFlag? 1:0);
+}
 
-        // Append the rest of the expression, skipping the first character (the operator)
-        strcat(temp, &expressionBuffer[1]); 
+const char* Calc_GetExpression(void)
+{
+    moveGap(ctx->exprIndex);
+    return ctx->expressionBuffer;
+}
 
-        // Copy the new expression back to the main buffer
-        strncpy(expressionBuffer, temp, sizeof(expressionBuffer) - 1);
-        expressionBuffer[sizeof(expressionBuffer) - 1] = '\0';  // Ensure null termination
+int Calc_GetCursor(void)
+{
+    return ctx->cursor;
+}
 
-        // Update the expression index to reflect the new length
-        exprIndex = (int)strlen(expressionBuffer);
+int Calc_CopyExpression(char *out, int first, int count)
+{
+    int n= 0;
+    for(int i= first; i < ctx->exprIndex && n < count; i++){
+        out[n++]= *textAt(i);
     }
+    out[n]= '\0';
+    return n;
 }
 
-    double val= parseAndEvaluate();
-    if(!errorFlag){
-        lastResult   = val;
-        hasLastResult= true;
-        return val;
+//////////////////// Independent contexts ////////////////////
+
+/// Each CalcCtx_* call makes c the active context for its duration. Everything runs from the main
+/// loop (never from an interrupt), so this cannot interleave with a keypad-side Calc_* call.
+
+void CalcCtx_Init(CalcContext *c)
+{
+    memset(c, 0, sizeof(*c));
+}
+
+int CalcCtx_SetExpression(CalcContext *c, const char *text)
+{
+    size_t length = strlen(text);
+    if(length >= MAX_EXPR_LEN) {
+        c->errorFlag = true;
+        return -1;
     }
-    return 0.0;
+    memset(c->expressionBuffer, 0, sizeof(c->expressionBuffer));
+    memcpy(c->expressionBuffer, text, length);
+    c->exprIndex = (int)length;
+    c->gapStart = (int)length;
+    c->cursor = (int)length;
+    c->errorFlag = false;
+    c->streamLive = false;  // Streamed by the next evaluation
+    c->truncated = false;
+    partialReset(&c->partial);
+    return 0;
 }
 
-int Calc_HadError(void)
+double CalcCtx_Evaluate(CalcContext *c)
 {
-    return (errorFlag? 1:0);
+    CalcContext *saved = ctx;
+    ctx = c;
+    double value = Calc_Evaluate();
+    ctx = saved;
+    return value;
 }
 
-const char* Calc_GetExpression(void)
+int CalcCtx_HadError(const CalcContext *c)
+{
+    return (c->errorFlag? 1:0);
+}
+
+void CalcCtx_FormatLastResult(CalcContext *c, char *out)
 {
-    return expressionBuffer;
+    CalcContext *saved = ctx;
+    ctx = c;
+    Calc_FormatLastResult(out);
+    ctx = saved;
 }
 
 //////////////////// Implementation Part ////////////////////
 
-/// The expression buffer is parsed as tokens, multiple passes are completed to handle BODMAS for ^, * /, + -.
+/// Expressions are streamed: characters are lexed into tokens, and each token is folded into an
+/// operator stack and a value stack straight away (shunting-yard), using the BODMAS order ^, *, /, +, -
+/// (each its own level, left to right, matching the original multi-pass evaluator). Binary operators
+/// only wait while they bind more tightly than the one before, so at most one per level is pending
+/// and the stacks are as deep as the functions nest, however long the expression is.
+///
+/// The fold either evaluates as it goes or emits the postfix program (Calc_Compile), which is run on
+/// a small value stack, CALC_BATCH values of X at a time.
 
 typedef enum {
     TOKEN_NUMBER,
     TOKEN_OPERATOR,  // + - * / ^
-    TOKEN_TRIG
+    TOKEN_FUNCTION,  // Registry function (sin, sqrt, ...), applied to the operand that follows
+    TOKEN_VARIABLE   // Slot index into variables[]
 } TokenType;
 
 typedef struct {
     TokenType type;
     double    numberVal;
-    char      opChar;  
-    char      trigString[16];
+    long long intVal;    // Exact value of an integer literal
+    bool      isInt;     // The literal is a plain integer that fits in 63 bits
+#ifdef CALC_FIXED
+    CalcFixed fixVal;    // Q32.32 value of the literal
+    bool      fixOk;     // The literal fits Q32.32
+#endif
+    char      opChar;
+    int       slot;      // CalcVariable, or FuncId for TOKEN_FUNCTION
 } CalcToken;
 
-static CalcToken tokens[32];
-static int       tokenCount=0;
+/// What a stream's fold does with each token
+typedef enum {
+    STREAM_HASH,      // Only hashes the tokens, for a cache lookup before evaluating
+    STREAM_EVALUATE,  // Folds values as it goes
+    STREAM_COMPILE    // Emits postfix into CalcStream.program
+} StreamMode;
+
+/// CalcStream.backends: evaluations still able to give the result. The integer one is exact and
+/// wins if it lasts to the end, then fixed point (CALC_FIXED), then double, which always lasts
+#define BACKEND_INT     0x01
+#define BACKEND_FIXED   0x02
+#define BACKEND_DOUBLE  0x04
+
+/**
+ * @brief Stream used by Calc_Evaluate and Calc_Compile, the text is fed to it from the gap buffer.
+ *        Calc_Evaluate and Calc_Preview also finish copies of the context's stream here.
+ */
+static CalcStream textStream;
+
+/**
+ * @brief Value stack for runProgram, one row per depth, one column per X in the batch.
+ *        With one precedence level per operator the stack never holds more than 6 values.
+ */
+static double batchStack[CALC_MAX_DEPTH][CALC_BATCH];
+
+/**
+ * @brief Results of recent expressions, keyed on the token stream with numbers and variables
+ *        replaced by their values. "2.50+1" and "2.5+1" share an entry, and an expression using
+ *        Ans or a variable only hits while that value is unchanged, so no explicit invalidation is needed.
+ *        Open addressing with linear probing; entries are never removed, only overwritten.
+ */
+#define CALC_CACHE_SIZE   16  // Power of two
+#define CALC_CACHE_PROBES 4
+
+typedef struct {
+    unsigned long long key;         // 64-bit FNV-1a of the normalised tokens
+    unsigned long      tokenCount;  // Second check against hash collisions
+    bool               used;
+    bool               error;
+    bool               isInteger;
+    double             value;
+    long long          intValue;
+} CacheEntry;
+
+static CacheEntry     cache[CALC_CACHE_SIZE];
+static CalcCacheStats cacheStats;
 
-static int tokeniseExpression(void);
-static double processTokens(void);
+static void runProgram(const CalcProgram *prog, const double *x, double *out, int n);
+static int  precedence(unsigned char opcode);
+static const CacheEntry*  cacheLookup(unsigned long long key, unsigned long tokenCount);
+static void               cacheStore(unsigned long long key, unsigned long tokenCount, double value);
+static void streamChar(CalcStream *s, char c);
 
 /**
- * @brief parseAndEvaluate => tokenise, process => final
+ * @brief FNV-1a over the tokens, with numbers and variables as the bits of their current value
  */
-static double parseAndEvaluate(void)
+static unsigned long long hashBytes(unsigned long long hash, const void *data, int length)
 {
-    tokenCount=0;
-    if(tokeniseExpression()<0){
-        errorFlag=true;
-        return 0.0;
+    const unsigned char *p= (const unsigned char *)data;
+    for(int i=0; i<length; i++){
+        hash^= p[i];
+        hash*= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static void hashToken(CalcStream *s, const CalcToken *t)
+{
+    unsigned char type= (unsigned char)t->type;
+    s->hash= hashBytes(s->hash, &type, 1);
+    switch(t->type){
+        case TOKEN_NUMBER:
+            // Both: doubles above 2^53 can be equal where the exact integers are not
+            s->hash= hashBytes(s->hash, &t->numberVal, sizeof(t->numberVal));
+            s->hash= hashBytes(s->hash, &t->intVal, sizeof(t->intVal));
+            break;
+        case TOKEN_VARIABLE: {
+            double value= Calc_RecallVariable((CalcVariable)t->slot);  // Ans is not in variables[]
+            s->hash= hashBytes(s->hash, &value, sizeof(value));
+            break;
+        }
+        case TOKEN_OPERATOR:
+            s->hash= hashBytes(s->hash, &t->opChar, 1);
+            break;
+        case TOKEN_FUNCTION:
+            s->hash= hashBytes(s->hash, &t->slot, sizeof(t->slot));
+            break;
     }
-    double finalVal= processTokens();
-    return finalVal;
 }
 
 /**
- * @brief Evaluate e.g. "sin30" => sin(30 deg).
+ * @brief Appends one postfix instruction to the program being compiled
  */
-static double evaluateTrig(const char* trigStr)
+static void emit(CalcStream *s, unsigned char opcode, unsigned char slot, const CalcToken *constant)
 {
-    
-    char func[4];
-    strncpy(func, trigStr,3);
-    func[3]='\0';
-
-    double angleDeg= atof(&trigStr[3]);
-    double rad= degToRad(angleDeg);
+    CalcProgram *prog= s->program;
 
-    if(strcmp(func,"sin")==0) return sin(rad);
-    if(strcmp(func,"cos")==0) return cos(rad);
-    if(strcmp(func,"tan")==0) return tan(rad);
-    errorFlag=true;
-    return 0.0;
+    if(prog->length >= MAX_TOKENS){
+        s->failed= true;  // Longer than a program can hold
+        return;
+    }
+    CalcInstr *ins= &prog->code[prog->length++];
+    ins->opcode= opcode;
+    ins->slot= slot;
+    ins->value= (constant!=NULL) ? constant->numberVal : 0.0;
+    ins->intValue= (constant!=NULL) ? constant->intVal : 0;
+#ifdef CALC_FIXED
+    ins->fixValue= (constant!=NULL) ? constant->fixVal : 0;
+#endif
 }
 
 /**
- * @brief Tokenise the expressionBuffer and populate the tokens array
+ * @brief Pops the top operator and applies it in every backend still running (or emits it)
  */
-static int tokeniseExpression(void)
+static void streamReduce(CalcStream *s)
 {
-    const char *currentChar = expressionBuffer;
-    tokenCount = 0;
+    unsigned char op= s->ops[--s->opTop];
+    unsigned char slot= s->opSlot[s->opTop];
+    int b= s->valueTop - 1;  // Right operand, or the function argument
+    int a= b - 1;
 
-    while (*currentChar != '\0') {
+    if(op!=CALC_OP_FUNC){
+        s->valueTop--;
+    }
+    if(s->mode==STREAM_COMPILE){
+        emit(s, op, slot, NULL);
+        return;
+    }
 
-        // Handle operator (+, -, *, /, ^)
-        if (strchr("+-*/^", *currentChar)) {
-            tokens[tokenCount].type = TOKEN_OPERATOR;
-            tokens[tokenCount].opChar = *currentChar;
-            tokenCount++;
-            currentChar++;
+    if(s->backends & BACKEND_DOUBLE){
+        double *v= s->values;
+        switch(op){
+            case CALC_OP_FUNC:
+                PERF_BEGIN(PERF_FUNCTION);
+                v[b]= Func_Apply((FuncId)slot, v[b]);
+                PERF_END(PERF_FUNCTION);
+                break;
+            case CALC_OP_ADD: v[a]= v[a] + v[b]; break;
+            case CALC_OP_SUB: v[a]= v[a] - v[b]; break;
+            case CALC_OP_MUL: v[a]= v[a] * v[b]; break;
+            case CALC_OP_DIV: v[a]= (v[b]!=0.0) ? v[a] / v[b] : NAN; break;
+            default:          v[a]= Calc_Power(v[a], v[b]); break;
         }
-        // Handle trigonometric functions (sin, cos, tan)
-        else if (strncmp(currentChar, "sin", 3) == 0 || 
-                 strncmp(currentChar, "cos", 3) == 0 || 
-                 strncmp(currentChar, "tan", 3) == 0) {
+    }
 
-            char trigBuffer[16] = {0};  // Buffer for trigonometric function
-            int i = 0;
+    if(s->backends & BACKEND_INT){
+        // Only + - * ^ reach here. Overflow or a negative exponent leaves it to the other backends
+        long long *v= s->intValues;
+        long long  x= v[a], y= v[b], r= 1;
+        bool       overflow;
+        switch(op){
+            case CALC_OP_ADD: overflow= __builtin_add_overflow(x, y, &r); break;
+            case CALC_OP_SUB: overflow= __builtin_sub_overflow(x, y, &r); break;
+            case CALC_OP_MUL: overflow= __builtin_mul_overflow(x, y, &r); break;
+            default:
+                // Exponentiation by squaring, checking every multiply
+                overflow= (y < 0);
+                while(!overflow && y > 0){
+                    overflow= (y & 1) && __builtin_mul_overflow(r, x, &r);
+                    y>>= 1;
+                    overflow= overflow || (y > 0 && __builtin_mul_overflow(x, x, &x));
+                }
+                break;
+        }
+        v[a]= r;
+        if(overflow){
+            s->backends&= (unsigned char)~BACKEND_INT;
+        }
+    }
 
-            while (*currentChar && !isspace((unsigned char)*currentChar) && 
-                   !strchr("+-*/^", *currentChar) && i < sizeof(trigBuffer) - 1) {
-                trigBuffer[i++] = *currentChar++;
+#ifdef CALC_FIXED
+    if(s->backends & BACKEND_FIXED){
+        CalcFixed     *v= s->fixValues;
+        unsigned long *e= s->fixErrors;
+        FixStatus      status= FIX_OK;
+        CalcFixed      x= v[b];
+        if(op==CALC_OP_FUNC){
+            v[b]= Fix_Apply(slot, x, &status);
+            e[b]= Fix_ApplyError(slot, x, e[b], v[b]);
+        }
+        else{
+            CalcFixed left= v[a];
+            switch(op){
+                case CALC_OP_ADD: v[a]= Fix_Add(left, x, &status); break;
+                case CALC_OP_SUB: v[a]= Fix_Sub(left, x, &status); break;
+                case CALC_OP_MUL: v[a]= Fix_Mul(left, x, &status); break;
+                case CALC_OP_DIV: v[a]= Fix_Div(left, x, &status); break;
+                default:          v[a]= Fix_Pow(left, x, &status); break;
+            }
+            if(status==FIX_OK){
+                e[a]= Fix_OpError("+-*/^"[op - CALC_OP_ADD], left, e[a], x, e[b], v[a]);
             }
-            trigBuffer[i] = '\0';
+        }
+        if(status==FIX_OK && e[(op==CALC_OP_FUNC) ? b : a] > FIX_ERROR_SHOWN){
+            status= FIX_RANGE;  // Could differ from double in the digits shown, so double gives it
+        }
+        if(status!=FIX_OK){
+            // Out of range goes on to double; a domain error is the result if fixed point is chosen
+            s->fixStatus= (unsigned char)status;
+            s->backends&= (unsigned char)~BACKEND_FIXED;
+        }
+    }
+#endif
+}
 
-            tokens[tokenCount].type = TOKEN_TRIG;
-            strncpy(tokens[tokenCount].trigString, trigBuffer, sizeof(tokens[tokenCount].trigString) - 1);
-            tokenCount++;
+/**
+ * @brief Notes that the stream has folded in the current value of a variable or Ans
+ */
+static void streamReads(CalcStream *s)
+{
+    if(!s->readsVariables){
+        s->readsVariables= true;
+        s->variableVersion= variablesVersion;
+    }
+}
+
+/**
+ * @brief Folds one complete token
+ */
+static void streamToken(CalcStream *s, const CalcToken *tok)
+{
+    if(s->failed){
+        return;
+    }
+
+    // A leading operator continues from the previous answer, which goes in front as a token
+    if(s->tokenCount==0 && tok->type==TOKEN_OPERATOR && s->continueAns){
+        CalcToken ans;
+        memset(&ans, 0, sizeof(ans));
+        s->continueAns= false;
+        if(s->mode==STREAM_COMPILE){
+            // A chained step (Calc_CompileStep): the instructions before it leave the value on the stack
+            s->valueTop++;
+            s->expectOperand= false;
+            s->tokenCount++;
+        }
+        else if(ctx->lastIsInteger){
+            // Exact binary value, and an integer constant so a chain of integer steps stays exact
+            streamReads(s);
+            ans.type= TOKEN_NUMBER;
+            ans.numberVal= ctx->lastResult;
+            ans.intVal= ctx->lastInteger;
+            ans.isInt= true;
+#ifdef CALC_FIXED
+            FixStatus fixStatus= FIX_OK;
+            ans.fixVal= Fix_FromInt(ctx->lastInteger, &fixStatus);
+            ans.fixOk= (fixStatus==FIX_OK);
+#endif
+        }
+        else{
+            ans.type= TOKEN_VARIABLE;
+            ans.slot= CALC_VAR_ANS;
         }
-        // Handle numbers (including decimals and negatives)
-        else if (isdigit((unsigned char)*currentChar) || *currentChar == '.' || 
-                (*currentChar == '-' && isdigit((unsigned char)*(currentChar + 1)))) {
+        if(s->mode!=STREAM_COMPILE){
+            streamToken(s, &ans);
+        }
+    }
+    s->tokenCount++;
 
-            char numBuffer[32] = {0};  // Buffer for numbers
-            int j = 0;
+    // Which backends the expression still suits
+    if((tok->type==TOKEN_NUMBER && !tok->isInt) || tok->type==TOKEN_VARIABLE ||
+       tok->type==TOKEN_FUNCTION || (tok->type==TOKEN_OPERATOR && tok->opChar=='/')){
+        s->integerOnly= false;
+        s->backends&= (unsigned char)~BACKEND_INT;
+    }
+#ifdef CALC_FIXED
+    if(tok->type==TOKEN_NUMBER && !tok->fixOk){
+        s->fixedLiterals= false;
+        s->backends&= (unsigned char)~BACKEND_FIXED;
+    }
+#endif
+
+    if(tok->type==TOKEN_VARIABLE){
+        streamReads(s);
+    }
+    if(s->mode!=STREAM_COMPILE){
+        hashToken(s, tok);  // An evaluating stream keeps the cache key too
+    }
+    if(s->mode==STREAM_HASH){
+        return;
+    }
 
-            if (*currentChar == '-') {
-                numBuffer[j++] = *currentChar++;
+    switch(tok->type){
+        case TOKEN_NUMBER:
+        case TOKEN_VARIABLE: {
+            if(!s->expectOperand || s->valueTop>=CALC_MAX_DEPTH){
+                s->failed= true;  // Two operands in a row
+                return;
+            }
+            int v= s->valueTop++;
+            if(s->mode==STREAM_COMPILE){
+                if(tok->type==TOKEN_NUMBER) emit(s, CALC_OP_CONST, 0, tok);
+                else                        emit(s, CALC_OP_VAR, (unsigned char)tok->slot, NULL);
             }
+            else if(tok->type==TOKEN_NUMBER){
+                s->values[v]= tok->numberVal;
+                s->intValues[v]= tok->intVal;
+#ifdef CALC_FIXED
+                s->fixValues[v]= tok->fixVal;
+                s->fixErrors[v]= Fix_RoundingError(tok->fixVal);
+#endif
+            }
+            else{
+                s->values[v]= Calc_RecallVariable((CalcVariable)tok->slot);
+#ifdef CALC_FIXED
+                if(s->backends & BACKEND_FIXED){
+                    FixStatus status= FIX_OK;
+                    s->fixValues[v]= Fix_FromDouble(s->values[v], &status);
+                    s->fixErrors[v]= Fix_RoundingError(s->fixValues[v]);
+                    if(status!=FIX_OK){
+                        s->fixStatus= (unsigned char)status;
+                        s->backends&= (unsigned char)~BACKEND_FIXED;
+                    }
+                }
+#endif
+            }
+            // Apply any functions waiting for this operand
+            while(s->opTop>0 && s->ops[s->opTop-1]==CALC_OP_FUNC){
+                streamReduce(s);
+            }
+            s->expectOperand= false;
+            break;
+        }
 
-            while (*currentChar && !isspace((unsigned char)*currentChar) && 
-                   !strchr("+-*/^", *currentChar) && j < sizeof(numBuffer) - 1) {
-                numBuffer[j++] = *currentChar++;
+        case TOKEN_FUNCTION:
+            if(!s->expectOperand || s->opTop>=CALC_MAX_NESTING){
+                s->failed= true;
+                return;
             }
-            numBuffer[j] = '\0';
+            s->opSlot[s->opTop]= (unsigned char)tok->slot;
+            s->ops[s->opTop++]= CALC_OP_FUNC;
+            break;
 
-            tokens[tokenCount].type = TOKEN_NUMBER;
-            tokens[tokenCount].numberVal = atof(numBuffer);
-            tokenCount++;
+        case TOKEN_OPERATOR: {
+            if(s->expectOperand){
+                s->failed= true;  // Operator with no left operand
+                return;
+            }
+            unsigned char op= (tok->opChar=='+') ? CALC_OP_ADD :
+                              (tok->opChar=='-') ? CALC_OP_SUB :
+                              (tok->opChar=='*') ? CALC_OP_MUL :
+                              (tok->opChar=='/') ? CALC_OP_DIV :
+                                                   CALC_OP_POW;
+            while(s->opTop>0 && precedence(s->ops[s->opTop-1])>=precedence(op)){
+                streamReduce(s);
+            }
+            if(s->opTop>=CALC_MAX_NESTING){
+                s->failed= true;
+                return;
+            }
+            s->opSlot[s->opTop]= 0;
+            s->ops[s->opTop++]= op;
+            s->expectOperand= true;
+            break;
         }
-        // Handle unrecognised characters
-        else {
-            errorFlag = true;
-            return -1;
+    }
+}
+
+/**
+ * @brief Turns the digits lexed so far into a number token
+ */
+static void finishNumber(CalcStream *s)
+{
+    CalcToken tok;
+
+    if(s->numberLength==0){
+        return;
+    }
+    s->number[s->numberLength]= '\0';
+    s->numberLength= 0;
+
+    memset(&tok, 0, sizeof(tok));
+    tok.type= TOKEN_NUMBER;
+
+    // Exact value if it is a plain integer that fits in 63 bits
+    tok.isInt= true;
+    for(int k = 0; s->number[k] != '\0' && tok.isInt; k++){
+        if(!isdigit((unsigned char)s->number[k]) ||
+           __builtin_mul_overflow(tok.intVal, 10, &tok.intVal) ||
+           __builtin_add_overflow(tok.intVal, s->number[k] - '0', &tok.intVal)){
+            tok.isInt= false;
         }
     }
+    // Converting the exact integer rounds the same as parsing the text, without the atof
+    if(tok.isInt){
+        tok.numberVal= (double)tok.intVal;
+    }
+    else{
+        tok.numberVal= atof(s->number);
+        tok.intVal= 0;
+    }
+#ifdef CALC_FIXED
+    FixStatus fixStatus= FIX_OK;
+    tok.fixVal= Fix_FromString(s->number, &fixStatus);
+    tok.fixOk= (fixStatus==FIX_OK);
+#endif
+    streamToken(s, &tok);
+}
 
-    return 0;  // Successful tokenisation
+/**
+ * @brief Compares the letters lexed so far with every function name in one pass. Returns the
+ *        function they spell exactly, else -1, with prefix set while they could still grow into one
+ */
+static int matchName(const CalcStream *s, bool *prefix)
+{
+    int func= -1;
+
+    *prefix= false;
+    for(int i=0; i<FUNC_COUNT; i++){
+        const char *name= Func_Get((FuncId)i)->name;
+        if(name[0]==s->name[0] && strncmp(name, s->name, s->nameLength)==0){
+            if(name[s->nameLength]=='\0') func= i;
+            else                          *prefix= true;
+        }
+    }
+    return func;
+}
+
+/**
+ * @brief Letters that can no longer grow into a name: the first is a variable, the rest are lexed again
+ */
+static void finishName(CalcStream *s)
+{
+    char c= s->name[0];
+    char rest[sizeof(s->name)];
+    int  restLength= s->nameLength - 1;
+    CalcToken tok;
+
+    if(s->nameLength==0){
+        return;
+    }
+    memcpy(rest, &s->name[1], restLength);
+    s->nameLength= 0;
+
+    if(!((c>='A' && c<='F') || c=='X' || c=='M')){
+        s->failed= true;  // Not a function, Ans or a variable
+        return;
+    }
+    memset(&tok, 0, sizeof(tok));
+    tok.type= TOKEN_VARIABLE;
+    tok.slot= (c=='X') ? CALC_VAR_X :
+              (c=='M') ? CALC_VAR_M :
+                         CALC_VAR_A + (c - 'A');
+    streamToken(s, &tok);
+
+    for(int i=0; i<restLength; i++){
+        streamChar(s, rest[i]);
+    }
+}
+
+/**
+ * @brief Lexes one character. Numbers and names are collected until a character ends them, so
+ *        "asin" is never read as 'a' + "sin" and "An" + 's' still becomes Ans
+ */
+static void streamChar(CalcStream *s, char c)
+{
+    if(isdigit((unsigned char)c) || c=='.'){
+        finishName(s);
+        if(s->numberLength >= CALC_NUMBER_MAX - 1){
+            finishNumber(s);  // A literal this long ends, and the next one makes two operands in a row
+        }
+        s->number[s->numberLength++]= c;
+        return;
+    }
+    finishNumber(s);
+
+    if(isalpha((unsigned char)c)){
+        CalcToken tok;
+        bool      prefix;
+        s->name[s->nameLength++]= c;
+        s->name[s->nameLength]= '\0';
+
+        memset(&tok, 0, sizeof(tok));
+        if((tok.slot= matchName(s, &prefix))>=0){
+            tok.type= TOKEN_FUNCTION;
+        }
+        else if(strcmp(s->name, "Ans")==0){
+            tok.type= TOKEN_VARIABLE;
+            tok.slot= CALC_VAR_ANS;
+        }
+        else{
+            if(!prefix && strncmp("Ans", s->name, s->nameLength)!=0){
+                finishName(s);
+            }
+            return;
+        }
+        s->nameLength= 0;
+        streamToken(s, &tok);
+        return;
+    }
+    finishName(s);
+
+    if(strchr("+-*/^", c)!=NULL && c!='\0'){
+        CalcToken tok;
+        memset(&tok, 0, sizeof(tok));
+        tok.type= TOKEN_OPERATOR;
+        tok.opChar= c;
+        streamToken(s, &tok);
+        return;
+    }
+    s->failed= true;  // Unrecognised character
+}
+
+static void streamBegin(CalcStream *s, StreamMode mode, unsigned char backends)
+{
+    s->context= ctx;
+    s->program= NULL;
+    s->mode= (unsigned char)mode;
+    s->backends= backends;
+    s->numberLength= 0;
+    s->nameLength= 0;
+    s->opTop= 0;
+    s->valueTop= 0;
+#ifdef CALC_FIXED
+    s->fixStatus= FIX_OK;
+    s->fixedLiterals= true;
+#endif
+    s->integerOnly= true;
+    s->continueAns= (mode!=STREAM_COMPILE) && ctx->hasLastResult;
+    s->expectOperand= true;
+    s->failed= false;
+    s->readsVariables= false;
+    s->variableVersion= 0;
+    s->tokenCount= 0;
+    s->hash= 0xCBF29CE484222325ULL;
+}
+
+/**
+ * @brief Cache key of a stream that has read the whole expression. The integer path gives exact
+ *        results, so "2*3" and "2.0*3" must not share an entry
+ */
+static unsigned long long streamKey(const CalcStream *s)
+{
+    return hashBytes(s->hash, &s->integerOnly, sizeof(s->integerOnly));
+}
+
+/**
+ * @brief Ends the last token and applies every operator still waiting. Returns false if the
+ *        expression is incomplete or invalid
+ */
+static bool streamEnd(CalcStream *s)
+{
+    finishNumber(s);
+    finishName(s);
+    if(s->mode==STREAM_HASH){
+        return !s->failed;
+    }
+    if(s->failed || s->expectOperand){
+        return false;  // Empty, trailing operator or function with no angle
+    }
+    while(s->opTop>0 && !s->failed){
+        streamReduce(s);
+    }
+    return !s->failed;
 }
 
 /**
- * @brief Multi-pass token processing
+ * @brief The result of an evaluating stream, in the old path order: exact integer, then fixed point,
+ *        then double. Returns false if none of the backends it ran can give it (the caller runs the next).
+ *        Sets the error flag and integerResult / resultIsInteger.
  */
-static double processTokens(void)
+static bool streamResult(CalcStream *s, double *value)
 {
-    // Evaluate trigonometric functions and replace them with numerical values
-    for (int i = 0; i < tokenCount; i++) {
-        if (tokens[i].type == TOKEN_TRIG) {
-            tokens[i].numberVal = evaluateTrig(tokens[i].trigString);
-            tokens[i].type = TOKEN_NUMBER;
+    bool complete= streamEnd(s);
+
+    *value= 0.0;
+    resultIsInteger= false;
+    if(!complete){
+        ctx->errorFlag= true;
+        return true;
+    }
+    if(s->backends & BACKEND_INT){
+        // Exact; the double copy is only for callers that want a double
+        resultIsInteger= true;
+        integerResult= s->intValues[0];
+        *value= (double)integerResult;
+        return true;
+    }
+#ifdef CALC_FIXED
+    if(s->fixedLiterals && s->fixStatus!=FIX_RANGE && ((s->backends & BACKEND_FIXED) || s->fixStatus==FIX_DOMAIN)){
+        // Q32.32 result or a domain error. Only a value outside +-2^31 goes on to double
+        if(s->fixStatus==FIX_DOMAIN){
+            ctx->errorFlag= true;
         }
+        else{
+            *value= Fix_ToDouble(s->fixValues[0]);
+        }
+        return true;
+    }
+#endif
+    if(s->backends & BACKEND_DOUBLE){
+        *value= s->values[0];
+        if(!isfinite(*value)){
+            ctx->errorFlag= true;  // Divide by zero, pow domain error or overflow
+            *value= 0.0;
+        }
+        return true;
     }
+    return false;
+}
+
+/**
+ * @brief Feeds the whole expression text, as it lies either side of the gap
+ */
+static void streamText(CalcStream *s)
+{
+    for(int i=0; i<ctx->exprIndex; i++){
+        streamChar(s, *textAt(i));
+    }
+}
+
+//////////////////// The context's stream ////////////////////
 
-    double numbers[32];
-    char operators[32];
-    int numCount = 0, opCount = 0;
+/// Each unit typed at the end of the text is fed to ctx->stream as it is inserted, so '=' only has
+/// to finish it. An edit anywhere else, a DEL, or a change to a value it has folded in leaves it
+/// stale, and the next evaluation streams the text into it again.
 
-    // Separate tokens into numbers and operators
-    for (int i = 0; i < tokenCount; i++) {
-        if (tokens[i].type == TOKEN_NUMBER) {
-            numbers[numCount++] = tokens[i].numberVal;
-        } else if (tokens[i].type == TOKEN_OPERATOR) {
-            operators[opCount++] = tokens[i].opChar;
-        } else {
-            errorFlag = true;
+static void streamRestart(void)
+{
+    streamBegin(&ctx->stream, STREAM_EVALUATE, BACKEND_INT | BACKEND_FIXED | BACKEND_DOUBLE);
+    ctx->streamLive= true;
+    ctx->truncated= false;
+}
+
+/**
+ * @brief Streams the text into ctx->stream again, making it current. Never needed once truncated
+ */
+static void streamResync(void)
+{
+    streamBegin(&ctx->stream, STREAM_EVALUATE, BACKEND_INT | BACKEND_FIXED | BACKEND_DOUBLE);
+    streamText(&ctx->stream);
+    ctx->streamLive= true;
+}
+
+static void streamUnit(const char *text)
+{
+    CalcStream *s= &ctx->stream;
+
+    if(s->tokenCount==0 && s->numberLength==0 && s->nameLength==0){
+        s->continueAns= ctx->hasLastResult;  // Ans may have arrived since the stream began
+    }
+    while(*text!='\0'){
+        streamChar(s, *text++);
+    }
+}
+
+/**
+ * @brief ctx->stream has read exactly the text, with the values the variables have now.
+ *        A truncated expression keeps the values it was typed with, its start cannot be read again
+ */
+static bool streamCurrent(void)
+{
+    const CalcStream *s= &ctx->stream;
+
+    if(ctx->truncated){
+        return true;
+    }
+    return ctx->streamLive && (!s->readsVariables || s->variableVersion==variablesVersion);
+}
+
+/**
+ * @brief Calc_Evaluate's path. A current stream is finished on a copy, so typing can carry on
+ *        after '='. Otherwise the text is lexed once for the cache key and, on a miss, streamed
+ *        again into ctx->stream with every backend side by side, which makes it current again.
+ */
+static double evaluateText(void)
+{
+    CalcStream *s= &textStream;
+    double      value= 0.0;
+    bool        current= streamCurrent();
+
+    if(current){
+        *s= ctx->stream;
+        finishNumber(s);
+        finishName(s);
+        if(s->failed){
+            streamResult(s, &value);  // The error, nothing to cache
+            return value;
+        }
+    }
+    else{
+        TRACE(TRACE_TOKENISE_BEGIN, 0);
+        PERF_BEGIN(PERF_TOKENISE);
+        streamBegin(s, STREAM_HASH, 0);
+        streamText(s);
+        bool lexed= streamEnd(s);
+        PERF_END(PERF_TOKENISE);
+        TRACE(TRACE_TOKENISE_END, 0);
+        if(!lexed){
+            ctx->errorFlag=true;
             return 0.0;
         }
     }
 
-    // Process operations based on precedence
-    char precedence[] = {'^', '*', '/', '+', '-'};
-    for (int p = 0; p < sizeof(precedence); p++) {
-        for (int i = 0; i < opCount; ) {
-            if (operators[i] == precedence[p]) {
-                if (i >= numCount - 1) {
-                    errorFlag = true;
-                    return 0.0;
+    unsigned long long key= streamKey(s);
+    unsigned long      tokenCount= s->tokenCount;
+    const CacheEntry  *hit= cacheLookup(key, tokenCount);
+    if(hit!=NULL){
+        ctx->errorFlag= hit->error;
+        resultIsInteger= hit->isInteger;
+        integerResult= hit->intValue;
+        return hit->value;
+    }
+
+    TRACE(TRACE_EVALUATE_BEGIN, 0);
+    PERF_BEGIN(PERF_PROCESS);
+    if(!current){
+        streamResync();
+        *s= ctx->stream;
+    }
+    streamResult(s, &value);  // Every backend ran, so this always gives the result
+    PERF_END(PERF_PROCESS);
+    TRACE(TRACE_EVALUATE_END, ctx->errorFlag);
+    cacheStore(key, tokenCount, value);
+    return value;
+}
+
+static const CacheEntry* cacheLookup(unsigned long long key, unsigned long tokenCount)
+{
+    cacheStats.lookups++;
+    for(int i=0; i<CALC_CACHE_PROBES; i++){
+        const CacheEntry *e= &cache[(key + i) & (CALC_CACHE_SIZE - 1)];
+        if(!e->used){
+            return NULL;  // Nothing is ever removed, so the chain ends here
+        }
+        if(e->key==key && e->tokenCount==tokenCount){
+            cacheStats.hits++;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Stores the result just computed: first free slot in the probe window, else the home slot
+ */
+static void cacheStore(unsigned long long key, unsigned long tokenCount, double value)
+{
+    CacheEntry *e= &cache[key & (CALC_CACHE_SIZE - 1)];
+    for(int i=0; i<CALC_CACHE_PROBES; i++){
+        CacheEntry *probe= &cache[(key + i) & (CALC_CACHE_SIZE - 1)];
+        if(!probe->used){
+            e= probe;
+            break;
+        }
+    }
+    e->key= key;
+    e->tokenCount= tokenCount;
+    e->used= true;
+    e->error= ctx->errorFlag;
+    e->isInteger= resultIsInteger;
+    e->value= value;
+    e->intValue= integerResult;
+}
+
+const CalcCacheStats* Calc_GetCacheStats(void)
+{
+    return &cacheStats;
+}
+
+void Calc_CacheClear(void)
+{
+    memset(cache, 0, sizeof(cache));
+    cacheStats.lookups= 0;
+    cacheStats.hits= 0;
+}
+
+int Calc_Compile(CalcProgram *prog)
+{
+    prog->length=0;
+    return Calc_CompileStep(prog);
+}
+
+int Calc_CompileStep(CalcProgram *prog)
+{
+    CalcStream *s= &textStream;
+    int         before= prog->length;
+
+    ctx->errorFlag=false;
+    if(ctx->truncated){
+        ctx->errorFlag=true;  // Only the tail of the expression is left to compile
+        return -1;
+    }
+    streamBegin(s, STREAM_COMPILE, 0);
+    s->program= prog;
+    s->continueAns= (before > 0);  // Cleared by a leading operator, see streamToken
+    streamText(s);
+    if(!streamEnd(s) || s->continueAns){
+        // Invalid, too long, or a later step that does not start with an operator
+        prog->length= before;
+        ctx->errorFlag=true;
+        return -1;
+    }
+    return 0;
+}
+
+//////////////////// Streaming from outside ////////////////////
+
+/// Each call makes the stream's context the active one for its duration, like CalcCtx_*.
+/// All backends run side by side, since the characters cannot be read a second time.
+
+void CalcStream_Begin(CalcStream *s, CalcContext *c)
+{
+    CalcContext *saved= ctx;
+    ctx= c;
+    ctx->errorFlag= false;
+    streamBegin(s, STREAM_EVALUATE, BACKEND_INT | BACKEND_FIXED | BACKEND_DOUBLE);
+    ctx= saved;
+}
+
+int CalcStream_Feed(CalcStream *s, char ch)
+{
+    CalcContext *saved= ctx;
+    ctx= s->context;
+    streamChar(s, ch);
+    ctx= saved;
+    return s->failed ? -1 : 0;
+}
+
+double CalcStream_Finish(CalcStream *s)
+{
+    CalcContext *saved= ctx;
+    double       value;
+
+    ctx= s->context;
+    if(s->tokenCount==0 && s->numberLength==0 && s->nameLength==0 && !s->failed){
+        // Nothing streamed
+        value= ctx->hasLastResult ? ctx->lastResult : 0.0;
+    }
+    else{
+        partialReset(&ctx->partial);  // Ans is about to change
+        streamResult(s, &value);
+        if(!ctx->errorFlag){
+            ctx->lastResult   = value;
+            ctx->hasLastResult= true;
+            ctx->lastInteger  = integerResult;
+            ctx->lastIsInteger= resultIsInteger;
+            variablesVersion++;  // Ans
+        }
+        else{
+            value= 0.0;
+        }
+    }
+    ctx= saved;
+    return value;
+}
+
+void Calc_EvaluateBatch(const CalcProgram *prog, const double *x, double *out, int n)
+{
+    for(int done=0; done<n; done+=CALC_BATCH){
+        int chunk= (n-done < CALC_BATCH) ? n-done : CALC_BATCH;
+        runProgram(prog, &x[done], &out[done], chunk);
+    }
+}
+
+/**
+ * @brief Forward-mode differentiation: every stack entry is a dual number (value, d/dX), X is
+ *        (x, 1) and every other operand has slope 0. One pass gives f(x) and f'(x) exactly
+ *        as the rules combine, with no step size to choose.
+ */
+void Calc_EvaluateDual(const CalcProgram *prog, double x, double *value, double *slope)
+{
+    double v[CALC_MAX_DEPTH];
+    double d[CALC_MAX_DEPTH];
+    int    sp= 0;
+
+    for(int pc=0; pc<prog->length; pc++){
+        const CalcInstr *ins= &prog->code[pc];
+        double av= (sp > 1) ? v[sp-2] : 0.0, ad= (sp > 1) ? d[sp-2] : 0.0;  // Left operand
+        double bv= (sp > 0) ? v[sp-1] : 0.0, bd= (sp > 0) ? d[sp-1] : 0.0;  // Right operand / argument
+        double rv, rd;
+
+        switch(ins->opcode){
+            case CALC_OP_CONST:
+                v[sp]= ins->value;
+                d[sp++]= 0.0;
+                continue;
+            case CALC_OP_VAR:
+                v[sp]= (ins->slot==CALC_VAR_X) ? x : Calc_RecallVariable((CalcVariable)ins->slot);
+                d[sp++]= (ins->slot==CALC_VAR_X) ? 1.0 : 0.0;
+                continue;
+            case CALC_OP_FUNC:
+                rv= Func_Apply((FuncId)ins->slot, bv);
+                v[sp-1]= rv;
+                d[sp-1]= (bd==0.0) ? 0.0 : Func_Slope((FuncId)ins->slot, bv, rv) * bd;
+                continue;
+            case CALC_OP_ADD: rv= av + bv; rd= ad + bd;             break;
+            case CALC_OP_SUB: rv= av - bv; rd= ad - bd;             break;
+            case CALC_OP_MUL: rv= av * bv; rd= ad*bv + av*bd;       break;
+            case CALC_OP_DIV:
+                rv= (bv!=0.0) ? av / bv : NAN;
+                rd= (ad - rv*bd) / bv;
+                break;
+            default:  // CALC_OP_POW
+                rv= Calc_Power(av, bv);
+                if(bd==0.0){
+                    // Constant exponent: b a^(b-1) a', also right for a negative base
+                    rd= (ad==0.0) ? 0.0 : bv * Calc_Power(av, bv - 1.0) * ad;
                 }
-                double result = (operators[i] == '^') ? pow(numbers[i], numbers[i + 1]) :
-                                (operators[i] == '*') ? numbers[i] * numbers[i + 1] :
-                                (operators[i] == '/') ? (numbers[i + 1] != 0 ? numbers[i] / numbers[i + 1] : (errorFlag = true, 0.0)) :
-                                (operators[i] == '+') ? numbers[i] + numbers[i + 1] :
-                                                        numbers[i] - numbers[i + 1];
-
-                if (errorFlag) return 0.0;
-                
-                numbers[i] = result;
-
-                // Shift arrays to remove processed operator and number
-                for (int j = i + 1; j < numCount - 1; j++) {
-                    numbers[j] = numbers[j + 1];
+                else{
+                    rd= rv * (bd*log(av) + bv*ad/av);
                 }
-                for (int j = i; j < opCount - 1; j++) {
-                    operators[j] = operators[j + 1];
+                break;
+        }
+        sp--;
+        v[sp-1]= rv;
+        d[sp-1]= rd;
+    }
+
+    *value= (sp > 0) ? v[0] : NAN;
+    *slope= (sp > 0) ? d[0] : NAN;
+}
+
+void Calc_FormatResult(double value, char *out)
+{
+    PERF_BEGIN(PERF_FORMAT);
+#ifdef CALC_FIXED
+    // Integer formatting whenever the value fits Q32.32, printf only for the rest
+    FixStatus status= FIX_OK;
+    CalcFixed fixed= Fix_FromDouble(value, &status);
+    if(status==FIX_OK){
+        Fix_Format(fixed, out);
+        PERF_END(PERF_FORMAT);
+        return;
+    }
+#endif
+    // Past 15 digits the fixed notation would overrun out (and the LCD): 9 significant digits instead
+    if(fabs(value) >= 1e15){
+        sprintf(out, "%.9g", value);
+        PERF_END(PERF_FORMAT);
+        return;
+    }
+    // Format up to 3 decimals
+    sprintf(out,"%.3f", value);
+    // strip trailing zeros
+    int length= (int)strlen(out);
+    while(length>0 && out[length-1]=='0'){
+        length--;
+        out[length]='\0';
+    }
+    if(length>0 && out[length-1]=='.'){
+        length--;
+        out[length]='\0';
+    }
+    if(strcmp(out, "-0")==0){
+        strcpy(out, "0");  // A negative value that rounds away
+    }
+    PERF_END(PERF_FORMAT);
+}
+
+void Calc_FormatLastResult(char *out)
+{
+    if(ctx->hasLastResult && ctx->lastIsInteger){
+        sprintf(out, "%lld", ctx->lastInteger);
+        return;
+    }
+    Calc_FormatResult(ctx->hasLastResult ? ctx->lastResult : 0.0, out);
+}
+
+/**
+ * @brief base^exponent by repeated squaring, for integral exponents (no libm call)
+ */
+static double powInteger(double base, long exponent)
+{
+    bool   invert= (exponent < 0);
+    double result= 1.0;
+
+    if(invert){
+        exponent= -exponent;
+    }
+    while(exponent > 0){
+        if(exponent & 1){
+            result*= base;
+        }
+        base*= base;
+        exponent>>= 1;
+    }
+    return invert ? 1.0/result : result;
+}
+
+double Calc_Power(double a, double b)
+{
+    // A domain error in an operand stays an error, though C's pow(x, 0) and pow(1, y) give 1 for NAN
+    if(isnan(a) || isnan(b)){
+        return NAN;
+    }
+    // Range first, so the cast to long only ever sees a value that fits
+    return (fabs(b)<=64.0 && b==(double)(long)b) ? powInteger(a, (long)b) : pow(a, b);
+}
+
+/**
+ * @brief Binding strength of a binary operator, from the original pass order ^ * / + -
+ */
+static int precedence(unsigned char opcode)
+{
+    switch(opcode){
+        case CALC_OP_POW: return 5;
+        case CALC_OP_MUL: return 4;
+        case CALC_OP_DIV: return 3;
+        case CALC_OP_ADD: return 2;
+        default:          return 1;  // CALC_OP_SUB
+    }
+}
+
+/**
+ * @brief Run a compiled program for n (<= CALC_BATCH) values of X.
+ *        Each instruction loops over the whole batch. Only the + - * / loops are free of
+ *        branches and calls (divide by zero is a select), so those the host compiler can
+ *        vectorise; ^ and functions call Calc_Power / Func_Apply once per element.
+ */
+static void runProgram(const CalcProgram *prog, const double *x, double *out, int n)
+{
+    int sp= 0;
+
+    for(int pc=0; pc<prog->length; pc++){
+        const CalcInstr *ins= &prog->code[pc];
+        double *restrict a= batchStack[sp > 1 ? sp-2 : 0];  // Left operand / result
+        double *restrict b= batchStack[sp > 0 ? sp-1 : 0];  // Right operand / unary argument
+
+        switch(ins->opcode){
+            case CALC_OP_CONST: {
+                double *restrict d= batchStack[sp++];
+                double v= ins->value;
+                for(int i=0; i<n; i++) d[i]= v;
+                break;
+            }
+            case CALC_OP_VAR: {
+                double *restrict d= batchStack[sp++];
+                if(ins->slot==CALC_VAR_X){
+                    for(int i=0; i<n; i++) d[i]= x[i];
+                }
+                else{
+                    double v= Calc_RecallVariable((CalcVariable)ins->slot);
+                    for(int i=0; i<n; i++) d[i]= v;
                 }
-                numCount--;
-                opCount--;
-            } else {
-                i++;
+                break;
+            }
+            case CALC_OP_ADD:
+                for(int i=0; i<n; i++) a[i]= a[i] + b[i];
+                sp--;
+                break;
+            case CALC_OP_SUB:
+                for(int i=0; i<n; i++) a[i]= a[i] - b[i];
+                sp--;
+                break;
+            case CALC_OP_MUL:
+                for(int i=0; i<n; i++) a[i]= a[i] * b[i];
+                sp--;
+                break;
+            case CALC_OP_DIV:
+                // Divide by zero => NAN for that point only
+                for(int i=0; i<n; i++) a[i]= (b[i]!=0.0) ? a[i] / b[i] : NAN;
+                sp--;
+                break;
+            case CALC_OP_POW:
+                for(int i=0; i<n; i++) a[i]= Calc_Power(a[i], b[i]);
+                sp--;
+                break;
+            case CALC_OP_FUNC: {
+                // Outside the domain => NAN for that point only
+                PERF_BEGIN(PERF_FUNCTION);
+                for(int i=0; i<n; i++) b[i]= Func_Apply((FuncId)ins->slot, b[i]);
+                PERF_END(PERF_FUNCTION);
+                break;
             }
         }
     }
 
-    if (numCount != 1) {
-        errorFlag = true;
-        return 0.0;
+    for(int i=0; i<n; i++) out[i]= batchStack[0][i];
+}
+
+//////////////////// Live preview ////////////////////
+
+/// The partial evaluation is the same shunting-yard fold as the stream, on doubles only. It therefore
+/// performs the same operations in the same order as runProgram and gives the same double result.
+///
+/// With a history (the keypad), every unit folded (a digit, operator, function name or variable)
+/// first pushes a checkpoint of the stack tops, and every reduction logs the operands it overwrote.
+/// Calc_Delete pops one checkpoint and replays only that unit's log backwards, so a delete costs
+/// what the unit cost to fold, never a re-parse. An edit before the end rolls back to the checkpoint
+/// at the cursor and folds only the units from there on.
+
+static void partialReset(CalcPartial *p)
+{
+    if(p==&ctx->partial && ctx->history!=NULL){
+        ctx->history->checkpointCount= 0;
+        ctx->history->undoTop= 0;
+    }
+    p->valueTop= 0;
+    p->opTop= 0;
+    p->scanned= 0;
+    p->numberStart= CALC_NO_NUMBER;
+    p->tokenCount= 0;
+    p->expectOperand= true;
+    p->failed= false;
+}
+
+/**
+ * @brief Pops the top operator and applies it to the value stack
+ */
+static void partialReduceTop(CalcPartial *p)
+{
+    unsigned char op= p->ops[--p->opTop];
+    double *b= &p->values[p->valueTop-1];
+
+    // Log what is overwritten, except when finishing a preview copy
+    CalcHistory *h= ctx->history;
+    if(p==&ctx->partial && h!=NULL && h->undoTop<MAX_EXPR_LEN / 2){
+        CalcUndo *u= &h->undo[h->undoTop++];
+        u->op= op;
+        u->slot= p->opSlot[p->opTop];
+        u->opIndex= p->opTop;
+        u->valueIndex= p->valueTop-1;
+        u->right= *b;
+        u->left= (op==CALC_OP_FUNC) ? 0.0 : *(b-1);
+    }
+
+    if(op==CALC_OP_FUNC){
+        *b= Func_Apply((FuncId)p->opSlot[p->opTop], *b);
+        return;
+    }
+
+    double *a= b-1;
+    switch(op){
+        case CALC_OP_ADD: *a= *a + *b; break;
+        case CALC_OP_SUB: *a= *a - *b; break;
+        case CALC_OP_MUL: *a= *a * *b; break;
+        case CALC_OP_DIV: *a= (*b!=0.0) ? *a / *b : NAN; break;
+        default:          *a= Calc_Power(*a, *b); break;
+    }
+    p->valueTop--;
+}
+
+/**
+ * @brief Folds one operand and applies the functions waiting for it
+ */
+static void partialOperand(CalcPartial *p, double value)
+{
+    if(!p->expectOperand || p->valueTop>=CALC_PARTIAL_VALUES){
+        p->failed= true;  // Two operands in a row, or nested too deep for the evaluator
+        return;
+    }
+    p->tokenCount++;
+    p->values[p->valueTop++]= value;
+    while(p->opTop>0 && p->ops[p->opTop-1]==CALC_OP_FUNC){
+        partialReduceTop(p);
+    }
+    p->expectOperand= false;
+}
+
+/**
+ * @brief Folds an operator or function, reducing everything that binds at least as tightly
+ */
+static void partialOperator(CalcPartial *p, unsigned char op, unsigned char slot)
+{
+    if(op!=CALC_OP_FUNC && p->expectOperand){
+        if(p->tokenCount>0 || !ctx->hasLastResult){
+            p->failed= true;
+            return;
+        }
+        partialOperand(p, ctx->lastResult);  // Leading operator continues from Ans
+    }
+    if((op==CALC_OP_FUNC && !p->expectOperand) || p->opTop>=CALC_PARTIAL_OPS){
+        p->failed= true;
+        return;
+    }
+    p->tokenCount++;
+    if(op!=CALC_OP_FUNC){
+        while(p->opTop>0 && precedence(p->ops[p->opTop-1])>=precedence(op)){
+            partialReduceTop(p);
+        }
+        p->expectOperand= true;
+    }
+    p->opSlot[p->opTop]= slot;
+    p->ops[p->opTop++]= op;
+}
+
+/**
+ * @brief Folds the number being typed, if any, as the stream would read it
+ */
+static void partialFinishNumber(CalcPartial *p)
+{
+    if(p->numberStart==CALC_NO_NUMBER){
+        return;
+    }
+    char numBuffer[32];
+    int  length= p->scanned - p->numberStart;
+    for(int i= 0; i < length; i++){
+        numBuffer[i]= *textAt(p->numberStart + i);  // The number may straddle the gap
+    }
+    numBuffer[length]= '\0';
+    p->numberStart= CALC_NO_NUMBER;
+    partialOperand(p, atof(numBuffer));
+}
+
+/**
+ * @brief Folds every character typed since the last call
+ */
+static void partialFold(void)
+{
+    CalcPartial *p= &ctx->partial;
+    CalcHistory *h= ctx->history;
+
+    if(ctx->truncated){
+        return;  // Calc_Preview reads the stream instead
+    }
+    while(p->scanned < ctx->exprIndex){
+        const char *c= textAt(p->scanned);  // Units never straddle the gap
+        int func, nameLength;
+
+        if(h!=NULL && h->checkpointCount<MAX_EXPR_LEN){
+            CalcCheckpoint *cp= &h->checkpoints[h->checkpointCount++];
+            cp->scanned= p->scanned;
+            cp->numberStart= p->numberStart;
+            cp->valueTop= p->valueTop;
+            cp->opTop= p->opTop;
+            cp->tokenCount= p->tokenCount;
+            cp->undoTop= h->undoTop;
+            cp->expectOperand= p->expectOperand;
+            cp->failed= p->failed;
+        }
+
+        // Once failed, units are still delimited (for Calc_Delete) but no longer evaluated
+        if(p->failed){
+            func= Func_Match(c, &nameLength);
+            p->scanned+= (func>=0) ? nameLength : (strncmp(c, "Ans", 3)==0) ? 3 : 1;
+            continue;
+        }
+
+        if(isdigit((unsigned char)*c) || *c=='.'){
+            // Same limit as the stream's number buffer
+            if(p->numberStart!=CALC_NO_NUMBER && p->scanned - p->numberStart >= CALC_NUMBER_MAX - 1){
+                partialFinishNumber(p);
+            }
+            if(p->numberStart==CALC_NO_NUMBER){
+                p->numberStart= p->scanned;
+            }
+            p->scanned++;
+            continue;
+        }
+        partialFinishNumber(p);
+
+        if(strchr("+-*/^", *c)){
+            partialOperator(p, (*c=='+') ? CALC_OP_ADD :
+                               (*c=='-') ? CALC_OP_SUB :
+                               (*c=='*') ? CALC_OP_MUL :
+                               (*c=='/') ? CALC_OP_DIV :
+                                           CALC_OP_POW, 0);
+            p->scanned++;
+        }
+        else if((func= Func_Match(c, &nameLength)) >= 0){
+            partialOperator(p, CALC_OP_FUNC, (unsigned char)func);
+            p->scanned+= nameLength;
+        }
+        else if(strncmp(c, "Ans", 3)==0){
+            partialOperand(p, Calc_RecallVariable(CALC_VAR_ANS));
+            p->scanned+= 3;
+        }
+        else if((*c>='A' && *c<='F') || *c=='X' || *c=='M'){
+            partialOperand(p, variables[(*c=='X') ? CALC_VAR_X :
+                                        (*c=='M') ? CALC_VAR_M :
+                                                    CALC_VAR_A + (*c - 'A')]);
+            p->scanned++;
+        }
+        else{
+            p->failed= true;
+            p->scanned++;
+        }
+    }
+}
+
+/**
+ * @brief Checkpoints taken before text position pos, i.e. the index of the unit starting there
+ */
+static int unitsBefore(int pos)
+{
+    const CalcHistory *h= ctx->history;
+    int low= 0, high= h->checkpointCount;
+
+    while(low < high){
+        int mid= (low + high) / 2;
+        if(h->checkpoints[mid].scanned < pos){
+            low= mid + 1;
+        }
+        else{
+            high= mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Rolls the partial evaluation back to checkpoint count, dropping it and every later one
+ */
+static void partialRollback(int count)
+{
+    CalcPartial *p= &ctx->partial;
+    CalcHistory *h= ctx->history;
+
+    if(count >= h->checkpointCount){
+        return;
+    }
+    const CalcCheckpoint *cp= &h->checkpoints[count];
+
+    // Undo the reductions of those units, newest first
+    while(h->undoTop > cp->undoTop){
+        const CalcUndo *u= &h->undo[--h->undoTop];
+        p->values[u->valueIndex]= u->right;
+        if(u->op!=CALC_OP_FUNC){
+            p->values[u->valueIndex-1]= u->left;
+        }
+        p->ops[u->opIndex]= u->op;
+        p->opSlot[u->opIndex]= u->slot;
+    }
+    p->opTop= cp->opTop;
+    p->valueTop= cp->valueTop;
+    p->numberStart= cp->numberStart;
+    p->tokenCount= cp->tokenCount;
+    p->expectOperand= cp->expectOperand;
+    p->failed= cp->failed;
+    p->scanned= cp->scanned;
+    h->checkpointCount= (unsigned char)count;
+}
+
+int Calc_Delete(void)
+{
+    CalcPartial *p= &ctx->partial;
+    CalcHistory *h= ctx->history;
+
+    if(ctx->cursor==0 || ctx->truncated){
+        return 0;  // Nothing before the cursor, or the unit was dropped with the rest of the start
+    }
+    ctx->streamLive= false;
+    if(h==NULL){
+        // No history (the cursor is always at the end): drop the last character and fold again from the start
+        moveGap(ctx->exprIndex);
+        ctx->expressionBuffer[--ctx->exprIndex]= '\0';
+        ctx->gapStart= ctx->exprIndex;
+        ctx->cursor= ctx->exprIndex;
+        partialReset(p);
+        partialFold();
+        return 1;
+    }
+
+    partialFold();  // Every unit up to exprIndex now has a checkpoint
+    int unit= unitsBefore(ctx->cursor) - 1;
+    int start= h->checkpoints[unit].scanned;
+    int removed= ctx->cursor - start;
+    partialRollback(unit);
+
+    // The unit is the end of the text before the gap, so it just joins the gap
+    moveGap(ctx->cursor);
+    memset(&ctx->expressionBuffer[start], 0, removed);
+    ctx->gapStart= start;
+    ctx->exprIndex-= removed;
+    ctx->cursor= start;
+
+    partialFold();  // Units after the cursor, if any, fold again from the restored state
+    return removed;
+}
+
+int Calc_MoveCursor(int direction)
+{
+    const CalcHistory *h= ctx->history;
+
+    if(h==NULL || ctx->truncated){
+        return 0;  // Units are only known from the checkpoints
     }
-    return numbers[0];
+    partialFold();
+    int unit= unitsBefore(ctx->cursor);
+
+    // Only the cursor moves, the gap follows on the next edit
+    if(direction < 0){
+        if(unit==0){
+            return 0;
+        }
+        ctx->cursor= h->checkpoints[unit-1].scanned;
+    }
+    else{
+        if(ctx->cursor >= ctx->exprIndex){
+            return 0;
+        }
+        ctx->cursor= (unit+1 < h->checkpointCount) ? h->checkpoints[unit+1].scanned : ctx->exprIndex;
+    }
+    return 1;
 }
 
+int Calc_Preview(double *value)
+{
+    if(ctx->truncated){
+        // The partial only covers the text kept, so finish a copy of the stream instead
+        bool   errorFlag= ctx->errorFlag;
+        double result;
+        textStream= ctx->stream;
+        streamResult(&textStream, &result);
+        bool complete= !ctx->errorFlag;
+        ctx->errorFlag= errorFlag;
+        if(complete){
+            *value= result;
+        }
+        return complete ? 1 : 0;
+    }
+    partialFold();
+
+    // Finish a copy: the running state must stay open for the next key
+    CalcPartial p= ctx->partial;
+    partialFinishNumber(&p);
+    if(p.failed || p.expectOperand){
+        return 0;
+    }
+    while(p.opTop>0){
+        partialReduceTop(&p);
+    }
+    if(!isfinite(p.values[0])){
+        return 0;
+    }
+    *value= p.values[0];
+    return 1;
+}
@@ -1,4 +1,25 @@
 #include "clock.h"
+#include "perf.h"
+#include "trace.h"
+
+static const unsigned long clockHz[CLOCK_SPEED_COUNT] = {
+    16000000,  // CLOCK_SLOW: main oscillator, PLL bypassed
+    80000000   // CLOCK_FAST: PLL
+};
+
+static ClockSpeed    currentSpeed = CLOCK_SLOW;
+static unsigned long lastSwitch = 0;                       // CYCCNT at the last accounting update
+static unsigned long long cyclesAt[CLOCK_SPEED_COUNT];     // Core cycles spent at each speed
+
+/**
+ * @brief Adds cycles since the last update to the current speed's total
+ */
+static void accountTime(void)
+{
+    unsigned long now = Cycles_Now();
+    cyclesAt[currentSpeed] += (unsigned long)(now - lastSwitch);
+    lastSwitch = now;
+}
 
 void SysTick_init(void) {
     // Disable SysTick during setup
@@ -19,7 +40,7 @@ void PLL_init(void) {
     SYSCTL_RCC2_R |= 0x80000000; // USERCC2
     
     // 2. Bypass PLL while initializing
-    SYSCTL_RCC2_R |= 0x00000800; // BYPASS2
+    SYSCTL_RCC2_R |= SYSCTL_RCC2_BYPASS2;
     
     // 3. Set crystal value and oscillator source
     SYSCTL_RCC_R = (SYSCTL_RCC_R & ~0x000007C0) + 0x00000540; // Clear and set XTAL to 16 MHz
@@ -33,11 +54,53 @@ void PLL_init(void) {
     SYSCTL_RCC2_R |= 0x40000000;  // USESYSDIV
     SYSCTL_RCC2_R = (SYSCTL_RCC2_R & ~0x1FC00000) + (4 << 22); // Configure for 80 MHz clock
     
-    // 6. Wait for the PLL to lock by polling PLLLRIS
-    while ((SYSCTL_RIS_R & 0x00000040) == 0) {}; // Wait for PLLLRIS bit
-    
-    // 7. Enable use of PLL by clearing BYPASS
-    SYSCTL_RCC2_R &= ~0x00000800;
+    // 6./7. Waiting for PLLLRIS and clearing BYPASS is left to Clock_SetSpeed(CLOCK_FAST),
+    //       so boot carries on at 16MHz while the PLL locks
+    currentSpeed = CLOCK_SLOW;
+    lastSwitch = Cycles_Now();
+}
+
+void Clock_SetSpeed(ClockSpeed speed) {
+    // Called every main loop pass, which also keeps the 32-bit cycle counter from wrapping unseen
+    accountTime();
+
+    if (speed == currentSpeed) {
+        return;
+    }
+
+    if (speed == CLOCK_FAST) {
+        // PLL is left running while bypassed. Until it first locks, stay slow rather than spin.
+        if ((SYSCTL_RIS_R & SYSCTL_RIS_PLLLRIS) == 0) {
+            return;
+        }
+        SYSCTL_RCC2_R &= ~SYSCTL_RCC2_BYPASS2;
+    } else {
+        SYSCTL_RCC2_R |= SYSCTL_RCC2_BYPASS2;
+    }
+    currentSpeed = speed;
+    TRACE(TRACE_CLOCK, clockHz[speed] / 1000000);
+}
+
+ClockSpeed Clock_GetSpeed(void) {
+    return currentSpeed;
+}
+
+unsigned long Clock_GetHz(void) {
+    return clockHz[currentSpeed];
+}
+
+unsigned long Clock_TimeAtMs(ClockSpeed speed) {
+    accountTime();
+    return (unsigned long)(cyclesAt[speed] / (clockHz[speed] / 1000));
+}
+
+unsigned long Clock_UptimeUs(void) {
+    unsigned long long us = 0;
+    accountTime();
+    for (int i = 0; i < CLOCK_SPEED_COUNT; i++) {
+        us += cyclesAt[i] / (clockHz[i] / 1000000);
+    }
+    return (unsigned long)us;
 }
 
 void SysTick_wait(unsigned long delay) {
@@ -54,15 +117,26 @@ void SysTick_wait(unsigned long delay) {
 // ms Delay Function
 void delay_ms(unsigned long delay) {
     unsigned long i;
+    unsigned long ticks = clockHz[currentSpeed] / 1000;  // 1 ms at the current clock
+    TRACE(TRACE_DELAY_BEGIN, delay * 1000);
     for (i = 0; i < delay; i++) {
-        SysTick_wait(80000); // 1 ms delay at 80 MHz
+        SysTick_wait(ticks);
     }
+    TRACE(TRACE_DELAY_END, 0);
 }
 
 // us Delay Function
 void delay_us(unsigned long delay) {
     unsigned long i;
+    unsigned long ticks = clockHz[currentSpeed] / 1000000;  // 1 us at the current clock
+#ifdef CALC_TRACE
+    int traced = (delay >= TRACE_MIN_DELAY_US);
+    if (traced) TRACE(TRACE_DELAY_BEGIN, delay);
+#endif
     for (i = 0; i < delay; i++) {
-        SysTick_wait(80); // 1 us delay at 80 MHz
+        SysTick_wait(ticks);
     }
+#ifdef CALC_TRACE
+    if (traced) TRACE(TRACE_DELAY_END, 0);
+#endif
 }
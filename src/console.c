@@ -0,0 +1,308 @@
+#include "console.h"
+#include "gpio.h"
+#include "calc.h"
+#include <string.h>  // for strlen, memcpy
+
+/*
+UART0 console:
+
+- PA0/PA1 as U0RX/U0TX, baud clock from PIOSC so clock scaling never changes the rate.
+- RX: uDMA channel 8 in ping-pong mode into rxBlock[0]/rxBlock[1]. Bursts of 8 bytes
+  (RX FIFO half full) so the tail of a line that does not fill a burst raises the
+  receive timeout instead, and the handler collects it from the block and the FIFO.
+- TX: uDMA channel 9 in basic mode. Replies are written into txBuffer[txFill] while
+  the other buffer is being sent, the buffers swap when the channel goes idle.
+- Received bytes go through a single-producer (handler) single-consumer (main loop)
+  ring. The main loop feeds them to a CalcStream one by one, so a line of any length
+  needs no more RAM than a short one. When the ring is full the last free slot gets
+  RX_LOST instead, so the line that lost bytes replies Error.
+*/
+
+// uDMA channel control word fields
+#define DMA_DSTINC_NONE   (3UL << 30)
+#define DMA_SRCINC_NONE   (3UL << 26)
+#define DMA_ARBSIZE_4     (2UL << 14)
+#define DMA_ARBSIZE_8     (3UL << 14)
+#define DMA_XFERSIZE(n)   (((unsigned long)(n) - 1) << 4)
+#define DMA_MODE_MASK     0x7UL
+#define DMA_MODE_BASIC    0x1UL
+#define DMA_MODE_PINGPONG 0x3UL
+
+#define DMA_ALT_OFFSET    32  // Alternate control structures start after the 32 primary ones
+
+#define RX_BIT            (1UL << UDMA_CHAN_UART0RX)
+#define RX_LOST           '\0'  // In the ring where received bytes were dropped
+#define TX_BIT            (1UL << UDMA_CHAN_UART0TX)
+
+/// One channel control structure: source end, destination end, control word, unused
+typedef struct {
+    volatile const void *srcEnd;
+    volatile void       *dstEnd;
+    volatile unsigned long control;
+    unsigned long        unused;
+} DmaControl;
+
+static DmaControl dmaTable[64] __attribute__((aligned(1024)));
+
+static volatile char rxBlock[2][CONSOLE_DMA_BLOCK];
+static int           rxActive = 0;         // Block the DMA is filling
+static int           rxConsumed[2] = {0};  // Bytes of each block already moved into the ring
+
+static char rxRing[CONSOLE_RX_RING];
+static volatile unsigned rxHead = 0;       // Written by the handler
+static volatile unsigned rxTail = 0;       // Written by the main loop
+
+static char txBuffer[2][CONSOLE_TX_BUFFER];
+static int  txLength[2] = {0};
+static int  txFill = 0;                      // Buffer being written by Console_Poll
+
+static CalcContext consoleContext;
+
+// Line being streamed by Console_Poll
+static CalcStream lineStream;
+static bool       lineStarted = false;   // Something other than spaces since the last line end
+static bool       lineFailed = false;    // Backspace or lost bytes
+
+/// RX FIFO state and next byte, for the tail the DMA did not take
+static inline int rxFifoEmpty(void)
+{
+#ifdef UART_MOCK
+    return UartHost_RxEmpty();
+#else
+    return (UART0_FR_R & UART_FR_RXFE) != 0;
+#endif
+}
+
+static inline char rxFifoRead(void)
+{
+#ifdef UART_MOCK
+    return UartHost_RxRead();
+#else
+    return (char)UART0_DR_R;
+#endif
+}
+
+/// Returns nonzero while the TX channel is still sending a buffer
+static inline int txBusy(void)
+{
+#ifdef UART_MOCK
+    return UartHost_TxBusy();
+#else
+    return (UDMA_ENASET_R & TX_BIT) != 0;
+#endif
+}
+
+/**
+ * @brief Re-arms one RX ping-pong structure (primary or alternate) for a full block
+ */
+static void armRxBlock(int block)
+{
+    DmaControl *d = &dmaTable[UDMA_CHAN_UART0RX + (block ? DMA_ALT_OFFSET : 0)];
+    d->srcEnd  = &UART0_DR_R;
+    d->dstEnd  = &rxBlock[block][CONSOLE_DMA_BLOCK - 1];
+    d->control = DMA_SRCINC_NONE | DMA_ARBSIZE_8 | DMA_XFERSIZE(CONSOLE_DMA_BLOCK) | DMA_MODE_PINGPONG;
+}
+
+/**
+ * @brief Puts one received byte in the ring for Console_Poll
+ */
+static void receiveByte(char c)
+{
+    unsigned next = (rxHead + 1) % CONSOLE_RX_RING;
+    if(next == rxTail) {
+        return;  // Full, the RX_LOST already in the ring covers this byte too
+    }
+    if((next + 1) % CONSOLE_RX_RING == rxTail) {
+        c = RX_LOST;  // Last free slot: record that this byte was dropped instead
+    }
+    rxRing[rxHead] = c;
+    rxHead = next;
+}
+
+/**
+ * @brief Assembles the bytes of a block from what was already consumed up to end
+ */
+static void consumeBlock(int block, int end)
+{
+    for(int i = rxConsumed[block]; i < end; i++) {
+        receiveByte(rxBlock[block][i]);
+    }
+    rxConsumed[block] = end;
+}
+
+/**
+ * @brief Assembles what the DMA has written so far into the block it is filling
+ */
+static void collectActiveBlock(void)
+{
+    unsigned long control = dmaTable[UDMA_CHAN_UART0RX + (rxActive ? DMA_ALT_OFFSET : 0)].control;
+    if((control & DMA_MODE_MASK) != 0) {
+        int remaining = (int)((control >> 4) & 0x3FF) + 1;
+        consumeBlock(rxActive, CONSOLE_DMA_BLOCK - remaining);
+    }
+}
+
+/**
+ * @brief Starts sending the filled TX buffer if the channel is idle
+ */
+static void kickTx(void)
+{
+    if(txBusy() || txLength[txFill] == 0) {
+        return;
+    }
+    DmaControl *d = &dmaTable[UDMA_CHAN_UART0TX];
+    d->srcEnd  = &txBuffer[txFill][txLength[txFill] - 1];
+    d->dstEnd  = &UART0_DR_R;
+    d->control = DMA_DSTINC_NONE | DMA_ARBSIZE_4 | DMA_XFERSIZE(txLength[txFill]) | DMA_MODE_BASIC;
+    UDMA_ENASET_R = TX_BIT;
+
+    txFill ^= 1;
+    txLength[txFill] = 0;
+}
+
+/**
+ * @brief Queues text for transmission, waiting for the channel when both buffers are full
+ */
+static void consoleWrite(const char *text)
+{
+    int length = (int)strlen(text);
+    if(txLength[txFill] + length > CONSOLE_TX_BUFFER) {
+        while(txBusy()) {}
+        kickTx();
+    }
+    memcpy(&txBuffer[txFill][txLength[txFill]], text, length);
+    txLength[txFill] += length;
+}
+
+void Console_Init(void)
+{
+    volatile unsigned long delay;
+
+    CalcCtx_Init(&consoleContext);
+    CalcStream_Begin(&lineStream, &consoleContext);
+
+    SYSCTL_RCGCUART_R |= 0x01;           // UART0
+    SYSCTL_RCGCDMA_R |= 0x01;            // uDMA
+    SYSCTL_RCGCGPIO_R |= 0x01;           // Port A (already on for the LCD)
+    while((SYSCTL_PRUART_R & 0x01) == 0) {}
+    delay = SYSCTL_RCGCDMA_R;
+    (void)delay;
+
+    // ===== PA0 (U0RX), PA1 (U0TX) =====
+    GPIO_PORTA_AMSEL_R &= ~0x03;
+    GPIO_PORTA_PCTL_R = (GPIO_PORTA_PCTL_R & ~0x000000FF) | 0x00000011;
+    GPIO_PORTA_AFSEL_R |= 0x03;
+    GPIO_PORTA_DEN_R |= 0x03;
+
+    // ===== UART0: 115200 8N1 from the 16MHz PIOSC, FIFOs at half, DMA on both sides =====
+    UART0_CTL_R = 0;
+    UART0_CC_R = UART_CC_PIOSC;
+    UART0_IBRD_R = 8;                    // 16MHz / (16 * 115200) = 8.6806
+    UART0_FBRD_R = 44;                   // 0.6806 * 64 + 0.5
+    UART0_LCRH_R = 0x70;                 // 8 bit, FIFOs enabled
+    UART0_IFLS_R = 0x12;                 // RX and TX trigger at 1/2
+    UART0_IM_R = UART_IM_RTIM;
+    UART0_DMACTL_R = 0x03;               // RXDMAE, TXDMAE
+    UART0_CTL_R = 0x301;                 // RXE, TXE, UARTEN
+
+    // ===== uDMA =====
+    UDMA_CFG_R = 0x01;
+    UDMA_CTLBASE_R = (unsigned long)dmaTable;
+    UDMA_CHMAP1_R &= ~0xFFUL;            // Channels 8/9 => UART0 RX/TX
+    UDMA_REQMASKCLR_R = RX_BIT | TX_BIT;
+    UDMA_ALTCLR_R = RX_BIT | TX_BIT;
+    UDMA_USEBURSTSET_R = RX_BIT;         // Only whole bursts, the tail comes by timeout
+
+    armRxBlock(0);
+    armRxBlock(1);
+    UDMA_ENASET_R = RX_BIT;
+
+    NVIC_EN0_R |= NVIC_EN0_UART0;
+}
+
+/**
+ * @brief UART0 interrupt: an RX block completed (uDMA done) or the line went idle (receive timeout)
+ */
+void UART0_Handler(void)
+{
+    unsigned long done = UDMA_CHIS_R;
+    UDMA_CHIS_R = done & (RX_BIT | TX_BIT);
+
+    if(done & RX_BIT) {
+        // The DMA has moved on to the other block, hand this one over and re-arm it
+        consumeBlock(rxActive, CONSOLE_DMA_BLOCK);
+        rxConsumed[rxActive] = 0;
+        armRxBlock(rxActive);
+        rxActive ^= 1;
+    }
+
+    if(UART0_MIS_R & UART_IM_RTIM) {
+        UART0_ICR_R = UART_IM_RTIM;
+
+        // Bytes already moved into the active block come first, then what is left in the FIFO
+        collectActiveBlock();
+        while(!rxFifoEmpty()) {
+            receiveByte(rxFifoRead());
+        }
+    }
+}
+
+int Console_HasWork(void)
+{
+    return (rxHead != rxTail) ? 1 : 0;
+}
+
+/**
+ * @brief Finishes the line being streamed and queues its reply
+ */
+static void finishLine(void)
+{
+    char text[32];
+
+    if(!lineFailed) {
+        CalcStream_Finish(&lineStream);
+    }
+    if(!lineFailed && !CalcCtx_HadError(&consoleContext)) {
+        CalcCtx_FormatLastResult(&consoleContext, text);
+        consoleWrite(text);
+        consoleWrite("\r\n");
+    }
+    else {
+        consoleWrite("Error\r\n");
+    }
+    CalcStream_Begin(&lineStream, &consoleContext);
+    lineStarted = false;
+    lineFailed = false;
+}
+
+void Console_Poll(void)
+{
+    // A line whose tail ended on a burst left the FIFO empty, and an empty FIFO raises no
+    // receive timeout, so the bytes would wait in the block for the next line. Take them here.
+    NVIC_DIS0_R = NVIC_EN0_UART0;
+    collectActiveBlock();
+    NVIC_EN0_R = NVIC_EN0_UART0;
+
+    while(rxHead != rxTail) {
+        char c = rxRing[rxTail];
+        rxTail = (rxTail + 1) % CONSOLE_RX_RING;
+
+        if(c == '\r' || c == '\n') {
+            if(lineStarted) {
+                finishLine();
+            }
+            continue;
+        }
+        if(c == ' ') {
+            continue;
+        }
+        lineStarted = true;
+        if(c == '\b' || c == 0x7F || c == RX_LOST) {
+            lineFailed = true;  // The stream cannot take back what it was fed
+        }
+        else if(!lineFailed) {
+            CalcStream_Feed(&lineStream, c);
+        }
+    }
+    kickTx();
+}
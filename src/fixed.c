@@ -0,0 +1,712 @@
+#include "fixed.h"
+#include "func.h"
+#include <stdbool.h>
+
+#define FIX_FRAC_MASK  0xFFFFFFFFULL
+#define LN2            2977044472LL         // ln 2 in Q32.32
+#define LN2_Q56        49946518145322874LL  // ln 2 in Q8.56, so k*ln2 stays exact to 2^-33 for any k used here
+#define SQRT2          6074001000LL
+#define INV_LN10       1865280597LL
+#define RAD_TO_DEG     246083499208LL
+#define DEG_TO_RAD     74961321LL
+#define EXP_MAX        92288378626LL        // ln 2^31, above this exp() does not fit
+#define EXP_MIN        (-98242467570LL)     // ln 2^-33, below this exp() rounds to 0
+#define DEGREES(n)     ((CalcFixed)(n) * FIX_ONE)
+
+/**
+ * @brief sin(k * 90/256 degrees) for k = 0..256 in Q1.31. cos comes from the same table read backwards.
+ */
+static const unsigned long sinTable[257] = {
+    0x00000000UL, 0x00C90F88UL, 0x01921D20UL, 0x025B26D7UL, 0x03242ABFUL, 0x03ED26E6UL,
+    0x04B6195DUL, 0x057F0035UL, 0x0647D97CUL, 0x0710A345UL, 0x07D95B9EUL, 0x08A2009AUL,
+    0x096A9049UL, 0x0A3308BDUL, 0x0AFB6805UL, 0x0BC3AC35UL, 0x0C8BD35EUL, 0x0D53DB92UL,
+    0x0E1BC2E4UL, 0x0EE38766UL, 0x0FAB272BUL, 0x1072A048UL, 0x1139F0CFUL, 0x120116D5UL,
+    0x12C8106FUL, 0x138EDBB1UL, 0x145576B1UL, 0x151BDF86UL, 0x15E21445UL, 0x16A81305UL,
+    0x176DD9DEUL, 0x183366E9UL, 0x18F8B83CUL, 0x19BDCBF3UL, 0x1A82A026UL, 0x1B4732EFUL,
+    0x1C0B826AUL, 0x1CCF8CB3UL, 0x1D934FE5UL, 0x1E56CA1EUL, 0x1F19F97BUL, 0x1FDCDC1BUL,
+    0x209F701CUL, 0x2161B3A0UL, 0x2223A4C5UL, 0x22E541AFUL, 0x23A6887FUL, 0x24677758UL,
+    0x25280C5EUL, 0x25E845B6UL, 0x26A82186UL, 0x27679DF4UL, 0x2826B928UL, 0x28E5714BUL,
+    0x29A3C485UL, 0x2A61B101UL, 0x2B1F34EBUL, 0x2BDC4E6FUL, 0x2C98FBBAUL, 0x2D553AFCUL,
+    0x2E110A62UL, 0x2ECC681EUL, 0x2F875262UL, 0x3041C761UL, 0x30FBC54DUL, 0x31B54A5EUL,
+    0x326E54C7UL, 0x3326E2C3UL, 0x33DEF287UL, 0x34968250UL, 0x354D9057UL, 0x36041AD9UL,
+    0x36BA2014UL, 0x376F9E46UL, 0x382493B0UL, 0x38D8FE93UL, 0x398CDD32UL, 0x3A402DD2UL,
+    0x3AF2EEB7UL, 0x3BA51E29UL, 0x3C56BA70UL, 0x3D07C1D6UL, 0x3DB832A6UL, 0x3E680B2CUL,
+    0x3F1749B8UL, 0x3FC5EC98UL, 0x4073F21DUL, 0x4121589BUL, 0x41CE1E65UL, 0x427A41D0UL,
+    0x4325C135UL, 0x43D09AEDUL, 0x447ACD50UL, 0x452456BDUL, 0x45CD358FUL, 0x46756828UL,
+    0x471CECE7UL, 0x47C3C22FUL, 0x4869E665UL, 0x490F57EEUL, 0x49B41533UL, 0x4A581C9EUL,
+    0x4AFB6C98UL, 0x4B9E0390UL, 0x4C3FDFF4UL, 0x4CE10034UL, 0x4D8162C4UL, 0x4E210617UL,
+    0x4EBFE8A5UL, 0x4F5E08E3UL, 0x4FFB654DUL, 0x5097FC5EUL, 0x5133CC94UL, 0x51CED46EUL,
+    0x5269126EUL, 0x53028518UL, 0x539B2AF0UL, 0x5433027DUL, 0x54CA0A4BUL, 0x556040E2UL,
+    0x55F5A4D2UL, 0x568A34A9UL, 0x571DEEFAUL, 0x57B0D256UL, 0x5842DD54UL, 0x58D40E8CUL,
+    0x59646498UL, 0x59F3DE12UL, 0x5A82799AUL, 0x5B1035CFUL, 0x5B9D1154UL, 0x5C290ACCUL,
+    0x5CB420E0UL, 0x5D3E5237UL, 0x5DC79D7CUL, 0x5E50015DUL, 0x5ED77C8AUL, 0x5F5E0DB3UL,
+    0x5FE3B38DUL, 0x60686CCFUL, 0x60EC3830UL, 0x616F146CUL, 0x61F1003FUL, 0x6271FA69UL,
+    0x62F201ACUL, 0x637114CCUL, 0x63EF3290UL, 0x646C59BFUL, 0x64E88926UL, 0x6563BF92UL,
+    0x65DDFBD3UL, 0x66573CBBUL, 0x66CF8120UL, 0x6746C7D8UL, 0x67BD0FBDUL, 0x683257ABUL,
+    0x68A69E81UL, 0x6919E320UL, 0x698C246CUL, 0x69FD614AUL, 0x6A6D98A4UL, 0x6ADCC964UL,
+    0x6B4AF279UL, 0x6BB812D1UL, 0x6C242960UL, 0x6C8F351CUL, 0x6CF934FCUL, 0x6D6227FAUL,
+    0x6DCA0D14UL, 0x6E30E34AUL, 0x6E96A99DUL, 0x6EFB5F12UL, 0x6F5F02B2UL, 0x6FC19385UL,
+    0x7023109AUL, 0x708378FFUL, 0x70E2CBC6UL, 0x71410805UL, 0x719E2CD2UL, 0x71FA3949UL,
+    0x72552C85UL, 0x72AF05A7UL, 0x7307C3D0UL, 0x735F6626UL, 0x73B5EBD1UL, 0x740B53FBUL,
+    0x745F9DD1UL, 0x74B2C884UL, 0x7504D345UL, 0x7555BD4CUL, 0x75A585CFUL, 0x75F42C0BUL,
+    0x7641AF3DUL, 0x768E0EA6UL, 0x76D94989UL, 0x77235F2DUL, 0x776C4EDBUL, 0x77B417DFUL,
+    0x77FAB989UL, 0x78403329UL, 0x78848414UL, 0x78C7ABA2UL, 0x7909A92DUL, 0x794A7C12UL,
+    0x798A23B1UL, 0x79C89F6EUL, 0x7A05EEADUL, 0x7A4210D8UL, 0x7A7D055BUL, 0x7AB6CBA4UL,
+    0x7AEF6323UL, 0x7B26CB4FUL, 0x7B5D039EUL, 0x7B920B89UL, 0x7BC5E290UL, 0x7BF88830UL,
+    0x7C29FBEEUL, 0x7C5A3D50UL, 0x7C894BDEUL, 0x7CB72724UL, 0x7CE3CEB2UL, 0x7D0F4218UL,
+    0x7D3980ECUL, 0x7D628AC6UL, 0x7D8A5F40UL, 0x7DB0FDF8UL, 0x7DD6668FUL, 0x7DFA98A8UL,
+    0x7E1D93EAUL, 0x7E3F57FFUL, 0x7E5FE493UL, 0x7E7F3957UL, 0x7E9D55FCUL, 0x7EBA3A39UL,
+    0x7ED5E5C6UL, 0x7EF05860UL, 0x7F0991C4UL, 0x7F2191B4UL, 0x7F3857F6UL, 0x7F4DE451UL,
+    0x7F62368FUL, 0x7F754E80UL, 0x7F872BF3UL, 0x7F97CEBDUL, 0x7FA736B4UL, 0x7FB563B3UL,
+    0x7FC25596UL, 0x7FCE0C3EUL, 0x7FD8878EUL, 0x7FE1C76BUL, 0x7FE9CBC0UL, 0x7FF09478UL,
+    0x7FF62182UL, 0x7FFA72D1UL, 0x7FFD885AUL, 0x7FFF6216UL, 0x80000000UL
+};
+
+/**
+ * @brief Raises status to s, never lowering it (FIX_DOMAIN wins over FIX_RANGE)
+ */
+static void raise(FixStatus *status, FixStatus s)
+{
+    if(s > *status){
+        *status= s;
+    }
+}
+
+static CalcFixed saturate(bool negative, FixStatus *status)
+{
+    raise(status, FIX_RANGE);
+    return negative ? FIX_MIN : FIX_MAX;
+}
+
+/**
+ * @brief A non-zero result that rounds to 0: the caller may redo it in double, as for an overflow
+ */
+static CalcFixed underflow(FixStatus *status)
+{
+    raise(status, FIX_RANGE);
+    return 0;
+}
+
+static unsigned long long magnitude(CalcFixed x)
+{
+    return (x < 0) ? 0ULL - (unsigned long long)x : (unsigned long long)x;
+}
+
+/**
+ * @brief Applies the sign to a magnitude, saturating if it does not fit
+ */
+static CalcFixed withSign(unsigned long long m, bool negative, FixStatus *status)
+{
+    if(m > (negative ? (1ULL << 63) : (unsigned long long)FIX_MAX)){
+        return saturate(negative, status);
+    }
+    return negative ? (CalcFixed)(0ULL - m) : (CalcFixed)m;
+}
+
+CalcFixed Fix_FromInt(long long n, FixStatus *status)
+{
+    if(n >= (1LL << 31) || n < -(1LL << 31)){
+        return saturate(n < 0, status);
+    }
+    return n * FIX_ONE;
+}
+
+CalcFixed Fix_FromString(const char *text, FixStatus *status)
+{
+    bool negative= (*text=='-');
+    unsigned long long whole= 0;
+    unsigned long long frac= 0;  // Q0.60 while the digits are read
+    const char *digits= text;
+    int count= 0;
+
+    if(negative){
+        text++;
+    }
+    for(; *text>='0' && *text<='9'; text++){
+        if(whole <= (1ULL << 32)){  // Further digits only matter for the range check
+            whole= whole*10 + (unsigned long long)(*text - '0');
+        }
+    }
+    if(*text=='.'){
+        digits= ++text;
+        while(digits[count]>='0' && digits[count]<='9'){
+            count++;
+        }
+        // Last digit first: frac = (digit + frac) / 10
+        for(int i=count-1; i>=0; i--){
+            frac= (((unsigned long long)(digits[i] - '0') << 60) + frac) / 10;
+        }
+    }
+
+    frac= (frac + (1ULL << 27)) >> 28;  // Round to 32 bits
+    if(frac >> 32){
+        whole++;
+        frac= 0;
+    }
+    if(whole > (1ULL << 31)){
+        return saturate(negative, status);
+    }
+    if(whole==0 && frac==0 && count > 0){
+        for(int i=0; i<count; i++){
+            if(digits[i]!='0'){
+                return underflow(status);  // Below half a step, e.g. 0.0000000001
+            }
+        }
+    }
+    return withSign((whole << 32) | frac, negative, status);
+}
+
+CalcFixed Fix_FromDouble(double value, FixStatus *status)
+{
+    if(!(value > -2147483647.0 && value < 2147483647.0)){
+        return saturate(value < 0.0, status);  // NAN lands here too
+    }
+    double scaled= value * 4294967296.0;
+    CalcFixed r= (CalcFixed)(scaled + (scaled < 0.0 ? -0.5 : 0.5));
+    if(r==0 && value!=0.0){
+        return underflow(status);
+    }
+    return r;
+}
+
+double Fix_ToDouble(CalcFixed value)
+{
+    return (double)value * (1.0 / 4294967296.0);
+}
+
+CalcFixed Fix_Add(CalcFixed a, CalcFixed b, FixStatus *status)
+{
+    CalcFixed r;
+    if(__builtin_add_overflow(a, b, &r)){
+        return saturate(a < 0, status);
+    }
+    return r;
+}
+
+CalcFixed Fix_Sub(CalcFixed a, CalcFixed b, FixStatus *status)
+{
+    CalcFixed r;
+    if(__builtin_sub_overflow(a, b, &r)){
+        return saturate(a < 0, status);
+    }
+    return r;
+}
+
+/**
+ * @brief 64x64 => 128-bit product from four 32x32 => 64 multiplies, keeping bits 32..95 (rounded)
+ */
+CalcFixed Fix_Mul(CalcFixed a, CalcFixed b, FixStatus *status)
+{
+    bool negative= (a < 0) != (b < 0);
+    unsigned long long ua= magnitude(a);
+    unsigned long long ub= magnitude(b);
+    unsigned long long al= ua & FIX_FRAC_MASK, ah= ua >> 32;
+    unsigned long long bl= ub & FIX_FRAC_MASK, bh= ub >> 32;
+
+    unsigned long long lo= al*bl;
+    unsigned long long hi= ah*bh;
+    unsigned long long r= (lo >> 32) + ((lo >> 31) & 1);
+
+    if(hi >> 32 ||
+       __builtin_add_overflow(r, ah*bl, &r) ||
+       __builtin_add_overflow(r, al*bh, &r) ||
+       __builtin_add_overflow(r, hi << 32, &r)){
+        return saturate(negative, status);
+    }
+    if(r==0 && ua!=0 && ub!=0){
+        return underflow(status);
+    }
+    return withSign(r, negative, status);
+}
+
+/**
+ * @brief Whole part by one 64-bit divide, then the 32 fraction bits by shift-and-subtract, rounded
+ */
+CalcFixed Fix_Div(CalcFixed a, CalcFixed b, FixStatus *status)
+{
+    if(b==0){
+        raise(status, FIX_DOMAIN);
+        return 0;
+    }
+    bool negative= (a < 0) != (b < 0);
+    unsigned long long ua= magnitude(a);
+    unsigned long long ub= magnitude(b);
+    unsigned long long whole= ua / ub;
+
+    unsigned long long rem= ua % ub;
+    unsigned long long frac= 0;
+
+    if(whole > (1ULL << 31)){
+        return saturate(negative, status);
+    }
+    // rem < ub <= 2^63, so rem << 1 cannot overflow
+    for(int i=0; i<32; i++){
+        rem<<= 1;
+        frac<<= 1;
+        if(rem >= ub){
+            rem-= ub;
+            frac|= 1;
+        }
+    }
+    unsigned long long r= (whole << 32) + frac;
+    if((rem << 1) >= ub){
+        r++;
+    }
+    if(r==0 && ua!=0){
+        return underflow(status);
+    }
+    return withSign(r, negative, status);
+}
+
+/**
+ * @brief k * ln2 from the Q8.56 constant, exact to 2^-33 for |k| <= 64
+ */
+static CalcFixed timesLn2(int k)
+{
+    return ((CalcFixed)k * LN2_Q56 + (1LL << 23)) >> 24;
+}
+
+/**
+ * @brief Integer square root, rounded to nearest
+ */
+static unsigned long long isqrt(unsigned long long n)
+{
+    unsigned long long root= 0;
+    unsigned long long bit= 1ULL << 62;
+
+    while(bit > n){
+        bit>>= 2;
+    }
+    while(bit != 0){
+        if(n >= root + bit){
+            n-= root + bit;
+            root= (root >> 1) + bit;
+        }
+        else{
+            root>>= 1;
+        }
+        bit>>= 2;
+    }
+    return (n > root) ? root + 1 : root;
+}
+
+/**
+ * @brief sqrt(x * 2^32) as isqrt(x * 4^s) * 2^(16 - s), with s as large as the 64 bits allow. Below
+ *        s = 16 that leaves the low 16 - s bits out, so one Newton step (r + x/r) / 2 puts them back.
+ */
+static CalcFixed fixSqrt(CalcFixed x, FixStatus *status)
+{
+    if(x < 0){
+        raise(status, FIX_DOMAIN);
+        return 0;
+    }
+    unsigned long long ux= (unsigned long long)x;
+    int s= 16;
+    while(s > 0 && (ux >> (64 - 2*s)) != 0){
+        s--;
+    }
+    CalcFixed r= (CalcFixed)(isqrt(ux << (2*s)) << (16 - s));
+    if(s < 16){
+        r= (r + Fix_Div(x, r, status) + 1) >> 1;
+    }
+    return r;
+}
+
+/**
+ * @brief ln x = e*ln2 + ln m with m in [sqrt(1/2), sqrt(2)), ln m = 2 atanh((m-1)/(m+1)) as a series in s^2 <= 0.03
+ */
+static CalcFixed fixLn(CalcFixed x, FixStatus *status)
+{
+    if(x <= 0){
+        raise(status, FIX_DOMAIN);
+        return 0;
+    }
+    int e= (63 - __builtin_clzll((unsigned long long)x)) - FIX_FRAC_BITS;
+    CalcFixed m= (e >= 0) ? (x >> e) : (x << -e);  // [1, 2)
+    if(m > SQRT2){
+        m>>= 1;
+        e++;
+    }
+
+    FixStatus series= FIX_OK;   // |s| < 0.18: terms only ever vanish, which is no error
+    CalcFixed s = Fix_Div(m - FIX_ONE, m + FIX_ONE, &series);
+    CalcFixed s2= Fix_Mul(s, s, &series);
+    CalcFixed term= s;
+    CalcFixed sum= 0;
+    for(int k=1; k<=13; k+=2){  // s^15/15 < 2^-40
+        sum+= term / k;
+        term= Fix_Mul(term, s2, &series);
+    }
+    return timesLn2(e) + 2*sum;
+}
+
+/**
+ * @brief exp x = 2^k * exp r with |r| <= ln2/2, exp r by its Taylor series
+ */
+static CalcFixed fixExp(CalcFixed x, FixStatus *status)
+{
+    if(x > EXP_MAX){
+        return saturate(false, status);
+    }
+    if(x < EXP_MIN){
+        return underflow(status);
+    }
+    int k= (int)((x + (x < 0 ? -LN2/2 : LN2/2)) / LN2);
+    CalcFixed r= x - timesLn2(k);
+    CalcFixed term= FIX_ONE;
+    CalcFixed sum= FIX_ONE;
+    FixStatus series= FIX_OK;   // |r| <= ln2/2: terms only ever vanish
+    for(int n=1; n<=11; n++){  // 0.35^12/12! < 2^-40
+        term= Fix_Mul(term, r, &series) / n;
+        sum+= term;
+    }
+    if(k >= 0){
+        if(sum > (FIX_MAX >> k)){
+            return saturate(false, status);
+        }
+        return sum << k;
+    }
+    sum= (sum + (1LL << (-k - 1))) >> -k;
+    return (sum==0) ? underflow(status) : sum;
+}
+
+/**
+ * @brief sin and cos of t in [0, 90) degrees: the table entry at or below t, then the remainder d
+ *        (under 0.36 degrees) through sin(a+d) = sin a cos d + cos a sin d. Linear interpolation
+ *        alone would leave errors near 5e-6, which tan magnifies close to 90.
+ */
+static void sinCosQuadrant(CalcFixed t, CalcFixed *sinOut, CalcFixed *cosOut)
+{
+    FixStatus inRange= FIX_OK;  // Every value here is within [-1, 1]
+    int       k= (int)((t * 256) / DEGREES(90));
+    CalcFixed d= Fix_Mul(t - (CalcFixed)k * (90LL << 24), DEG_TO_RAD, &inRange);
+    CalcFixed d2= Fix_Mul(d, d, &inRange);
+    CalcFixed sinD= d - Fix_Mul(d, d2, &inRange) / 6;  // d^5/120 < 2^-42
+    CalcFixed cosD= FIX_ONE - d2 / 2;                  // d^4/24 < 2^-33
+    CalcFixed sinA= (CalcFixed)sinTable[k] << 1;
+    CalcFixed cosA= (CalcFixed)sinTable[256 - k] << 1;
+
+    *sinOut= Fix_Mul(sinA, cosD, &inRange) + Fix_Mul(cosA, sinD, &inRange);
+    *cosOut= Fix_Mul(cosA, cosD, &inRange) - Fix_Mul(sinA, sinD, &inRange);
+}
+
+static void sinCosDegrees(CalcFixed x, CalcFixed *sinOut, CalcFixed *cosOut)
+{
+    CalcFixed r= x % DEGREES(360);
+    if(r < 0){
+        r+= DEGREES(360);
+    }
+    int quadrant= (int)(r / DEGREES(90));
+    CalcFixed s, c;
+    sinCosQuadrant(r - quadrant * DEGREES(90), &s, &c);
+
+    switch(quadrant){
+        case 0:  *sinOut=  s; *cosOut=  c; break;
+        case 1:  *sinOut=  c; *cosOut= -s; break;
+        case 2:  *sinOut= -s; *cosOut= -c; break;
+        default: *sinOut= -c; *cosOut=  s; break;
+    }
+}
+
+/**
+ * @brief atan in degrees: |x| > 1 through 90 - atan(1/x), then two half-angle steps
+ *        atan a = 2 atan(a / (1 + sqrt(1 + a^2))) so the series only sees a <= tan(11.25)
+ */
+static CalcFixed fixAtan(CalcFixed x, FixStatus *status)
+{
+    bool      negative= (x < 0);
+    CalcFixed a= negative ? ((x==FIX_MIN) ? FIX_MAX : -x) : x;
+    bool      invert= (a > FIX_ONE);
+    FixStatus series= FIX_OK;   // From here a <= 1, so products only ever vanish, which is no error
+
+    if(invert){
+        a= Fix_Div(FIX_ONE, a, status);
+    }
+    for(int i=0; i<2; i++){
+        a= Fix_Div(a, FIX_ONE + fixSqrt(FIX_ONE + Fix_Mul(a, a, &series), status), &series);
+    }
+
+    CalcFixed a2= Fix_Mul(a, a, &series);
+    CalcFixed term= a;
+    CalcFixed sum= 0;
+    for(int k=1; k<=15; k+=2){  // a^17/17 < 2^-43
+        sum+= ((k & 2) ? -term : term) / k;
+        term= Fix_Mul(term, a2, &series);
+    }
+    CalcFixed degrees= Fix_Mul(4*sum, RAD_TO_DEG, status);
+    if(invert){
+        degrees= DEGREES(90) - degrees;
+    }
+    return negative ? -degrees : degrees;
+}
+
+static CalcFixed fixAsin(CalcFixed x, FixStatus *status)
+{
+    if(x > FIX_ONE || x < -FIX_ONE){
+        raise(status, FIX_DOMAIN);
+        return 0;
+    }
+    if(x==FIX_ONE || x==-FIX_ONE){
+        return (x < 0) ? -DEGREES(90) : DEGREES(90);
+    }
+    // cos = sqrt(1-x) sqrt(1+x): both factors are exact, where 1 - x*x would cancel close to +-1
+    CalcFixed c= Fix_Mul(fixSqrt(FIX_ONE - x, status), fixSqrt(FIX_ONE + x, status), status);
+    if(c==0){
+        return (x < 0) ? -DEGREES(90) : DEGREES(90);  // Closer to +-1 than the last step
+    }
+    return fixAtan(Fix_Div(x, c, status), status);
+}
+
+CalcFixed Fix_Pow(CalcFixed a, CalcFixed b, FixStatus *status)
+{
+    if((b & (CalcFixed)FIX_FRAC_MASK)==0){
+        // Integral exponent: repeated squaring, no squaring past the last bit so it cannot overflow needlessly
+        long long n= b / FIX_ONE;
+        unsigned long long e= (n < 0) ? 0ULL - (unsigned long long)n : (unsigned long long)n;
+        CalcFixed result= FIX_ONE;
+        CalcFixed base= a;
+        while(e > 0){
+            if(e & 1){
+                result= Fix_Mul(result, base, status);
+            }
+            e>>= 1;
+            if(e > 0){
+                base= Fix_Mul(base, base, status);
+            }
+        }
+        if(n < 0){
+            if(a==0){
+                raise(status, FIX_DOMAIN);
+                return 0;
+            }
+            if(magnitude(result) < (1ULL << 16)){
+                return saturate(false, status);  // Too few significant bits left to invert
+            }
+            result= Fix_Div(FIX_ONE, result, status);
+        }
+        return result;
+    }
+
+    // a^b = exp(b ln a), only defined for a > 0 (0^b for b > 0 is 0)
+    if(a==0){
+        if(b < 0) raise(status, FIX_DOMAIN);
+        return 0;
+    }
+    if(a < 0){
+        raise(status, FIX_DOMAIN);
+        return 0;
+    }
+    return fixExp(Fix_Mul(b, fixLn(a, status), status), status);
+}
+
+CalcFixed Fix_Apply(int func, CalcFixed x, FixStatus *status)
+{
+    CalcFixed s, c;
+
+    switch(func){
+        case FUNC_SIN:
+            sinCosDegrees(x, &s, &c);
+            return s;
+        case FUNC_COS:
+            sinCosDegrees(x, &s, &c);
+            return c;
+        case FUNC_TAN:
+            sinCosDegrees(x, &s, &c);
+            if(c==0){
+                return saturate(s < 0, status);  // Huge but finite in double
+            }
+            return Fix_Div(s, c, status);
+        case FUNC_SQRT: return fixSqrt(x, status);
+        case FUNC_LN:   return fixLn(x, status);
+        case FUNC_LOG:  return Fix_Mul(fixLn(x, status), INV_LN10, status);
+        case FUNC_EXP:  return fixExp(x, status);
+        case FUNC_ASIN: return fixAsin(x, status);
+        case FUNC_ACOS: {
+            CalcFixed r= fixAsin(x, status);
+            return DEGREES(90) - r;
+        }
+        case FUNC_ATAN: return fixAtan(x, status);
+        default:
+            raise(status, FIX_DOMAIN);
+            return 0;
+    }
+}
+
+/**
+ * @brief a + b for error bounds, saturating at FIX_ERROR_MAX
+ */
+static unsigned long errorAdd(unsigned long long a, unsigned long long b)
+{
+    return (a + b > FIX_ERROR_MAX) ? FIX_ERROR_MAX : (unsigned long)(a + b);
+}
+
+/**
+ * @brief e * factor for error bounds, saturating at FIX_ERROR_MAX
+ */
+static unsigned long errorScale(unsigned long long e, unsigned long long factor)
+{
+    unsigned long long r;
+    if(__builtin_mul_overflow(e, factor, &r) || r > FIX_ERROR_MAX){
+        return FIX_ERROR_MAX;
+    }
+    return (unsigned long)r;
+}
+
+/**
+ * @brief Steps between a result moved by an error in its input and r, FIX_ERROR_MAX if it failed
+ */
+static unsigned long errorDistance(CalcFixed moved, CalcFixed r, FixStatus status)
+{
+    if(status!=FIX_OK){
+        return FIX_ERROR_MAX;
+    }
+    unsigned long long d= (moved > r) ? (unsigned long long)moved - (unsigned long long)r
+                                      : (unsigned long long)r - (unsigned long long)moved;
+    return errorScale(d, 1);
+}
+
+/**
+ * @brief Error bound of r = a^b: the inputs' errors moved through Fix_Pow, plus its own rounding
+ */
+static unsigned long powError(CalcFixed a, unsigned long ea, CalcFixed b, unsigned long eb, CalcFixed r)
+{
+    unsigned long long ur= magnitude(r);
+    unsigned long long ub= magnitude(b);
+    unsigned long      kernel;
+    FixStatus          st= FIX_OK;
+
+    if(eb==0 && (b & (CalcFixed)FIX_FRAC_MASK)==0){
+        if(b==FIX_MIN){
+            return FIX_ERROR_MAX;
+        }
+        if(b < 0){
+            // 1 / a^-b: the error of the power, through the division
+            CalcFixed power= Fix_Pow(a, -b, &st);
+            if(st!=FIX_OK){
+                return FIX_ERROR_MAX;
+            }
+            return Fix_OpError('/', FIX_ONE, 0, power, powError(a, ea, -b, 0, power), r);
+        }
+        // Each multiply rounds, and later squarings scale what came before: |r| steps per multiply
+        kernel= errorAdd(errorScale((ur >> 32) + 1, (ub >> 32) + 1), 16);
+    }
+    else{
+        // exp(b ln a): ln a within 16 steps puts b ln a within 16|b| + 1, which is relative in r
+        kernel= errorAdd(errorScale(16 * ((ub >> 32) + 1) + 1, (ur >> 32) + 1), 16);
+    }
+
+    unsigned long spread= 0;
+    if(ea > 0){
+        spread= errorAdd(errorDistance(Fix_Pow(Fix_Add(a, (CalcFixed)ea, &st), b, &st), r, st),
+                         errorDistance(Fix_Pow(Fix_Sub(a, (CalcFixed)ea, &st), b, &st), r, st));
+    }
+    if(eb > 0){
+        spread= errorAdd(spread, errorAdd(errorDistance(Fix_Pow(a, Fix_Add(b, (CalcFixed)eb, &st), &st), r, st),
+                                          errorDistance(Fix_Pow(a, Fix_Sub(b, (CalcFixed)eb, &st), &st), r, st)));
+    }
+    return errorAdd(kernel, spread);
+}
+
+unsigned long Fix_RoundingError(CalcFixed value)
+{
+    return (value & (CalcFixed)FIX_FRAC_MASK) ? 1 : 0;
+}
+
+unsigned long Fix_OpError(char op, CalcFixed a, unsigned long ea, CalcFixed b, unsigned long eb, CalcFixed r)
+{
+    unsigned long long ua= magnitude(a);
+    unsigned long long ub= magnitude(b);
+    unsigned long long ur= magnitude(r);
+
+    switch(op){
+        case '+':
+        case '-':
+            return errorAdd(ea, eb);
+        case '*':
+            // d(ab) = b da + a db, plus the rounding of the product
+            return errorAdd(errorAdd(errorScale(ea, (ub >> 32) + 1), errorScale(eb, (ua >> 32) + 1)), 1);
+        case '/':
+            // d(a/b) = da / b - (a/b) db / b, plus the rounding of the quotient
+            if(eb >= ub){
+                return FIX_ERROR_MAX;  // b could be 0
+            }
+            return errorAdd(errorAdd(errorScale(ea, (1ULL << 32) / ub + 1), errorScale(eb, ur / ub + 1)), 1);
+        default:
+            return powError(a, ea, b, eb, r);
+    }
+}
+
+unsigned long Fix_ApplyError(int func, CalcFixed x, unsigned long ex, CalcFixed r)
+{
+    unsigned long kernel;
+    FixStatus     st= FIX_OK;
+
+    // The kernels' own error, as measured against the double ones (tests/test_fixed.c)
+    switch(func){
+        case FUNC_SQRT: kernel= 1;    break;
+        case FUNC_SIN:
+        case FUNC_COS:  kernel= 8;    break;
+        case FUNC_LN:
+        case FUNC_LOG:  kernel= 16;   break;
+        case FUNC_EXP:  kernel= errorAdd(magnitude(r) >> 29, 16); break;
+        case FUNC_TAN: {
+            // sin / cos, each within 8 steps
+            CalcFixed c= Fix_Apply(FUNC_COS, x, &st);
+            kernel= (st==FIX_OK) ? Fix_OpError('/', 0, 8, c, 8, r) : FIX_ERROR_MAX;
+            break;
+        }
+        default:        kernel= 1024; break;  // asin, acos, atan: 2e-7 degrees
+    }
+    if(ex==0){
+        return kernel;
+    }
+    // How far the input's error can move the result, from both sides
+    unsigned long up= errorDistance(Fix_Apply(func, Fix_Add(x, (CalcFixed)ex, &st), &st), r, st);
+    unsigned long down= errorDistance(Fix_Apply(func, Fix_Sub(x, (CalcFixed)ex, &st), &st), r, st);
+    return errorAdd(kernel, (up > down) ? up : down);
+}
+
+void Fix_Format(CalcFixed value, char *out)
+{
+    unsigned long long m= magnitude(value);
+    unsigned long long whole= m >> 32;
+    unsigned long long product= (m & FIX_FRAC_MASK) * 1000;
+    unsigned long long milli= product >> 32;
+    unsigned long long rest= product & FIX_FRAC_MASK;
+    char digits[12];
+    int  n= 0;
+
+    // Nearest thousandth, ties to even like printf
+    if(rest > 0x80000000ULL || (rest==0x80000000ULL && (milli & 1))){
+        milli++;
+    }
+    if(milli==1000){
+        whole++;
+        milli= 0;
+    }
+
+    if(value < 0 && (whole!=0 || milli!=0)){
+        *out++= '-';
+    }
+    do{
+        digits[n++]= (char)('0' + whole % 10);
+        whole/= 10;
+    }while(whole!=0);
+    while(n > 0){
+        *out++= digits[--n];
+    }
+
+    if(milli!=0){
+        int places= 3;
+        while(milli % 10==0){  // Strip trailing zeros
+            milli/= 10;
+            places--;
+        }
+        *out++= '.';
+        for(int p=places-1; p>=0; p--){
+            unsigned long long div= (p==2) ? 100 : (p==1) ? 10 : 1;
+            *out++= (char)('0' + (milli / div) % 10);
+        }
+    }
+    *out= '\0';
+}
@@ -0,0 +1,45 @@
+#include "flash.h"
+#include <string.h>  // for memcpy
+
+/**
+ * @brief Starts an FMC command and waits for the controller to clear its bit again
+ */
+static int runCommand(unsigned long address, unsigned long command)
+{
+    FLASH_FCMISC_R= FLASH_FCRIS_ARIS;  // Clear an old access violation
+    FLASH_FMA_R= address;
+    FLASH_FMC_R= FLASH_FMC_WRKEY | command;
+    while(FLASH_FMC_R & command){ }
+    return (FLASH_FCRIS_R & FLASH_FCRIS_ARIS) ? -1 : 0;
+}
+
+int Flash_ErasePage(unsigned long address)
+{
+    if(address % FLASH_PAGE_SIZE != 0 || address >= FLASH_SIZE){
+        return -1;
+    }
+    return runCommand(address, FLASH_FMC_ERASE);
+}
+
+int Flash_Write(unsigned long address, const void *data, int length)
+{
+    const unsigned char *bytes= (const unsigned char *)data;
+
+    if(address % 4 != 0 || length % 4 != 0 || address + (unsigned long)length > FLASH_SIZE){
+        return -1;
+    }
+    for(int i=0; i<length; i+=4){
+        unsigned long word;
+        memcpy(&word, &bytes[i], 4);  // data need not be word-aligned
+        FLASH_FMD_R= word;
+        if(runCommand(address + (unsigned long)i, FLASH_FMC_WRITE)<0){
+            return -1;
+        }
+    }
+    return 0;
+}
+
+const void* Flash_Read(unsigned long address)
+{
+    return (const void *)address;
+}
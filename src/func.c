@@ -0,0 +1,214 @@
+#include "func.h"
+#include "calc.h"
+#include <math.h>     // frexp, ldexp, trig, and sqrt/exp/log/log10 unless FUNC_KERNELS
+#include <string.h>   // strncmp, strlen
+
+#define LN2_HI      6.93147180369123816490e-01  // ln(2) upper bits, exact times any small k
+#define LN2_LO      1.90821492927058770002e-10
+#define INV_LN2     1.44269504088896338700e+00
+#define INV_LN10    4.34294481903251816668e-01
+#define LOG10_2_HI  3.01029995663611771306e-01
+#define LOG10_2_LO  3.69423907715893078616e-13
+#define EXP_MAX     7.09782712893383973096e+02  // Above this exp() overflows
+#define EXP_MIN    -7.45133219101941108420e+02  // Below this exp() underflows to 0
+#define SQRT_HALF   0.70710678118654752440
+
+// The registry uses libm's sqrt/exp/log/log10: on the host they beat the kernels below
+// (bench/bench_func.c) and no target cycle counts show otherwise. Build with FUNC_KERNELS
+// to use the kernels instead, once PERF_FUNCTION on the board shows them ahead.
+#ifdef FUNC_KERNELS
+#define SQRT_KERNEL   Func_Sqrt
+#define EXP_KERNEL    Func_Exp
+#define LN_KERNEL     Func_Ln
+#define LOG10_KERNEL  Func_Log10
+#else
+#define SQRT_KERNEL   sqrt
+#define EXP_KERNEL    exp
+#define LN_KERNEL     log
+#define LOG10_KERNEL  log10
+#endif
+
+// exp(r) = 1 + r + r*c/(2-c) with c = r - r^2*P(r^2), |r| <= ln2/2 (minimax, |error| < 2^-59)
+static const double expP[5] = {
+     1.66666666666666019037e-01,
+    -2.77777777770155933842e-03,
+     6.61375632143793436117e-05,
+    -1.65339022054652515390e-06,
+     4.13813679705723846039e-08
+};
+
+// ln(1+f) = 2s + s*R(s^2) with s = f/(2+f), |s| <= 0.1716 (minimax, |error| < 2^-58.45)
+static const double lnP[7] = {
+    6.666666666666735130e-01,
+    3.999999999940941908e-01,
+    2.857142874366239149e-01,
+    2.222219843214978396e-01,
+    1.818357216161805012e-01,
+    1.531383769920937332e-01,
+    1.479819860511658591e-01
+};
+
+static double sinDeg(double x)  { return sin(x*(M_PI/180.0)); }
+static double cosDeg(double x)  { return cos(x*(M_PI/180.0)); }
+static double tanDeg(double x)  { return tan(x*(M_PI/180.0)); }
+static double asinDeg(double x) { return asin(x)*(180.0/M_PI); }
+static double acosDeg(double x) { return acos(x)*(180.0/M_PI); }
+static double atanDeg(double x) { return atan(x)*(180.0/M_PI); }
+
+// Derivatives, per degree for the trig functions (chain rule through the degree conversion)
+#define DEG_TO_RAD (M_PI/180.0)
+#define RAD_TO_DEG (180.0/M_PI)
+
+static double sinSlope(double x, double fx)  { (void)fx; return cosDeg(x)*DEG_TO_RAD; }
+static double cosSlope(double x, double fx)  { (void)fx; return -sinDeg(x)*DEG_TO_RAD; }
+static double tanSlope(double x, double fx)  { (void)x;  return (1.0 + fx*fx)*DEG_TO_RAD; }
+static double sqrtSlope(double x, double fx) { (void)x;  return 0.5/fx; }
+static double lnSlope(double x, double fx)   { (void)fx; return 1.0/x; }
+static double logSlope(double x, double fx)  { (void)fx; return INV_LN10/x; }
+static double expSlope(double x, double fx)  { (void)x;  return fx; }
+static double asinSlope(double x, double fx) { (void)fx; return RAD_TO_DEG/SQRT_KERNEL((1.0-x)*(1.0+x)); }
+static double acosSlope(double x, double fx) { (void)fx; return -RAD_TO_DEG/SQRT_KERNEL((1.0-x)*(1.0+x)); }
+static double atanSlope(double x, double fx) { (void)fx; return RAD_TO_DEG/(1.0 + x*x); }
+
+static int nonNegative(double x) { return x >= 0.0; }
+static int positive(double x)    { return x > 0.0; }
+static int unitRange(double x)   { return x >= -1.0 && x <= 1.0; }
+
+static const FuncInfo funcTable[FUNC_COUNT] = {
+    [FUNC_SIN]  = { "sin",  's', 1, sinDeg,       sinSlope,  NULL        },
+    [FUNC_COS]  = { "cos",  'c', 1, cosDeg,       cosSlope,  NULL        },
+    [FUNC_TAN]  = { "tan",  't', 1, tanDeg,       tanSlope,  NULL        },
+    [FUNC_SQRT] = { "sqrt", 'r', 1, SQRT_KERNEL,  sqrtSlope, nonNegative },
+    [FUNC_LN]   = { "ln",   'l', 1, LN_KERNEL,    lnSlope,   positive    },
+    [FUNC_LOG]  = { "log",  'g', 1, LOG10_KERNEL, logSlope,  positive    },
+    [FUNC_EXP]  = { "exp",  'e', 1, EXP_KERNEL,   expSlope,  NULL        },
+    [FUNC_ASIN] = { "asin", 'i', 1, asinDeg,      asinSlope, unitRange   },
+    [FUNC_ACOS] = { "acos", 'o', 1, acosDeg,      acosSlope, unitRange   },
+    [FUNC_ATAN] = { "atan", 'a', 1, atanDeg,      atanSlope, NULL        }
+};
+
+const FuncInfo* Func_Get(FuncId id)
+{
+    return &funcTable[id];
+}
+
+int Func_FromKey(char key)
+{
+    for(int i=0; i<FUNC_COUNT; i++){
+        if(funcTable[i].key==key) return i;
+    }
+    return -1;
+}
+
+int Func_Match(const char *text, int *length)
+{
+    // Longest match, so "asin" is not read as 'a' + "sin"
+    int best= -1;
+    int bestLength= 0;
+    for(int i=0; i<FUNC_COUNT; i++){
+        int n= (int)strlen(funcTable[i].name);
+        if(n>bestLength && strncmp(text, funcTable[i].name, n)==0){
+            best= i;
+            bestLength= n;
+        }
+    }
+    *length= bestLength;
+    return best;
+}
+
+double Func_Apply(FuncId id, double x)
+{
+    const FuncInfo *f= &funcTable[id];
+    if(f->inDomain!=NULL && !f->inDomain(x)){
+        return NAN;
+    }
+    return f->kernel(x);
+}
+
+double Func_Slope(FuncId id, double x, double fx)
+{
+    return funcTable[id].slope(x, fx);
+}
+
+/**
+ * @brief Square root from the single-precision VSQRT (14 cycles) and two Newton steps,
+ *        each doubling the correct bits: 24 => 48 => full double. The exponent is halved
+ *        separately so any double fits the float estimate.
+ */
+double Func_Sqrt(double x)
+{
+    if(x==0.0 || isinf(x)) return x;
+    if(!(x > 0.0)) return NAN;
+
+    int    e;
+    double m= frexp(x, &e);  // x = m * 2^e, m in [0.5, 1)
+    if(e & 1){
+        m*= 2.0;             // Even exponent, m in [0.5, 2)
+        e--;
+    }
+    double y= (double)__builtin_sqrtf((float)m);
+    y= 0.5*(y + m/y);
+    y= 0.5*(y + m/y);
+    return ldexp(y, e/2);
+}
+
+/**
+ * @brief exp(x) = 2^k * exp(r), x = k*ln2 + r. ln2 is split so k*LN2_HI is exact.
+ */
+double Func_Exp(double x)
+{
+    if(isnan(x))     return x;
+    if(x > EXP_MAX)  return INFINITY;
+    if(x < EXP_MIN)  return 0.0;
+
+    int    k = (int)(x*INV_LN2 + (x < 0.0 ? -0.5 : 0.5));
+    double hi= x - k*LN2_HI;
+    double lo= k*LN2_LO;
+    double r = hi - lo;
+    double t = r*r;
+    double c = r - t*(expP[0] + t*(expP[1] + t*(expP[2] + t*(expP[3] + t*expP[4]))));
+    double y = 1.0 - ((lo - (r*c)/(2.0 - c)) - hi);
+    return ldexp(y, k);
+}
+
+/**
+ * @brief ln(x) = k*ln2 + ln(1+f), x = 2^k * (1+f) with 1+f in [sqrt(1/2), sqrt(2))
+ */
+double Func_Ln(double x)
+{
+    if(isnan(x) || x < 0.0) return NAN;
+    if(x == 0.0)            return -INFINITY;
+    if(isinf(x))            return x;
+
+    int    k;
+    double m= frexp(x, &k);  // m in [0.5, 1)
+    if(m < SQRT_HALF){
+        m*= 2.0;
+        k--;
+    }
+    double f   = m - 1.0;
+    double s   = f/(2.0 + f);
+    double z   = s*s;
+    double w   = z*z;
+    double t1  = w*(lnP[1] + w*(lnP[3] + w*lnP[5]));
+    double t2  = z*(lnP[0] + w*(lnP[2] + w*(lnP[4] + w*lnP[6])));
+    double hfsq= 0.5*f*f;
+    return k*LN2_HI - ((hfsq - (s*(hfsq + t1 + t2) + k*LN2_LO)) - f);
+}
+
+/**
+ * @brief log10(x) = k*log10(2) + log10(m), x = 2^k * m with m in [sqrt(1/2), sqrt(2)),
+ *        so k is 0 near x = 1 and nothing cancels there
+ */
+double Func_Log10(double x)
+{
+    if(isnan(x) || x <= 0.0 || isinf(x)) return Func_Ln(x);
+
+    int    k;
+    double m= frexp(x, &k);
+    if(m < SQRT_HALF){
+        m*= 2.0;
+        k--;
+    }
+    return (k*LOG10_2_LO + INV_LN10*Func_Ln(m)) + k*LOG10_2_HI;
+}
@@ -0,0 +1,361 @@
+#include "integ.h"
+#include "calc.h"
+#include "lcd.h"
+#include <math.h>
+#include <stdio.h>
+
+typedef enum {
+    INTEG_ENTER_F,
+    INTEG_ENTER_A,
+    INTEG_ENTER_B,
+    INTEG_ENTER_TOL,
+    INTEG_RUNNING,
+    INTEG_DONE
+} IntegStage;
+
+typedef enum {
+    OUTCOME_OK,
+    OUTCOME_ROUGH,    // Interval stack ran out, tolerance may not be met
+    OUTCOME_ERROR,    // f(X) failed somewhere in [a,b]
+    OUTCOME_ABORTED
+} IntegOutcome;
+
+#define INTEG_DEFAULT_TOL 1e-6   // Prompted as 0.000001, the keypad cannot type an exponent
+#define INTEG_MAX_SPLITS  40     // Interval stack depth (bisection levels)
+
+static IntegKind    kind = INTEG_INTEGRATE;
+static IntegStage   stage = INTEG_ENTER_F;
+static IntegOutcome outcome = OUTCOME_OK;
+static bool         inputError = false;
+static CalcProgram  integrand;
+
+static double lowerX = 0.0;
+static double upperX = 0.0;
+static double tolerance = INTEG_DEFAULT_TOL;
+
+static double total = 0.0;
+static double compensation = 0.0;  // Kahan running error
+static int    percentDone = 0;
+
+/**
+ * @brief Pending sub-intervals of the integral (depth first)
+ */
+typedef struct {
+    double a;
+    double b;
+} Interval;
+
+static Interval pending[INTEG_MAX_SPLITS];
+static int      pendingCount = 0;
+static double   widthDone = 0.0;
+
+/**
+ * @brief Summation progress: next X index and number of terms
+ */
+static long termIndex = 0;
+static long termCount = 0;
+
+/**
+ * @brief 15-point Kronrod nodes on [0,1] (xgk[7] = 0 is the centre) and weights.
+ *        Odd-indexed nodes are the 7-point Gauss nodes with weights wg.
+ */
+static const double xgk[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.000000000000000000000000000000000
+};
+static const double wgk[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+};
+static const double wg[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+};
+
+static void addToTotal(double value)
+{
+    double y= value - compensation;
+    double t= total + y;
+    compensation= (t - total) - y;
+    total= t;
+}
+
+/**
+ * @brief Gauss-Kronrod 7/15 over [a,b] in one batched evaluation. Returns false if f(X) failed.
+ */
+static bool kronrod15(double a, double b, double *result, double *errorEst)
+{
+    double x[15];
+    double f[15];
+    double centre= 0.5*(a+b);
+    double half  = 0.5*(b-a);
+
+    for(int i=0; i<7; i++){
+        x[2*i]   = centre - half*xgk[i];
+        x[2*i+1] = centre + half*xgk[i];
+    }
+    x[14]= centre;
+
+    Calc_EvaluateBatch(&integrand, x, f, 15);
+
+    double kronrod= wgk[7]*f[14];
+    double gauss  = wg[3]*f[14];
+    for(int i=0; i<7; i++){
+        double pair= f[2*i] + f[2*i+1];
+        kronrod+= wgk[i]*pair;
+        if(i & 1){
+            gauss+= wg[i/2]*pair;
+        }
+    }
+
+    *result  = kronrod*half;
+    *errorEst= fabs((kronrod-gauss)*half);
+    return isfinite(*result) && isfinite(*errorEst);
+}
+
+/**
+ * @brief Takes the value typed for a limit, leaving Ans alone. Returns false if the expression had an error.
+ */
+static bool takeValue(double *value)
+{
+    *value= Calc_EvaluateInput();
+    bool valid= !Calc_HadError();
+    Calc_ClearExpression();  // Clears the error flag too
+    return valid;
+}
+
+static void start(void)
+{
+    total= 0.0;
+    compensation= 0.0;
+    percentDone= 0;
+    outcome= OUTCOME_OK;
+
+    if(kind==INTEG_INTEGRATE){
+        pending[0].a= lowerX;
+        pending[0].b= upperX;
+        pendingCount= (lowerX==upperX) ? 0 : 1;
+        widthDone= 0.0;
+    }
+    else{
+        termIndex= 0;
+        // rangeFits() has bounded the span, so the conversion cannot overflow
+        termCount= (upperX<lowerX) ? 0 : (long)floor(upperX-lowerX + 1e-9) + 1;
+    }
+    stage= INTEG_RUNNING;
+}
+
+/**
+ * @brief Returns false if [a,b] is too wide to work through: an infinite or NaN width, or more than
+ *        INTEG_MAX_TERMS terms to sum
+ */
+static bool rangeFits(void)
+{
+    double span= upperX-lowerX;
+
+    if(kind==INTEG_SUM){
+        return span<INTEG_MAX_TERMS;  // False for NaN too
+    }
+    return isfinite(span);
+}
+
+void Integ_Enter(IntegKind newKind)
+{
+    kind= newKind;
+    stage= INTEG_ENTER_F;
+    inputError= false;
+    Calc_ClearExpression();
+}
+
+bool Integ_HandleKey(char key)
+{
+    if(stage==INTEG_RUNNING){
+        if(key=='C'){
+            outcome= OUTCOME_ABORTED;
+            stage= INTEG_DONE;
+        }
+        return true;  // Nothing else while running
+    }
+
+    if(stage==INTEG_DONE){
+        if(key=='C' || key=='='){
+            Integ_Enter(kind);
+        }
+        return true;
+    }
+
+    if(key!='='){
+        inputError= false;
+        return false;  // Typing f(X) or a limit
+    }
+
+    switch(stage){
+        case INTEG_ENTER_F:
+            inputError= (Calc_Compile(&integrand)<0);
+            if(!inputError){
+                Calc_ClearExpression();
+                stage= INTEG_ENTER_A;
+            }
+            break;
+
+        case INTEG_ENTER_A:
+            inputError= !takeValue(&lowerX);
+            if(!inputError) stage= INTEG_ENTER_B;
+            break;
+
+        case INTEG_ENTER_B:
+            inputError= !takeValue(&upperX) || !rangeFits();
+            if(!inputError){
+                if(kind==INTEG_INTEGRATE){
+                    stage= INTEG_ENTER_TOL;
+                }
+                else{
+                    start();
+                }
+            }
+            break;
+
+        default:
+            // Empty or non-positive tolerance => default
+            tolerance= (Calc_GetExpression()[0]=='\0') ? INTEG_DEFAULT_TOL : Calc_EvaluateInput();
+            inputError= Calc_HadError();
+            Calc_ClearExpression();
+            if(!inputError){
+                if(!(tolerance>0.0)){
+                    tolerance= INTEG_DEFAULT_TOL;
+                }
+                start();
+            }
+            break;
+    }
+    return true;
+}
+
+bool Integ_Step(void)
+{
+    int before= percentDone;
+
+    if(stage!=INTEG_RUNNING){
+        return false;
+    }
+
+    if(kind==INTEG_INTEGRATE){
+        if(pendingCount==0){
+            stage= INTEG_DONE;
+            return true;
+        }
+
+        Interval iv= pending[--pendingCount];
+        double   value, errorEst;
+        double   span= upperX-lowerX;
+
+        if(!kronrod15(iv.a, iv.b, &value, &errorEst)){
+            outcome= OUTCOME_ERROR;
+            stage= INTEG_DONE;
+            return true;
+        }
+
+        // Accept if this piece meets its share of the tolerance, else bisect
+        double share= tolerance*fabs((iv.b-iv.a)/span);
+        double mid  = 0.5*(iv.a+iv.b);
+        if(errorEst<=share || mid==iv.a || mid==iv.b){
+            addToTotal(value);
+            widthDone+= fabs(iv.b-iv.a);
+        }
+        else if(pendingCount+2 > INTEG_MAX_SPLITS){
+            addToTotal(value);
+            widthDone+= fabs(iv.b-iv.a);
+            outcome= OUTCOME_ROUGH;
+        }
+        else{
+            // Right half underneath so the left half is done first
+            pending[pendingCount].a  = mid;
+            pending[pendingCount++].b= iv.b;
+            pending[pendingCount].a  = iv.a;
+            pending[pendingCount++].b= mid;
+        }
+        percentDone= (int)(100.0*widthDone/fabs(span));
+    }
+    else{
+        if(termIndex>=termCount){
+            stage= INTEG_DONE;
+            return true;
+        }
+
+        double x[CALC_BATCH];
+        double f[CALC_BATCH];
+        int    n= (termCount-termIndex < CALC_BATCH) ? (int)(termCount-termIndex) : CALC_BATCH;
+
+        for(int i=0; i<CALC_BATCH; i++){
+            x[i]= lowerX + (double)(termIndex+i);  // Past n unused, filled so the batch is always set
+        }
+        Calc_EvaluateBatch(&integrand, x, f, n);
+        for(int i=0; i<n; i++){
+            if(!isfinite(f[i])){
+                outcome= OUTCOME_ERROR;
+                stage= INTEG_DONE;
+                return true;
+            }
+            addToTotal(f[i]);
+        }
+        termIndex+= n;
+        percentDone= (int)(100.0*termIndex/termCount);  // 100*termIndex would overflow a 32-bit long
+    }
+
+    return percentDone!=before;
+}
+
+const char* Integ_Prompt(void)
+{
+    switch(stage){
+        case INTEG_ENTER_F:   return inputError ? "Error! f(X)=" : "f(X)=";
+        case INTEG_ENTER_A:   return inputError ? "Error! a?"    : (kind==INTEG_SUM ? "From X=" : "a?");
+        case INTEG_ENTER_B:   return inputError ? "Error! b?"    : (kind==INTEG_SUM ? "To X="   : "b?");
+        case INTEG_ENTER_TOL: return inputError ? "Error! Tol?"  : "Tol? (=0.000001)";
+        default:              return "";
+    }
+}
+
+bool Integ_IsBusy(void)
+{
+    return stage==INTEG_RUNNING;
+}
+
+bool Integ_OwnsDisplay(void)
+{
+    return stage==INTEG_RUNNING || stage==INTEG_DONE;
+}
+
+void Integ_Draw(void)
+{
+    char value[32];
+    char line[40];
+
+    if(stage==INTEG_RUNNING){
+        LCD_WriteRow(0, kind==INTEG_SUM ? "Summing..." : "Integrating...");
+        snprintf(line, sizeof(line), "%3d%%  C=abort", percentDone);
+        LCD_WriteRow(1, line);
+        return;
+    }
+
+    switch(outcome){
+        case OUTCOME_ERROR:
+            LCD_WriteRow(0, "Error!");
+            LCD_WriteRow(1, "");
+            return;
+        case OUTCOME_ABORTED:
+            LCD_WriteRow(0, "Aborted");
+            LCD_WriteRow(1, "");
+            return;
+        default:
+            break;
+    }
+
+    LCD_WriteRow(0, kind==INTEG_SUM ? "Sum=" : (outcome==OUTCOME_ROUGH ? "Integral~" : "Integral="));
+    Calc_FormatResult(total, value);
+    LCD_WriteRow(1, value);
+}
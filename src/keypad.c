@@ -1,57 +1,146 @@
 #include "keypad.h"
 #include "gpio.h"
 #include "clock.h"
-#include <stdbool.h>
+#include "perf.h"
+#include "trace.h"
+#include <stddef.h>
 
-static bool shiftState = false;
+#define KEYPAD_LAYERS 3
 
-static const char normalMap[4][4] = {
-    {'1','2','3','+'},
-    {'4','5','6','-'},
-    {'7','8','9','*'},
-    {'S','0','.', '='}
+static unsigned char layer = 0;  // 0 = Normal, 1 = SHIFT, 2 = ALT
+
+/**
+ * @brief FIFO of decoded keys with the cycle count at which each was queued
+ */
+static char          keyQueue[KEY_QUEUE_SIZE];
+static unsigned long keyStamp[KEY_QUEUE_SIZE];
+static volatile unsigned char keyHead = 0;   // Next slot to read
+static volatile unsigned char keyTail = 0;   // Next slot to write
+
+static const char normalMaps[KEYPAD_LAYERS][4][4] = {
+    // Normal
+    {
+        {'1','2','3','+'},
+        {'4','5','6','-'},
+        {'7','8','9','*'},
+        {'S','0','.', '='}
+    },
+    // SHIFT
+    {
+        {'^',KEY_SWAP,KEY_ROLL,'/'},
+        {'s','c','t','C'},
+        {KEY_RCL,KEY_STO,KEY_MODE,KEY_LASTX},
+        {'S',KEY_LEFT,KEY_RIGHT,KEY_DEL}
+    },
+    // ALT (function key codes from func.h)
+    {
+        {'r','l','g','e'},
+        {'i','o','a','?'},
+        {KEY_MPLUS,KEY_MMINUS,KEY_MR,KEY_MC},
+        {'S','?','?','?'}
+    }
 };
 
-static const char shiftedMap[4][4] = {
-    {'^','?','?','/'},
-    {'s','c','t','C'},
-    {'?','?','?','?'},
-    {'S','?','?','?'}
+// BASE mode: the same Normal layer, bitwise operators on SHIFT, hex digits on ALT
+static const char baseMaps[KEYPAD_LAYERS][4][4] = {
+    // Normal
+    {
+        {'1','2','3','+'},
+        {'4','5','6','-'},
+        {'7','8','9','*'},
+        {'S','0','.', '='}
+    },
+    // SHIFT
+    {
+        {KEY_AND,KEY_OR,KEY_XOR,'/'},
+        {KEY_NOT,KEY_SHL,KEY_SHR,'C'},
+        {KEY_BASE,KEY_WORD,KEY_MODE,'?'},
+        {'S',KEY_LEFT,KEY_RIGHT,KEY_DEL}
+    },
+    // ALT (hex digits)
+    {
+        {'a','b','c','d'},
+        {'e','f','?','?'},
+        {'?','?','?','?'},
+        {'S','?','?','?'}
+    }
 };
 
+static const char (*keyMaps)[4][4] = normalMaps;
+
 void Keypad_Init(void)
 {
     // If already configured in GPIO_Init, do nothing here.
 }
 
+void Keypad_SetLayout(KeypadLayout layout)
+{
+    keyMaps= (layout==KEYPAD_LAYOUT_BASE) ? baseMaps : normalMaps;
+}
+
+int Keypad_Push(char key)
+{
+    unsigned char next = (keyTail + 1) % KEY_QUEUE_SIZE;
+    if(next == keyHead){
+        return -1; // Queue full
+    }
+    keyQueue[keyTail] = key;
+    keyStamp[keyTail] = Cycles_Now();
+    keyTail = next;
+    return 0;
+}
+
+int Keypad_HasKey(void)
+{
+    return keyHead != keyTail;
+}
+
+char Keypad_Pop(unsigned long *queuedAt)
+{
+    if(keyHead == keyTail){
+        return '\0';
+    }
+    char key = keyQueue[keyHead];
+    if(queuedAt){
+        *queuedAt = keyStamp[keyHead];
+    }
+    keyHead = (keyHead + 1) % KEY_QUEUE_SIZE;
+    return key;
+}
+
 char Keypad_GetKey(void)
+{
+    Keypad_Scan();
+    return Keypad_Pop(NULL);
+}
+
+/**
+ * @brief Scans the matrix once and returns the debounced key under the current layer,
+ *        or '\0' if none is held. Waits for the key to be released.
+ */
+static char scanMatrix(void)
 {
     unsigned char col, row;
-    char c = '\0';
 
     for(col=0; col<4; col++){
-        // Drive all columns high
-        GPIO_PORTD_DATA_R |= KEYPAD_COL_MASK;
-        // Pull this column low
-        GPIO_PORTD_DATA_R &= ~(1<<col);
+        // Pull this column low and drive the others high in a single store
+        GPIO_WritePins(GPIO_PORTD_BASE, KEYPAD_COL_MASK, KEYPAD_COL_MASK & ~(1<<col));
 
         delay_us(2);
 
-        unsigned char rowData= GPIO_PORTE_DATA_R & KEYPAD_ROW_MASK;
+        unsigned char rowData= GPIO_ReadPins(GPIO_PORTE_BASE, KEYPAD_ROW_MASK);
         for(row=0; row<4; row++){
             if(!(rowData & (1<<row))){
                 // Debounce
+                TRACE(TRACE_KEY_PRESSED, (row << 4) | col);
                 delay_ms(20);
-                rowData= GPIO_PORTE_DATA_R & KEYPAD_ROW_MASK;
+                rowData= GPIO_ReadPins(GPIO_PORTE_BASE, KEYPAD_ROW_MASK);
                 if(!(rowData & (1<<row))){
                     // Wait release
-                    while(!(GPIO_PORTE_DATA_R & (1<<row))){ }
+                    while(!GPIO_ReadPins(GPIO_PORTE_BASE, 1<<row)){ }
 
-                    c= shiftState ? shiftedMap[row][col] : normalMap[row][col];
-                    if(c=='S'){
-                        shiftState= !shiftState;
-                        return '\0';
-                    }
+                    char c= keyMaps[layer][row][col];
+                    TRACE(TRACE_KEY_DEBOUNCED, c);
                     return c;
                 }
             }
@@ -59,3 +148,16 @@ char Keypad_GetKey(void)
     }
     return '\0';
 }
+
+void Keypad_Scan(void)
+{
+    PERF_BEGIN(PERF_KEYPAD_SCAN);
+    char c= scanMatrix();
+    if(c=='S'){
+        layer= (layer + 1) % KEYPAD_LAYERS;
+    }
+    else if(c!='\0' && c!='?'){  // '?' is an unused key
+        Keypad_Push(c);
+    }
+    PERF_END(PERF_KEYPAD_SCAN);
+}
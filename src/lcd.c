@@ -1,63 +1,103 @@
 #include "lcd.h"
 #include "gpio.h"
 #include "clock.h"
+#include "perf.h"
+#include "trace.h"
 
-// Definitions for control pins on Port A
-#define LCD_RS 0x08  // PA3: Register Select (1 for data, 0 for command)
-#define LCD_EN 0x04  // PA2: Enable pin
-
-// Definitions for data pins on Port B
-#define LCD_DATA_PINS 0x0F  // PB0-PB3 connected to LCD DB4-DB7
+// Control pins on Port A (PA2 EN, PA3 RS) and data pins on Port B (PB0-PB3 => DB4-DB7)
+// are defined in gpio.h. Every write below is a single address-masked store.
 
 // Internal function prototypes
 static void LCD_SendNibble(unsigned char nibble, unsigned char isData);
 static void LCD_SendByte(unsigned char byte, unsigned char isData);
 
-void LCD_Init(void) {
-    // Allow LCD power to stabilise
-    delay_ms(20);
-
+/**
+ * @brief Power-on sequence as data, so it can run as a state machine (LCD_Poll) while the
+ *        keypad is already live. Each step is sent, then the next waits waitUs after it.
+ */
+typedef enum {
+    INIT_WAIT,     // Nothing to send, just wait
+    INIT_NIBBLE,   // Single nibble (8-bit mode function set)
+    INIT_COMMAND   // Full command byte, both nibbles
+} LcdInitKind;
+
+typedef struct {
+    unsigned char  kind;    // LcdInitKind
+    unsigned char  value;
+    unsigned short waitUs;  // Time the LCD needs after this step
+} LcdInitStep;
+
+static const LcdInitStep initSteps[] = {
+    {INIT_WAIT,    0x00, 20000},  // Allow LCD power to stabilise
+    // Initialise LCD in 8-bit mode (hardware default on boot) with three function set commands
+    {INIT_NIBBLE,  0x03, 1000},
+    {INIT_NIBBLE,  0x03, 1000},
+    {INIT_NIBBLE,  0x03, 1000},
+    {INIT_NIBBLE,  0x02, 1000},   // Switch to 4-bit mode
+    {INIT_COMMAND, 0x28, 1000},   // Function set: 4-bit mode, 2 lines, 5x8 dots
+    {INIT_COMMAND, 0x08, 1000},   // Display off, cursor off, blink off
+    {INIT_COMMAND, 0x01, 2000},   // Clear display (longer delay for clear command)
+    {INIT_COMMAND, 0x06, 1000},   // Entry mode: increment cursor, no shift
+    {INIT_COMMAND, 0x0C, 1000}    // Display on, cursor off, blink off
+};
+
+#define LCD_INIT_STEPS (sizeof(initSteps) / sizeof(initSteps[0]))
+
+static unsigned char initStep = 0;
+static unsigned long initDue  = 0;   // Clock_UptimeUs() when the next step may run
+static unsigned char lcdReady = 0;
+static unsigned char cursorShown = 0;  // Display control currently 0x0F rather than 0x0C
+
+void LCD_InitStart(void) {
     // Ensure control lines are low
-    GPIO_PORTA_DATA_R &= ~(LCD_RS | LCD_EN);
+    GPIO_WritePins(GPIO_PORTA_BASE, LCD_RS_PIN | LCD_EN_PIN, 0);
 
-    // Initialise LCD in 8-bit mode (hardware default on boot) with three function set commands
-    LCD_SendNibble(0x03, 0);
-    delay_ms(1);  
-    LCD_SendNibble(0x03, 0);
-    delay_ms(1);  
-    LCD_SendNibble(0x03, 0);
-    delay_ms(1);
-
-    // Step 3: Switch to 4-bit mode
-    LCD_SendNibble(0x02, 0);
-    delay_ms(1);
-
-    // Configure LCD for 2-line display and 5x8 character font
-    LCD_Command(0x28);  // Function set: 4-bit mode, 2 lines, 5x8 dots
-    delay_ms(1);
-
-    // Turn off the display while configuring
-    LCD_Command(0x08);  // Display off, cursor off, blink off
-    delay_ms(1);
-
-    // Clear the display
-    LCD_Command(0x01);  // Clear display command
-    delay_ms(2);        // Longer delay for clear command
-
-    // Set entry mode to increment cursor, no shift
-    LCD_Command(0x06); 
-    delay_ms(1);
-
-    // Turn on the display with cursor off
-    LCD_Command(0x0C);  // Display on, cursor off, blink off
-    delay_ms(1);
+    initStep = 0;
+    initDue  = Clock_UptimeUs();
+    lcdReady = 0;
+    cursorShown = 0;   // The sequence ends with the cursor off
+}
+
+int LCD_Poll(void) {
+    if (lcdReady) {
+        return 1;
+    }
+
+    unsigned long now = Clock_UptimeUs();
+    if ((long)(now - initDue) < 0) {
+        return 0;  // LCD still busy with the previous step
+    }
+    if (initStep >= LCD_INIT_STEPS) {
+        lcdReady = 1;  // Last step's wait has passed
+        return 1;
+    }
+
+    const LcdInitStep *step = &initSteps[initStep];
+    if (step->kind == INIT_NIBBLE) {
+        LCD_SendNibble(step->value, 0);
+    } else if (step->kind == INIT_COMMAND) {
+        // Both nibbles without LCD_SendByte's blocking post-delay; the step wait covers it
+        LCD_SendNibble(step->value >> 4, 0);
+        LCD_SendNibble(step->value & 0x0F, 0);
+    }
+    initDue = Clock_UptimeUs() + step->waitUs;
+    initStep++;
+    return 0;
+}
+
+void LCD_Init(void) {
+    // Blocking version of the same sequence
+    LCD_InitStart();
+    while (!LCD_Poll()) {}
 }
 
 void LCD_Command(unsigned char command) {
+    TRACE(TRACE_LCD_COMMAND, command);
     LCD_SendByte(command, 0);  // Send command byte (isData = 0)
 }
 
 void LCD_Data(unsigned char data) {
+    TRACE(TRACE_LCD_DATA, data);
     LCD_SendByte(data, 1);  // Send data byte (isData = 1)
 }
 
@@ -66,7 +106,7 @@ void LCD_Clear(void) {
     delay_ms(2);        // Delay >1.52ms for processing
 }
 
-void LCD_String(char *str) {
+void LCD_String(const char *str) {
     // Send each character in the string to the LCD
     while (*str) {
         LCD_Data(*str++);
@@ -91,7 +131,69 @@ void LCD_SetCursor(unsigned char row, unsigned char col) {
     LCD_Command(address);  // Send address command to LCD
 }
 
+void LCD_WriteRow(unsigned char row, const char *str) {
+    LCD_SetCursor(row, 0);
+    for (int i = 0; i < LCD_COLUMNS; i++) {
+        LCD_Data(' ');
+    }
+    LCD_SetCursor(row, 0);
+    LCD_String(str);
+}
+
+void LCD_PatchRow(unsigned char row, char *shown, const char *str) {
+    int cursor = -1;     // Column the LCD address counter points at, -1 if not known
+    int shownEnd = 0;
+    int strEnd = 0;
+
+    while (shownEnd < LCD_ROW_CELLS && shown[shownEnd] != '\0') shownEnd++;
+    while (strEnd < LCD_ROW_CELLS && str[strEnd] != '\0') strEnd++;
+
+    int end = (strEnd > shownEnd) ? strEnd : shownEnd;
+    for (int col = 0; col < end; col++) {
+        char want = (col < strEnd) ? str[col] : ' ';
+        char have = (col < shownEnd) ? shown[col] : ' ';
+        if (want == have) {
+            continue;
+        }
+        if (cursor != col) {
+            LCD_SetCursor(row, col);
+        }
+        LCD_Data(want);
+        cursor = col + 1;
+    }
+
+    for (int col = 0; col < strEnd; col++) {
+        shown[col] = str[col];
+    }
+    shown[strEnd] = '\0';
+}
+
+void LCD_ShowCursor(unsigned char row, unsigned char col) {
+    LCD_SetCursor(row, col);
+    if (!cursorShown) {
+        LCD_Command(0x0F);  // Display on, cursor on, blink on
+        cursorShown = 1;
+    }
+}
+
+void LCD_HideCursor(void) {
+    if (cursorShown) {
+        LCD_Command(0x0C);  // Display on, cursor off, blink off
+        cursorShown = 0;
+    }
+}
+
+void LCD_ForgetRow(char *shown) {
+    // A character the calculator never writes, so every visible cell differs
+    for (int col = 0; col < LCD_COLUMNS; col++) {
+        shown[col] = '\xFF';
+    }
+    shown[LCD_COLUMNS] = '\0';
+}
+
 static void LCD_SendByte(unsigned char byte, unsigned char isData) {
+    PERF_BEGIN(PERF_LCD_BYTE);
+
     // Send the upper nibble (4 bits)
     LCD_SendNibble(byte >> 4, isData);
 
@@ -104,27 +206,24 @@ static void LCD_SendByte(unsigned char byte, unsigned char isData) {
     } else {
         delay_us(50);  // Other commands require >37�s
     }
+
+    PERF_END(PERF_LCD_BYTE);
 }
 
 static void LCD_SendNibble(unsigned char nibble, unsigned char isData) {
-    // Set RS line based on data/command mode
-    if (isData) {
-        GPIO_PORTA_DATA_R |= LCD_RS;  // RS = 1 for data
-    } else {
-        GPIO_PORTA_DATA_R &= ~LCD_RS;  // RS = 0 for command
-    }
+    // Set RS line based on data/command mode (RS = 1 for data, 0 for command)
+    GPIO_WritePins(GPIO_PORTA_BASE, LCD_RS_PIN, isData ? LCD_RS_PIN : 0);
 
-    // Send nibble to data pins
-    GPIO_PORTB_DATA_R &= ~LCD_DATA_PINS;         // Clear data pins
-    GPIO_PORTB_DATA_R |= (nibble & 0x0F);        // Set new nibble
+    // Send nibble to data pins in one store, so DB4-DB7 change together
+    GPIO_WritePins(GPIO_PORTB_BASE, LCD_DATA_MASK, nibble);
 
     // Small delay to meet setup time
     delay_us(1);
 
     // Pulse the EN line
-    GPIO_PORTA_DATA_R |= LCD_EN;   // EN = 1
-    delay_us(1);                   // EN high pulse width (>450ns)
-    GPIO_PORTA_DATA_R &= ~LCD_EN;  // EN = 0
+    GPIO_WritePins(GPIO_PORTA_BASE, LCD_EN_PIN, LCD_EN_PIN);  // EN = 1
+    delay_us(1);                                              // EN high pulse width (>450ns)
+    GPIO_WritePins(GPIO_PORTA_BASE, LCD_EN_PIN, 0);           // EN = 0
 
     // Small delay for hold time
     delay_us(1);
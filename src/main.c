@@ -7,98 +7,582 @@
 #include "lcd.h"
 #include "keypad.h"
 #include "calc.h"
+#include "func.h"
+#include "perf.h"
+#include "table.h"
+#include "integ.h"
+#include "stat.h"
+#include "rpn.h"
+#include "prog.h"
+#include "solve.h"
+#include "base.h"
+#include "console.h"
+#include "stack.h"
+#include "trace.h"
 
-#define LCD_COLUMNS 16
+/**
+ * @brief What row 1 should show after the current batch of keys
+ */
+typedef enum {
+    MODE_COMP,        // Normal expression entry
+    MODE_TABLE,       // f(X) table, see table.h
+    MODE_INTEG,       // Integration or summation, see integ.h
+    MODE_STAT,        // Single-variable statistics or regression, see stat.h
+    MODE_RPN,         // Stack entry, see rpn.h
+    MODE_PROG,        // Saving or running a stored program, see prog.h
+    MODE_SOLVE,       // Root of f(X), see solve.h
+    MODE_BASE         // Integer words in DEC/HEX/BIN/OCT, see base.h
+} CalcMode;
 
-int main(void)
+typedef enum {
+    VIEW_EXPRESSION,  // The expression being typed
+    VIEW_RESULT       // The result (or error) of the last '='
+} DisplayView;
+
+static CalcMode    mode = MODE_COMP;
+static DisplayView view = VIEW_EXPRESSION;
+static bool        displayDirty = true;
+static const char* drawnStatus = "";  // Row 0 text currently on the LCD (NULL => unknown)
+static char        resultText[32];
+static char        row1Shown[LCD_ROW_CELLS + 1];  // Row 1 as last written, so updates only touch changed cells
+static int         exprFirst = 0;  // First expression character on row 1, scrolled to keep the cursor in view
+
+// Live preview of the expression's value on row 0, redrawn at most every PREVIEW_INTERVAL_US
+// and only once the key queue is empty, so it never holds up key handling
+#define PREVIEW_INTERVAL_US 50000
+static bool          previewDirty = false;
+static unsigned long previewDrawnAt = 0;
+static char          previewText[LCD_COLUMNS + 1];
+
+// If user just did '=', next digit => new expression, next operator => continue from last.
+static bool justEvaluated = false;
+
+// KEY_RCL / KEY_STO / KEY_MODE waiting for the digit that completes it, shown on row 0
+static char   pendingPrefix = '\0';
+static double storeValue = 0.0;
+
+// MODE menu, one page (row 0, row 1) at a time. MODE again turns the page
+static const char* const modeMenu[][2] = {
+    {"1:COMP 2:TABLE", "3:INTEG 4:SUM"},
+    {"5:STAT 6:REG",   "7:RPN"},
+    {"8:PRGM 9:RUN",   "0:SOLVE .:BASE"}
+};
+#define MODE_MENU_PAGES (sizeof(modeMenu) / sizeof(modeMenu[0]))
+static unsigned char modePage = 0;
+
+/**
+ * @brief Maps the digit after RCL/STO to a variable: 1-6 => A-F, 7 => X, 8 => M, 0 => Ans. -1 if not a variable.
+ */
+static int digitToVariable(char key)
 {
-    PLL_init();
-    SysTick_init();
-    GPIO_Init();
-    LCD_Init();
-    Keypad_Init();
-    Calc_Init();
+    if(key>='1' && key<='6') return CALC_VAR_A + (key-'1');
+    if(key=='7') return CALC_VAR_X;
+    if(key=='8') return CALC_VAR_M;
+    if(key=='0') return CALC_VAR_ANS;
+    return -1;
+}
 
-    LCD_Clear();
+/**
+ * @brief Evaluates the expression and formats the answer into resultText. Returns false on error.
+ */
+static bool evaluateToText(double *answerOut)
+{
+    double answer= Calc_Evaluate();
 
-    // If user just did '=', next digit => new expression, next operator => continue from last.
-    bool justEvaluated=false;
+    if(Calc_HadError()){
+        strcpy(resultText, "Error!");
+        return false;
+    }
+    *answerOut= answer;
 
-    while(1){
-        char key= Keypad_GetKey();
-        if(key=='\0'){
-            // no press or SHIFT toggling
-            continue;
+    Calc_FormatLastResult(resultText);
+    return true;
+}
+
+/**
+ * @brief Inserts a variable into the expression, starting a new one if we just evaluated
+ */
+static void insertVariable(CalcVariable var)
+{
+    if(justEvaluated){
+        Calc_ClearExpression();
+        justEvaluated=false;
+    }
+    // Buffer full => the variable is not added, DEL makes room
+    Calc_AddVariable(var);
+    view=VIEW_EXPRESSION;
+}
+
+/**
+ * @brief Switches mode from the digit after MODE: 1 => COMP, 2 => TABLE, 3 => INTEGRATE, 4 => SUM,
+ *        5 => STAT, 6 => REG, 7 => RPN, 8 => PRGM, 9 => RUN, 0 => SOLVE, '.' => BASE.
+ *        Other keys keep the current mode.
+ */
+static void enterMode(char key)
+{
+    if(key=='1'){
+        mode=MODE_COMP;
+        Calc_ClearExpression();
+    }
+    else if(key=='2'){
+        mode=MODE_TABLE;
+        Table_Enter();
+    }
+    else if(key=='3' || key=='4'){
+        mode=MODE_INTEG;
+        Integ_Enter(key=='3' ? INTEG_INTEGRATE : INTEG_SUM);
+    }
+    else if(key=='5' || key=='6'){
+        mode=MODE_STAT;
+        Stat_Enter(key=='5' ? STAT_SINGLE : STAT_PAIRED);
+    }
+    else if(key=='7'){
+        mode=MODE_RPN;
+        Rpn_Enter();
+    }
+    else if(key=='8' || key=='9'){
+        mode=MODE_PROG;
+        Prog_Enter(key=='8' ? PROG_RECORD : PROG_RUN);
+    }
+    else if(key=='0'){
+        mode=MODE_SOLVE;
+        Solve_Enter();
+    }
+    else if(key=='.'){
+        mode=MODE_BASE;
+        Base_Enter();
+    }
+    else{
+        return;
+    }
+    Keypad_SetLayout(mode==MODE_BASE ? KEYPAD_LAYOUT_BASE : KEYPAD_LAYOUT_NORMAL);
+    view=VIEW_EXPRESSION;
+    justEvaluated=false;
+}
+
+/**
+ * @brief Row 0 text: a pending prefix, else the mode's prompt
+ */
+static const char* statusText(void)
+{
+    switch(pendingPrefix){
+        case KEY_RCL:  return "RCL";
+        case KEY_STO:  return "STO";
+        case KEY_MODE: return modeMenu[modePage][0];
+        default:       break;
+    }
+    switch(mode){
+        case MODE_TABLE: return Table_Prompt();
+        case MODE_INTEG: return Integ_Prompt();
+        case MODE_STAT:  return Stat_Prompt();
+        case MODE_PROG:  return Prog_Prompt();
+        case MODE_SOLVE: return Solve_Prompt();
+        default:         return "";
+    }
+}
+
+/**
+ * @brief Input phase: applies one key to the calculator state. No LCD access here.
+ */
+static void handleKey(char key)
+{
+    double answer;
+
+    displayDirty=true;
+
+    // Digit completing RCL/STO/MODE. Any other key cancels the prefix.
+    if(pendingPrefix!='\0'){
+        char prefix= pendingPrefix;
+        int  var= digitToVariable(key);
+        pendingPrefix='\0';
+
+        if(prefix==KEY_MODE && key==KEY_MODE){
+            modePage= (unsigned char)((modePage + 1) % MODE_MENU_PAGES);
+            pendingPrefix=KEY_MODE;
+        }
+        else if(prefix==KEY_MODE){
+            enterMode(key);
+        }
+        else if(var>=0 && prefix==KEY_RCL && mode==MODE_RPN){
+            Rpn_Push(Calc_RecallVariable((CalcVariable)var));
         }
+        else if(var>=0 && prefix==KEY_RCL){
+            insertVariable((CalcVariable)var);
+        }
+        else if(var>=0 && var!=CALC_VAR_ANS && prefix==KEY_STO){
+            Calc_StoreVariable((CalcVariable)var, storeValue);
+        }
+        return;
+    }
 
-        // If we just evaluated, handle new key
-        if(justEvaluated){
-            // if digit/trig => new expression
-            if( (key>='0' && key<='9') || key=='.' || key=='s' ||key=='c'||key=='t') {
-                Calc_ClearExpression();
-                LCD_Clear();
+    if(key==KEY_MODE){
+        pendingPrefix=KEY_MODE;
+        modePage=0;
+        return;
+    }
+    if(mode==MODE_BASE){
+        Base_HandleKey(key);  // Its own keys and no expression
+        return;
+    }
+
+    // Modes take the keys they need (e.g. '=' and paging in the table), the rest edit the expression
+    if(mode==MODE_TABLE && Table_HandleKey(key)){
+        return;
+    }
+    if(mode==MODE_INTEG && Integ_HandleKey(key)){
+        return;
+    }
+    if(mode==MODE_STAT && Stat_HandleKey(key)){
+        return;
+    }
+    if(mode==MODE_RPN && Rpn_HandleKey(key)){
+        return;
+    }
+    if(mode==MODE_PROG && Prog_HandleKey(key)){
+        return;
+    }
+    if(mode==MODE_SOLVE && Solve_HandleKey(key)){
+        return;
+    }
+
+    switch(key){
+        case KEY_RCL:
+            pendingPrefix=KEY_RCL;
+            return;
+
+        case KEY_STO:
+            if(mode==MODE_RPN){
+                storeValue= Rpn_X();
+                pendingPrefix=KEY_STO;
+                return;
+            }
+            // Evaluate first, then the next digit chooses where the result goes
+            view=VIEW_RESULT;
+            justEvaluated=true;
+            if(evaluateToText(&storeValue)){
+                pendingPrefix=KEY_STO;
+            }
+            return;
+
+        case KEY_MPLUS:
+        case KEY_MMINUS:
+            if(mode==MODE_RPN){
+                answer= Rpn_X();
+                Calc_MemoryAdd(key==KEY_MPLUS ? answer : -answer);
+                return;
+            }
+            view=VIEW_RESULT;
+            justEvaluated=true;
+            if(evaluateToText(&answer)){
+                Calc_MemoryAdd(key==KEY_MPLUS ? answer : -answer);
+            }
+            return;
+
+        case KEY_MR:
+            if(mode==MODE_RPN){
+                Rpn_Push(Calc_RecallVariable(CALC_VAR_M));
+                return;
+            }
+            insertVariable(CALC_VAR_M);
+            return;
+
+        case KEY_MC:
+            Calc_MemoryClear();
+            return;
+
+        case KEY_DEL:
+            // Straight after a result, DEL brings the expression back for editing
+            if(!justEvaluated){
+                Calc_Delete();
             }
             justEvaluated=false;
-        }
+            view=VIEW_EXPRESSION;
+            return;
 
-        // 'C' => clear
-        if(key=='C'){
+        case KEY_LEFT:
+        case KEY_RIGHT:
+            // After a result the cursor starts from the end of the expression
+            Calc_MoveCursor(key==KEY_LEFT ? -1 : 1);
+            justEvaluated=false;
+            view=VIEW_EXPRESSION;
+            return;
+
+        case KEY_SWAP:
+        case KEY_ROLL:
+        case KEY_LASTX:
+            return;  // Stack keys, only RPN mode uses them
+
+        default:
+            break;
+    }
+
+    // If we just evaluated, handle new key
+    if(justEvaluated){
+        // if digit/function => new expression
+        if( (key>='0' && key<='9') || key=='.' || Func_FromKey(key)>=0) {
             Calc_ClearExpression();
-            LCD_Clear();
-            continue;
         }
+        justEvaluated=false;
+    }
 
-        // '=' => evaluate
-        if(key=='='){
-            double answer= Calc_Evaluate();
+    // 'C' => clear
+    if(key=='C'){
+        Calc_ClearExpression();
+        view=VIEW_EXPRESSION;
+        return;
+    }
 
-            // Clear row=1
-            LCD_SetCursor(1,0);
-            for(int i=0;i<LCD_COLUMNS;i++){
-                LCD_Data(' ');
-            }
-            LCD_SetCursor(1,0);
+    // '=' => evaluate
+    if(key=='='){
+        evaluateToText(&answer);
+        view=VIEW_RESULT;
+        justEvaluated=true;
+        return;
+    }
 
-            if(Calc_HadError()){
-                LCD_String("Error!");
-            }
-            else{
-                // Format up to 3 decimals
-                char outBuf[32];
-                sprintf(outBuf,"%.3f", answer);
-                // strip trailing zeros
-                int length= (int)strlen(outBuf);
-                while(length>0 && outBuf[length-1]=='0'){
-                    length--;
-                    outBuf[length]='\0';
-                }
-                if(length>0 && outBuf[length-1]=='.'){
-                    length--;
-                    outBuf[length]='\0';
-                }
-
-                LCD_String(outBuf);
+    // Attempt to add key to expression. Buffer full => the key is dropped, DEL makes room
+    PERF_BEGIN(PERF_CALC_ADDCHAR);
+    Calc_AddChar(key);
+    PERF_END(PERF_CALC_ADDCHAR);
+    view=VIEW_EXPRESSION;
+}
+
+/**
+ * @brief Row 0 shows the preview while typing in COMP mode with no prefix pending
+ */
+static bool previewOwnsRow0(void)
+{
+    return mode==MODE_COMP && pendingPrefix=='\0' && view==VIEW_EXPRESSION;
+}
+
+/**
+ * @brief Draws the preview right-aligned on row 0, blank while the expression is incomplete
+ */
+static void drawPreview(void)
+{
+    char   text[32] = "";
+    char   row[LCD_COLUMNS + 1];
+    double value;
+
+    previewDirty=false;
+    if(!previewOwnsRow0()){
+        return;  // Mode or view changed since it was requested
+    }
+    previewDrawnAt= Clock_UptimeUs();
+
+    if(Calc_Preview(&value)){
+        Calc_FormatResult(value, text);
+    }
+    size_t length= strlen(text);
+    if(length > LCD_COLUMNS){
+        length= LCD_COLUMNS;
+    }
+    memset(row, ' ', LCD_COLUMNS);
+    memcpy(&row[LCD_COLUMNS - length], text, length);
+    row[LCD_COLUMNS]= '\0';
+
+    if(drawnStatus==previewText && strcmp(row, previewText)==0){
+        return;  // Unchanged
+    }
+    LCD_WriteRow(0, row);
+    strcpy(previewText, row);
+    drawnStatus= previewText;
+    LCD_ShowCursor(1, (unsigned char)(Calc_GetCursor() - exprFirst));  // The write above moved it
+}
+
+/**
+ * @brief Draws the part of the expression around the cursor on row 1 and puts the LCD cursor on it.
+ *        Only the cells that changed are written, i.e. those from the edit point on.
+ */
+static void drawExpression(void)
+{
+    char text[LCD_COLUMNS + 1];
+    int  cursor= Calc_GetCursor();
+
+    if(cursor < exprFirst){
+        exprFirst= cursor;
+    }
+    else if(cursor > exprFirst + LCD_COLUMNS - 1){
+        exprFirst= cursor - (LCD_COLUMNS - 1);
+    }
+    Calc_CopyExpression(text, exprFirst, LCD_COLUMNS);
+    LCD_PatchRow(1, row1Shown, text);
+    LCD_ShowCursor(1, (unsigned char)(cursor - exprFirst));
+}
+
+/**
+ * @brief Render phase: one coalesced update for however many keys were applied
+ */
+static void render(void)
+{
+    displayDirty=false;
+
+    if(mode==MODE_TABLE && Table_IsViewing() && pendingPrefix=='\0'){
+        Table_Draw();
+        drawnStatus=NULL;
+        LCD_ForgetRow(row1Shown);
+        LCD_HideCursor();
+        return;
+    }
+    if(mode==MODE_INTEG && Integ_OwnsDisplay() && pendingPrefix=='\0'){
+        Integ_Draw();
+        drawnStatus=NULL;
+        LCD_ForgetRow(row1Shown);
+        LCD_HideCursor();
+        return;
+    }
+    if(mode==MODE_STAT && Stat_OwnsDisplay() && pendingPrefix=='\0'){
+        Stat_Draw();
+        drawnStatus=NULL;
+        LCD_ForgetRow(row1Shown);
+        LCD_HideCursor();
+        return;
+    }
+    if(mode==MODE_SOLVE && Solve_OwnsDisplay() && pendingPrefix=='\0'){
+        Solve_Draw();
+        drawnStatus=NULL;
+        LCD_ForgetRow(row1Shown);
+        LCD_HideCursor();
+        return;
+    }
+    if(mode==MODE_PROG && Prog_OwnsDisplay() && pendingPrefix=='\0'){
+        Prog_Draw();
+        drawnStatus=NULL;
+        LCD_ForgetRow(row1Shown);
+        LCD_HideCursor();
+        return;
+    }
+    if(mode==MODE_RPN && pendingPrefix!=KEY_MODE){
+        Rpn_Draw();
+        if(pendingPrefix!='\0'){
+            // RCL / STO cover Y, X stays in view for the digit
+            LCD_WriteRow(0, statusText());
+            Rpn_ForgetDisplay();
+        }
+        drawnStatus=NULL;
+        LCD_ForgetRow(row1Shown);
+        LCD_HideCursor();
+        return;
+    }
+    if(mode==MODE_BASE && pendingPrefix=='\0'){
+        Base_Draw();
+        drawnStatus=NULL;
+        LCD_ForgetRow(row1Shown);
+        LCD_HideCursor();
+        return;
+    }
+    if(mode==MODE_RPN){
+        Rpn_ForgetDisplay();  // The MODE menu takes both rows
+    }
+    if(mode==MODE_BASE){
+        Base_ForgetDisplay();
+    }
+
+    // Row 0 only changes when its text does
+    const char* status= statusText();
+    previewDirty= previewOwnsRow0();  // If so it is drawn from the main loop once the keys are drained
+    if(!previewDirty && status!=drawnStatus){
+        LCD_WriteRow(0, status);
+        drawnStatus=status;
+    }
+
+    if(pendingPrefix==KEY_MODE){
+        LCD_PatchRow(1, row1Shown, modeMenu[modePage][1]);
+        LCD_HideCursor();
+        return;
+    }
+    if(view==VIEW_RESULT){
+        LCD_PatchRow(1, row1Shown, resultText);
+        LCD_HideCursor();
+        return;
+    }
+    drawExpression();
+}
+
+int main(void)
+{
+    // Keypad first: the PLL locks and the LCD powers up in the background,
+    // and keys pressed meanwhile are queued and applied, then drawn once the LCD is ready
+    Perf_Init();
+    PLL_init();
+#ifdef CALC_TRACE
+    Trace_Init();
+#endif
+    SysTick_init();
+    GPIO_Init();
+    Keypad_Init();
+    Calc_Init();
+    Console_Init();
+    LCD_InitStart();
+    displayDirty=false;
+
+    while(1){
+        bool busy= (mode==MODE_INTEG && Integ_IsBusy()) || (mode==MODE_SOLVE && Solve_IsBusy());
+
+        // Idle at low frequency while waiting for keys, boost as soon as there is work
+        if(!busy){
+            Clock_SetSpeed(CLOCK_SLOW);
+        }
+        Keypad_Scan();
+        if(busy || Keypad_HasKey() || Console_HasWork()){
+            Clock_SetSpeed(CLOCK_FAST);
+        }
+
+        // Drain every queued key before touching the LCD
+        unsigned long oldestKey= 0;
+        unsigned long queuedAt;
+        bool gotKey= false;
+        char key;
+        while((key= Keypad_Pop(&queuedAt))!='\0'){
+            if(!gotKey){
+                oldestKey= queuedAt;
+                gotKey= true;
+                Perf_BootMark(BOOT_FIRST_KEY);
             }
-            justEvaluated=true;
-            continue;
+            STACK_BEGIN(STACK_PATH_KEY);
+            handleKey(key);
+            STACK_END(STACK_PATH_KEY);
         }
 
-        // Attempt to add key to expression
-        if(Calc_AddChar(key)<0){
-            // buffer full => reset
-            Calc_ClearExpression();
-            LCD_Clear();
-            continue;
+        // Remote lines are evaluated in their own context, the keypad expression is untouched
+        STACK_BEGIN(STACK_PATH_CONSOLE);
+        Console_Poll();
+        STACK_END(STACK_PATH_CONSOLE);
+
+        // Long-running modes work in slices so keys (e.g. 'C' to abort) are still scanned
+        STACK_BEGIN(STACK_PATH_STEP);
+        if(mode==MODE_INTEG && Integ_IsBusy() && Integ_Step()){
+            displayDirty=true;
+        }
+        if(mode==MODE_SOLVE && Solve_IsBusy() && Solve_Step()){
+            displayDirty=true;
         }
+        STACK_END(STACK_PATH_STEP);
+
+        // Advances the LCD power-on sequence during boot. The sequence itself blanks the
+        // display, so there is nothing to draw until a key arrives.
+        bool lcdReady= LCD_Poll();
+        STACK_BEGIN(STACK_PATH_RENDER);
+        if(displayDirty && lcdReady){
+            render();
+            Perf_BootMark(BOOT_FIRST_DRAW);
+        }
+        if(previewDirty && lcdReady && !Keypad_HasKey() &&
+           Clock_UptimeUs() - previewDrawnAt >= PREVIEW_INTERVAL_US){
+            drawPreview();
+        }
+        STACK_END(STACK_PATH_RENDER);
+
+        // Stops in Stack_OnOverflow if the stack has run into its guard band
+        Stack_Check();
 
-        // Display expression on row=1
-        const char* expr= Calc_GetExpression();
-        LCD_SetCursor(1,0);
-        for(int i=0;i<LCD_COLUMNS;i++){
-            LCD_Data(' ');
+#ifdef CALC_PROFILE
+        if(gotKey){
+            Perf_Record(PERF_KEY_LATENCY, Cycles_Now() - oldestKey);
         }
-        LCD_SetCursor(1,0);
-        LCD_String(expr);
+#else
+        (void)oldestKey;
+#endif
     }
 
     return 0;
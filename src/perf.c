@@ -0,0 +1,66 @@
+#include "perf.h"
+#include "clock.h"
+
+static PerfStat      perfStats[PERF_METRIC_COUNT];
+static unsigned long bootTimes[BOOT_MARK_COUNT];
+
+void Perf_Init(void) {
+    // Enable trace so the DWT unit is clocked
+    CORE_DEMCR_R |= CORE_DEMCR_TRCENA;
+
+    // Reset and start the cycle counter
+    DWT_CYCCNT_R = 0;
+    DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;
+
+    Perf_Reset();
+}
+
+unsigned long Cycles_Now(void) {
+    return DWT_CYCCNT_R;
+}
+
+void Perf_Record(PerfMetric metric, unsigned long cycles) {
+    PerfStat *stat = &perfStats[metric];
+
+    if (stat->count == 0 || cycles < stat->min) {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max) {
+        stat->max = cycles;
+    }
+    stat->total += cycles;
+    stat->count++;
+}
+
+const PerfStat* Perf_Get(PerfMetric metric) {
+    return &perfStats[metric];
+}
+
+void Perf_Reset(void) {
+    for (int i = 0; i < PERF_METRIC_COUNT; i++) {
+        perfStats[i].count = 0;
+        perfStats[i].total = 0;
+        perfStats[i].min   = 0;
+        perfStats[i].max   = 0;
+    }
+}
+
+void Perf_BootMark(BootMark mark) {
+    if (bootTimes[mark] != 0) {
+        return;  // Only the first occurrence counts
+    }
+    bootTimes[mark] = Clock_UptimeUs();
+    if (bootTimes[mark] == 0) {
+        bootTimes[mark] = 1;  // Keep 0 meaning "not yet"
+    }
+    Perf_OnBootMark(mark, bootTimes[mark]);
+}
+
+unsigned long Perf_BootTimeUs(BootMark mark) {
+    return bootTimes[mark];
+}
+
+__attribute__((weak)) void Perf_OnBootMark(BootMark mark, unsigned long microseconds) {
+    (void)mark;
+    (void)microseconds;
+}
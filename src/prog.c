@@ -0,0 +1,291 @@
+#include "prog.h"
+#include "flash.h"
+#include "lcd.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef enum {
+    PROG_SELECT,          // Waiting for the slot digit
+    PROG_ENTER_PROGRAM,   // Typing the steps of the calculation to save
+    PROG_ENTER_INPUT,     // Typing the value of one input
+    PROG_VIEW             // Showing the result of a run
+} ProgStage;
+
+typedef enum {
+    NOTE_NONE,
+    NOTE_SAVED,
+    NOTE_EMPTY,
+    NOTE_FAILED
+} ProgNote;
+
+/**
+ * @brief One slot as stored in flash. Instructions are one byte each (opcode << 4 | slot) and
+ *        only the constants take a double, so a 32-instruction program fits in 168 bytes and
+ *        PROG_SLOTS of them in one page. An erased slot reads magic = 0xFFFFFFFF.
+ */
+#define PROG_MAGIC         0x50524F47UL  // "PROG"
+#define PROG_MAX_CONSTANTS (MAX_TOKENS / 2)  // n numbers need n-1 operators between them
+
+typedef struct {
+    uint32_t      magic;
+    unsigned char length;
+    unsigned char inputs;                           // Bit per CalcVariable read, Ans excluded
+    unsigned char constantCount;
+    unsigned char reserved;
+    unsigned char code[MAX_TOKENS];
+    double        constants[PROG_MAX_CONSTANTS];
+} ProgRecord;
+
+static ProgKind    kind = PROG_RUN;
+static ProgStage   stage = PROG_SELECT;
+static ProgNote    note = NOTE_NONE;
+static bool        inputError = false;
+static int         slot = 0;
+static CalcProgram program;         // The slot being run (unpacked once when it is picked) or saved
+static int         steps = 0;       // Steps compiled into program while recording
+static unsigned    inputs = 0;
+static int         input = 0;       // CalcVariable being asked for
+static double      result = 0.0;
+
+// main redraws row 0 when the prompt pointer changes, so a changed prompt goes in the other buffer
+static char promptText[2][LCD_COLUMNS + 1];
+static int  promptIndex = 0;
+
+static const char variableLetters[CALC_VAR_ANS] = {'A', 'B', 'C', 'D', 'E', 'F', 'X', 'M'};
+
+/**
+ * @brief Page image for a save, the flash page is erased and rewritten from it
+ */
+static ProgRecord page[PROG_SLOTS];
+
+static unsigned long slotAddress(int index)
+{
+    return FLASH_STORE_PAGE + (unsigned long)index * sizeof(ProgRecord);
+}
+
+static bool isErased(const void *data, int length)
+{
+    const unsigned char *bytes= (const unsigned char *)data;
+    for(int i=0; i<length; i++){
+        if(bytes[i]!=0xFF){
+            return false;
+        }
+    }
+    return true;
+}
+
+int Prog_Save(int index, const CalcProgram *prog)
+{
+    ProgRecord record;
+    int        constants= 0;
+
+    if(index<0 || index>=PROG_SLOTS){
+        return -1;
+    }
+    memset(&record, 0, sizeof(record));
+    record.magic= PROG_MAGIC;
+    record.length= (unsigned char)prog->length;
+
+    for(int pc=0; pc<prog->length; pc++){
+        const CalcInstr *ins= &prog->code[pc];
+        if(ins->opcode==CALC_OP_CONST){
+            if(constants>=PROG_MAX_CONSTANTS){
+                return -1;
+            }
+            record.constants[constants++]= ins->value;
+        }
+        else if(ins->opcode==CALC_OP_VAR && ins->slot<CALC_VAR_ANS){
+            record.inputs|= (unsigned char)(1u << ins->slot);
+        }
+        record.code[pc]= (unsigned char)((ins->opcode << 4) | ins->slot);
+    }
+    record.constantCount= (unsigned char)constants;
+
+    // Straight into an erased slot, otherwise the whole page is erased and written back
+    const void *stored= Flash_Read(slotAddress(index));
+    if(stored!=NULL && isErased(stored, sizeof(record))){
+        return Flash_Write(slotAddress(index), &record, sizeof(record));
+    }
+    const void *current= Flash_Read(FLASH_STORE_PAGE);
+    if(current==NULL){
+        return -1;
+    }
+    memcpy(page, current, sizeof(page));
+    page[index]= record;
+    if(Flash_ErasePage(FLASH_STORE_PAGE)<0){
+        return -1;
+    }
+    return Flash_Write(FLASH_STORE_PAGE, page, sizeof(page));
+}
+
+int Prog_Load(int index, CalcProgram *prog, unsigned *inputsOut)
+{
+    const ProgRecord *record;
+    int constants= 0;
+
+    if(index<0 || index>=PROG_SLOTS){
+        return -1;
+    }
+    record= (const ProgRecord *)Flash_Read(slotAddress(index));
+    if(record==NULL || record->magic!=PROG_MAGIC || record->length>MAX_TOKENS){
+        return -1;
+    }
+
+    prog->length= record->length;
+    for(int pc=0; pc<record->length; pc++){
+        CalcInstr *ins= &prog->code[pc];
+        memset(ins, 0, sizeof(*ins));
+        ins->opcode= record->code[pc] >> 4;
+        ins->slot= record->code[pc] & 0x0F;
+        if(ins->opcode==CALC_OP_CONST){
+            if(constants>=record->constantCount){
+                return -1;  // Not what Prog_Save wrote
+            }
+            ins->value= record->constants[constants++];
+        }
+    }
+    *inputsOut= record->inputs;
+    return 0;
+}
+
+/**
+ * @brief Moves to the next input after the current one, or runs the program once all are in
+ */
+static void nextInput(int from)
+{
+    for(input= from; input<CALC_VAR_ANS; input++){
+        if(inputs & (1u << input)){
+            stage= PROG_ENTER_INPUT;
+            return;
+        }
+    }
+
+    double x= Calc_RecallVariable(CALC_VAR_X);
+    Calc_EvaluateBatch(&program, &x, &result, 1);
+    stage= PROG_VIEW;
+}
+
+void Prog_Enter(ProgKind newKind)
+{
+    kind= newKind;
+    stage= PROG_SELECT;
+    note= NOTE_NONE;
+    inputError= false;
+    Calc_ClearExpression();
+}
+
+bool Prog_HandleKey(char key)
+{
+    if(stage==PROG_SELECT){
+        if(key>='1' && key<'1' + PROG_SLOTS){
+            slot= key - '1';
+            note= NOTE_NONE;
+            if(kind==PROG_RECORD){
+                program.length= 0;
+                steps= 0;
+                stage= PROG_ENTER_PROGRAM;
+            }
+            else if(Prog_Load(slot, &program, &inputs)<0){
+                note= NOTE_EMPTY;
+            }
+            else{
+                nextInput(0);
+            }
+        }
+        return true;  // Nothing is typed at the slot prompt
+    }
+
+    if(stage==PROG_VIEW){
+        // Next run: '=' asks for the inputs again, a digit already starts the first one
+        nextInput(0);
+        return key=='=' || stage==PROG_VIEW;
+    }
+
+    if(key!='='){
+        inputError= false;
+        return false;  // Typing the program or an input
+    }
+    if(Calc_GetExpression()[0]=='\0'){
+        if(stage==PROG_ENTER_PROGRAM && steps>0){
+            // '=' with nothing typed ends the recording
+            note= (Prog_Save(slot, &program)<0) ? NOTE_FAILED : NOTE_SAVED;
+            stage= PROG_SELECT;
+        }
+        return true;
+    }
+
+    if(stage==PROG_ENTER_PROGRAM){
+        // Each step goes onto the end of the static program, a CalcProgram is too big for the main stack
+        inputError= (Calc_CompileStep(&program)<0);
+        if(!inputError){
+            Calc_ClearExpression();
+            steps++;
+        }
+    }
+    else{
+        // An input, so Ans keeps the last calculation. The error goes before the clear resets it
+        double value= Calc_EvaluateInput();
+        inputError= (Calc_HadError()!=0);
+        Calc_ClearExpression();
+        if(!inputError){
+            Calc_StoreVariable((CalcVariable)input, value);
+            nextInput(input + 1);
+        }
+    }
+    return true;
+}
+
+const char* Prog_Prompt(void)
+{
+    static const char* const notes[] = {"", "saved.", "empty.", "failed."};
+    const char *error= inputError ? "Error! " : "";
+    char text[32];
+
+    switch(stage){
+        case PROG_SELECT:
+            if(note!=NOTE_NONE){
+                snprintf(text, sizeof(text), "P%d %s 1-%d?", slot + 1, notes[note], PROG_SLOTS);
+            }
+            else{
+                snprintf(text, sizeof(text), "%s 1-%d?", (kind==PROG_RECORD) ? "PRGM" : "RUN", PROG_SLOTS);
+            }
+            break;
+        case PROG_ENTER_PROGRAM:
+            snprintf(text, sizeof(text), "%sP%d.%d:", error, slot + 1, steps + 1);
+            break;
+        case PROG_ENTER_INPUT:
+            snprintf(text, sizeof(text), "%s%c?", error, variableLetters[input]);
+            break;
+        default:
+            text[0]= '\0';
+            break;
+    }
+    text[LCD_COLUMNS]= '\0';  // Cut to the row
+    if(strcmp(text, promptText[promptIndex])!=0){
+        promptIndex^= 1;
+        strcpy(promptText[promptIndex], text);
+    }
+    return promptText[promptIndex];
+}
+
+bool Prog_OwnsDisplay(void)
+{
+    return stage==PROG_VIEW;
+}
+
+void Prog_Draw(void)
+{
+    char text[32];
+
+    snprintf(text, sizeof(text), "P%d=", slot + 1);
+    LCD_WriteRow(0, text);
+    if(isfinite(result)){
+        Calc_FormatResult(result, text);
+        LCD_WriteRow(1, text);
+    }
+    else{
+        LCD_WriteRow(1, "Error!");  // Divide by zero, domain error or overflow
+    }
+}
@@ -0,0 +1,248 @@
+#include "rpn.h"
+#include "calc.h"
+#include "func.h"
+#include "keypad.h"
+#include "lcd.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Stack registers, x is the one shown on row 1
+ */
+static double x, y, z, t;
+static double lastX;
+static bool   liftEnabled = true;  // False straight after ENTER or CLx: the next number overwrites X
+static bool   error = false;       // Last operation had no result, the stack is unchanged
+
+// Number being typed into X
+static char entry[LCD_COLUMNS + 1];
+static int  entryLength = 0;
+static bool entering = false;
+
+static char rowShown[2][LCD_ROW_CELLS + 1];
+
+/**
+ * @brief Pushes the stack up one level, T is lost
+ */
+static void lift(void)
+{
+    t= z;
+    z= y;
+    y= x;
+}
+
+/**
+ * @brief Drops the stack one level after a two-operand operation, T is copied down
+ */
+static void drop(void)
+{
+    y= z;
+    z= t;
+}
+
+/**
+ * @brief The number being typed is final. Every key other than a digit, '.' or DEL ends it
+ */
+static void endEntry(void)
+{
+    entering= false;
+}
+
+static void typeDigit(char key)
+{
+    if(!entering){
+        if(liftEnabled){
+            lift();
+        }
+        entering= true;
+        entryLength= 0;
+    }
+    if(entryLength >= LCD_COLUMNS - 1 || (key=='.' && memchr(entry, '.', entryLength)!=NULL)){
+        return;
+    }
+    entry[entryLength++]= key;
+    entry[entryLength]= '\0';
+    x= atof(entry);
+    liftEnabled= true;
+}
+
+/**
+ * @brief x = y op x. Returns false (stack untouched) when there is no result
+ */
+static bool binary(char op)
+{
+    double r;
+
+    switch(op){
+        case '+': r= y + x;    break;
+        case '-': r= y - x;    break;
+        case '*': r= y * x;    break;
+        case '/': r= y / x;    break;
+        default:  r= Calc_Power(y, x); break;
+    }
+    if(!isfinite(r)){
+        return false;
+    }
+    lastX= x;
+    x= r;
+    drop();
+    return true;
+}
+
+static bool unary(int func)
+{
+    double r= Func_Apply((FuncId)func, x);
+
+    if(!isfinite(r)){
+        return false;
+    }
+    lastX= x;
+    x= r;
+    return true;
+}
+
+void Rpn_Enter(void)
+{
+    x= y= z= t= 0.0;
+    lastX= 0.0;
+    liftEnabled= true;
+    error= false;
+    entering= false;
+    Rpn_ForgetDisplay();
+}
+
+bool Rpn_HandleKey(char key)
+{
+    int func= Func_FromKey(key);
+
+    error= false;
+
+    if((key>='0' && key<='9') || key=='.'){
+        typeDigit(key);
+        return true;
+    }
+    if(key==KEY_DEL){
+        if(entering && entryLength > 1){
+            entry[--entryLength]= '\0';
+            x= atof(entry);
+        }
+        else{
+            // CLx: X becomes 0 and the next number replaces it
+            endEntry();
+            x= 0.0;
+            liftEnabled= false;
+        }
+        return true;
+    }
+    if(key==KEY_RCL || key==KEY_STO || key==KEY_MPLUS || key==KEY_MMINUS || key==KEY_MR || key==KEY_MC){
+        return false;
+    }
+
+    endEntry();
+    if(key!='\0' && strchr("+-*/^", key)!=NULL){
+        error= !binary(key);
+    }
+    else if(func>=0){
+        error= !unary(func);
+    }
+    else{
+        switch(key){
+            case '=':
+                lift();
+                liftEnabled= false;
+                return true;
+
+            case KEY_SWAP: {
+                double old= x;
+                x= y;
+                y= old;
+                break;
+            }
+
+            case KEY_ROLL: {
+                double old= x;
+                x= y;
+                drop();
+                t= old;
+                break;
+            }
+
+            case KEY_LASTX:
+                if(liftEnabled){
+                    lift();
+                }
+                x= lastX;
+                break;
+
+            case 'C':
+                x= y= z= t= 0.0;
+                break;
+
+            default:
+                return true;  // Nothing else means anything here
+        }
+    }
+    liftEnabled= true;
+    return true;
+}
+
+double Rpn_X(void)
+{
+    endEntry();
+    liftEnabled= true;
+    return x;
+}
+
+void Rpn_Push(double value)
+{
+    endEntry();
+    if(liftEnabled){
+        lift();
+    }
+    x= value;
+    liftEnabled= true;
+}
+
+void Rpn_ForgetDisplay(void)
+{
+    LCD_ForgetRow(rowShown[0]);
+    LCD_ForgetRow(rowShown[1]);
+}
+
+/**
+ * @brief One row: the register name on the left, the text right-aligned
+ */
+static void drawRow(unsigned char row, char name, const char *text)
+{
+    char   cells[LCD_COLUMNS + 1];
+    size_t length= strlen(text);
+
+    if(length > LCD_COLUMNS - 1){
+        length= LCD_COLUMNS - 1;
+    }
+    memset(cells, ' ', LCD_COLUMNS);
+    cells[0]= name;
+    memcpy(&cells[LCD_COLUMNS - length], text, length);
+    cells[LCD_COLUMNS]= '\0';
+    LCD_PatchRow(row, rowShown[row], cells);
+}
+
+void Rpn_Draw(void)
+{
+    char text[32];
+
+    Calc_FormatResult(y, text);
+    drawRow(0, 'Y', text);
+
+    if(error){
+        drawRow(1, 'X', "Error!");
+    }
+    else if(entering){
+        drawRow(1, 'X', entry);
+    }
+    else{
+        Calc_FormatResult(x, text);
+        drawRow(1, 'X', text);
+    }
+}
@@ -0,0 +1,260 @@
+#include "solve.h"
+#include "calc.h"
+#include "lcd.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+
+typedef enum {
+    SOLVE_ENTER_F,
+    SOLVE_ENTER_A,
+    SOLVE_ENTER_B,
+    SOLVE_RUNNING,
+    SOLVE_DONE
+} SolveStage;
+
+typedef enum {
+    OUTCOME_OK,
+    OUTCOME_ROUGH,    // SOLVE_MAX_ITER reached, X is the best estimate
+    OUTCOME_NO_ROOT,  // Flat or failing f(X) with no sign change to fall back on
+    OUTCOME_ABORTED
+} SolveOutcome;
+
+#define SOLVE_REL_TOL (4.0*DBL_EPSILON)  // Converged once a step is this small relative to X
+
+static SolveStage   stage = SOLVE_ENTER_F;
+static SolveOutcome outcome = OUTCOME_OK;
+static bool         inputError = false;
+static CalcProgram  function;
+
+static double endA = 0.0;
+static double endB = 0.0;
+
+/**
+ * @brief Iteration state. lo/hi hold a sign change of f while bracketed, fLo = f(lo)
+ */
+static double x, fx, dfx;
+static double lo, hi, fLo;
+static bool   bracketed = false;
+static double lastStep = 0.0;
+static int    iterations = 0;
+
+static bool differentSigns(double a, double b)
+{
+    return (a < 0.0) != (b < 0.0);
+}
+
+static void finish(SolveOutcome result)
+{
+    outcome= result;
+    stage= SOLVE_DONE;
+    if(result==OUTCOME_OK || result==OUTCOME_ROUGH){
+        Calc_StoreVariable(CALC_VAR_X, x);
+    }
+}
+
+/**
+ * @brief Takes the value typed for an interval end. Returns false if the expression had an error.
+ */
+static bool takeValue(double *value)
+{
+    *value= Calc_EvaluateInput();
+    bool valid= !Calc_HadError();
+    Calc_ClearExpression();  // Clears the error flag too
+    return valid;
+}
+
+static void start(void)
+{
+    double fa, da, fb, db;
+
+    Calc_EvaluateDual(&function, endA, &fa, &da);
+    Calc_EvaluateDual(&function, endB, &fb, &db);
+    iterations= 0;
+    lastStep= fabs(endB - endA);
+    stage= SOLVE_RUNNING;
+
+    bracketed= isfinite(fa) && isfinite(fb) && differentSigns(fa, fb);
+    if(bracketed){
+        lo= endA;
+        fLo= fa;
+        hi= endB;
+    }
+
+    // Start from the end nearer to a root
+    if(isfinite(fa) && (!isfinite(fb) || fabs(fa) <= fabs(fb))){
+        x= endA; fx= fa; dfx= da;
+    }
+    else if(isfinite(fb)){
+        x= endB; fx= fb; dfx= db;
+    }
+    else{
+        finish(OUTCOME_NO_ROOT);
+        return;
+    }
+    if(fx==0.0){
+        finish(OUTCOME_OK);
+    }
+}
+
+void Solve_Enter(void)
+{
+    stage= SOLVE_ENTER_F;
+    inputError= false;
+    Calc_ClearExpression();
+}
+
+bool Solve_HandleKey(char key)
+{
+    if(stage==SOLVE_RUNNING){
+        if(key=='C'){
+            finish(OUTCOME_ABORTED);
+        }
+        return true;  // Nothing else while running
+    }
+
+    if(stage==SOLVE_DONE){
+        if(key=='C' || key=='='){
+            Solve_Enter();
+        }
+        return true;
+    }
+
+    if(key!='='){
+        inputError= false;
+        return false;  // Typing f(X) or an interval end
+    }
+
+    switch(stage){
+        case SOLVE_ENTER_F:
+            inputError= (Calc_Compile(&function)<0);
+            if(!inputError){
+                Calc_ClearExpression();
+                stage= SOLVE_ENTER_A;
+            }
+            break;
+
+        case SOLVE_ENTER_A:
+            inputError= !takeValue(&endA);
+            if(!inputError) stage= SOLVE_ENTER_B;
+            break;
+
+        default:
+            inputError= !takeValue(&endB);
+            if(!inputError) start();
+            break;
+    }
+    return true;
+}
+
+bool Solve_Step(void)
+{
+    double next, fNext, dfNext;
+
+    if(stage!=SOLVE_RUNNING){
+        return false;
+    }
+
+    // Newton, unless it leaves the bracket or is not converging at least as fast as bisection
+    next= x - fx/dfx;
+    if(bracketed){
+        bool inside= (next >= fmin(lo, hi)) && (next <= fmax(lo, hi));
+        if(!inside || !(fabs(next - x) <= 0.5*lastStep)){
+            next= lo + 0.5*(hi - lo);
+        }
+    }
+    else if(!isfinite(next)){
+        finish(OUTCOME_NO_ROOT);  // f'(X) = 0 and nothing to bisect
+        return true;
+    }
+
+    Calc_EvaluateDual(&function, next, &fNext, &dfNext);
+    iterations++;
+    if(!isfinite(fNext)){
+        finish(OUTCOME_NO_ROOT);  // Left the domain of f(X)
+        return true;
+    }
+
+    double step= next - x;
+    lastStep= fabs(step);
+
+    if(bracketed){
+        if(differentSigns(fNext, fLo)){
+            hi= next;
+        }
+        else{
+            lo= next;
+            fLo= fNext;
+        }
+    }
+    else if(differentSigns(fNext, fx)){
+        bracketed= true;
+        lo= x;
+        fLo= fx;
+        hi= next;
+    }
+    x= next;
+    fx= fNext;
+    dfx= dfNext;
+
+    if(fx==0.0 || lastStep <= SOLVE_REL_TOL*fabs(x) ||
+       (bracketed && fabs(hi - lo) <= SOLVE_REL_TOL*fabs(x))){
+        finish(OUTCOME_OK);
+        return true;
+    }
+    if(iterations>=SOLVE_MAX_ITER){
+        finish(OUTCOME_ROUGH);
+        return true;
+    }
+    return false;
+}
+
+const char* Solve_Prompt(void)
+{
+    switch(stage){
+        case SOLVE_ENTER_F: return inputError ? "Error! f(X)=" : "Solve f(X)=";
+        case SOLVE_ENTER_A: return inputError ? "Error! a?"    : "a?";
+        case SOLVE_ENTER_B: return inputError ? "Error! b?"    : "b?";
+        default:            return "";
+    }
+}
+
+bool Solve_IsBusy(void)
+{
+    return stage==SOLVE_RUNNING;
+}
+
+bool Solve_OwnsDisplay(void)
+{
+    return stage==SOLVE_RUNNING || stage==SOLVE_DONE;
+}
+
+void Solve_Draw(void)
+{
+    char value[32];
+    char line[40];
+
+    if(stage==SOLVE_RUNNING){
+        LCD_WriteRow(0, "Solving...");
+        LCD_WriteRow(1, "C=abort");
+        return;
+    }
+
+    switch(outcome){
+        case OUTCOME_NO_ROOT:
+            LCD_WriteRow(0, "No root found");
+            LCD_WriteRow(1, "");
+            return;
+        case OUTCOME_ABORTED:
+            LCD_WriteRow(0, "Aborted");
+            LCD_WriteRow(1, "");
+            return;
+        default:
+            break;
+    }
+
+    snprintf(line, sizeof(line), "%s  (%d it)", outcome==OUTCOME_ROUGH ? "X~" : "X=", iterations);
+    LCD_WriteRow(0, line);
+    Calc_FormatResult(x, value);
+    LCD_WriteRow(1, value);
+}
@@ -0,0 +1,105 @@
+#include "stack.h"
+#include <stdint.h>
+
+#define STACK_GUARD_WORDS  (STACK_GUARD_BYTES / sizeof(unsigned long))
+#define STACK_REPAINT_GAP  16  // Words left alone below the caller, for this function's own frame
+
+// Both ends of the STACK area, exported by startup_TM4C123.s
+extern unsigned long Stack_Mem[];
+extern unsigned long Stack_Top[];
+
+static unsigned long highWater;                      // Deepest seen before a repaint erased it
+static unsigned long pathPeaks[STACK_PATH_COUNT];
+static unsigned      openPaths;                      // Bit per StackPath between BEGIN and END
+static bool          overflowReported;
+
+/**
+ * @brief Bytes from the top of the stack down to the lowest word that is not paint
+ */
+static unsigned long bytesUsed(void)
+{
+    const unsigned long *word= Stack_Mem;
+
+    while(word < Stack_Top && *word==STACK_PAINT){
+        word++;
+    }
+    return (unsigned long)(Stack_Top - word) * sizeof(unsigned long);
+}
+
+/**
+ * @brief Adds the current depth to every open path and to the high-water mark
+ */
+static void credit(void)
+{
+    unsigned long used= bytesUsed();
+
+    if(used > highWater){
+        highWater= used;
+    }
+    for(int i=0; i<STACK_PATH_COUNT; i++){
+        if((openPaths & (1u << i)) && used > pathPeaks[i]){
+            pathPeaks[i]= used;
+        }
+    }
+}
+
+unsigned long Stack_Capacity(void)
+{
+    return (unsigned long)(Stack_Top - Stack_Mem) * sizeof(unsigned long);
+}
+
+unsigned long Stack_HighWater(void)
+{
+    credit();
+    return highWater;
+}
+
+unsigned long Stack_PathPeak(StackPath path)
+{
+    return pathPeaks[path];
+}
+
+bool Stack_Check(void)
+{
+    for(unsigned i=0; i<STACK_GUARD_WORDS; i++){
+        if(Stack_Mem[i]!=STACK_PAINT){
+            if(!overflowReported){
+                overflowReported= true;
+                Stack_OnOverflow(Stack_HighWater());
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void Stack_PathBegin(StackPath path)
+{
+    volatile unsigned long here;  // Its address marks the bottom of the caller's frames
+    unsigned long *word= Stack_Mem + STACK_GUARD_WORDS;  // A written guard band stays as evidence
+    uintptr_t      bottom= (uintptr_t)&here - STACK_REPAINT_GAP * sizeof(unsigned long);
+    unsigned long *end= word;
+
+    // Not running on the stack (a host test off it): nothing of it to repaint
+    if(bottom > (uintptr_t)word && bottom <= (uintptr_t)Stack_Top){
+        end= (unsigned long *)bottom;
+    }
+
+    credit();
+    openPaths|= 1u << path;
+    while(word < end){
+        *word++= STACK_PAINT;
+    }
+}
+
+void Stack_PathEnd(StackPath path)
+{
+    credit();
+    openPaths&= ~(1u << path);
+}
+
+__attribute__((weak)) void Stack_OnOverflow(unsigned long highWaterBytes)
+{
+    (void)highWaterBytes;
+    while(1){ }
+}
@@ -0,0 +1,250 @@
+#include "stat.h"
+#include "calc.h"
+#include "func.h"
+#include "lcd.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef enum {
+    STAT_ENTER_X,
+    STAT_ENTER_Y,
+    STAT_VIEW
+} StatStage;
+
+static StatKind        kind = STAT_SINGLE;
+static StatStage       stage = STAT_ENTER_X;
+static StatStage       entryStage = STAT_ENTER_X;  // Stage to return to from STAT_VIEW
+static bool            inputError = false;
+static StatAccumulator data;
+static double          pendingX = 0.0;    // x of the pair whose y is being typed
+static StatResult      shown = STAT_N;
+
+// main redraws row 0 when the prompt pointer changes, so a changed prompt goes in the other buffer
+static char promptText[2][LCD_COLUMNS + 1];
+static int  promptIndex = 0;
+
+/**
+ * @brief Label on row 0 for each result
+ */
+static const char* const resultNames[STAT_RESULT_COUNT] = {
+    "n=", "mean=", "sigma=", "s=", "min=", "max=", "Sum x=", "Sum x2=",
+    "mean y=", "sigma y=", "Sum y=", "Sum y2=", "Sum xy=", "a=", "b=", "r="
+};
+
+/**
+ * @brief Result each function key shows
+ */
+static const StatResult keyResults[FUNC_COUNT] = {
+    [FUNC_SIN]  = STAT_N,
+    [FUNC_COS]  = STAT_MEAN,
+    [FUNC_TAN]  = STAT_SIGMA,
+    [FUNC_SQRT] = STAT_S,
+    [FUNC_LN]   = STAT_MIN,
+    [FUNC_LOG]  = STAT_MAX,
+    [FUNC_EXP]  = STAT_SUM_X,
+    [FUNC_ASIN] = STAT_A,
+    [FUNC_ACOS] = STAT_B,
+    [FUNC_ATAN] = STAT_R
+};
+
+void StatAcc_Clear(StatAccumulator *acc)
+{
+    memset(acc, 0, sizeof(*acc));
+}
+
+void StatAcc_Push(StatAccumulator *acc, double x, double y)
+{
+    if(acc->n++==0){
+        acc->originX= x;
+        acc->originY= y;
+    }
+
+    // Welford on the values relative to the first entry: the deviation from the old mean times the
+    // deviation from the new one. The shift keeps the running mean small when the data sits on a
+    // large offset, so it does not drift
+    double dx= (x - acc->originX) - acc->meanX;
+    double dy= (y - acc->originY) - acc->meanY;
+    acc->meanX+= dx / (double)acc->n;
+    acc->meanY+= dy / (double)acc->n;
+    acc->m2X+= dx * ((x - acc->originX) - acc->meanX);
+    acc->m2Y+= dy * ((y - acc->originY) - acc->meanY);
+    acc->cXY+= dx * ((y - acc->originY) - acc->meanY);
+
+    if(acc->n==1 || x < acc->minX) acc->minX= x;
+    if(acc->n==1 || x > acc->maxX) acc->maxX= x;
+
+    acc->sumX+= x;
+    acc->sumX2+= x*x;
+    acc->sumY+= y;
+    acc->sumY2+= y*y;
+    acc->sumXY+= x*y;
+}
+
+bool StatAcc_Result(const StatAccumulator *acc, StatResult which, double *value)
+{
+    double n= (double)acc->n;
+
+    if(acc->n==0 && which!=STAT_N){
+        return false;
+    }
+    switch(which){
+        case STAT_N:       *value= n;                            break;
+        case STAT_MEAN:    *value= acc->originX + acc->meanX;    break;
+        case STAT_SIGMA:   *value= sqrt(acc->m2X / n);           break;
+        case STAT_MIN:     *value= acc->minX;                    break;
+        case STAT_MAX:     *value= acc->maxX;                    break;
+        case STAT_SUM_X:   *value= acc->sumX;                    break;
+        case STAT_SUM_X2:  *value= acc->sumX2;                   break;
+        case STAT_MEAN_Y:  *value= acc->originY + acc->meanY;    break;
+        case STAT_SIGMA_Y: *value= sqrt(acc->m2Y / n);           break;
+        case STAT_SUM_Y:   *value= acc->sumY;                    break;
+        case STAT_SUM_Y2:  *value= acc->sumY2;                   break;
+        case STAT_SUM_XY:  *value= acc->sumXY;                   break;
+
+        case STAT_S:
+            if(acc->n < 2) return false;
+            *value= sqrt(acc->m2X / (n - 1.0));
+            break;
+
+        // Least squares from the co-moments: b = Cxy / M2x, a = mean y - b mean x
+        case STAT_B:
+        case STAT_A:
+            if(!(acc->m2X > 0.0)) return false;  // All x equal
+            *value= acc->cXY / acc->m2X;
+            if(which==STAT_A){
+                *value= (acc->originY + acc->meanY) - *value * (acc->originX + acc->meanX);
+            }
+            break;
+
+        case STAT_R:
+            if(!(acc->m2X > 0.0) || !(acc->m2Y > 0.0)) return false;
+            *value= acc->cXY / sqrt(acc->m2X * acc->m2Y);
+            break;
+
+        default:
+            return false;
+    }
+    return isfinite(*value);
+}
+
+/**
+ * @brief Takes the value typed for an entry. Returns false if the expression had an error.
+ */
+static bool takeValue(double *value)
+{
+    *value= Calc_EvaluateInput();
+    bool valid= !Calc_HadError();
+    Calc_ClearExpression();  // Clears the error flag too
+    return valid;
+}
+
+/**
+ * @brief Results that exist for this kind of data: single-variable data stops before the y ones
+ */
+static StatResult resultCount(void)
+{
+    return (kind==STAT_PAIRED) ? STAT_RESULT_COUNT : STAT_MEAN_Y;
+}
+
+void Stat_Enter(StatKind newKind)
+{
+    kind= newKind;
+    stage= STAT_ENTER_X;
+    inputError= false;
+    StatAcc_Clear(&data);
+    Calc_ClearExpression();
+}
+
+bool Stat_HandleKey(char key)
+{
+    int func= Func_FromKey(key);
+
+    if(stage==STAT_VIEW){
+        if(key=='+' || key=='-'){
+            StatResult count= resultCount();
+            shown= (StatResult)((shown + (key=='+' ? 1 : count - 1)) % count);
+            return true;
+        }
+        if(func>=0 && keyResults[func] < resultCount()){
+            shown= keyResults[func];
+            return true;
+        }
+        // Back to the entry that was being typed, where the key is applied
+        stage= entryStage;
+        return key=='=';
+    }
+
+    // Function keys read results instead of typing function names
+    if(func>=0){
+        if(keyResults[func] < resultCount()){
+            shown= keyResults[func];
+            entryStage= stage;
+            stage= STAT_VIEW;
+        }
+        return true;
+    }
+
+    if(key!='='){
+        inputError= false;
+        return false;  // Typing an entry
+    }
+    if(Calc_GetExpression()[0]=='\0'){
+        return true;   // Nothing typed, nothing to add
+    }
+
+    if(stage==STAT_ENTER_X){
+        inputError= !takeValue(&pendingX);
+        if(!inputError){
+            if(kind==STAT_PAIRED){
+                stage= STAT_ENTER_Y;
+            }
+            else{
+                StatAcc_Push(&data, pendingX, 0.0);
+            }
+        }
+    }
+    else{
+        double y;
+        inputError= !takeValue(&y);
+        if(!inputError){
+            StatAcc_Push(&data, pendingX, y);
+            stage= STAT_ENTER_X;
+        }
+    }
+    return true;
+}
+
+const char* Stat_Prompt(void)
+{
+    char text[32];
+
+    snprintf(text, sizeof(text), "%s%c%ld?", inputError ? "Error! " : "",
+             (stage==STAT_ENTER_Y) ? 'y' : 'x', data.n + 1);
+    text[LCD_COLUMNS]= '\0';  // Cut to the row
+    if(strcmp(text, promptText[promptIndex])!=0){
+        promptIndex^= 1;
+        strcpy(promptText[promptIndex], text);
+    }
+    return promptText[promptIndex];
+}
+
+bool Stat_OwnsDisplay(void)
+{
+    return stage==STAT_VIEW;
+}
+
+void Stat_Draw(void)
+{
+    char   text[32];
+    double value;
+
+    LCD_WriteRow(0, resultNames[shown]);
+    if(StatAcc_Result(&data, shown, &value)){
+        Calc_FormatResult(value, text);
+        LCD_WriteRow(1, text);
+    }
+    else{
+        LCD_WriteRow(1, "Error!");
+    }
+}
@@ -0,0 +1,175 @@
+#include "table.h"
+#include "calc.h"
+#include "lcd.h"
+#include <math.h>
+#include <stdio.h>
+
+typedef enum {
+    TABLE_ENTER_F,
+    TABLE_ENTER_START,
+    TABLE_ENTER_END,
+    TABLE_ENTER_STEP,
+    TABLE_VIEW
+} TableStage;
+
+static TableStage  stage = TABLE_ENTER_F;
+static bool        inputError = false;
+static CalcProgram tableProgram;
+
+static double startX = 0.0;
+static double endX   = 0.0;
+static double stepX  = 1.0;
+static long   rowCount = 0;
+static long   rowIndex = 0;
+
+/**
+ * @brief One page of the table, evaluated in a single batched pass
+ */
+static long   pageStart = -1;
+static int    pageCount = 0;
+static double pageX[CALC_BATCH];
+static double pageF[CALC_BATCH];
+
+/**
+ * @brief Evaluates the page holding rowIndex, unless it is already cached
+ */
+static void loadPage(void)
+{
+    long first= (rowIndex / CALC_BATCH) * CALC_BATCH;
+    if(first==pageStart){
+        return;
+    }
+
+    pageStart= first;
+    pageCount= (rowCount - first < CALC_BATCH) ? (int)(rowCount - first) : CALC_BATCH;
+
+    // X from the row number (not a running sum) so rounding does not build up
+    for(int i=0; i<pageCount; i++){
+        pageX[i]= startX + (double)(first + i) * stepX;
+    }
+    Calc_EvaluateBatch(&tableProgram, pageX, pageF, pageCount);
+}
+
+static void moveTo(long row)
+{
+    if(row<0) row= 0;
+    if(row>=rowCount) row= rowCount-1;
+    rowIndex= row;
+    loadPage();
+}
+
+/**
+ * @brief Takes the value typed for Start/End/Step, leaving Ans alone. Returns false if the expression had an error.
+ */
+static bool takeValue(double *value)
+{
+    *value= Calc_EvaluateInput();
+    bool valid= !Calc_HadError();
+    Calc_ClearExpression();  // Clears the error flag too
+    return valid;
+}
+
+void Table_Enter(void)
+{
+    stage= TABLE_ENTER_F;
+    inputError= false;
+    pageStart= -1;
+    Calc_ClearExpression();
+}
+
+bool Table_HandleKey(char key)
+{
+    if(stage!=TABLE_VIEW){
+        if(key!='='){
+            inputError= false;
+            return false;  // Typing f(X) or a limit
+        }
+
+        switch(stage){
+            case TABLE_ENTER_F:
+                inputError= (Calc_Compile(&tableProgram)<0);
+                if(!inputError){
+                    Calc_ClearExpression();
+                    stage= TABLE_ENTER_START;
+                }
+                break;
+
+            case TABLE_ENTER_START:
+                inputError= !takeValue(&startX);
+                if(!inputError) stage= TABLE_ENTER_END;
+                break;
+
+            case TABLE_ENTER_END:
+                inputError= !takeValue(&endX);
+                if(!inputError) stage= TABLE_ENTER_STEP;
+                break;
+
+            default:
+                inputError= !takeValue(&stepX) || stepX==0.0;
+                if(!inputError){
+                    double span= (endX-startX)/stepX;
+                    inputError= !(span>=0.0);  // Also rejects NaN
+                    if(!inputError){
+                        // Small tolerance so e.g. 0..1 step 0.1 includes the end point. Clamped first,
+                        // as a span beyond the range of long (or infinite) cannot be converted
+                        span= floor(span + 1e-9);
+                        rowCount= (span < TABLE_MAX_ROWS - 1) ? (long)span + 1 : TABLE_MAX_ROWS;
+                        pageStart= -1;
+                        stage= TABLE_VIEW;
+                        moveTo(0);
+                    }
+                }
+                break;
+        }
+        return true;
+    }
+
+    switch(key){
+        case '+': moveTo(rowIndex+1);          break;
+        case '-': moveTo(rowIndex-1);          break;
+        case '*': moveTo(rowIndex+CALC_BATCH); break;
+        case '/': moveTo(rowIndex-CALC_BATCH); break;
+        case 'C':
+            Table_Enter();
+            break;
+        default:
+            break;  // Everything else is ignored while viewing
+    }
+    return true;
+}
+
+const char* Table_Prompt(void)
+{
+    switch(stage){
+        case TABLE_ENTER_F:     return inputError ? "Error! f(X)=" : "f(X)=";
+        case TABLE_ENTER_START: return inputError ? "Error! Start?" : "Start?";
+        case TABLE_ENTER_END:   return inputError ? "Error! End?"   : "End?";
+        case TABLE_ENTER_STEP:  return inputError ? "Error! Step?"  : "Step?";
+        default:                return "";
+    }
+}
+
+bool Table_IsViewing(void)
+{
+    return stage==TABLE_VIEW;
+}
+
+void Table_Draw(void)
+{
+    char value[32];
+    char line[40];
+    int  i= (int)(rowIndex - pageStart);
+
+    Calc_FormatResult(pageX[i], value);
+    snprintf(line, sizeof(line), "X=%s", value);
+    LCD_WriteRow(0, line);
+
+    if(isfinite(pageF[i])){
+        Calc_FormatResult(pageF[i], value);
+        snprintf(line, sizeof(line), "f=%s", value);
+    }
+    else{
+        snprintf(line, sizeof(line), "f=Error");
+    }
+    LCD_WriteRow(1, line);
+}
@@ -0,0 +1,22 @@
+#include "trace.h"
+#include "perf.h"
+#include "clock.h"
+
+// Not static so the debugger can find it by name
+TraceBuffer traceBuffer;
+
+void Trace_Init(void) {
+    traceBuffer.magic = TRACE_MAGIC;
+    traceBuffer.capacity = TRACE_RECORDS;
+    traceBuffer.head = 0;
+    Trace_Record(TRACE_CLOCK, Clock_GetHz() / 1000000);
+}
+
+void Trace_Record(TraceEvent event, unsigned long arg) {
+    // Claim a slot first, so an interrupt arriving halfway through gets the next one
+    unsigned long slot = __atomic_fetch_add(&traceBuffer.head, 1, __ATOMIC_RELAXED) & (TRACE_RECORDS - 1);
+    TraceRecord *r = &traceBuffer.records[slot];
+
+    r->cycles = Cycles_Now();
+    r->word = ((unsigned long)event << 24) | (arg & 0x00FFFFFF);
+}
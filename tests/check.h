@@ -0,0 +1,51 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+/**
+ * @file check.h
+ * @brief Host test helpers (see tests/Makefile):
+ *        - Each test_*.c is its own program linking the modules it covers and the host
+ *          stand-ins from tools/
+ *        - A failed CHECK prints the file, line and condition and the test carries on
+ *        - main returns CHECK_RESULT(), which prints a summary and is non-zero on any failure
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static int checkCount = 0;
+static int checkFailures = 0;
+
+#define CHECK(cond) do { \
+        checkCount++; \
+        if(!(cond)){ \
+            checkFailures++; \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while(0)
+
+/// Passes if actual is within tolerance of expected, or both are the same NaN/infinity
+#define CHECK_NEAR(actual, expected, tolerance) do { \
+        double checkA = (actual), checkE = (expected); \
+        checkCount++; \
+        if(!(fabs(checkA - checkE) <= (tolerance) || checkA == checkE || (isnan(checkA) && isnan(checkE)))){ \
+            checkFailures++; \
+            printf("%s:%d: %s = %.17g, expected %.17g\n", __FILE__, __LINE__, #actual, checkA, checkE); \
+        } \
+    } while(0)
+
+#define CHECK_STR(actual, expected) do { \
+        const char *checkA = (actual), *checkE = (expected); \
+        checkCount++; \
+        if(strcmp(checkA, checkE) != 0){ \
+            checkFailures++; \
+            printf("%s:%d: %s = \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, checkA, checkE); \
+        } \
+    } while(0)
+
+#define CHECK_RESULT() ( \
+        printf("%s: %d checks, %d failed\n", __FILE__, checkCount, checkFailures), \
+        checkFailures != 0)
+
+#endif // CHECK_H
@@ -0,0 +1,48 @@
+#ifndef KEYS_H
+#define KEYS_H
+
+/**
+ * @file keys.h
+ * @brief Types keys into the calculator as main.c's handleKey would for a mode:
+ *        the mode's handler sees each key first, the keys it leaves edit the expression.
+ *        'X' inserts the variable X, 'A' its own variable A (RCL 1 on the keypad).
+ */
+
+#include "calc.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef bool (*KeyHandler)(char key);
+
+static inline void typeKeys(const char *keys, KeyHandler handler)
+{
+    for(const char *k = keys; *k; k++){
+        if(handler != NULL && handler(*k)){
+            continue;
+        }
+        if(*k == 'X'){
+            Calc_AddVariable(CALC_VAR_X);
+        }
+        else if(*k == 'A'){
+            Calc_AddVariable(CALC_VAR_A);
+        }
+        else if(*k == 'C'){
+            Calc_ClearExpression();
+        }
+        else{
+            Calc_AddChar(*k);
+        }
+    }
+}
+
+/// Evaluates keys as a calculation on its own ('='), which sets Ans
+static inline double calculate(const char *keys)
+{
+    Calc_ClearExpression();
+    typeKeys(keys, NULL);
+    double value = Calc_Evaluate();
+    Calc_ClearExpression();
+    return value;
+}
+
+#endif // KEYS_H
@@ -0,0 +1,106 @@
+/*
+Continuing from Ans: a leading operator puts the last result in front as a
+token, with its exact binary value, and the typed text stays as entered.
+*/
+
+#include "check.h"
+#include "keys.h"
+#include <math.h>
+
+/**
+ * @brief Evaluates keys as typed after a result, continuing from it. The expression stays
+ */
+static double chain(const char *keys)
+{
+    Calc_ClearExpression();
+    typeKeys(keys, NULL);
+    return Calc_Evaluate();
+}
+
+static void testNoAns(void)
+{
+    // Nothing calculated yet: a leading operator has no left operand (there is no sign key)
+    CHECK(chain("-5") == 0.0);
+    CHECK(Calc_HadError());
+    CHECK(calculate("10") == 10.0);
+    CHECK(chain("-5") == 5.0);
+}
+
+static void testPrecision(void)
+{
+    // The sprintf("%.6f") splice drifted by 3e-7 here
+    CHECK(calculate("1/3") == 1.0 / 3.0);
+    for(int i=0; i<20; i++){
+        chain("*3");
+        chain("/3");
+    }
+    CHECK(Calc_RecallVariable(CALC_VAR_ANS) == 1.0 / 3.0);
+
+    CHECK(calculate("0.1") == 0.1);
+    CHECK(chain("*0.000001") == 0.1 * 0.000001);   // Six decimals would have made it 0
+    CHECK(chain("^0.5") == sqrt(0.1 * 0.000001));
+}
+
+static void testLongValue(void)
+{
+    double big = pow(9.0, 300.0);
+
+    // 287 digits would not have fit the 64-byte buffer as text
+    CHECK(calculate("9^300") == big);
+    CHECK(chain("*2") == big * 2.0);
+    CHECK(!Calc_HadError());
+    CHECK_STR(Calc_GetExpression(), "*2");
+    CHECK(chain("/2") == big);
+}
+
+static void testAnsToken(void)
+{
+    CHECK(calculate("2.5") == 2.5);
+    Calc_ClearExpression();
+    Calc_AddVariable(CALC_VAR_ANS);
+    typeKeys("*4", NULL);
+    CHECK(Calc_Evaluate() == 10.0);
+
+    // Same text, different Ans: the cache must not hand back the old value
+    Calc_CacheClear();
+    CHECK(calculate("0.25") == 0.25);
+    CHECK(chain("*4") == 1.0);
+    CHECK(calculate("0.75") == 0.75);
+    CHECK(chain("*4") == 3.0);
+}
+
+static void testErrorKeepsAns(void)
+{
+    CHECK(calculate("7") == 7.0);
+    chain("/0");
+    CHECK(Calc_HadError());
+    CHECK(chain("+1") == 8.0);
+    CHECK(!Calc_HadError());
+}
+
+static void testPreviewAndCompile(void)
+{
+    double value = 0.0;
+    CalcProgram program;
+
+    CHECK(calculate("1.25") == 1.25);
+    Calc_ClearExpression();
+    typeKeys("*2", NULL);
+    CHECK(Calc_Preview(&value) && value == 2.5);
+
+    // A compiled program has no Ans to continue from, so the leading operator is an error
+    CHECK(Calc_Compile(&program) < 0);
+    CHECK(Calc_HadError());
+}
+
+int main(void)
+{
+    Calc_Init();
+    testNoAns();
+    testPrecision();
+    testLongValue();
+    testAnsToken();
+    testErrorKeepsAns();
+    testPreviewAndCompile();
+    return CHECK_RESULT();
+}
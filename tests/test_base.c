@@ -0,0 +1,276 @@
+/*
+Programmer mode (base.c): every operator on every word size against a
+reference on the word, table-driven conversion against printf, word size
+changes, and scrolling long words across the row.
+*/
+
+#include "check.h"
+#include "host.h"
+#include "keypad.h"
+#include "base.h"
+#include "lcd.h"
+#include <inttypes.h>
+#include <stdlib.h>
+
+#define TRIALS 2000
+
+static const int    wordSizes[] = {8, 16, 32, 64};
+static const char   operators[] = {'+', '-', '*', '/', KEY_AND, KEY_OR, KEY_XOR, KEY_SHL, KEY_SHR};
+
+static unsigned long long next = 88172645463325252ULL;
+
+static unsigned long long random64(void)
+{
+    next ^= next << 13;
+    next ^= next >> 7;
+    next ^= next << 17;
+    return next;
+}
+
+static unsigned long long maskFor(int bits)
+{
+    return (bits == 64) ? ~0ULL : (1ULL << bits) - 1;
+}
+
+static long long signedWord(unsigned long long value, int bits)
+{
+    if(bits < 64 && (value & (1ULL << (bits - 1)))){
+        value |= ~maskFor(bits);
+    }
+    return (long long)value;
+}
+
+/**
+ * @brief a op b on a word, written from the description in base.h. Returns false for / by 0
+ */
+static bool reference(char op, unsigned long long a, unsigned long long b, int bits, unsigned long long *r)
+{
+    long long sa = signedWord(a, bits), sb = signedWord(b, bits);
+
+    switch(op){
+        case '+':     *r = a + b; break;
+        case '-':     *r = a - b; break;
+        case '*':     *r = a * b; break;
+        case KEY_AND: *r = a & b; break;
+        case KEY_OR:  *r = a | b; break;
+        case KEY_XOR: *r = a ^ b; break;
+        case KEY_SHL: *r = (b >= (unsigned)bits) ? 0 : a << b; break;
+        case KEY_SHR: *r = (unsigned long long)(sa >> (b >= (unsigned)bits ? bits - 1 : (int)b)); break;
+        default:
+            if(sb == 0){
+                return false;
+            }
+            // The most negative word / -1 wraps back to itself
+            *r = (sa == (long long)(1ULL << 63) && sb == -1) ? (unsigned long long)sa
+               : (sb == -1) ? 0 - (unsigned long long)sa : (unsigned long long)(sa / sb);
+            break;
+    }
+    *r &= maskFor(bits);
+    return true;
+}
+
+static void keys(const char *text)
+{
+    for(const char *k = text; *k; k++){
+        Base_HandleKey(*k);
+    }
+}
+
+/**
+ * @brief Types a word as hex digits (the keypad's a-f)
+ */
+static void typeHex(unsigned long long value)
+{
+    char text[17];
+    snprintf(text, sizeof(text), "%" PRIx64, (uint64_t)value);
+    keys(text);
+}
+
+/**
+ * @brief Row 1 without the padding either side
+ */
+static const char* shown(void)
+{
+    static char cells[LCD_COLUMNS + 1];
+    const char *row = cells;
+
+    Base_Draw();
+    memcpy(cells, GpioHost_LcdRow(1), LCD_COLUMNS);
+    for(int i = LCD_COLUMNS - 1; i >= 0 && cells[i] == ' '; i--){
+        cells[i] = '\0';    // "Error!" is on the left
+    }
+    while(*row == ' '){
+        row++;
+    }
+    return row;
+}
+
+/**
+ * @brief Base_Enter, then HEX and the word size
+ */
+static void enterHex(int bits)
+{
+    Base_Enter();
+    keys("$");
+    while(1){
+        Base_Draw();
+        char name[8];
+        snprintf(name, sizeof(name), "HEX%d", bits);
+        if(strncmp(GpioHost_LcdRow(0), name, strlen(name)) == 0 && GpioHost_LcdRow(0)[strlen(name)] == ' '){
+            break;
+        }
+        keys("%");
+    }
+}
+
+static void testOperators(void)
+{
+    for(unsigned w=0; w<sizeof(wordSizes)/sizeof(wordSizes[0]); w++){
+        int bits = wordSizes[w];
+        enterHex(bits);
+        for(unsigned o=0; o<sizeof(operators); o++){
+            int wrong = 0;
+            for(int i=0; i<TRIALS / 8; i++){
+                unsigned long long a = random64() & maskFor(bits);
+                unsigned long long b = random64() & maskFor(bits);
+                if(operators[o] == KEY_SHL || operators[o] == KEY_SHR){
+                    b = random64() % (unsigned)(bits + 3);
+                }
+                else if(i % 4 == 0){
+                    b = (unsigned long long)(long long)((int)(random64() % 7) - 3) & maskFor(bits);  // -3..3
+                }
+                if(i == 0){
+                    a = 1ULL << (bits - 1);             // Most negative word
+                    b = maskFor(bits);                  // -1
+                }
+
+                unsigned long long expected;
+                bool defined = reference(operators[o], a, b, bits, &expected);
+                char text[BASE_TEXT_MAX];
+                keys("C");
+                typeHex(a);
+                Base_HandleKey(operators[o]);
+                typeHex(b);
+                keys("=");
+                if(defined){
+                    Base_Format(expected, 16, bits, text);
+                }
+                else{
+                    strcpy(text, "Error!");
+                }
+                if(strcmp(shown(), text) != 0 && wrong++ == 0){
+                    printf("  %d-bit %llx %c %llx shows %s, expected %s\n", bits, a, operators[o], b, shown(), text);
+                }
+            }
+            CHECK(wrong == 0);
+        }
+
+        // NOT complements the word shown
+        keys("C");
+        typeHex(0x5A);
+        keys("~");
+        char text[BASE_TEXT_MAX];
+        Base_Format(~0x5AULL, 16, bits, text);
+        CHECK_STR(shown(), text);
+    }
+
+    // Left to right, no precedence; a digit that does not fit the word is dropped
+    enterHex(32);
+    keys("2+3*4=");
+    CHECK_STR(shown(), "00000014");
+    Base_Enter();
+    keys("%%");       // 8-bit DEC
+    keys("256");
+    CHECK_STR(shown(), "25");
+    keys("K");
+    CHECK_STR(shown(), "2");
+}
+
+static void testFormat(void)
+{
+    int wrong = 0;
+
+    for(int i=0; i<TRIALS * 10; i++){
+        int bits = wordSizes[i % 4];
+        unsigned long long value = random64() >> (random64() % 64);
+        unsigned long long word = value & maskFor(bits);
+        char text[BASE_TEXT_MAX], expected[BASE_TEXT_MAX];
+
+        snprintf(expected, sizeof(expected), "%" PRId64, (int64_t)signedWord(word, bits));
+        Base_Format(value, 10, bits, text);
+        wrong += (strcmp(text, expected) != 0);
+
+        snprintf(expected, sizeof(expected), "%0*" PRIX64, bits / 4, (uint64_t)word);
+        Base_Format(value, 16, bits, text);
+        wrong += (strcmp(text, expected) != 0);
+
+        snprintf(expected, sizeof(expected), "%0*" PRIo64, (bits + 2) / 3, (uint64_t)word);
+        Base_Format(value, 8, bits, text);
+        wrong += (strcmp(text, expected) != 0);
+
+        for(int b=0; b<bits; b++){
+            expected[b] = (word >> (bits - 1 - b)) & 1 ? '1' : '0';
+        }
+        expected[bits] = '\0';
+        wrong += (Base_Format(value, 2, bits, text) != bits || strcmp(text, expected) != 0);
+    }
+    CHECK(wrong == 0);
+
+    char text[BASE_TEXT_MAX];
+    Base_Format(1ULL << 63, 10, 64, text);
+    CHECK_STR(text, "-9223372036854775808");
+    Base_Format(0x80, 10, 8, text);
+    CHECK_STR(text, "-128");
+    Base_Format(0, 10, 16, text);
+    CHECK_STR(text, "0");
+}
+
+static void testWordSize(void)
+{
+    // Wider sign-extends, narrower truncates
+    Base_Enter();
+    keys("1-2=");
+    CHECK_STR(shown(), "-1");
+    keys("$");                                   // HEX32
+    CHECK_STR(shown(), "FFFFFFFF");
+    keys("%");                                   // 64
+    CHECK_STR(shown(), "FFFFFFFFFFFFFFFF");
+    keys("%");                                   // 8
+    CHECK_STR(shown(), "FF");
+    keys("C1234%");                              // 16: typed in 8 bits, so 0x12 and 0x34 dropped
+    CHECK_STR(shown(), "0012");
+    keys("C7fff%%%");                            // 16 => 32 => 64 => 8
+    CHECK_STR(shown(), "FF");
+}
+
+static void testScroll(void)
+{
+    // BIN32: the low 16 bits, then the window moves left by half a row
+    Base_Enter();
+    keys("$$");                                  // BIN
+    keys("C11110000111100001010101011001100");
+    Base_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "BIN32 15-0", 10) == 0);
+    CHECK(strncmp(GpioHost_LcdRow(1), "1010101011001100", 16) == 0);
+    keys("<");
+    Base_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "BIN32 23-8", 10) == 0);
+    CHECK(strncmp(GpioHost_LcdRow(1), "1111000010101010", 16) == 0);
+    keys("<<<");                                 // Clamped at the top bits
+    Base_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "BIN32 31-16", 11) == 0);
+    CHECK(strncmp(GpioHost_LcdRow(1), "1111000011110000", 16) == 0);
+    keys(">>>");
+    Base_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "BIN32 15-0", 10) == 0);
+}
+
+int main(void)
+{
+    LCD_Init();
+    testFormat();
+    testOperators();
+    testWordSize();
+    testScroll();
+    return CHECK_RESULT();
+}
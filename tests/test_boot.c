@@ -0,0 +1,111 @@
+/*
+Boot with a live keypad: keys pressed while LCD_Poll is still running the
+LCD's power-on sequence are kept and drawn once it is ready.
+
+src/main.c runs unchanged (its main renamed) on the host stand-ins. On the
+first main loop pass "1+" is queued, as a scripted feed would, and '2' is
+held on the modelled keypad matrix. All three are handled before the
+sequence ends. Row 1 must then show "1+2", the boot marks must arrive once
+each in order (first key, then first draw), and the first draw must come
+after the last byte of the power-on sequence.
+*/
+
+#include "check.h"
+#include "host.h"
+#include "keypad.h"
+#include "gpio.h"
+#include "perf.h"
+#include "calc.h"
+#include <setjmp.h>
+
+int Firmware_Main(void);
+
+#define LCD_INIT_BYTES  9             // Function sets to display on, as lcd.c's initSteps counts them
+#define HOLD_US         21000UL       // '2', just past the 20 ms debounce
+#define END_NS          200000000ULL  // Everything drawn by then
+
+static jmp_buf       done;
+static int           passes = 0;
+static unsigned long typedAt = 0;     // Simulated us when the expression first read "1+2", 0 until then
+static unsigned long initSentAt = 0;  // ... when the LCD had received the whole power-on sequence
+
+static BootMark      marks[4];
+static unsigned long markUs[4];
+static unsigned long markLcdBytes[4];  // LCD bytes received when each was reported
+static int           markCount = 0;
+
+/**
+ * @brief Records every report, so the test sees the order and that none repeats
+ */
+void Perf_OnBootMark(BootMark mark, unsigned long microseconds)
+{
+    if(markCount < 4){
+        marks[markCount] = mark;
+        markUs[markCount] = microseconds;
+        markLcdBytes[markCount] = GpioHost_LcdBytes();
+    }
+    markCount++;
+}
+
+/**
+ * @brief Runs at the start of every main loop pass (the scan's first column read)
+ */
+static void onPass(unsigned long base, unsigned long mask)
+{
+    if(base != GPIO_PORTE_BASE || mask != KEYPAD_ROW_MASK ||
+       (GpioHost_Pins(GPIO_PORTD_BASE) & KEYPAD_COL_MASK) != 0x0E){
+        return;
+    }
+    if(passes++ == 0){
+        Keypad_Push('1');
+        Keypad_Push('+');
+        GpioHost_HoldKey(0, 1, HOLD_US);
+        return;
+    }
+    unsigned long now = (unsigned long)(Host_TimeNs() / 1000);
+    char typed[4];
+    if(typedAt == 0 && Calc_CopyExpression(typed, 0, 3) == 3 && memcmp(typed, "1+2", 3) == 0){
+        typedAt = now;
+    }
+    if(initSentAt == 0 && GpioHost_LcdBytes() >= LCD_INIT_BYTES){
+        initSentAt = now;
+    }
+    if(Host_TimeNs() >= END_NS){
+        longjmp(done, 1);
+    }
+}
+
+int main(void)
+{
+    char row[LCD_COLUMNS + 1];
+
+    GpioHost_SetReadHook(onPass);
+    if(!setjmp(done)){
+        Firmware_Main();
+    }
+    GpioHost_SetReadHook(NULL);
+
+    // Nothing lost: the queued keys and the matrix key all reach the expression
+    memcpy(row, GpioHost_LcdRow(1), LCD_COLUMNS);
+    row[LCD_COLUMNS] = '\0';
+    CHECK(strncmp(row, "1+2 ", 4) == 0);
+
+    // First key, then first draw, each reported once
+    CHECK(markCount == 2);
+    CHECK(marks[0] == BOOT_FIRST_KEY);
+    CHECK(marks[1] == BOOT_FIRST_DRAW);
+    CHECK(markUs[0] < markUs[1]);
+    CHECK(Perf_BootTimeUs(BOOT_FIRST_KEY) == markUs[0]);
+    CHECK(Perf_BootTimeUs(BOOT_FIRST_DRAW) == markUs[1]);
+
+    // The keys were handled while the LCD was still powering up, and drawn only after it
+    CHECK(markLcdBytes[0] < LCD_INIT_BYTES);
+    CHECK(typedAt != 0 && initSentAt != 0);
+    CHECK(typedAt < initSentAt);
+    CHECK(markLcdBytes[1] > LCD_INIT_BYTES);
+    if(markCount != 2 || typedAt == 0 || typedAt >= initSentAt){
+        printf("  first key %lu us, \"1+2\" typed %lu us, LCD sequence sent %lu us, first draw %lu us, %d marks\n",
+               markUs[0], typedAt, initSentAt, markUs[1], markCount);
+    }
+    return CHECK_RESULT();
+}
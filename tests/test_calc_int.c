@@ -0,0 +1,100 @@
+/*
+The exact 64-bit integer path of calc.c at the edges of long long, and the
+shared power function that RPN also uses.
+*/
+
+#include "check.h"
+#include "keys.h"
+#include <math.h>
+
+/**
+ * @brief Evaluates keys and checks the exact text Calc_FormatLastResult gives
+ */
+static void checkExact(const char *keys, const char *shown)
+{
+    char text[32];
+
+    Calc_ClearExpression();
+    typeKeys(keys, NULL);
+    Calc_Evaluate();
+    CHECK(!Calc_HadError());
+    Calc_FormatLastResult(text);
+    if(strcmp(text, shown) != 0){
+        printf("  \"%s\" shows %s, expected %s\n", keys, text, shown);
+    }
+    CHECK_STR(text, shown);
+}
+
+/**
+ * @brief Evaluates keys that leave the integer range and checks the double it falls back to
+ */
+static void checkFallback(const char *keys, double expected)
+{
+    CHECK(calculate(keys) == expected);
+    CHECK(!Calc_HadError());
+}
+
+static void testLimits(void)
+{
+    checkExact("9223372036854775807", "9223372036854775807");
+    checkExact("9223372036854775806+1", "9223372036854775807");
+    checkExact("0-9223372036854775807-1", "-9223372036854775808");
+    checkExact("3037000499*3037000499", "9223372030926249001");
+    checkExact("2^62", "4611686018427387904");
+    checkExact("3^39", "4052555153018976267");
+    checkExact("1^9223372036854775807", "1");
+    checkExact("0^0", "1");
+
+    // One step past the edge: the double evaluation is the result
+    checkFallback("9223372036854775807+1", 9223372036854775808.0);
+    checkFallback("0-9223372036854775807-2", -9223372036854775809.0);
+    checkFallback("3037000500*3037000500", 3037000500.0 * 3037000500.0);
+    checkFallback("2^63", 9223372036854775808.0);
+    checkFallback("3^40", pow(3.0, 40.0));
+    checkFallback("9223372036854775808", 9223372036854775808.0);   // Literal too big for the integer path
+}
+
+static void testAnsChain(void)
+{
+    checkExact("9223372036854775806", "9223372036854775806");
+    checkExact("+1", "9223372036854775807");                        // Continues from the exact Ans
+    Calc_ClearExpression();
+    typeKeys("+1", NULL);
+    CHECK(Calc_Evaluate() == 9223372036854775808.0);
+}
+
+static void testPower(void)
+{
+    // Integral exponents up to 64 are exact products, the same in every evaluator
+    CHECK(Calc_Power(3.0, 4.0) == 81.0);
+    CHECK(Calc_Power(2.0, -2.0) == 0.25);
+    CHECK(Calc_Power(2.0, 64.0) == 18446744073709551616.0);
+    CHECK(Calc_Power(-2.0, 3.0) == -8.0);
+    CHECK(Calc_Power(2.0, 0.5) == sqrt(2.0));
+
+    // Exponents a long cannot hold go to libm without a conversion (UBSan checks there is none)
+    CHECK(isinf(Calc_Power(2.0, 1e300)));
+    CHECK(Calc_Power(0.5, 1e300) == 0.0);
+    CHECK(Calc_Power(2.0, -1e300) == 0.0);
+    CHECK(isnan(Calc_Power(2.0, NAN)));
+    CHECK(Calc_Power(1.0, INFINITY) == 1.0);
+
+    // The compiled, streamed and preview evaluations agree with it
+    CalcProgram prog;
+    double x = 1.5, f;
+    Calc_ClearExpression();
+    typeKeys("X^7", NULL);
+    CHECK(Calc_Compile(&prog) == 0);
+    Calc_EvaluateBatch(&prog, &x, &f, 1);
+    CHECK(f == Calc_Power(1.5, 7.0));
+    CHECK(calculate("1.5^7") == Calc_Power(1.5, 7.0));
+}
+
+int main(void)
+{
+    Calc_Init();
+    testLimits();
+    testAnsChain();
+    testPower();
+    return CHECK_RESULT();
+}
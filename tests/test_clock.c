@@ -0,0 +1,108 @@
+/*
+Clock scaling (src/clock.c itself, not the clock_host.c stand-in): delays sized
+for the current frequency, the PLL lock gate, and the time accounting across
+speed switches.
+
+Registers are plain memory here (periph_host.c), so the SysTick count flag is
+held set for SysTick_wait to return at once, and time passes by moving
+DWT_CYCCNT by hand. On a 64-bit host the counter is 64 bits wide, so its
+32-bit wrap is not covered.
+*/
+
+#include "check.h"
+#include "clock.h"
+#include "perf.h"
+
+#define SYSTICK_COUNT 0x00010000   // NVIC_ST_CTRL_R COUNTFLAG
+
+static void pass(unsigned long cycles)
+{
+    DWT_CYCCNT_R += cycles;
+}
+
+static void testDelays(void)
+{
+    SysTick_init();
+    NVIC_ST_CTRL_R |= SYSTICK_COUNT;
+
+    // Ticks per SysTick_wait follow the speed, so a millisecond is a millisecond at both
+    CHECK(Clock_GetSpeed() == CLOCK_SLOW);
+    delay_ms(3);
+    CHECK(NVIC_ST_RELOAD_R == 16000 - 1);
+    delay_us(3);
+    CHECK(NVIC_ST_RELOAD_R == 16 - 1);
+
+    Clock_SetSpeed(CLOCK_FAST);
+    delay_ms(3);
+    CHECK(NVIC_ST_RELOAD_R == 80000 - 1);
+    delay_us(3);
+    CHECK(NVIC_ST_RELOAD_R == 80 - 1);
+
+    Clock_SetSpeed(CLOCK_SLOW);
+    delay_ms(1);
+    CHECK(NVIC_ST_RELOAD_R == 16000 - 1);
+}
+
+static void testPllLock(void)
+{
+    SYSCTL_RIS_R = 0;
+    PLL_init();
+    CHECK(Clock_GetSpeed() == CLOCK_SLOW);
+    CHECK(SYSCTL_RCC2_R & SYSCTL_RCC2_BYPASS2);
+
+    // Not locked yet: stays on the oscillator rather than waiting
+    Clock_SetSpeed(CLOCK_FAST);
+    CHECK(Clock_GetSpeed() == CLOCK_SLOW);
+    CHECK(Clock_GetHz() == 16000000);
+    CHECK(SYSCTL_RCC2_R & SYSCTL_RCC2_BYPASS2);
+
+    SYSCTL_RIS_R = SYSCTL_RIS_PLLLRIS;
+    Clock_SetSpeed(CLOCK_FAST);
+    CHECK(Clock_GetSpeed() == CLOCK_FAST);
+    CHECK(Clock_GetHz() == 80000000);
+    CHECK(!(SYSCTL_RCC2_R & SYSCTL_RCC2_BYPASS2));
+
+    Clock_SetSpeed(CLOCK_SLOW);
+    CHECK(SYSCTL_RCC2_R & SYSCTL_RCC2_BYPASS2);
+}
+
+static void testAccounting(void)
+{
+    unsigned long slowMs = Clock_TimeAtMs(CLOCK_SLOW);
+    unsigned long fastMs = Clock_TimeAtMs(CLOCK_FAST);
+    unsigned long upUs = Clock_UptimeUs();
+
+    // 1 s slow, 1 s fast, 0.5 s slow: cycles become time at the speed they ran at
+    CHECK(Clock_GetSpeed() == CLOCK_SLOW);
+    pass(16000000);
+    Clock_SetSpeed(CLOCK_FAST);
+    pass(80000000);
+    Clock_SetSpeed(CLOCK_FAST);                 // Same speed: accounted, not switched
+    CHECK(Clock_TimeAtMs(CLOCK_FAST) - fastMs == 1000);
+    Clock_SetSpeed(CLOCK_SLOW);
+    pass(8000000);
+
+    CHECK(Clock_TimeAtMs(CLOCK_SLOW) - slowMs == 1500);
+    CHECK(Clock_TimeAtMs(CLOCK_FAST) - fastMs == 1000);
+    CHECK(Clock_UptimeUs() - upUs == 2500000);
+
+    // Many short bursts, as the main loop does per key, add up the same
+    upUs = Clock_UptimeUs();
+    for(int i=0; i<1000; i++){
+        Clock_SetSpeed(CLOCK_FAST);
+        pass(800);                              // 10 us
+        Clock_SetSpeed(CLOCK_SLOW);
+        pass(1600);                             // 100 us
+    }
+    CHECK(Clock_UptimeUs() - upUs == 110000);
+}
+
+int main(void)
+{
+    Perf_Init();
+    PLL_init();
+    testDelays();
+    testPllLock();
+    testAccounting();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,150 @@
+/*
+UART console (console.c) on the UART/uDMA model, tools/uart_host.c: replies,
+line tails at every length around the DMA burst and block sizes, a continuous
+stream, and lines that must reply Error.
+*/
+
+#include "check.h"
+#include "host.h"
+#include "console.h"
+#include "calc.h"
+#include <stdio.h>
+
+static char replies[4096];
+
+/**
+ * @brief Runs the main loop's part (Console_Poll) and the TX line until both are quiet
+ */
+static void settle(void)
+{
+    do {
+        UartHost_Idle();
+        Console_Poll();
+    } while(UartHost_Transmit(1 << 20) > 0 || Console_HasWork());
+}
+
+/**
+ * @brief Sends text with the main loop polling every 16 bytes, as it keeps up on the target
+ */
+static const char* converse(const char *text)
+{
+    for(int length = (int)strlen(text); length > 0; length -= 16, text += 16) {
+        UartHost_Receive(text, length < 16 ? length : 16);
+        Console_Poll();
+    }
+    settle();
+    UartHost_TakeSent(replies, sizeof(replies));
+    return replies;
+}
+
+/**
+ * @brief An expression of exactly length characters whose value is 5
+ */
+static void fiveOfLength(char *out, int length)
+{
+    int i = 0;
+
+    if(length % 2 == 0) {
+        out[i++] = '0';
+    }
+    out[i++] = '5';
+    while(i < length) {
+        out[i++] = '+';
+        out[i++] = '0';
+    }
+    out[i] = '\0';
+}
+
+static void testReplies(void)
+{
+    CHECK_STR(converse("1+2\n"), "3\r\n");
+    CHECK_STR(converse("12.5*3+4-7/2^2\r\n"), "39.75\r\n");
+    CHECK_STR(converse("  6 * 7 \n"), "42\r\n");            // Spaces ignored
+    CHECK_STR(converse("\r\n\n"), "");                       // Blank lines ignored
+    CHECK_STR(converse("*2\n"), "84\r\n");                   // Its own Ans
+    CHECK_STR(converse("1+\n"), "Error\r\n");
+    CHECK_STR(converse("12\b3\n"), "Error\r\n");             // Backspace cannot be taken back
+    CHECK_STR(converse("9223372036854775806+1\n"), "9223372036854775807\r\n");
+}
+
+static void testEveryLength(void)
+{
+    char line[400];
+    int  failures = 0;
+
+    // Every tail: shorter than a burst, ending on a burst or block boundary, spanning blocks
+    for(int length = 1; length < 300; length++) {
+        fiveOfLength(line, length);
+        strcat(line, "\n");
+        if(strcmp(converse(line), "5\r\n") != 0) {
+            if(failures++ < 3) {
+                printf("  line of %d bytes: \"%s\"\n", length + 1, replies);
+            }
+        }
+    }
+    CHECK(failures == 0);
+}
+
+static void testStream(void)
+{
+    static char received[32768];
+    static char expected[32768];
+    char line[32];
+    int  length = 0;
+
+    // Lines back to back with no idle gap. The main loop polls every 16 bytes and the TX line
+    // sends a byte per byte received, as both run at 115200
+    expected[0] = '\0';
+    for(int i = 0; i < 2000; i++) {
+        snprintf(line, sizeof(line), "%d*3+1\n", i);
+        snprintf(expected + strlen(expected), 16, "%d\r\n", i * 3 + 1);
+        for(const char *p = line; *p; p++) {
+            UartHost_Receive(p, 1);
+            UartHost_Transmit(1);
+            if((p - line) % 16 == 15) {
+                Console_Poll();
+            }
+        }
+        Console_Poll();
+        length += UartHost_TakeSent(received + length, (int)sizeof(received) - length);
+    }
+    settle();
+    UartHost_TakeSent(received + length, (int)sizeof(received) - length);
+    CHECK_STR(received, expected);
+    CHECK(UartHost_Overruns() == 0);
+}
+
+static void testLostBytes(void)
+{
+    char line[400];
+
+    // More than the ring holds before the main loop gets to it: the line replies Error. Its end
+    // was lost too, so the Error also covers the next line; the one after that is fine
+    fiveOfLength(line, 300);
+    strcat(line, "\n");
+    UartHost_Receive(line, (int)strlen(line));
+    CHECK_STR(converse("2+2\n"), "Error\r\n");
+    CHECK_STR(converse("3+3\n"), "6\r\n");
+    CHECK(UartHost_Overruns() == 0);                         // The DMA kept up, the ring did not
+}
+
+static void testKeypadUntouched(void)
+{
+    Calc_ClearExpression();
+    Calc_AddChar('9');
+    CHECK_STR(converse("1+1\n"), "2\r\n");
+    CHECK_STR(Calc_GetExpression(), "9");
+    Calc_ClearExpression();
+}
+
+int main(void)
+{
+    Calc_Init();
+    Console_Init();
+    testReplies();
+    testEveryLength();
+    testStream();
+    testLostBytes();
+    testKeypadUntouched();
+    return CHECK_RESULT();
+}
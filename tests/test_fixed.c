@@ -0,0 +1,260 @@
+/*
+Q32.32 backend (fixed.c, calc.c built with CALC_FIXED) against double: underflow,
+parsing and formatting, the kernels within the error bounds they report, and
+expressions shown the same as the double evaluation gives them.
+*/
+
+#include "check.h"
+#include "calc.h"
+#include "fixed.h"
+#include "func.h"
+#include <stdlib.h>
+
+#define STEP     (1.0 / 4294967296.0)
+#define SAMPLES  20000
+#ifndef EXPRESSIONS
+#define EXPRESSIONS 20000
+#endif
+
+static double uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+static CalcFixed fixed(const char *text)
+{
+    FixStatus status = FIX_OK;
+    CalcFixed value = Fix_FromString(text, &status);
+    CHECK(status == FIX_OK);
+    return value;
+}
+
+static void testUnderflow(void)
+{
+    FixStatus status = FIX_OK;
+
+    // A product or quotient that is not zero but rounds to it goes to double
+    Fix_Mul(fixed("0.00001"), fixed("0.00001"), &status);
+    CHECK(status == FIX_RANGE);
+    status = FIX_OK;
+    Fix_Div(1, fixed("1000"), &status);
+    CHECK(status == FIX_RANGE);
+    status = FIX_OK;
+    CHECK(Fix_Div(FIX_ONE, Fix_FromInt(2147483647, &status), &status) == 2 && status == FIX_OK);
+    CHECK(Fix_Mul(0, fixed("0.00001"), &status) == 0 && status == FIX_OK);
+    Fix_FromString("0.0000000001", &status);
+    CHECK(status == FIX_RANGE);
+    status = FIX_OK;
+    Fix_FromDouble(1e-11, &status);
+    CHECK(status == FIX_RANGE);
+    status = FIX_OK;
+    Fix_Apply(FUNC_EXP, fixed("-25"), &status);   // 1.4e-11
+    CHECK(status == FIX_RANGE);
+    status = FIX_OK;
+    CHECK(Fix_FromString("0.00000000012", &status) == 1 && status == FIX_OK);
+}
+
+static void testParseFormat(void)
+{
+    FixStatus status = FIX_OK;
+    char text[16];
+
+    CHECK(fixed("12.5") == 25 * (FIX_ONE / 2));
+    CHECK(fixed("-.25") == -(FIX_ONE / 4));
+    CHECK(fixed("2147483647") == 2147483647LL * FIX_ONE);
+    Fix_FromString("2147483648", &status);
+    CHECK(status == FIX_RANGE);
+
+    Fix_Format(fixed("-12.3456"), text);
+    CHECK_STR(text, "-12.346");
+    Fix_Format(fixed("1.5"), text);
+    CHECK_STR(text, "1.5");
+    Fix_Format(fixed("-0.0004"), text);
+    CHECK_STR(text, "0");
+    Fix_Format(fixed("0.9996"), text);
+    CHECK_STR(text, "1");
+
+    // Through the calculator: the double results that do not fit Q32.32 still format
+    Calc_FormatResult(-0.0001, text);
+    CHECK_STR(text, "0");
+    char wide[32];
+    Calc_FormatResult(-1.5e300, wide);
+    CHECK_STR(wide, "-1.5e+300");
+}
+
+/**
+ * @brief Every kernel within the bound Fix_ApplyError reports for an exact argument
+ */
+static void testKernelBounds(void)
+{
+    static const struct {
+        int    func;
+        double lo, hi;
+    } ranges[] = {
+        {FUNC_SIN, -720.0, 720.0}, {FUNC_COS, -720.0, 720.0}, {FUNC_TAN, -89.9, 89.9},
+        {FUNC_SQRT, 0.0, 10000.0}, {FUNC_LN, 0.001, 100000.0}, {FUNC_LOG, 0.001, 100000.0},
+        {FUNC_EXP, -20.0, 21.0},   {FUNC_ASIN, -1.0, 1.0},     {FUNC_ACOS, -1.0, 1.0},
+        {FUNC_ATAN, -1000.0, 1000.0}
+    };
+
+    srand(1);
+    for(unsigned f=0; f<sizeof(ranges)/sizeof(ranges[0]); f++){
+        int over = 0;
+        for(int i=0; i<SAMPLES; i++){
+            FixStatus status = FIX_OK;
+            CalcFixed x = Fix_FromDouble(uniform(ranges[f].lo, ranges[f].hi), &status);
+            CalcFixed r = Fix_Apply(ranges[f].func, x, &status);
+            if(status != FIX_OK){
+                continue;
+            }
+            double exact = Func_Apply((FuncId)ranges[f].func, Fix_ToDouble(x));
+            unsigned long steps = Fix_ApplyError(ranges[f].func, x, 0, r);
+            double bound = steps * STEP;
+            if(steps != FIX_ERROR_MAX && fabs(Fix_ToDouble(r) - exact) > bound + fabs(exact) * 1e-15 && over++ == 0){
+                printf("  %s(%.17g): %.17g, double %.17g, bound %.3g\n", Func_Get(ranges[f].func)->name,
+                       Fix_ToDouble(x), Fix_ToDouble(r), exact, bound);
+            }
+        }
+        CHECK(over == 0);
+    }
+}
+
+/**
+ * @brief * / ^ within the bounds Fix_OpError reports, for exact operands and for operands a step off
+ */
+static void testOpBounds(void)
+{
+    static const char ops[] = "*/^";
+    int over = 0;
+
+    srand(2);
+    for(int i=0; i<SAMPLES * 3; i++){
+        char      op = ops[i % 3];
+        FixStatus status = FIX_OK;
+        double    scale = (op == '^') ? 8.0 : pow(10.0, uniform(-4.0, 4.0));
+        CalcFixed a = Fix_FromDouble(uniform(op == '^' ? 0.1 : -scale, scale), &status);
+        CalcFixed b = Fix_FromDouble(op == '^' ? uniform(-6.0, 6.0) : uniform(-1000.0, 1000.0), &status);
+        if(op == '^' && i % 2){
+            b = b / FIX_ONE * FIX_ONE;   // Integral exponents take the repeated squaring
+        }
+        unsigned long error = (unsigned long)(i % 4 == 0);  // Sometimes each operand a step off
+        CalcFixed ar = a + (CalcFixed)error, br = b + (CalcFixed)error;
+
+        CalcFixed r = (op == '*') ? Fix_Mul(ar, br, &status) :
+                      (op == '/') ? Fix_Div(ar, br, &status) : Fix_Pow(ar, br, &status);
+        if(status != FIX_OK){
+            continue;
+        }
+        double x = Fix_ToDouble(a), y = Fix_ToDouble(b);
+        double exact = (op == '*') ? x * y : (op == '/') ? x / y : pow(x, y);
+        unsigned long steps = Fix_OpError(op, ar, error, br, error, r);
+        double bound = steps * STEP;
+        if(steps != FIX_ERROR_MAX && fabs(Fix_ToDouble(r) - exact) > bound + fabs(exact) * 1e-15 && over++ < 3){
+            printf("  %.17g %c %.17g: %.17g, double %.17g, bound %.3g\n", x, op, y, Fix_ToDouble(r), exact, bound);
+        }
+    }
+    CHECK(over == 0);
+}
+
+static void operand(char *text)
+{
+    static const char funcKeys[] = "sctrlgeioa";
+    char number[24];
+
+    if(rand() % 3 == 0){
+        size_t length = strlen(text);
+        text[length] = funcKeys[rand() % 10];
+        text[length + 1] = '\0';
+    }
+    switch(rand() % 4){
+        case 0:  sprintf(number, "%d", rand() % 100); break;
+        case 1:  sprintf(number, "%d.%03d", rand() % 1000, rand() % 1000); break;
+        case 2:  sprintf(number, "0.%05d", rand() % 100000); break;
+        default: sprintf(number, "%d", rand() % 100000); break;
+    }
+    strcat(text, number);
+}
+
+static double evaluate(const char *text)
+{
+    Calc_ClearExpression();
+    for(const char *k = text; *k; k++){
+        Calc_AddChar(*k);
+    }
+    return Calc_Evaluate();
+}
+
+/**
+ * @brief Random expressions: fixed point first (Calc_Evaluate) against the double program
+ *        (Calc_EvaluateBatch). Within range they must agree to FIX_ERROR_SHOWN steps, so the
+ *        3 decimals shown can only differ on a tie
+ */
+static void testExpressions(void)
+{
+    CalcProgram program;
+    long  compared = 0, far = 0, errors = 0, shownDiffer = 0;
+    double worst = 0.0;
+
+    srand(5);
+    for(int i=0; i<EXPRESSIONS; i++){
+        char text[128] = "";
+        int  terms = 1 + rand() % 4;
+
+        operand(text);
+        for(int t=1; t<terms; t++){
+            size_t length = strlen(text);
+            text[length] = "+-*/^"[rand() % 5];
+            text[length + 1] = '\0';
+            operand(text);
+        }
+
+        double value = evaluate(text), reference, x = 0.0;
+        bool   failed = Calc_HadError();
+        if(Calc_Compile(&program) < 0){
+            continue;
+        }
+        Calc_EvaluateBatch(&program, &x, &reference, 1);
+        if(!(fabs(reference) < 2147483648.0)){
+            continue;   // Beyond Q32.32, or no value: double decides it either way
+        }
+        compared++;
+        if(failed){
+            if(errors++ < 3){
+                printf("  \"%s\": error, double %.17g\n", text, reference);
+            }
+            continue;
+        }
+        double difference = fabs(value - reference);
+        worst = fmax(worst, difference);
+        if(difference > FIX_ERROR_SHOWN * STEP && far++ < 3){
+            printf("  \"%s\" = %.17g, double %.17g\n", text, value, reference);
+        }
+        char shown[32], shownDouble[32];
+        Calc_FormatResult(value, shown);
+        Calc_FormatResult(reference, shownDouble);
+        shownDiffer += (strcmp(shown, shownDouble) != 0);
+    }
+    printf("  %ld expressions compared, %ld shown differently (ties), worst difference %.2g\n",
+           compared, shownDiffer, worst);
+    CHECK(compared > EXPRESSIONS / 2);
+    CHECK(errors == 0);
+    CHECK(far == 0);
+    CHECK(shownDiffer < compared / 1000);
+
+    // Underflow and scaled-up rounding go to double
+    CHECK_NEAR(evaluate("0.00001*0.00001*100000*100000"), 1.0, 1e-12);
+    CHECK_NEAR(evaluate("0.0001*100000000"), 10000.0, 1e-9);
+    CHECK_NEAR(evaluate("0.17881*15233*6282"), 0.17881 * 15233 * 6282, 1e-6);
+    CHECK_NEAR(evaluate("1.0001^100000"), pow(1.0001, 100000), 1e-6);
+}
+
+int main(void)
+{
+    Calc_Init();
+    testUnderflow();
+    testParseFormat();
+    testKernelBounds();
+    testOpBounds();
+    testExpressions();
+    return CHECK_RESULT();
+}
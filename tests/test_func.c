@@ -0,0 +1,144 @@
+/*
+Function kernels (func.c) against libm: the ULP bounds documented in func.h,
+exact values, domains and the degree conversions.
+*/
+
+#include "check.h"
+#include "func.h"
+#include <float.h>
+
+#define SAMPLES 200000
+
+static unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+
+/// Uniform in [lo, hi), from a fixed xorshift sequence so every run sees the same arguments
+static double uniform(double lo, double hi)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return lo + (hi - lo) * (double)(seed >> 11) / 9007199254740992.0;
+}
+
+/// Error of value in units in the last place of reference (subnormal spacing below DBL_MIN)
+static double ulps(double value, double reference)
+{
+    if(value == reference){
+        return 0.0;
+    }
+    double spacing = nextafter(fabs(reference), INFINITY) - fabs(reference);
+    return fabs(value - reference) / spacing;
+}
+
+typedef struct {
+    const char *name;
+    double    (*kernel)(double);
+    double    (*reference)(double);
+    double      lo, hi;            // Range of the argument, or of its log if logScale
+    int         logScale;
+    double      bound;             // ulp, as func.h documents it
+} UlpCase;
+
+static double expOf(double x) { return exp(x); }
+
+static const UlpCase cases[] = {
+    {"sqrt",  Func_Sqrt,  sqrt,  -744.0, 709.0, 1, 1.0},   // Subnormal to near DBL_MAX
+    {"sqrt",  Func_Sqrt,  sqrt,     0.0, 100.0, 0, 1.0},
+    {"exp",   Func_Exp,   expOf, -708.0, 709.0, 0, 1.0},
+    {"exp",   Func_Exp,   expOf,   -2.0,   2.0, 0, 1.0},
+    {"exp",   Func_Exp,   expOf, -745.0, -708.0, 0, 1.0},  // Results in the subnormal range
+    {"ln",    Func_Ln,    log,   -744.0, 709.0, 1, 1.0},
+    {"ln",    Func_Ln,    log,      0.5,   2.0, 0, 1.0},   // Around 1, where the result cancels
+    {"log",   Func_Log10, log10, -744.0, 709.0, 1, 2.0},
+    {"log",   Func_Log10, log10,    0.5,  20.0, 0, 2.0},
+};
+
+static void testUlpBounds(void)
+{
+    for(unsigned c=0; c<sizeof(cases)/sizeof(cases[0]); c++){
+        const UlpCase *u = &cases[c];
+        double worst = 0.0, worstAt = 0.0;
+
+        for(int i=0; i<SAMPLES; i++){
+            double x = uniform(u->lo, u->hi);
+            if(u->logScale){
+                x = exp(x);
+            }
+            double e = ulps(u->kernel(x), u->reference(x));
+            if(e > worst){
+                worst = e;
+                worstAt = x;
+            }
+        }
+        if(worst > u->bound){
+            printf("  %s: %.3f ulp at %.17g, documented %.0f\n", u->name, worst, worstAt, u->bound);
+        }
+        CHECK(worst <= u->bound);
+    }
+}
+
+static void testExactValues(void)
+{
+    CHECK(Func_Sqrt(16.0) == 4.0);
+    CHECK(Func_Exp(0.0) == 1.0);
+    CHECK(Func_Ln(1.0) == 0.0);
+
+    // The ends of the range are within the bounds too
+    CHECK(ulps(Func_Sqrt(DBL_MAX), sqrt(DBL_MAX)) <= 1.0);
+    CHECK(ulps(Func_Sqrt(nextafter(0.0, 1.0)), sqrt(nextafter(0.0, 1.0))) <= 1.0);
+    CHECK(ulps(Func_Ln(DBL_MAX), log(DBL_MAX)) <= 1.0);
+    CHECK(ulps(Func_Ln(nextafter(0.0, 1.0)), log(nextafter(0.0, 1.0))) <= 1.0);
+    CHECK(ulps(Func_Exp(709.78), exp(709.78)) <= 1.0);
+    // Powers of ten that are exact doubles give exact integers
+    double power = 1.0;
+    int    exact = 1;
+    for(int k = 0; k <= 22; k++, power *= 10.0){
+        exact &= (Func_Log10(power) == (double)k);
+    }
+    CHECK(exact);
+    CHECK(ulps(Func_Log10(1e-5), -5.0) <= 2.0);
+}
+
+static void testEdges(void)
+{
+    // Domains: NAN outside, which the evaluator reports as an error
+    CHECK(isnan(Func_Apply(FUNC_SQRT, -1.0)));
+    CHECK(isnan(Func_Apply(FUNC_LN, 0.0)));
+    CHECK(isnan(Func_Apply(FUNC_LOG, -2.0)));
+    CHECK(isnan(Func_Apply(FUNC_ASIN, 1.0000001)));
+    CHECK(isnan(Func_Apply(FUNC_ACOS, -1.5)));
+    CHECK(Func_Apply(FUNC_SQRT, 0.0) == 0.0);
+
+    // Overflow and underflow of exp
+    CHECK(isinf(Func_Exp(710.0)));
+    CHECK(Func_Exp(-746.0) == 0.0);
+    CHECK(isinf(Func_Sqrt(INFINITY)) && isinf(Func_Ln(INFINITY)));
+    CHECK(isnan(Func_Exp(NAN)) && isnan(Func_Ln(NAN)) && isnan(Func_Sqrt(NAN)));
+
+    // The registry applies libm unless built with FUNC_KERNELS
+#ifndef FUNC_KERNELS
+    CHECK(Func_Apply(FUNC_SQRT, 2.0) == sqrt(2.0));
+    CHECK(Func_Apply(FUNC_EXP, 1.5) == exp(1.5));
+    CHECK(Func_Apply(FUNC_LN, 3.0) == log(3.0));
+    CHECK(Func_Apply(FUNC_LOG, 7.0) == log10(7.0));
+#else
+    CHECK(Func_Apply(FUNC_SQRT, 2.0) == Func_Sqrt(2.0));
+    CHECK(Func_Apply(FUNC_EXP, 1.5) == Func_Exp(1.5));
+#endif
+
+    // Degrees in and out
+    CHECK_NEAR(Func_Apply(FUNC_SIN, 30.0), 0.5, 1e-15);
+    CHECK_NEAR(Func_Apply(FUNC_COS, 60.0), 0.5, 1e-15);
+    CHECK_NEAR(Func_Apply(FUNC_TAN, 45.0), 1.0, 1e-15);
+    CHECK_NEAR(Func_Apply(FUNC_ASIN, 0.5), 30.0, 1e-13);
+    CHECK_NEAR(Func_Apply(FUNC_ACOS, 0.5), 60.0, 1e-13);
+    CHECK_NEAR(Func_Apply(FUNC_ATAN, 1.0), 45.0, 1e-13);
+}
+
+int main(void)
+{
+    testUlpBounds();
+    testExactValues();
+    testEdges();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,162 @@
+/*
+Address-masked GPIO access (gpio.h) through the host port model, tools/gpio_host.c.
+
+The LCD must only ever see the nibbles the driver means to send, and pins the
+drivers do not own must keep whatever another master or interrupt set them to.
+The old read-modify-write nibble write is reproduced here as the reference it
+replaced: it glitches the data pins and loses a pin changed between its load
+and its store.
+*/
+
+#include "check.h"
+#include "host.h"
+#include "gpio.h"
+#include "lcd.h"
+#include "keypad.h"
+#include "clock.h"
+
+// Pins of the ports the drivers do not own, set before the drivers run
+#define PORTA_OTHERS  0xF3   // PA0/PA1 are UART0, the rest unused
+#define PORTB_OTHERS  0xF0
+#define PORTD_OTHERS  0xF0
+
+static void setOtherPins(void)
+{
+    GpioHost_Drive(GPIO_PORTA_BASE, PORTA_OTHERS, 0xA1);
+    GpioHost_Drive(GPIO_PORTB_BASE, PORTB_OTHERS, 0x50);
+    GpioHost_Drive(GPIO_PORTD_BASE, PORTD_OTHERS, 0x90);
+}
+
+static void checkOtherPins(void)
+{
+    CHECK((GpioHost_Pins(GPIO_PORTA_BASE) & PORTA_OTHERS) == 0xA1);
+    CHECK((GpioHost_Pins(GPIO_PORTB_BASE) & PORTB_OTHERS) == 0x50);
+    CHECK((GpioHost_Pins(GPIO_PORTD_BASE) & PORTD_OTHERS) == 0x90);
+}
+
+/**
+ * @brief The nibble write lcd.c used before address masking:
+ *        GPIO_PORTB_DATA_R &= ~LCD_DATA_MASK; GPIO_PORTB_DATA_R |= nibble;
+ *        interrupt (may be NULL) runs between the first load and its store.
+ */
+static void rmwNibble(unsigned char nibble, void (*interrupt)(void))
+{
+    unsigned long data = GpioHost_Read(GPIO_PORTB_BASE, 0xFF);
+    if(interrupt){
+        interrupt();
+    }
+    GpioHost_Write(GPIO_PORTB_BASE, 0xFF, data & ~LCD_DATA_MASK);
+    data = GpioHost_Read(GPIO_PORTB_BASE, 0xFF);
+    GpioHost_Write(GPIO_PORTB_BASE, 0xFF, data | nibble);
+}
+
+static void setPB7(void)
+{
+    GpioHost_Drive(GPIO_PORTB_BASE, 0x80, 0x80);
+}
+
+static void latch(void)
+{
+    GPIO_WritePins(GPIO_PORTA_BASE, LCD_EN_PIN, LCD_EN_PIN);
+    GPIO_WritePins(GPIO_PORTA_BASE, LCD_EN_PIN, 0);
+}
+
+static void testLcdTraffic(void)
+{
+    char shown[LCD_ROW_CELLS + 1];
+
+    GpioHost_Reset();
+    setOtherPins();
+    Clock_SetSpeed(CLOCK_FAST);
+
+    LCD_Init();
+    LCD_WriteRow(0, "3.14159265");
+    LCD_WriteRow(1, "12+34*5");
+    LCD_ForgetRow(shown);
+    LCD_PatchRow(1, shown, "12+34*56");
+    LCD_ShowCursor(1, 8);
+    LCD_HideCursor();
+
+    const GpioHostStats *stats = GpioHost_GetStats();
+    CHECK(stats->dataGlitches == 0);
+    CHECK(stats->rsGlitches == 0);
+    CHECK(stats->strayWrites == 0);
+    CHECK(stats->reads == 0);                   // Pure stores, nothing read back
+    CHECK(strncmp(GpioHost_LcdRow(0), "3.14159265      ", LCD_COLUMNS) == 0);
+    CHECK(strncmp(GpioHost_LcdRow(1), "12+34*56        ", LCD_COLUMNS) == 0);
+    checkOtherPins();
+}
+
+static void testKeypadScan(void)
+{
+    GpioHost_Reset();
+    setOtherPins();
+    while(Keypad_Pop(NULL) != '\0'){ }
+
+    Keypad_Scan();                              // Idle
+    GpioHost_HoldKey(2, 1, 25000);              // '8'
+    Keypad_Scan();
+    GpioHost_HoldKey(0, 3, 25000);              // '+'
+    Keypad_Scan();
+
+    CHECK(Keypad_Pop(NULL) == '8');
+    CHECK(Keypad_Pop(NULL) == '+');
+    CHECK(Keypad_Pop(NULL) == '\0');
+    CHECK(GpioHost_GetStats()->strayWrites == 0);
+    checkOtherPins();
+}
+
+static void testReadModifyWriteReference(void)
+{
+    // Masked: one store per nibble, one data change per latch
+    GpioHost_Reset();
+    GPIO_WritePins(GPIO_PORTB_BASE, LCD_DATA_MASK, 0x9);
+    latch();
+    GPIO_WritePins(GPIO_PORTB_BASE, LCD_DATA_MASK, 0x6);
+    latch();
+    CHECK(GpioHost_GetStats()->dataGlitches == 0);
+    unsigned long maskedAccesses = GpioHost_GetStats()->reads + GpioHost_GetStats()->writes;
+
+    // Read-modify-write: passes through 0 before each nibble
+    GpioHost_Reset();
+    rmwNibble(0x9, NULL);
+    latch();
+    unsigned long rmwAccesses = GpioHost_GetStats()->reads + GpioHost_GetStats()->writes;
+    rmwNibble(0x6, NULL);
+    latch();
+    CHECK(GpioHost_GetStats()->dataGlitches == 1);   // 9 -> 0 -> 6 on the second nibble
+    CHECK(GpioHost_GetStats()->strayWrites == 4);    // Whole-port stores
+
+    // Accesses per nibble (EN pulse excluded): 4 against 1
+    CHECK(maskedAccesses - 4 == 2);
+    CHECK(rmwAccesses - 2 == 4);
+
+    // A pin changed between the load and the store is lost by RMW ...
+    GpioHost_Reset();
+    rmwNibble(0x3, setPB7);
+    CHECK((GpioHost_Pins(GPIO_PORTB_BASE) & 0x80) == 0);
+
+    // ... and kept by the masked store
+    GpioHost_Reset();
+    setPB7();
+    GPIO_WritePins(GPIO_PORTB_BASE, LCD_DATA_MASK, 0x3);
+    CHECK(GpioHost_Pins(GPIO_PORTB_BASE) == 0x83);
+}
+
+static void testMaskedRead(void)
+{
+    GpioHost_Reset();
+    GpioHost_Drive(GPIO_PORTA_BASE, 0xFF, 0xFF);
+    CHECK(GPIO_ReadPins(GPIO_PORTA_BASE, LCD_RS_PIN) == LCD_RS_PIN);
+    CHECK(GPIO_ReadPins(GPIO_PORTA_BASE, LCD_CTRL_MASK) == LCD_CTRL_MASK);
+    CHECK(GPIO_ReadPins(GPIO_PORTE_BASE, KEYPAD_ROW_MASK) == KEYPAD_ROW_MASK);  // Pulled up
+}
+
+int main(void)
+{
+    testLcdTraffic();
+    testKeypadScan();
+    testReadModifyWriteReference();
+    testMaskedRead();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,126 @@
+/*
+Integration / summation mode (integ.c): results, inputs that leave Ans alone,
+the tolerance prompt, and ranges too wide to work through.
+*/
+
+#include "check.h"
+#include "keys.h"
+#include "host.h"
+#include "integ.h"
+#include "lcd.h"
+
+/**
+ * @brief Types f(X) and the inputs ('=' separated), then runs the calculation to the end
+ */
+static void run(IntegKind kind, const char *function, const char *inputs)
+{
+    Integ_Enter(kind);
+    typeKeys(function, Integ_HandleKey);
+    Integ_HandleKey('=');
+    typeKeys(inputs, Integ_HandleKey);
+    while(Integ_IsBusy()){
+        Integ_Step();
+    }
+}
+
+static void checkShown(const char *result)
+{
+    CHECK(Integ_OwnsDisplay());
+    Integ_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(1), result, strlen(result)) == 0);
+}
+
+static void testResults(void)
+{
+    run(INTEG_INTEGRATE, "X^2", "0=3==");
+    checkShown("9 ");
+    CHECK(strncmp(GpioHost_LcdRow(0), "Integral=", 9) == 0);
+
+    run(INTEG_SUM, "X", "1=100=");
+    checkShown("5050 ");
+    CHECK(strncmp(GpioHost_LcdRow(0), "Sum=", 4) == 0);
+
+    run(INTEG_SUM, "X", "5=1=");      // Empty sum
+    checkShown("0 ");
+}
+
+static void testTolerance(void)
+{
+    Integ_Enter(INTEG_INTEGRATE);
+    typeKeys("X=0=1=", Integ_HandleKey);
+    CHECK_STR(Integ_Prompt(), "Tol? (=0.000001)");
+    CHECK(strlen(Integ_Prompt()) <= LCD_COLUMNS);
+
+    // The default, typed as the prompt shows it, is accepted (the keypad has no exponent)
+    typeKeys("0.000001=", Integ_HandleKey);
+    while(Integ_IsBusy()){
+        Integ_Step();
+    }
+    checkShown("0.5 ");
+}
+
+static void testInputErrors(void)
+{
+    // An input that does not evaluate stays at its prompt
+    Integ_Enter(INTEG_INTEGRATE);
+    typeKeys("X=1/0=", Integ_HandleKey);
+    CHECK_STR(Integ_Prompt(), "Error! a?");
+    typeKeys("0=1=", Integ_HandleKey);
+    CHECK_STR(Integ_Prompt(), "Tol? (=0.000001)");
+    typeKeys("1+=", Integ_HandleKey);
+    CHECK(!Integ_IsBusy());
+    CHECK(strncmp(Integ_Prompt(), "Error!", 6) == 0);
+}
+
+static void testAnsKept(void)
+{
+    CHECK_NEAR(calculate("6*7"), 42.0, 0.0);
+
+    run(INTEG_INTEGRATE, "X^2", "0=/14=1/10^8=");   // b = Ans/14 = 3
+    checkShown("9 ");
+    CHECK_NEAR(Calc_RecallVariable(CALC_VAR_ANS), 42.0, 0.0);
+
+    run(INTEG_SUM, "X", "1=+58=");                  // To X = Ans+58 = 100
+    checkShown("5050 ");
+    CHECK_NEAR(Calc_RecallVariable(CALC_VAR_ANS), 42.0, 0.0);
+}
+
+static void testWideRanges(void)
+{
+    // 10^300 terms would overflow the term count, and never finish anyway
+    Integ_Enter(INTEG_SUM);
+    typeKeys("X=1=10^300=", Integ_HandleKey);
+    CHECK(!Integ_IsBusy());
+    CHECK_STR(Integ_Prompt(), "Error! b?");
+
+    // Exactly INTEG_MAX_TERMS terms is one too many; one fewer is accepted (then aborted)
+    Integ_Enter(INTEG_SUM);
+    typeKeys("X=0=10^9=", Integ_HandleKey);
+    CHECK_STR(Integ_Prompt(), "Error! b?");
+    Integ_Enter(INTEG_SUM);
+    typeKeys("X=1=10^9=", Integ_HandleKey);
+    CHECK(Integ_IsBusy());
+    Integ_Step();
+    Integ_HandleKey('C');
+    CHECK(!Integ_IsBusy());
+    Integ_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "Aborted", 7) == 0);
+
+    // An infinite width cannot be split into shares of the tolerance
+    Integ_Enter(INTEG_INTEGRATE);
+    typeKeys("X=0-10^308=10^308=", Integ_HandleKey);
+    CHECK(!Integ_IsBusy());
+    CHECK_STR(Integ_Prompt(), "Error! b?");
+}
+
+int main(void)
+{
+    Calc_Init();
+    LCD_Init();
+    testResults();
+    testTolerance();
+    testInputErrors();
+    testAnsKept();
+    testWideRanges();
+    return CHECK_RESULT();
+}
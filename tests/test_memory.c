@@ -0,0 +1,133 @@
+/*
+Variable and memory keys (STO, RCL, M+, M-, MR, MC) through the firmware
+main loop on the host stand-ins.
+
+src/main.c runs unchanged (its main renamed), as in test_trace.c. Each step's
+keys are queued at once, as a scripted feed would, and once the loop has
+handled and drawn them the step is checked: the values of A and M and what
+row 1 of the modelled LCD shows. An expression that does not evaluate must
+leave A and M as they were.
+*/
+
+#include "check.h"
+#include "host.h"
+#include "keypad.h"
+#include "gpio.h"
+#include "calc.h"
+#include <setjmp.h>
+
+int Firmware_Main(void);
+
+#define BOOT_NS   60000000ULL    // LCD power-on sequence finished by then
+#define GAP_NS   100000000ULL    // Step to step, the preview is drawn in it
+
+// Key codes of keypad.h, spelled as strings so a step reads as typed
+#define STO   "T"   // KEY_STO
+#define RCL   "R"   // KEY_RCL
+#define MPLUS "P"   // KEY_MPLUS
+#define MMIN  "N"   // KEY_MMINUS
+#define MR    "Q"   // KEY_MR
+#define MC    "Z"   // KEY_MC
+
+typedef struct {
+    const char *keys;
+    double      a;       // A and M once the keys are handled
+    double      m;
+    const char *row1;    // What row 1 shows, spaces trimmed
+} Step;
+
+static const Step script[] = {
+    {"12.5" STO "1",       12.5, 0.0, "12.5"},    // STO 1 => A
+    {"C" RCL "1" "*2=",    12.5, 0.0, "25"},      // RCL 1 brings it back
+    {"C3" MPLUS,           12.5, 3.0, "3"},
+    {"C2" MPLUS,           12.5, 5.0, "2"},
+    {"C1" MMIN,            12.5, 4.0, "1"},
+    {"C" MR "=",           12.5, 4.0, "4"},
+    {MC "C" MR "=",        12.5, 0.0, "0"},       // MC => M is 0
+    {"C7" MPLUS,           12.5, 7.0, "7"},
+    {"C5+" MPLUS,          12.5, 7.0, "Error!"},  // Error: M unchanged
+    {"C5+" MMIN,           12.5, 7.0, "Error!"},
+    {"C5+" STO,            12.5, 7.0, "Error!"},  // Error: no STO prompt ...
+    {"1",                  12.5, 7.0, "1"},       // ... so the digit is typed, A unchanged
+    {"C5+=" MR "=",        12.5, 7.0, "7"},       // MR after an error starts from M
+    {"C" RCL "1" "=",      12.5, 7.0, "12.5"},
+};
+#define SCRIPT_STEPS (sizeof(script) / sizeof(script[0]))
+
+typedef struct {
+    double a;
+    double m;
+    char   row1[LCD_COLUMNS + 1];
+} Seen;
+
+static jmp_buf            done;
+static unsigned           next = 0;
+static unsigned long long nextAt = BOOT_NS;
+static Seen               seen[SCRIPT_STEPS];
+
+/**
+ * @brief Visible part of an LCD row with the spaces either side trimmed
+ */
+static void shown(int row, char *out)
+{
+    const char *cells = GpioHost_LcdRow(row);
+    int first = 0, last = LCD_COLUMNS;
+
+    while(first < last && cells[first] == ' ') first++;
+    while(last > first && cells[last - 1] == ' ') last--;
+    memcpy(out, cells + first, (size_t)(last - first));
+    out[last - first] = '\0';
+}
+
+/**
+ * @brief Runs at the start of every main loop pass (the scan's first column read)
+ */
+static void onPass(unsigned long base, unsigned long mask)
+{
+    if(base != GPIO_PORTE_BASE || mask != KEYPAD_ROW_MASK ||
+       (GpioHost_Pins(GPIO_PORTD_BASE) & KEYPAD_COL_MASK) != 0x0E){
+        return;
+    }
+    unsigned long long now = Host_TimeNs();
+    if(now < nextAt){
+        return;
+    }
+    if(next > 0){
+        Seen *s = &seen[next - 1];
+        s->a = Calc_RecallVariable(CALC_VAR_A);
+        s->m = Calc_RecallVariable(CALC_VAR_M);
+        shown(1, s->row1);
+    }
+    if(next == SCRIPT_STEPS){
+        longjmp(done, 1);
+    }
+    for(const char *k = script[next].keys; *k; k++){
+        Keypad_Push(*k);
+    }
+    next++;
+    nextAt = now + GAP_NS;
+}
+
+int main(void)
+{
+    CHECK(STO[0] == KEY_STO && RCL[0] == KEY_RCL && MPLUS[0] == KEY_MPLUS &&
+          MMIN[0] == KEY_MMINUS && MR[0] == KEY_MR && MC[0] == KEY_MC);
+
+    GpioHost_SetReadHook(onPass);
+    if(!setjmp(done)){
+        Firmware_Main();
+    }
+    GpioHost_SetReadHook(NULL);
+
+    for(unsigned i = 0; i < SCRIPT_STEPS; i++){
+        const Step *step = &script[i];
+        if(seen[i].a != step->a || seen[i].m != step->m || strcmp(seen[i].row1, step->row1) != 0){
+            printf("  step %u \"%s\": A=%g M=%g \"%s\", expected A=%g M=%g \"%s\"\n", i, step->keys,
+                   seen[i].a, seen[i].m, seen[i].row1, step->a, step->m, step->row1);
+        }
+        CHECK(seen[i].a == step->a);
+        CHECK(seen[i].m == step->m);
+        CHECK_STR(seen[i].row1, step->row1);
+    }
+    return CHECK_RESULT();
+}
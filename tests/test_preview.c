@@ -0,0 +1,217 @@
+/*
+Live preview, DEL and the cursor (calc.c): after any sequence of keys, deletes
+and cursor moves, the text matches a model of the units typed and the preview
+agrees with a full evaluation of that text.
+*/
+
+#include "check.h"
+#include "calc.h"
+#include "func.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIALS      20000
+#define MAX_UNITS   MAX_EXPR_LEN
+#define UNIT_CHARS  8
+
+static const char keys[] = "01234567890123456789..++--**//^sctrlgeioaABXDDDLLLRRR";
+
+// Model: the units typed (a digit, an operator, a variable or a function name), cursor in units
+static char units[MAX_UNITS][UNIT_CHARS];
+static int  unitCount;
+static int  cursorUnits;
+
+static void modelText(char *out)
+{
+    out[0] = '\0';
+    for(int i=0; i<unitCount; i++){
+        strcat(out, units[i]);
+    }
+}
+
+static int modelCursor(void)
+{
+    int chars = 0;
+    for(int i=0; i<cursorUnits; i++){
+        chars += (int)strlen(units[i]);
+    }
+    return chars;
+}
+
+static void modelInsert(const char *unit)
+{
+    memmove(units[cursorUnits + 1], units[cursorUnits], (size_t)(unitCount - cursorUnits) * UNIT_CHARS);
+    strcpy(units[cursorUnits], unit);
+    unitCount++;
+    cursorUnits++;
+}
+
+/**
+ * @brief Applies one key to the calculator and the model. Returns 0 if they disagree on the result
+ */
+static int press(char key)
+{
+    char unit[UNIT_CHARS] = {key, '\0'};
+    int  result;
+
+    switch(key){
+    case 'D':
+        result = Calc_Delete();
+        if(cursorUnits == 0){
+            return result == 0;
+        }
+        if(result != (int)strlen(units[cursorUnits - 1])){
+            return 0;
+        }
+        cursorUnits--;
+        unitCount--;
+        memmove(units[cursorUnits], units[cursorUnits + 1], (size_t)(unitCount - cursorUnits) * UNIT_CHARS);
+        return 1;
+    case 'L':
+        result = Calc_MoveCursor(-1);
+        if(result != (cursorUnits > 0)){
+            return 0;
+        }
+        cursorUnits -= result;
+        return 1;
+    case 'R':
+        result = Calc_MoveCursor(1);
+        if(result != (cursorUnits < unitCount)){
+            return 0;
+        }
+        cursorUnits += result;
+        return 1;
+    case 'A':
+    case 'B':
+    case 'X':
+        result = Calc_AddVariable(key == 'A' ? CALC_VAR_A : key == 'B' ? CALC_VAR_B : CALC_VAR_X);
+        break;
+    default:
+        result = Calc_AddChar(key);
+        if(Func_FromKey(key) >= 0){
+            strcpy(unit, Func_Get(Func_FromKey(key))->name);
+        }
+        break;
+    }
+    if(result >= 0){
+        modelInsert(unit);
+    }
+    return 1;
+}
+
+/**
+ * @brief Preview against a full evaluation of the same text in a fresh context
+ */
+static int previewMatches(const char *text)
+{
+    static CalcContext reference;
+    double preview;
+    int    available = Calc_Preview(&preview);
+
+    CalcCtx_Init(&reference);
+    CalcCtx_SetExpression(&reference, text);
+    double full = CalcCtx_Evaluate(&reference);
+
+    if(!available){
+        return CalcCtx_HadError(&reference) || !isfinite(full);
+    }
+    return !CalcCtx_HadError(&reference) &&
+           (preview == full || fabs(preview - full) <= 1e-12 * fabs(full));
+}
+
+static void testProperty(void)
+{
+    char   text[MAX_EXPR_LEN + 1], got[MAX_EXPR_LEN + 1];
+    long   textErrors = 0, mismatches = 0, available = 0, steps = 0;
+    double ignored;
+
+    srand(11);
+    for(int trial=0; trial<TRIALS; trial++){
+        Calc_ClearExpression();
+        unitCount = 0;
+        cursorUnits = 0;
+
+        int length = 1 + rand() % 60;
+        for(int k=0; k<length; k++){
+            if(!press(keys[rand() % (sizeof(keys) - 1)])){
+                textErrors++;
+            }
+            modelText(text);
+            Calc_CopyExpression(got, 0, MAX_EXPR_LEN);
+            if(strcmp(text, got) != 0 || Calc_GetCursor() != modelCursor()){
+                if(textErrors++ < 5){
+                    printf("  text \"%s\" cursor %d, model \"%s\" cursor %d\n",
+                           got, Calc_GetCursor(), text, modelCursor());
+                }
+            }
+            if(text[0] == '\0'){
+                continue;
+            }
+            steps++;
+            available += Calc_Preview(&ignored);
+            if(!previewMatches(text) && mismatches++ < 5){
+                printf("  preview of \"%s\" differs from its evaluation\n", text);
+            }
+        }
+    }
+    CHECK(textErrors == 0);
+    CHECK(mismatches == 0);
+    CHECK(available > steps / 20);  // Random keys mostly make invalid text, but tens of thousands preview
+}
+
+static void testUnits(void)
+{
+    double value;
+
+    Calc_ClearExpression();
+    Calc_AddChar('1');
+    Calc_AddChar('+');
+    Calc_AddChar('s');
+    CHECK_STR(Calc_GetExpression(), "1+sin");
+    CHECK(Calc_Preview(&value) == 0);         // Waiting for the operand
+    CHECK(Calc_Delete() == 3);                // The whole name goes
+    CHECK_STR(Calc_GetExpression(), "1+");
+    Calc_AddChar('2');
+    CHECK(Calc_Preview(&value) == 1);
+    CHECK_NEAR(value, 3.0, 0.0);
+
+    // Insert in the middle: 12+3 becomes 1*52+3... cursor after 1
+    Calc_ClearExpression();
+    Calc_AddChar('1');
+    Calc_AddChar('2');
+    Calc_AddChar('+');
+    Calc_AddChar('3');
+    CHECK(Calc_MoveCursor(-1) && Calc_MoveCursor(-1) && Calc_MoveCursor(-1));
+    CHECK(Calc_GetCursor() == 1);
+    Calc_AddChar('*');
+    Calc_AddChar('5');
+    CHECK_STR(Calc_GetExpression(), "1*52+3");
+    CHECK(Calc_Preview(&value) == 1);
+    CHECK_NEAR(value, 55.0, 0.0);
+
+    // The ends stop the cursor, a delete at the start removes nothing
+    CHECK(Calc_MoveCursor(-1) + Calc_MoveCursor(-1) + Calc_MoveCursor(-1) + Calc_MoveCursor(-1) == 3);
+    CHECK(Calc_Delete() == 0);
+    while(Calc_MoveCursor(1)){
+    }
+    CHECK(Calc_GetCursor() == 6);
+
+    // A division by zero has no preview
+    Calc_ClearExpression();
+    Calc_AddChar('1');
+    Calc_AddChar('/');
+    Calc_AddChar('0');
+    CHECK(Calc_Preview(&value) == 0);
+}
+
+int main(void)
+{
+    Calc_Init();
+    Calc_StoreVariable(CALC_VAR_A, 2.5);
+    Calc_StoreVariable(CALC_VAR_B, -3.0);
+    Calc_StoreVariable(CALC_VAR_X, 7.0);
+
+    testUnits();
+    testProperty();
+    return CHECK_RESULT();
+}
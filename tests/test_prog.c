@@ -0,0 +1,155 @@
+/*
+Stored programs (prog.c): saved to the flash stand-in, loaded back and run
+with their inputs, steps chained as keys continue after '=', and inputs
+and steps that do not evaluate or compile.
+*/
+
+#include "check.h"
+#include "keys.h"
+#include "host.h"
+#include "prog.h"
+#include "lcd.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define IMAGE "prog.bin"
+
+/**
+ * @brief Types program keys into a slot (1-6) through the PRGM prompts. A final '=' with
+ *        nothing typed saves it
+ */
+static void record(char slot, const char *keys)
+{
+    char select[2] = {slot, '\0'};
+
+    Prog_Enter(PROG_RECORD);
+    typeKeys(select, Prog_HandleKey);
+    typeKeys(keys, Prog_HandleKey);
+}
+
+/**
+ * @brief Runs a slot with the inputs keys and returns what row 1 shows
+ */
+static const char* run(char slot, const char *keys)
+{
+    char select[2] = {slot, '\0'};
+
+    Prog_Enter(PROG_RUN);
+    typeKeys(select, Prog_HandleKey);
+    typeKeys(keys, Prog_HandleKey);
+    if(!Prog_OwnsDisplay()){
+        return "";
+    }
+    Prog_Draw();
+    return GpioHost_LcdRow(1);
+}
+
+static void testSaveAndRun(void)
+{
+    CalcProgram program;
+    unsigned    inputs = 0;
+
+    record('1', "A*X+2==");
+    CHECK_STR(Prog_Prompt(), "P1 saved. 1-6?");
+    CHECK(Prog_Load(0, &program, &inputs) == 0);
+    CHECK(inputs == ((1u << CALC_VAR_A) | (1u << CALC_VAR_X)));
+
+    Prog_Enter(PROG_RUN);
+    typeKeys("1", Prog_HandleKey);
+    CHECK_STR(Prog_Prompt(), "A?");
+    typeKeys("3=", Prog_HandleKey);
+    CHECK_STR(Prog_Prompt(), "X?");
+    typeKeys("4=", Prog_HandleKey);
+    CHECK(Prog_OwnsDisplay());
+    Prog_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(1), "14 ", 3) == 0);
+
+    // '=' runs it again with new inputs, a slot without a program says so
+    typeKeys("=5=6=", Prog_HandleKey);
+    Prog_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(1), "32 ", 3) == 0);
+    CHECK_STR(run('6', ""), "");
+    CHECK_STR(Prog_Prompt(), "P6 empty. 1-6?");
+
+    // Rewriting a slot erases the page and keeps the others
+    record('1', "X/2==");
+    record('2', "X^2==");
+    CHECK(strncmp(run('1', "9="), "4.5 ", 4) == 0);
+    CHECK(strncmp(run('2', "9="), "81 ", 3) == 0);
+}
+
+static void testInputErrors(void)
+{
+    record('3', "1/X==");
+    CHECK(strncmp(run('3', "0="), "Error!", 6) == 0);      // The program fails, not the input
+
+    // An input that does not evaluate stays at its prompt and says so
+    run('3', "1/0=");
+    CHECK(!Prog_OwnsDisplay());
+    CHECK_STR(Prog_Prompt(), "Error! X?");
+    typeKeys("2", Prog_HandleKey);
+    CHECK_STR(Prog_Prompt(), "X?");                         // Typing clears it
+    typeKeys("=", Prog_HandleKey);
+    Prog_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(1), "0.5 ", 4) == 0);
+
+    // A program that does not compile stays to be edited
+    record('4', "1+=");
+    CHECK_STR(Prog_Prompt(), "Error! P4.1:");
+}
+
+static void testSteps(void)
+{
+    // Each step continues from the one before: (X*1.2)+5, then the whole of that times 2
+    record('5', "X*1.2=");
+    CHECK_STR(Prog_Prompt(), "P5.2:");
+    typeKeys("+5=*2=", Prog_HandleKey);
+    CHECK_STR(Prog_Prompt(), "P5.4:");
+    typeKeys("=", Prog_HandleKey);
+    CHECK_STR(Prog_Prompt(), "P5 saved. 1-6?");
+    CHECK(strncmp(run('5', "10="), "34 ", 3) == 0);
+
+    // Not 3+1*2: the first step is finished before the second starts
+    record('5', "X+1=*2==");
+    CHECK(strncmp(run('5', "3="), "8 ", 2) == 0);
+
+    // A later step must continue with an operator; a rejected step leaves the ones before
+    record('6', "A-X=5=");
+    CHECK_STR(Prog_Prompt(), "Error! P6.2:");
+    Calc_ClearExpression();
+    typeKeys("/2==", Prog_HandleKey);
+    CHECK(strncmp(run('6', "9=1="), "4 ", 2) == 0);
+
+    // All the steps share MAX_TOKENS instructions
+    record('6', "1=");
+    for(int i = 1; i < MAX_TOKENS / 2; i++){
+        typeKeys("+1=", Prog_HandleKey);
+    }
+    CHECK_STR(Prog_Prompt(), "P6.17:");
+    typeKeys("+1=", Prog_HandleKey);
+    CHECK_STR(Prog_Prompt(), "Error! P6.17:");
+    Calc_ClearExpression();
+    typeKeys("=", Prog_HandleKey);
+    CHECK(strncmp(run('6', ""), "16 ", 3) == 0);
+}
+
+static void testAnsKept(void)
+{
+    CHECK(calculate("6*7") == 42.0);
+    CHECK(strncmp(run('2', "+8="), "2500 ", 5) == 0);       // X = Ans+8 = 50
+    CHECK(Calc_RecallVariable(CALC_VAR_ANS) == 42.0);
+}
+
+int main(void)
+{
+    remove(IMAGE);
+    setenv("FLASH_IMAGE", IMAGE, 1);
+    Calc_Init();
+    LCD_Init();
+    testSaveAndRun();
+    testInputErrors();
+    testSteps();
+    testAnsKept();
+    remove(IMAGE);
+    return CHECK_RESULT();
+}
@@ -0,0 +1,120 @@
+/*
+RPN mode (rpn.c): stack lift and drop, the stack keys, errors leaving the
+stack alone, the power it shares with infix, and the two rows it draws.
+*/
+
+#include "check.h"
+#include "keys.h"
+#include "host.h"
+#include "keypad.h"
+#include "rpn.h"
+#include "lcd.h"
+
+/**
+ * @brief Types keys in RPN mode and returns X
+ */
+static double rpn(const char *keys)
+{
+    typeKeys(keys, Rpn_HandleKey);
+    return Rpn_X();
+}
+
+static void testArithmetic(void)
+{
+    Rpn_Enter();
+    CHECK(rpn("12.5=3*4+") == 41.5);
+    CHECK(rpn("7=2=2^/-") == 39.75);   // 12.5*3+4-7/2^2, no parse and no precedence
+
+    // T is copied down as the stack drops: 5 fills all four levels
+    Rpn_Enter();
+    CHECK(rpn("5===++") == 15.0);
+    CHECK(rpn("+") == 20.0);
+
+    // A number typed after ENTER replaces the copy in X, after an operation it lifts
+    Rpn_Enter();
+    CHECK(rpn("2=3") == 3.0);
+    CHECK(rpn("+4*") == 20.0);
+    CHECK(rpn("K") == 0.0);            // CLx
+    CHECK(rpn("6+") == 6.0);           // 6 replaced the cleared X, Y was 0
+}
+
+static void testStackKeys(void)
+{
+    Rpn_Enter();
+    rpn("1=2=3=4");                    // T=1 Z=2 Y=3 X=4
+    CHECK(rpn("W") == 3.0);            // SWAP
+    CHECK(rpn("W") == 4.0);
+    CHECK(rpn("V") == 3.0);            // ROLL: X=3 Y=2 Z=1 T=4
+    CHECK(rpn("V") == 2.0);
+    CHECK(rpn("V") == 1.0);
+    CHECK(rpn("V") == 4.0);            // Back where it started
+
+    Rpn_Enter();
+    CHECK(rpn("9=4-") == 5.0);
+    CHECK(rpn("L") == 4.0);            // LASTx lifts 4 back
+    CHECK(rpn("+") == 9.0);
+
+    // DEL takes off the last digit while typing
+    Rpn_Enter();
+    CHECK(rpn("123K") == 12.0);
+    CHECK(rpn("C") == 0.0);
+}
+
+static void testPowerAndErrors(void)
+{
+    // '^' is Calc_Power, the function infix uses, exact for integral exponents
+    Rpn_Enter();
+    CHECK(rpn("2=64^") == 18446744073709551616.0);
+    double root = rpn("C2=0.5^");
+    CHECK(root == Calc_Power(2.0, 0.5));
+    CHECK(root == calculate("2^0.5"));
+    CHECK(rpn("C1.5=7^") == calculate("1.5^7"));
+
+    // No result: the stack is left as it was and row 1 says so
+    Rpn_Enter();
+    CHECK(rpn("8=0/") == 0.0);
+    Rpn_Draw();
+    CHECK(strstr(GpioHost_LcdRow(1), "Error!") != NULL);
+    CHECK(rpn("+") == 8.0);
+
+    Rpn_Enter();
+    CHECK(rpn("0=8-") == -8.0);
+    CHECK(rpn("1=3/") == 1.0 / 3.0);
+    CHECK(rpn("^") == 1.0 / 3.0);      // (-8)^(1/3) has no real power here
+    Rpn_Draw();
+    CHECK(strstr(GpioHost_LcdRow(1), "Error!") != NULL);
+    CHECK(rpn("W") == -8.0);
+    CHECK(rpn("r") == -8.0);           // sqrt(-8)
+    CHECK(rpn("L") == 3.0);            // LASTx is still the divisor, from the last operation that worked
+}
+
+static void testDisplay(void)
+{
+    Rpn_Enter();
+    Rpn_ForgetDisplay();
+    typeKeys("12.5=3", Rpn_HandleKey);
+    Rpn_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "Y", 1) == 0 && strstr(GpioHost_LcdRow(0), "12.5") != NULL);
+    CHECK(strncmp(GpioHost_LcdRow(1), "X", 1) == 0 && strstr(GpioHost_LcdRow(1), " 3") != NULL);
+    typeKeys("*", Rpn_HandleKey);
+    Rpn_Draw();
+    CHECK(strstr(GpioHost_LcdRow(1), "37.5") != NULL);
+    CHECK(strstr(GpioHost_LcdRow(0), "12.5") == NULL);   // Dropped: Y is 0 now
+
+    // Something else drew over the rows: the next draw rewrites them whole
+    LCD_Clear();
+    Rpn_ForgetDisplay();
+    Rpn_Draw();
+    CHECK(strstr(GpioHost_LcdRow(1), "37.5") != NULL);
+}
+
+int main(void)
+{
+    Calc_Init();
+    LCD_Init();
+    testArithmetic();
+    testStackKeys();
+    testPowerAndErrors();
+    testDisplay();
+    return CHECK_RESULT();
+}
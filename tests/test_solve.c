@@ -0,0 +1,98 @@
+/*
+Solver mode (solve.c): roots with and without a bracket, the root stored in
+X, interval ends that do not evaluate or that leave Ans alone, and aborting.
+*/
+
+#include "check.h"
+#include "keys.h"
+#include "host.h"
+#include "solve.h"
+#include "lcd.h"
+#include <float.h>
+
+/**
+ * @brief Types f(X) and the interval ends ('=' separated), then iterates to the end
+ */
+static void run(const char *function, const char *ends)
+{
+    Solve_Enter();
+    typeKeys(function, Solve_HandleKey);
+    Solve_HandleKey('=');
+    typeKeys(ends, Solve_HandleKey);
+    while(Solve_IsBusy()){
+        Solve_Step();
+    }
+}
+
+static void checkRoot(double root)
+{
+    double x = Calc_RecallVariable(CALC_VAR_X);
+
+    CHECK(Solve_OwnsDisplay());
+    Solve_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "X=", 2) == 0);
+    if(fabs(x - root) > 8 * DBL_EPSILON * fabs(root)){
+        printf("  X = %.17g, expected %.17g\n", x, root);
+    }
+    CHECK(fabs(x - root) <= 8 * DBL_EPSILON * fabs(root));
+}
+
+static void testRoots(void)
+{
+    run("X^2-2", "1=2=");                 // Bracketed
+    checkRoot(sqrt(2.0));
+    run("X^2-2", "5=5=");                 // One starting guess
+    checkRoot(sqrt(2.0));
+    run("X^3-2*X-5", "2=3=");
+    checkRoot(2.0945514815423265);
+    run("eX-10", "0=5=");
+    checkRoot(log(10.0));
+
+    // Newton would leave the bracket from this end, bisection keeps it in
+    run("aX-45", "0=1000=");
+    checkRoot(1.0);
+}
+
+static void testNoRoot(void)
+{
+    run("X^2+1", "0=0=");                 // f'(0) = 0, nothing to bisect
+    Solve_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "No root found", 13) == 0);
+
+    Solve_Enter();
+    typeKeys("X^2-2", Solve_HandleKey);
+    typeKeys("=1=2=", Solve_HandleKey);
+    CHECK(Solve_IsBusy());
+    Solve_HandleKey('C');
+    CHECK(!Solve_IsBusy());
+    Solve_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "Aborted", 7) == 0);
+}
+
+static void testInputs(void)
+{
+    // An end that does not evaluate stays at its prompt
+    Solve_Enter();
+    typeKeys("X-1=1/0=", Solve_HandleKey);
+    CHECK_STR(Solve_Prompt(), "Error! a?");
+    typeKeys("0=", Solve_HandleKey);
+    CHECK_STR(Solve_Prompt(), "b?");
+    typeKeys("1+=", Solve_HandleKey);
+    CHECK_STR(Solve_Prompt(), "Error! b?");
+
+    // Ends continue from Ans without changing it
+    CHECK(calculate("6*7") == 42.0);
+    run("X-40", "-2=+0=");                // a = 40, b = 42
+    checkRoot(40.0);
+    CHECK(Calc_RecallVariable(CALC_VAR_ANS) == 42.0);
+}
+
+int main(void)
+{
+    Calc_Init();
+    LCD_Init();
+    testRoots();
+    testNoRoot();
+    testInputs();
+    return CHECK_RESULT();
+}
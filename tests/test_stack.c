@@ -0,0 +1,151 @@
+/*
+Stack monitor (stack.c) on the painted Stack_Mem of tools/stack_host.c: the
+test switches onto it with a ucontext, so the frames it measures are real.
+High-water mark, per-path peaks with repainting and nesting, and the guard band.
+*/
+
+#include "check.h"
+#include "host.h"
+#include "stack.h"
+#include <ucontext.h>
+
+#define SLACK 64   // Bytes of frames and alignment around a measured depth
+
+extern unsigned long Stack_Mem[];
+
+static ucontext_t    mainContext, stackContext;
+static int           overflows = 0;
+static unsigned long overflowHighWater = 0;
+
+void Stack_OnOverflow(unsigned long highWater)
+{
+    overflows++;
+    overflowHighWater = highWater;
+}
+
+/**
+ * @brief Uses bytes of stack below the caller, in one frame
+ */
+static __attribute__((noinline)) unsigned char useStack(unsigned long bytes)
+{
+    volatile unsigned char frame[bytes];
+
+    for(unsigned long i=0; i<bytes; i++){
+        frame[i] = 1;
+    }
+    return frame[0];
+}
+
+/**
+ * @brief What onStack measured. CHECK prints, which needs more stack than there is, so the
+ *        checks run back on the host's stack
+ */
+static struct {
+    unsigned long base, deep, afterShallow;
+    unsigned long key, render, step, console;
+    bool          checked, checkedDeep;
+} seen;
+
+/**
+ * @brief Runs on Stack_Mem
+ */
+static void onStack(void)
+{
+    seen.base = Stack_HighWater();
+    seen.checked = Stack_Check();
+
+    // The mark follows the deepest frame and stays there
+    useStack(600);
+    seen.deep = Stack_HighWater();
+    useStack(100);
+    seen.afterShallow = Stack_HighWater();
+
+    // Each path gets its own peak: BEGIN repaints what the one before left
+    Stack_PathBegin(STACK_PATH_KEY);
+    useStack(1000);
+    Stack_PathEnd(STACK_PATH_KEY);
+    Stack_PathBegin(STACK_PATH_RENDER);
+    useStack(200);
+    Stack_PathEnd(STACK_PATH_RENDER);
+
+    // An outer path is credited with everything inside it
+    Stack_PathBegin(STACK_PATH_STEP);
+    Stack_PathBegin(STACK_PATH_CONSOLE);
+    useStack(400);
+    Stack_PathEnd(STACK_PATH_CONSOLE);
+    Stack_PathEnd(STACK_PATH_STEP);
+
+    // Deep, but short of the guard band
+    useStack(Stack_Capacity() - STACK_GUARD_BYTES - seen.base - 256);
+    seen.checkedDeep = Stack_Check();
+}
+
+static void run(void (*fn)(void))
+{
+    getcontext(&stackContext);
+    stackContext.uc_stack.ss_sp = Stack_Mem;
+    stackContext.uc_stack.ss_size = HOST_STACK_BYTES;
+    stackContext.uc_link = &mainContext;
+    makecontext(&stackContext, fn, 0);
+    swapcontext(&mainContext, &stackContext);
+}
+
+/**
+ * @brief A depth bytes below onStack's frame, give or take the calls in between
+ */
+static bool near(unsigned long depth, unsigned long bytes)
+{
+    return depth + SLACK >= seen.base + bytes && depth <= seen.base + bytes + SLACK;
+}
+
+static void testOnStack(void)
+{
+    run(onStack);
+    CHECK(seen.base > 0 && seen.base < 256);
+    CHECK(seen.checked);
+    CHECK(near(seen.deep, 600));
+    CHECK(seen.afterShallow == seen.deep);
+
+    CHECK(near(Stack_PathPeak(STACK_PATH_KEY), 1000));
+    CHECK(near(Stack_PathPeak(STACK_PATH_RENDER), 200));
+    CHECK(near(Stack_PathPeak(STACK_PATH_CONSOLE), 400));
+    CHECK(Stack_PathPeak(STACK_PATH_STEP) >= Stack_PathPeak(STACK_PATH_CONSOLE));
+
+    CHECK(seen.checkedDeep);
+    CHECK(overflows == 0);
+    CHECK(near(Stack_HighWater(), Stack_Capacity() - STACK_GUARD_BYTES - seen.base - 256));
+}
+
+static void testOffStack(void)
+{
+    // The host's own stack is not Stack_Mem: nothing used, nothing repainted outside it
+    CHECK(Stack_Capacity() == HOST_STACK_BYTES);
+    CHECK(Stack_HighWater() == 0);
+    Stack_PathBegin(STACK_PATH_KEY);
+    Stack_PathEnd(STACK_PATH_KEY);
+    CHECK(Stack_PathPeak(STACK_PATH_KEY) == 0);
+}
+
+static void testGuard(void)
+{
+    // A frame that reached the band: reported once, with the depth it got to
+    Stack_Mem[2] = 0;
+    CHECK(!Stack_Check());
+    CHECK(overflows == 1);
+    CHECK(overflowHighWater == HOST_STACK_BYTES - 2 * sizeof(unsigned long));
+    CHECK(!Stack_Check());
+    CHECK(overflows == 1);
+
+    // A repaint leaves the band as evidence
+    Stack_PathBegin(STACK_PATH_KEY);
+    Stack_PathEnd(STACK_PATH_KEY);
+    CHECK(Stack_Mem[2] == 0);
+}
+
+int main(void)
+{
+    testOffStack();
+    testOnStack();
+    testGuard();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,163 @@
+/*
+Statistics mode (stat.c): the Welford accumulators against a two-pass
+reference on 10^6-value streams, known results, and the mode's keys.
+*/
+
+#include "check.h"
+#include "keys.h"
+#include "host.h"
+#include "stat.h"
+#include "lcd.h"
+#include <stdlib.h>
+
+#define STREAM 1000000
+
+static double xs[STREAM], ys[STREAM];
+
+static double relative(double value, double reference)
+{
+    return fabs(value - reference) / fabs(reference);
+}
+
+/**
+ * @brief s, b, a and r of one stream on an offset, against a two-pass long double reference
+ */
+static void checkStream(double offset)
+{
+    StatAccumulator acc;
+    long double     meanX = 0.0L, meanY = 0.0L, sxx = 0.0L, syy = 0.0L, sxy = 0.0L;
+    double          s, b, a, r;
+
+    srand(3);
+    StatAcc_Clear(&acc);
+    for(int i=0; i<STREAM; i++){
+        xs[i] = offset + rand() / (double)RAND_MAX;
+        ys[i] = 2.5 * xs[i] - 7.0 + (rand() / (double)RAND_MAX - 0.5) * 0.1;
+        StatAcc_Push(&acc, xs[i], ys[i]);
+    }
+
+    // Two passes: the means, then the sums of products of deviations
+    for(int i=0; i<STREAM; i++){
+        meanX += xs[i];
+        meanY += ys[i];
+    }
+    meanX /= STREAM;
+    meanY /= STREAM;
+    for(int i=0; i<STREAM; i++){
+        long double dx = xs[i] - meanX, dy = ys[i] - meanY;
+        sxx += dx * dx;
+        syy += dy * dy;
+        sxy += dx * dy;
+    }
+
+    CHECK(StatAcc_Result(&acc, STAT_S, &s) && StatAcc_Result(&acc, STAT_B, &b) &&
+          StatAcc_Result(&acc, STAT_A, &a) && StatAcc_Result(&acc, STAT_R, &r));
+    double refS = (double)sqrtl(sxx / (STREAM - 1));
+    double refB = (double)(sxy / sxx);
+    double refR = (double)(sxy / sqrtl(sxx * syy));
+    double refA = (double)(meanY - refB * meanX);
+
+    // The intercept is a difference of two values ~offset apart, so it keeps less
+    if(relative(s, refS) > 1e-10 || relative(b, refB) > 1e-10 || relative(r, refR) > 1e-10 ||
+       relative(a, refA) > 1e-10 + 1e-15 * offset){
+        printf("  offset %g: s %.1e, b %.1e, r %.1e, a %.1e relative\n", offset,
+               relative(s, refS), relative(b, refB), relative(r, refR), relative(a, refA));
+    }
+    CHECK(relative(s, refS) <= 1e-10);
+    CHECK(relative(b, refB) <= 1e-10);
+    CHECK(relative(r, refR) <= 1e-10);
+    CHECK(relative(a, refA) <= 1e-10 + 1e-15 * offset);
+
+    // Where the raw sums lose it all: the reason for Welford
+    if(offset >= 1e9){
+        double naive = sqrt((acc.sumX2 - acc.sumX * acc.sumX / STREAM) / (STREAM - 1));
+        CHECK(!(relative(naive, refS) < 0.01));
+    }
+}
+
+static void testStability(void)
+{
+    checkStream(0.0);
+    checkStream(1e3);
+    checkStream(1e6);
+    checkStream(1e9);
+}
+
+static void testKnownResults(void)
+{
+    static const double data[] = {2, 4, 4, 4, 5, 5, 7, 9};
+    StatAccumulator acc;
+    double value;
+
+    StatAcc_Clear(&acc);
+    CHECK(StatAcc_Result(&acc, STAT_N, &value) && value == 0.0);
+    CHECK(!StatAcc_Result(&acc, STAT_MEAN, &value));
+    StatAcc_Push(&acc, 2.0, 0.0);
+    CHECK(!StatAcc_Result(&acc, STAT_S, &value));   // s needs two values
+    CHECK(!StatAcc_Result(&acc, STAT_B, &value));   // So does a slope
+
+    StatAcc_Clear(&acc);
+    for(unsigned i=0; i<sizeof(data)/sizeof(data[0]); i++){
+        StatAcc_Push(&acc, data[i], 3.0 * data[i] + 1.0);
+    }
+    CHECK(StatAcc_Result(&acc, STAT_MEAN, &value) && value == 5.0);
+    CHECK(StatAcc_Result(&acc, STAT_SIGMA, &value) && value == 2.0);
+    CHECK(StatAcc_Result(&acc, STAT_S, &value));
+    CHECK_NEAR(value, sqrt(32.0 / 7.0), 1e-15);
+    CHECK(StatAcc_Result(&acc, STAT_MIN, &value) && value == 2.0);
+    CHECK(StatAcc_Result(&acc, STAT_MAX, &value) && value == 9.0);
+    CHECK(StatAcc_Result(&acc, STAT_SUM_X2, &value) && value == 232.0);
+    CHECK(StatAcc_Result(&acc, STAT_B, &value));
+    CHECK_NEAR(value, 3.0, 1e-15);
+    CHECK(StatAcc_Result(&acc, STAT_A, &value));
+    CHECK_NEAR(value, 1.0, 1e-14);
+    CHECK(StatAcc_Result(&acc, STAT_R, &value));
+    CHECK_NEAR(value, 1.0, 1e-15);
+}
+
+static void testMode(void)
+{
+    CHECK_NEAR(calculate("6*7"), 42.0, 0.0);
+
+    Stat_Enter(STAT_PAIRED);
+    CHECK_STR(Stat_Prompt(), "x1?");
+    typeKeys("1=2*2=", Stat_HandleKey);
+    CHECK_STR(Stat_Prompt(), "x2?");
+    typeKeys("3=8=", Stat_HandleKey);
+    typeKeys("1/0=", Stat_HandleKey);
+    CHECK_STR(Stat_Prompt(), "Error! x3?");
+    typeKeys("C5=12=", Stat_HandleKey);     // Typing clears the error
+    CHECK_STR(Stat_Prompt(), "x4?");
+
+    // Entries are prompt values: Ans stays the last calculation
+    CHECK_NEAR(Calc_RecallVariable(CALC_VAR_ANS), 42.0, 0.0);
+
+    // acos shows b, '+' steps to r, any other key goes back to entry
+    CHECK(Stat_HandleKey('o'));
+    CHECK(Stat_OwnsDisplay());
+    Stat_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "b=", 2) == 0);
+    CHECK(strncmp(GpioHost_LcdRow(1), "2 ", 2) == 0);
+    CHECK(Stat_HandleKey('+'));
+    Stat_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), "r=", 2) == 0);
+    CHECK(strncmp(GpioHost_LcdRow(1), "1 ", 2) == 0);
+    CHECK(Stat_HandleKey('='));
+    CHECK(!Stat_OwnsDisplay());
+
+    // Single-variable data has no regression results
+    Stat_Enter(STAT_SINGLE);
+    typeKeys("4=", Stat_HandleKey);
+    CHECK(Stat_HandleKey('a'));
+    CHECK(!Stat_OwnsDisplay());
+}
+
+int main(void)
+{
+    Calc_Init();
+    LCD_Init();
+    testKnownResults();
+    testMode();
+    testStability();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,300 @@
+/*
+Expressions far longer than the keypad buffer, fed to a CalcStream one
+character at a time as the console does. The stream keeps a bounded
+operator/value stack, so 10,000 tokens evaluate in the same RAM as ten; only
+nesting is limited, and running past it is an error, not an overflow.
+
+The keypad context streams the same way as keys are typed, keeping only the
+tail of the text for the LCD, so long entries through Calc_AddChar are
+checked too, as are edits that make it read the text again.
+
+Random expressions are checked against a reference evaluator here, with the
+same precedence table (- below +, / below *, ^ on top, all left-associative)
+and the same order of double operations, so the results match exactly.
+*/
+
+#include "check.h"
+#include "calc.h"
+
+#define TOKENS 10000
+
+static char text[2 * TOKENS + 16];
+
+/**
+ * @brief Streams text through a fresh context. Returns the value, error in *error
+ */
+static double stream(const char *expr, int *error)
+{
+    static CalcContext context;
+    CalcStream         s;
+    int                rejected = 0;
+
+    CalcCtx_Init(&context);
+    CalcStream_Begin(&s, &context);
+    for(const char *p = expr; *p != '\0'; p++){
+        rejected |= (CalcStream_Feed(&s, *p) < 0);
+    }
+    double value = CalcStream_Finish(&s);
+    *error = CalcCtx_HadError(&context);
+    CHECK(!rejected || *error);  // Rejected early means an error at the end
+    return value;
+}
+
+/// Small LCG, so every run checks the same expressions
+static unsigned long seed = 12345;
+static int randomBelow(int n)
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return (int)((seed >> 16) % (unsigned long)n);
+}
+
+static int refPrecedence(char op)
+{
+    switch(op){
+        case '-': return 1;
+        case '+': return 2;
+        case '/': return 3;
+        case '*': return 4;
+        default:  return 5;
+    }
+}
+
+static void refApply(double *values, int *top, char op)
+{
+    double b = values[--*top];
+    double *a = &values[*top - 1];
+    switch(op){
+        case '+': *a = *a + b; break;
+        case '-': *a = *a - b; break;
+        case '*': *a = *a * b; break;
+        default:  *a = *a / b; break;
+    }
+}
+
+/**
+ * @brief Reference for single-digit operands and + - * /, reducing in the order the stream does
+ */
+static double reference(const char *expr)
+{
+    double values[8];
+    char   ops[8];
+    int    valueTop = 0, opTop = 0;
+
+    for(const char *p = expr; *p != '\0'; p++){
+        if(*p >= '0' && *p <= '9'){
+            values[valueTop++] = *p - '0';
+            continue;
+        }
+        while(opTop > 0 && refPrecedence(ops[opTop - 1]) >= refPrecedence(*p)){
+            refApply(values, &valueTop, ops[--opTop]);
+        }
+        ops[opTop++] = *p;
+    }
+    while(opTop > 0){
+        refApply(values, &valueTop, ops[--opTop]);
+    }
+    return values[0];
+}
+
+static void testRandom(void)
+{
+    static const char operators[] = "+-*/";
+    int error;
+
+    for(int round = 0; round < 4; round++){
+        char *p = text;
+        *p++ = (char)('1' + randomBelow(9));
+        for(int i = 1; i < TOKENS / 2; i++){
+            *p++ = operators[randomBelow(4)];
+            *p++ = (char)('1' + randomBelow(9));
+        }
+        *p = '\0';
+
+        double value = stream(text, &error);
+        CHECK(!error);
+        CHECK(value == reference(text));
+    }
+}
+
+static void testChains(void)
+{
+    int error;
+
+    // 5,000 ones: 9,999 tokens, exact in the integer backend
+    text[0] = '1';
+    for(int i = 1; i < TOKENS / 2; i++){
+        text[2 * i - 1] = '+';
+        text[2 * i] = '1';
+    }
+    text[TOKENS - 1] = '\0';
+    CHECK(stream(text, &error) == TOKENS / 2);
+    CHECK(!error);
+
+    // X is 2, multiplied by one 5,000 times
+    strcpy(text, "X");
+    for(int i = 0; i < TOKENS / 2; i++){
+        strcat(text + 2 * i, "*1");
+    }
+    Calc_StoreVariable(CALC_VAR_X, 2.0);
+    CHECK(stream(text, &error) == 2.0);
+    CHECK(!error);
+
+    // A long expression that goes wrong at the end is still an error
+    text[TOKENS + 1] = '*';
+    text[TOKENS + 2] = '\0';
+    stream(text, &error);
+    CHECK(error);
+}
+
+static void testNesting(void)
+{
+    int error;
+
+    // Within CALC_MAX_NESTING: sqrt of sqrt ... of 1
+    text[0] = '\0';
+    for(int i = 0; i < CALC_MAX_NESTING - 1; i++){
+        strcat(text, "sqrt");
+    }
+    strcat(text, "1");
+    CHECK(stream(text, &error) == 1.0);
+    CHECK(!error);
+
+    // 10,000 functions deep: rejected once the stack is full, the rest ignored
+    static char deep[4 * TOKENS + 2];
+    for(int i = 0; i < TOKENS; i++){
+        memcpy(deep + 4 * i, "sqrt", 4);
+    }
+    strcpy(deep + 4 * TOKENS, "1");
+    CHECK(stream(deep, &error) == 0.0);
+    CHECK(error);
+}
+
+/**
+ * @brief Types expr through Calc_AddChar, one key at a time as the keypad does
+ */
+static void typeExpression(const char *expr)
+{
+    Calc_ClearExpression();
+    for(const char *p = expr; *p != '\0'; p++){
+        CHECK(Calc_AddChar(*p) == 0);
+    }
+}
+
+static void testKeypadLong(void)
+{
+    // The keypad buffer only keeps MAX_EXPR_LEN characters for the LCD; entry goes on past it
+    int error;
+
+    Calc_Init();
+    for(int round = 0; round < 2; round++){
+        char *p = text;
+        *p++ = (char)('1' + randomBelow(9));
+        for(int i = 1; i < TOKENS / 2; i++){
+            *p++ = "+-*/"[randomBelow(4)];
+            *p++ = (char)('1' + randomBelow(9));
+        }
+        *p = '\0';
+
+        typeExpression(text);
+        const char *kept = Calc_GetExpression();
+        CHECK(strlen(kept) < MAX_EXPR_LEN);
+        CHECK(strcmp(kept, text + strlen(text) - strlen(kept)) == 0);  // The tail, as the LCD shows it
+
+        double preview;
+        CHECK(Calc_Preview(&preview));
+        double value = Calc_Evaluate();
+        CHECK(!Calc_HadError());
+        CHECK(value == reference(text));
+        CHECK(value == stream(text, &error));
+        CHECK(preview == value);
+    }
+
+    // A truncated expression is append-only: no DEL, no cursor moves, no compiling its tail
+    CalcProgram program;
+    CHECK(Calc_Delete() == 0);
+    CHECK(Calc_MoveCursor(-1) == 0);
+    CHECK(Calc_Compile(&program) < 0);
+
+    // ... and keys typed after '=' carry on from where it ended, as on the LCD
+    CHECK(Calc_AddChar('+') == 0);
+    CHECK(Calc_AddChar('1') == 0);
+    strcat(text, "+1");
+    CHECK(Calc_Evaluate() == reference(text));
+
+    // 5,000 ones typed, and a trailing operator is still an error
+    text[0] = '1';
+    for(int i = 1; i < TOKENS / 2; i++){
+        text[2 * i - 1] = '+';
+        text[2 * i] = '1';
+    }
+    text[TOKENS - 1] = '\0';
+    typeExpression(text);
+    CHECK(Calc_Evaluate() == TOKENS / 2);
+    CHECK(Calc_AddChar('+') == 0);
+    Calc_Evaluate();
+    CHECK(Calc_HadError());
+
+    // A variable read early in a long entry keeps the value it had when typed
+    Calc_StoreVariable(CALC_VAR_X, 2.0);
+    Calc_ClearExpression();
+    CHECK(Calc_AddVariable(CALC_VAR_X) == 0);
+    for(int i = 0; i < MAX_EXPR_LEN; i++){
+        CHECK(Calc_AddChar('*') == 0);
+        CHECK(Calc_AddChar('1') == 0);
+    }
+    Calc_StoreVariable(CALC_VAR_X, 3.0);
+    CHECK(Calc_Evaluate() == 2.0);
+
+    // Before it is truncated, the text is read again instead
+    Calc_ClearExpression();
+    CHECK(Calc_AddVariable(CALC_VAR_X) == 0);
+    CHECK(Calc_AddChar('*') == 0);
+    CHECK(Calc_AddChar('2') == 0);
+    Calc_StoreVariable(CALC_VAR_X, 4.0);
+    CHECK(Calc_Evaluate() == 8.0);
+}
+
+/**
+ * @brief Short expressions through the stream fed as typed, and again after edits leave it stale
+ */
+static void testKeypadEdits(void)
+{
+    int error;
+
+    for(int round = 0; round < 200; round++){
+        char *p = text;
+        int   tokens = 1 + 2 * randomBelow(20);
+        *p++ = (char)('1' + randomBelow(9));
+        for(int i = 1; i < tokens; i += 2){
+            *p++ = "+-*/"[randomBelow(4)];
+            *p++ = (char)('1' + randomBelow(9));
+        }
+        *p = '\0';
+
+        // Typed at the end: finished from the live stream
+        typeExpression(text);
+        double typed = Calc_Evaluate();
+        CHECK(typed == stream(text, &error));
+        CHECK(Calc_Evaluate() == typed);  // Finishing left the stream open
+
+        // The first digit deleted and typed again: the text is read again
+        CHECK(Calc_MoveCursor(-1) == 1 || tokens == 1);
+        for(int i = 1; i < tokens; i++){
+            Calc_MoveCursor(-1);
+        }
+        Calc_MoveCursor(1);
+        CHECK(Calc_Delete() == 1);
+        CHECK(Calc_AddChar(text[0]) == 0);
+        CHECK(Calc_Evaluate() == typed);
+    }
+}
+
+int main(void)
+{
+    testRandom();
+    testChains();
+    testNesting();
+    testKeypadLong();
+    testKeypadEdits();
+    return CHECK_RESULT();
+}
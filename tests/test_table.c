@@ -0,0 +1,101 @@
+/*
+Table mode (table.c): rows from the compiled f(X), inputs that leave Ans alone,
+and ranges too long for a long.
+*/
+
+#include "check.h"
+#include "keys.h"
+#include "host.h"
+#include "table.h"
+#include "lcd.h"
+#include <float.h>
+
+static void startTable(const char *function, const char *start, const char *end, const char *step)
+{
+    Table_Enter();
+    typeKeys(function, Table_HandleKey);
+    Table_HandleKey('=');
+    typeKeys(start, Table_HandleKey);
+    Table_HandleKey('=');
+    typeKeys(end, Table_HandleKey);
+    Table_HandleKey('=');
+    typeKeys(step, Table_HandleKey);
+    Table_HandleKey('=');
+}
+
+static void checkShown(const char *x, const char *f)
+{
+    Table_Draw();
+    CHECK(strncmp(GpioHost_LcdRow(0), x, strlen(x)) == 0);
+    CHECK(strncmp(GpioHost_LcdRow(1), f, strlen(f)) == 0);
+}
+
+static void testRows(void)
+{
+    startTable("X*X+1", "1", "10", "1");
+    CHECK(Table_IsViewing());
+    checkShown("X=1 ", "f=2 ");
+    Table_HandleKey('+');
+    checkShown("X=2 ", "f=5 ");
+    Table_HandleKey('*');             // A page on
+    checkShown("X=10", "f=101");
+    Table_HandleKey('+');             // Past the end stays on the last row
+    checkShown("X=10", "f=101");
+}
+
+static void testAnsKept(void)
+{
+    CHECK_NEAR(calculate("6*7"), 42.0, 0.0);
+
+    startTable("X+A", "2+3", "5*4", "5");
+    CHECK(Table_IsViewing());
+    checkShown("X=5 ", "f=5 ");       // A is 0
+    CHECK_NEAR(Calc_RecallVariable(CALC_VAR_ANS), 42.0, 0.0);
+
+    // Ans is still the one from before the table, inside the table's inputs too
+    Calc_ClearExpression();
+    startTable("X", "0", "*2", "1");  // End = Ans * 2
+    CHECK(Table_IsViewing());
+    for(int i=0; i<84; i++){
+        Table_HandleKey('+');
+    }
+    checkShown("X=84", "f=84");
+    CHECK_NEAR(Calc_RecallVariable(CALC_VAR_ANS), 42.0, 0.0);
+}
+
+static void testHugeRange(void)
+{
+    // 10^300 rows: cut at TABLE_MAX_ROWS rather than overflowing the long (UBSan aborts if it does)
+    startTable("X", "0", "10^300", "1");
+    CHECK(Table_IsViewing());
+    checkShown("X=0 ", "f=0 ");
+    Table_HandleKey('*');
+    checkShown("X=8 ", "f=8 ");
+
+    // Infinite span (the step is tiny) is clamped the same way
+    startTable("X", "0", "10^300", "1/10^300");
+    CHECK(Table_IsViewing());
+    checkShown("X=0 ", "f=0 ");
+
+    // An input that does not evaluate stays at its prompt
+    Table_Enter();
+    typeKeys("X=1/0=", Table_HandleKey);
+    CHECK_STR(Table_Prompt(), "Error! Start?");
+    typeKeys("2=", Table_HandleKey);
+    CHECK_STR(Table_Prompt(), "End?");
+
+    // End before start is an error at the Step prompt
+    startTable("X", "5", "1", "1");
+    CHECK(!Table_IsViewing());
+    CHECK_STR(Table_Prompt(), "Error! Step?");
+}
+
+int main(void)
+{
+    Calc_Init();
+    LCD_Init();
+    testRows();
+    testAnsKept();
+    testHugeRange();
+    return CHECK_RESULT();
+}
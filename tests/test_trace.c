@@ -0,0 +1,157 @@
+/*
+Event trace of a host simulation, through tools/trace2json.py.
+
+The whole firmware runs with CALC_TRACE on the host stand-ins while keys
+"1+2=" are pressed on the modelled keypad. The trace is dumped as the
+target's debugger saves it (tools/trace_host.c) and converted. The JSON must
+have balanced slices and ordered timestamps, show the keys, the evaluation
+and "3" reaching the LCD, and place the '=' key where the simulation pressed
+it: the microseconds come from CYCCNT and the recorded clock changes.
+
+The ring is enlarged (TRACE_RECORDS) to keep everything since boot, so
+timestamps count from 0 as the simulated time does. trace.json is left in
+tests/ for ui.perfetto.dev.
+*/
+
+#include "check.h"
+#include "host.h"
+#include "gpio.h"
+#include "trace.h"
+#include <setjmp.h>
+#include <stdlib.h>
+
+int Firmware_Main(void);
+
+#define BOOT_NS   60000000ULL    // LCD power-on sequence finished by then
+#define HOLD_US   30000UL        // Longer than the 20 ms debounce
+#define GAP_NS    130000000ULL   // Key to key
+
+typedef struct {
+    char key;
+    int  row;
+    int  col;
+} KeyPosition;
+
+static const KeyPosition script[] = { {'1', 0, 0}, {'+', 0, 3}, {'2', 0, 1}, {'=', 3, 3} };
+#define SCRIPT_KEYS (sizeof(script) / sizeof(script[0]))
+
+static jmp_buf            done;
+static unsigned           next = 0;
+static unsigned long long nextAt = BOOT_NS;
+static unsigned long long pressedAt[SCRIPT_KEYS];
+
+/**
+ * @brief Runs at the start of every main loop pass (the scan's first column read)
+ */
+static void onPass(unsigned long base, unsigned long mask)
+{
+    if(base != GPIO_PORTE_BASE || mask != KEYPAD_ROW_MASK ||
+       (GpioHost_Pins(GPIO_PORTD_BASE) & KEYPAD_COL_MASK) != 0x0E){
+        return;
+    }
+    unsigned long long now = Host_TimeNs();
+    if(now < nextAt){
+        return;
+    }
+    if(next == SCRIPT_KEYS){
+        longjmp(done, 1);
+    }
+    GpioHost_HoldKey(script[next].row, script[next].col, HOLD_US);
+    pressedAt[next++] = now;
+    nextAt = now + GAP_NS;
+}
+
+static char *readFile(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if(f == NULL){
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    char *text = malloc((size_t)size + 1);
+    text[fread(text, 1, (size_t)size, f)] = '\0';
+    fclose(f);
+    return text;
+}
+
+static int count(const char *text, const char *what)
+{
+    int n = 0;
+    for(const char *p = text; (p = strstr(p, what)) != NULL; p += strlen(what)){
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Timestamp of the event object that contains at (its "ts" comes before its "name")
+ */
+static double timestampOf(const char *text, const char *at)
+{
+    const char *p = at;
+    while(p > text && strncmp(p, "\"ts\": ", 6) != 0){
+        p--;
+    }
+    return atof(p + 6);
+}
+
+static void checkTimeline(const char *json)
+{
+    // Slices balance, and time never runs backwards
+    CHECK(count(json, "\"ph\": \"B\"") == count(json, "\"ph\": \"E\""));
+    CHECK(count(json, "\"name\": \"evaluate\"") >= 2);
+    CHECK(count(json, "\"name\": \"delay\"") > 0);
+
+    int    ordered = 1;
+    double last = -1.0;
+    for(const char *p = json; (p = strstr(p, "\"ts\": ")) != NULL; p += 6){
+        double ts = atof(p + 6);
+        ordered &= (ts >= last);
+        last = ts;
+    }
+    CHECK(ordered);
+    CHECK(last * 1000.0 <= (double)Host_TimeNs());
+
+    // Every key, as scanned and as typed
+    CHECK(strstr(json, "key_debounced '1'") != NULL);
+    CHECK(strstr(json, "key_debounced '+'") != NULL);
+    CHECK(strstr(json, "key_debounced '2'") != NULL);
+    CHECK(strstr(json, "addchar '2'") != NULL);
+    CHECK(strstr(json, "key_pressed r3 c3") != NULL);
+
+    // '=' is debounced once released, HOLD_US after the press, and the result is drawn after it
+    const char *equals = strstr(json, "key_debounced '='");
+    CHECK(equals != NULL);
+    if(equals != NULL){
+        double expected = (double)pressedAt[SCRIPT_KEYS - 1] / 1000.0 + HOLD_US;
+        double ts = timestampOf(json, equals);
+        if(ts < expected || ts > expected + 50.0){
+            printf("  '=' debounced at %.3f us, released at %.3f us\n", ts, expected);
+        }
+        CHECK(ts >= expected && ts <= expected + 50.0);
+        CHECK(strstr(equals, "lcd_data '3'") != NULL);
+    }
+}
+
+int main(void)
+{
+    GpioHost_SetReadHook(onPass);
+    if(!setjmp(done)){
+        Firmware_Main();
+    }
+    GpioHost_SetReadHook(NULL);
+
+    CHECK(traceBuffer.head <= TRACE_RECORDS);       // Nothing overwritten, the trace starts at boot
+    CHECK(TraceHost_Dump("trace.bin") == 0);
+    CHECK(system("python3 ../tools/trace2json.py trace.bin trace.json") == 0);
+
+    char *json = readFile("trace.json");
+    CHECK(json != NULL);
+    if(json != NULL){
+        checkTimeline(json);
+        free(json);
+    }
+    return CHECK_RESULT();
+}
@@ -0,0 +1,108 @@
+/*
+Host stand-in for src/clock.c, for running the drivers on a PC in simulated time.
+
+Link it instead of src/clock.c (and with periph_host.c). Nothing waits: a delay
+advances the simulated clock by exactly the cycles the target would spend in
+it, at the current speed, and DWT_CYCCNT advances with it. Cycles_Now(), the
+PERF macros and Clock_UptimeUs() therefore all report simulated time, which is
+the same on every run. Host_Advance() lets time pass for work the simulation
+does not otherwise charge for (gpio_host.c charges each pin access). Reading
+the uptime costs HOST_CLOCK_READ_CYCLES, so a loop that polls it, like
+LCD_Init() waiting on LCD_Poll(), still moves forward.
+
+The PLL is taken as locked from the start, so CLOCK_FAST is never refused.
+*/
+
+#include "clock.h"
+#include "perf.h"
+#include "trace.h"
+#include "host.h"
+
+static const unsigned long clockHz[CLOCK_SPEED_COUNT] = {
+    16000000,  // CLOCK_SLOW
+    80000000   // CLOCK_FAST
+};
+
+static ClockSpeed         currentSpeed = CLOCK_SLOW;
+static unsigned long long cyclesAt[CLOCK_SPEED_COUNT];
+static unsigned long long elapsedPs;   // Simulated time in picoseconds, exact at both speeds
+
+void Host_Advance(unsigned long cycles)
+{
+    DWT_CYCCNT_R += cycles;
+    cyclesAt[currentSpeed] += cycles;
+    elapsedPs += (unsigned long long)cycles * (1000000000000ULL / clockHz[currentSpeed]);
+}
+
+unsigned long long Host_Cycles(void)
+{
+    return cyclesAt[CLOCK_SLOW] + cyclesAt[CLOCK_FAST];
+}
+
+unsigned long long Host_TimeNs(void)
+{
+    return elapsedPs / 1000;
+}
+
+void SysTick_init(void)
+{
+}
+
+void PLL_init(void)
+{
+    currentSpeed = CLOCK_SLOW;
+}
+
+void SysTick_wait(unsigned long delay)
+{
+    Host_Advance(delay);
+}
+
+void delay_ms(unsigned long delay)
+{
+    TRACE(TRACE_DELAY_BEGIN, delay * 1000);
+    Host_Advance(delay * (clockHz[currentSpeed] / 1000));
+    TRACE(TRACE_DELAY_END, 0);
+}
+
+void delay_us(unsigned long delay)
+{
+#ifdef CALC_TRACE
+    int traced = (delay >= TRACE_MIN_DELAY_US);
+    if (traced) TRACE(TRACE_DELAY_BEGIN, delay);
+#endif
+    Host_Advance(delay * (clockHz[currentSpeed] / 1000000));
+#ifdef CALC_TRACE
+    if (traced) TRACE(TRACE_DELAY_END, 0);
+#endif
+}
+
+void Clock_SetSpeed(ClockSpeed speed)
+{
+    if (speed == currentSpeed) {
+        return;
+    }
+    currentSpeed = speed;
+    TRACE(TRACE_CLOCK, clockHz[speed] / 1000000);
+}
+
+ClockSpeed Clock_GetSpeed(void)
+{
+    return currentSpeed;
+}
+
+unsigned long Clock_GetHz(void)
+{
+    return clockHz[currentSpeed];
+}
+
+unsigned long Clock_TimeAtMs(ClockSpeed speed)
+{
+    return (unsigned long)(cyclesAt[speed] / (clockHz[speed] / 1000));
+}
+
+unsigned long Clock_UptimeUs(void)
+{
+    Host_Advance(HOST_CLOCK_READ_CYCLES);
+    return (unsigned long)(elapsedPs / 1000000);
+}
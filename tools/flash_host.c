@@ -0,0 +1,89 @@
+/*
+Host stand-in for src/flash.c, for building the calculator core on a PC.
+
+Link it instead of src/flash.c. The store page is kept in memory and saved to
+flash.bin (or $FLASH_IMAGE) after every erase or write, so programs survive
+between runs the way they survive a reset on the board. It behaves like the
+real flash: erase sets the page to 0xFF and a write can only clear bits, so
+code that forgets to erase shows the same corruption it would on the target.
+Only the store page exists; any other address is an access violation.
+*/
+
+#include "flash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned char page[FLASH_PAGE_SIZE];
+static int           loaded = 0;
+
+static const char* imagePath(void)
+{
+    const char *path= getenv("FLASH_IMAGE");
+    return (path != NULL) ? path : "flash.bin";
+}
+
+/**
+ * @brief Loads the image on first use. A missing or short file reads as erased flash
+ */
+static void load(void)
+{
+    if(loaded){
+        return;
+    }
+    loaded= 1;
+    memset(page, 0xFF, sizeof(page));
+
+    FILE *f= fopen(imagePath(), "rb");
+    if(f != NULL){
+        size_t n= fread(page, 1, sizeof(page), f);
+        (void)n;
+        fclose(f);
+    }
+}
+
+static void save(void)
+{
+    FILE *f= fopen(imagePath(), "wb");
+    if(f != NULL){
+        fwrite(page, 1, sizeof(page), f);
+        fclose(f);
+    }
+}
+
+static int inStore(unsigned long address, unsigned long length)
+{
+    return address >= FLASH_STORE_PAGE && address + length <= FLASH_STORE_PAGE + FLASH_PAGE_SIZE;
+}
+
+int Flash_ErasePage(unsigned long address)
+{
+    if(address != FLASH_STORE_PAGE){
+        return -1;
+    }
+    load();
+    memset(page, 0xFF, sizeof(page));
+    save();
+    return 0;
+}
+
+int Flash_Write(unsigned long address, const void *data, int length)
+{
+    const unsigned char *bytes= (const unsigned char *)data;
+
+    if(address % 4 != 0 || length % 4 != 0 || !inStore(address, (unsigned long)length)){
+        return -1;
+    }
+    load();
+    for(int i=0; i<length; i++){
+        page[address - FLASH_STORE_PAGE + i]&= bytes[i];
+    }
+    save();
+    return 0;
+}
+
+const void* Flash_Read(unsigned long address)
+{
+    load();
+    return inStore(address, 1) ? &page[address - FLASH_STORE_PAGE] : NULL;
+}
@@ -0,0 +1,245 @@
+/*
+Host stand-in for the GPIO pins, for running lcd.c and keypad.c on a PC.
+
+Build the drivers with GPIO_MOCK so GPIO_WritePins/GPIO_ReadPins (gpio.h) call
+in here, and link clock_host.c for the simulated time. Each access is one bus
+access on the target, and costs HOST_GPIO_ACCESS_CYCLES of simulated time.
+
+- Ports A, B, D and E keep pin levels. A write changes only the pins in its
+  mask and a read returns 0 outside it, like the TM4C's address-masked DATA
+  register.
+- Port E reads the keypad matrix: a row reads low while a held key joins it
+  to a column that port D drives low. Rows are pulled up otherwise.
+- Ports A and B drive an HD44780 in 4-bit mode (gpio.h has the pins). On EN
+  falling it latches RS and DB4-DB7, and keeps DDRAM so a test can read back
+  what the display shows. It starts in 8-bit mode, as after power-on.
+- A read hook lets a simulation act at a known point, e.g. once per main loop
+  pass when the keypad scan reads its first column.
+- GpioHostStats counts what the target's pins would have shown: data or RS
+  moving while EN is high, data changing twice before a latch (the
+  intermediate value of a read-modify-write), and stores whose mask reaches
+  pins the drivers do not own.
+*/
+
+#include "gpio.h"
+#include "host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PORT_COUNT 4
+
+typedef enum { PORT_A, PORT_B, PORT_D, PORT_E } HostPort;
+
+static const unsigned long portBase[PORT_COUNT] = {
+    GPIO_PORTA_BASE, GPIO_PORTB_BASE, GPIO_PORTD_BASE, GPIO_PORTE_BASE
+};
+
+// Pins the drivers write: LCD control, LCD data, keypad columns. Port E is all inputs.
+static const unsigned long ownedPins[PORT_COUNT] = {
+    LCD_CTRL_MASK, LCD_DATA_MASK, KEYPAD_COL_MASK, 0
+};
+
+static unsigned long      pins[PORT_COUNT];
+static GpioHostStats      stats;
+static unsigned long long keyUntilNs[4][4];   // Simulated time each key is held until
+static GpioHostReadHook   readHook;
+
+// HD44780 model
+static char          ddram[2][LCD_ROW_CELLS + 1];
+static unsigned char address;          // DDRAM address counter
+static int           fourBit;          // Interface width set by the last function set
+static int           highNibble;       // First half of a 4-bit transfer, -1 if none
+static int           dataChanged;      // DB4-DB7 changed since the last latch
+static unsigned long lcdBytes;
+
+static HostPort portOf(unsigned long base)
+{
+    for(int i=0; i<PORT_COUNT; i++){
+        if(portBase[i] == base){
+            return (HostPort)i;
+        }
+    }
+    fprintf(stderr, "gpio_host: no port at %#lx\n", base);
+    exit(2);
+}
+
+static unsigned long keypadRows(void)
+{
+    unsigned long rows= KEYPAD_ROW_MASK;
+    unsigned long long now= Host_TimeNs();
+
+    for(int row=0; row<4; row++){
+        for(int col=0; col<4; col++){
+            if(keyUntilNs[row][col] > now && !(pins[PORT_D] & (1u << col))){
+                rows&= ~(1u << row);
+            }
+        }
+    }
+    return rows;
+}
+
+static void lcdCommand(unsigned char command)
+{
+    if(command & 0x80){
+        address= command & 0x7F;              // Set DDRAM address
+    }
+    else if((command & 0xE0) == 0x20){
+        fourBit= !(command & 0x10);           // Function set, DL bit
+    }
+    else if(command == 0x01){
+        memset(ddram[0], ' ', LCD_ROW_CELLS); // Clear
+        memset(ddram[1], ' ', LCD_ROW_CELLS);
+        address= 0;
+    }
+    else if((command & 0xFE) == 0x02){
+        address= 0;                           // Home
+    }
+    // Entry mode (increment assumed), display control and shifts do not change DDRAM
+}
+
+static void lcdData(unsigned char data)
+{
+    int row= (address >= 0x40);
+    int col= address & 0x3F;
+
+    if(col < LCD_ROW_CELLS){
+        ddram[row][col]= (char)data;
+    }
+    address++;
+    if(address == LCD_ROW_CELLS){
+        address= 0x40;                        // End of row 0 runs on into row 1
+    }
+    else if(address == 0x40 + LCD_ROW_CELLS){
+        address= 0;
+    }
+}
+
+static void lcdLatch(unsigned char nibble, int isData)
+{
+    stats.lcdNibbles++;
+    if(!fourBit){
+        // 8-bit interface: DB0-DB3 are not wired, so they read as 0
+        lcdBytes++;
+        lcdCommand((unsigned char)(nibble << 4));
+        return;
+    }
+    if(highNibble < 0){
+        highNibble= nibble;
+        return;
+    }
+    unsigned char byte= (unsigned char)((highNibble << 4) | nibble);
+    highNibble= -1;
+    lcdBytes++;
+    if(isData){
+        lcdData(byte);
+    }
+    else{
+        lcdCommand(byte);
+    }
+}
+
+/**
+ * @brief Changes pin levels and lets the LCD see the edges
+ */
+static void setPins(HostPort port, unsigned long mask, unsigned long value)
+{
+    unsigned long before= pins[port];
+    unsigned long after= (before & ~mask) | (value & mask);
+    unsigned long changed= before ^ after;
+    int enableHigh= (pins[PORT_A] & LCD_EN_PIN) != 0;
+
+    pins[port]= after;
+
+    if(port == PORT_B && (changed & LCD_DATA_MASK)){
+        if(enableHigh || dataChanged){
+            stats.dataGlitches++;
+        }
+        dataChanged= 1;
+    }
+    if(port == PORT_A && (changed & LCD_RS_PIN) && enableHigh){
+        stats.rsGlitches++;
+    }
+    if(port == PORT_A && (changed & LCD_EN_PIN) && !(after & LCD_EN_PIN)){
+        dataChanged= 0;
+        lcdLatch((unsigned char)(pins[PORT_B] & LCD_DATA_MASK), (after & LCD_RS_PIN) != 0);
+    }
+}
+
+void GpioHost_Write(unsigned long base, unsigned long mask, unsigned long value)
+{
+    HostPort port= portOf(base);
+
+    Host_Advance(HOST_GPIO_ACCESS_CYCLES);
+    stats.writes++;
+    if(mask & ~ownedPins[port]){
+        stats.strayWrites++;
+    }
+    setPins(port, mask, value);
+}
+
+unsigned long GpioHost_Read(unsigned long base, unsigned long mask)
+{
+    Host_Advance(HOST_GPIO_ACCESS_CYCLES);
+    stats.reads++;
+    if(readHook != NULL){
+        readHook(base, mask);
+    }
+    return GpioHost_Pins(base) & mask;
+}
+
+void GpioHost_Reset(void)
+{
+    memset(pins, 0, sizeof(pins));
+    memset(&stats, 0, sizeof(stats));
+    memset(keyUntilNs, 0, sizeof(keyUntilNs));
+    memset(ddram, ' ', sizeof(ddram));
+    ddram[0][LCD_ROW_CELLS]= '\0';
+    ddram[1][LCD_ROW_CELLS]= '\0';
+    address= 0;
+    fourBit= 0;
+    highNibble= -1;
+    dataChanged= 0;
+    lcdBytes= 0;
+}
+
+const GpioHostStats* GpioHost_GetStats(void)
+{
+    return &stats;
+}
+
+unsigned long GpioHost_Pins(unsigned long base)
+{
+    HostPort port= portOf(base);
+    return (port == PORT_E) ? keypadRows() : pins[port];
+}
+
+void GpioHost_Drive(unsigned long base, unsigned long mask, unsigned long value)
+{
+    setPins(portOf(base), mask, value);
+}
+
+void GpioHost_HoldKey(int row, int col, unsigned long microseconds)
+{
+    keyUntilNs[row][col]= Host_TimeNs() + (unsigned long long)microseconds * 1000;
+}
+
+void GpioHost_SetReadHook(GpioHostReadHook hook)
+{
+    readHook= hook;
+}
+
+const char* GpioHost_LcdRow(int row)
+{
+    return ddram[row];
+}
+
+unsigned long GpioHost_LcdBytes(void)
+{
+    return lcdBytes;
+}
+
+__attribute__((constructor)) static void start(void)
+{
+    GpioHost_Reset();
+}
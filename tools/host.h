@@ -0,0 +1,105 @@
+#ifndef HOST_H
+#define HOST_H
+
+/**
+ * @file host.h
+ * @brief Host stand-ins for building the firmware modules on a PC (bench/ and tests/):
+ *        - periph_host.c maps RAM at the peripheral addresses, so the register macros in include/
+ *          read and write ordinary memory. Linking it is enough, the mapping is made before main
+ *        - clock_host.c replaces src/clock.c. Delays advance a simulated clock instead of waiting,
+ *          and DWT_CYCCNT follows it, so Cycles_Now() and the PERF macros count simulated cycles
+ *        - gpio_host.c models the GPIO pins behind GPIO_WritePins/GPIO_ReadPins (build with
+ *          GPIO_MOCK): address masking, a keypad matrix and an HD44780 decoding what lcd.c sends
+ *        - uart_host.c models UART0 and its uDMA channels under console.c (build with UART_MOCK),
+ *          optionally wired to a pseudo-terminal
+ *        - trace_host.c saves the traceBuffer of a CALC_TRACE simulation as the target's debugger would
+ *        - stack_host.c provides Stack_Mem/Stack_Top for src/stack.c, painted as Reset_Handler does
+ *        - flash_host.c replaces src/flash.c
+ */
+
+#include "lcd.h"
+
+// ---- clock_host.c ----
+
+#define HOST_CLOCK_READ_CYCLES 20  // Simulated cost of Clock_UptimeUs(), as src/clock.c divides
+
+/// Lets cycles of simulated time pass at the current clock speed
+void Host_Advance(unsigned long cycles);
+
+/// Simulated time since start, across speed changes
+unsigned long long Host_Cycles(void);
+unsigned long long Host_TimeNs(void);
+
+// ---- stack_host.c ----
+
+#define HOST_STACK_BYTES 0x800  // Stack_Size in startup_TM4C123.s
+
+// ---- gpio_host.c ----
+
+#define HOST_GPIO_ACCESS_CYCLES 1  // Simulated cost of one GPIO load or store
+
+/**
+ * @brief What the port model saw since GpioHost_Reset(). A "glitch" is a pin state the LCD could
+ *        latch that the driver never meant to send.
+ */
+typedef struct {
+    unsigned long reads;           // Loads from a DATA register
+    unsigned long writes;          // Stores to a DATA register
+    unsigned long strayWrites;     // Stores whose mask covers pins the drivers do not own
+    unsigned long lcdNibbles;      // Nibbles latched by EN falling
+    unsigned long dataGlitches;    // DB4-DB7 changed twice between latches, or while EN was high
+    unsigned long rsGlitches;      // RS changed while EN was high
+} GpioHostStats;
+
+/// Clears the statistics, the pin levels, the keypad and the LCD model
+void GpioHost_Reset(void);
+const GpioHostStats* GpioHost_GetStats(void);
+
+/// Pin levels of a port (e.g. GPIO_PORTA_BASE)
+unsigned long GpioHost_Pins(unsigned long base);
+
+/// Changes pins the way another bus master or an interrupt handler would (not counted in the stats)
+void GpioHost_Drive(unsigned long base, unsigned long mask, unsigned long value);
+
+/// Closes the switch at row/col of the keypad matrix for the given simulated microseconds
+void GpioHost_HoldKey(int row, int col, unsigned long microseconds);
+
+/// Called before every GPIO read returns, NULL for none. It may longjmp out of the firmware.
+typedef void (*GpioHostReadHook)(unsigned long base, unsigned long mask);
+void GpioHost_SetReadHook(GpioHostReadHook hook);
+
+/// A DDRAM row of the modelled LCD, LCD_ROW_CELLS characters, of which LCD_COLUMNS are visible
+const char* GpioHost_LcdRow(int row);
+
+/// Bytes (commands and data) the LCD has received
+unsigned long GpioHost_LcdBytes(void);
+
+// ---- uart_host.c ----
+
+/// Bytes arrive on the RX line. The DMA and interrupt handler run as they come in
+void UartHost_Receive(const char *data, int length);
+
+/// The line goes idle: bytes left in the RX FIFO raise the receive timeout
+void UartHost_Idle(void);
+
+/// Lets the TX channel send up to count bytes. Returns how many it sent
+int  UartHost_Transmit(int count);
+
+/// Copies the bytes sent so far into out as a string (up to size - 1) and forgets them. Returns the count
+int  UartHost_TakeSent(char *out, int size);
+
+/// Bytes lost to a full RX FIFO
+unsigned long UartHost_Overruns(void);
+
+/// Puts a pseudo-terminal on the line (raw mode). Returns the device name for the terminal end
+const char* UartHost_OpenPty(void);
+
+/// Moves bytes between the pseudo-terminal and the UART, idling the line if none came. Returns bytes moved
+int  UartHost_Pump(void);
+
+// ---- trace_host.c ----
+
+/// Writes traceBuffer in the target's 32-bit layout, for tools/trace2json.py. Returns 0 on success
+int  TraceHost_Dump(const char *path);
+
+#endif // HOST_H
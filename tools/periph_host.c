@@ -0,0 +1,50 @@
+/*
+Host stand-in for the TM4C123 peripherals, for building the firmware modules on a PC.
+
+Maps zeroed RAM over the peripheral (0x40000000) and private peripheral bus
+(0xE0000000) regions before main runs, so the register macros in include/
+read and write ordinary memory instead of faulting. Registers do nothing on
+their own. The status bits the drivers wait on at start-up are preset as an
+idle board shows them (peripherals ready, PLL locked, UART FIFOs empty);
+anything else a test waits on, it sets itself. A delay loop that spins on
+SysTick must be replaced (clock_host.c) or its flag preset.
+
+On a 64-bit host an unsigned long register access is 8 bytes wide, so it also
+touches the next register up. None of the modules rely on neighbouring
+registers keeping their values, so this only matters to a test that reads one
+back after writing the one below it.
+*/
+
+#define _GNU_SOURCE
+#include "clock.h"
+#include "console.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+typedef struct {
+    unsigned long base;
+    unsigned long size;
+} PeriphRegion;
+
+static const PeriphRegion regions[] = {
+    {0x40000000UL, 0x00100000UL},  // GPIO, UART, system control, uDMA
+    {0xE0000000UL, 0x00100000UL}   // DWT, SysTick, NVIC
+};
+
+__attribute__((constructor)) static void mapPeripherals(void)
+{
+    for(unsigned i=0; i<sizeof(regions)/sizeof(regions[0]); i++){
+        void *want= (void *)regions[i].base;
+        void *got= mmap(want, regions[i].size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if(got != want){
+            fprintf(stderr, "periph_host: cannot map %#lx\n", regions[i].base);
+            exit(2);
+        }
+    }
+
+    SYSCTL_PRUART_R = 0x01;                // UART0 ready
+    SYSCTL_RIS_R = SYSCTL_RIS_PLLLRIS;     // PLL locked
+    UART0_FR_R = UART_FR_RXFE | 0x80;      // RX and TX FIFOs empty
+}
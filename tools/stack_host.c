@@ -0,0 +1,26 @@
+/*
+Host stand-in for the STACK area of startup_TM4C123.s, for linking src/stack.c on a PC.
+
+Defines Stack_Mem and Stack_Top around HOST_STACK_BYTES and paints it with
+STACK_PAINT before main, as Reset_Handler does. The host program does not run
+on it, so Stack_Check() passes and the peaks stay 0, unless a test switches
+onto it (e.g. with makecontext) to measure real frames.
+*/
+
+#include "stack.h"
+#include "host.h"
+
+unsigned long Stack_Mem[HOST_STACK_BYTES / sizeof(unsigned long)] __attribute__((aligned(16)));
+
+// Stack_Top is the first address past Stack_Mem, as an array symbol like the startup file's
+#define STACK_STR(x) #x
+#define STACK_XSTR(x) STACK_STR(x)
+__asm__(".globl Stack_Top\n"
+        ".set Stack_Top, Stack_Mem + " STACK_XSTR(HOST_STACK_BYTES));
+
+__attribute__((constructor)) static void paint(void)
+{
+    for(unsigned i=0; i<sizeof(Stack_Mem)/sizeof(Stack_Mem[0]); i++){
+        Stack_Mem[i]= STACK_PAINT;
+    }
+}
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Static worst-case stack estimate from the armlink call graph (see include/stack.h).
+
+The project links with --callgraph, so every build writes Objects/ELEC3662-Calculator.htm
+with each function's own frame and its deepest call chain. Run
+
+    python3 tools/stack_report.py src/Objects/ELEC3662-Calculator.htm
+
+to print the deepest functions, the worst thread-mode chain and the worst interrupt handler,
+and to check thread + interrupt (plus the exception frame the core pushes) against the stack
+reserved in startup_TM4C123.s less the guard band. Interrupts are assumed not to nest.
+The exit status is 1 if the estimate does not fit, so it can run as a post-build step.
+
+Recursion and calls through function pointers are not in the call graph; armlink marks such
+chains "+ Unknown" and so does this report.
+"""
+
+import html
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+STARTUP = os.path.join(ROOT, "src", "RTE", "Device", "TM4C123GH6PM", "startup_TM4C123.s")
+STACK_H = os.path.join(ROOT, "include", "stack.h")
+
+# Cortex-M4F exception entry: 8 words, or 26 with the lazily stacked FPU context
+EXCEPTION_FRAME = 104
+
+FUNCTION = re.compile(
+    r'<STRONG><a name="\[[0-9a-f]+\]"></a>([^<]+)</STRONG>\s*'
+    r'\((?:Thumb|ARM), \d+ bytes, Stack size (\d+) bytes, ([^)]*)\)')
+MAX_DEPTH = re.compile(r"Max Depth = (\d+)( \+ Unknown[^<]*)?")
+CALL_CHAIN = re.compile(r"Call Chain = ([^<]*)")
+
+
+def read_define(path, pattern):
+    with open(path) as f:
+        match = re.search(pattern, f.read(), re.MULTILINE)
+    if not match:
+        sys.exit("%s: %s not found" % (path, pattern))
+    return int(match.group(1), 0)
+
+
+def parse_callgraph(path):
+    """Returns {name: (own frame, max depth, unknown, call chain)}"""
+    with open(path, encoding="latin-1") as f:
+        text = f.read()
+
+    functions = {}
+    matches = list(FUNCTION.finditer(text))
+    for i, match in enumerate(matches):
+        name = html.unescape(match.group(1))
+        frame = int(match.group(2))
+        end = matches[i + 1].start() if i + 1 < len(matches) else len(text)
+        body = text[match.end():end]
+
+        depth = MAX_DEPTH.search(body)
+        chain = CALL_CHAIN.search(body)
+        functions[name] = (
+            frame,
+            int(depth.group(1)) if depth else frame,
+            bool(depth and depth.group(2)),
+            html.unescape(chain.group(1)).replace("\u21d2", "=>").strip() if chain else name,
+        )
+    if not functions:
+        sys.exit("%s: no functions found, is it an armlink --callgraph file?" % path)
+    return functions
+
+
+def worst(functions, predicate):
+    candidates = [(info[1], name) for name, info in functions.items() if predicate(name)]
+    return max(candidates) if candidates else (0, None)
+
+
+def describe(functions, name):
+    frame, depth, unknown, chain = functions[name]
+    return "%5d%s  %s" % (depth, "+?" if unknown else "  ", chain)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: stack_report.py <image>.htm")
+
+    functions = parse_callgraph(sys.argv[1])
+    reserved = read_define(STARTUP, r"^Stack_Size\s+EQU\s+(\S+)")
+    guard = read_define(STACK_H, r"^#define STACK_GUARD_BYTES\s+(\d+)")
+
+    def is_handler(name):
+        return name.endswith("_Handler")
+
+    print("Deepest functions (bytes, +? where armlink could not follow every call):")
+    ranked = sorted(functions, key=lambda name: functions[name][1], reverse=True)
+    for name in ranked[:10]:
+        print("  " + describe(functions, name))
+
+    thread, threadName = worst(functions, lambda name: not is_handler(name))
+    handler, handlerName = worst(functions, is_handler)
+    interrupt = handler + EXCEPTION_FRAME if handlerName else 0
+    total = thread + interrupt
+    usable = reserved - guard
+
+    print()
+    print("Thread:     " + describe(functions, threadName))
+    if handlerName:
+        print("Interrupt:  " + describe(functions, handlerName) + " (+%d frame)" % EXCEPTION_FRAME)
+    unknown = any(info[2] for info in functions.values())
+    print("Worst case: %d bytes%s of %d usable (%d reserved, %d guard)"
+          % (total, " + unknown" if unknown else "", usable, reserved, guard))
+
+    if total > usable:
+        print("Stack_Size in startup_TM4C123.s is too small")
+        return 1
+    print("Margin:     %d bytes" % (usable - total))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
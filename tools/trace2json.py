@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""Converts a traceBuffer dump (see include/trace.h) into Chrome trace / Perfetto JSON.
+
+Dump the buffer from the uVision command window while halted, e.g.
+
+    SAVE trace.hex &traceBuffer, (unsigned long)&traceBuffer + sizeof(traceBuffer) - 1
+
+then run
+
+    python3 tools/trace2json.py trace.hex trace.json
+
+and open trace.json in chrome://tracing or ui.perfetto.dev. Raw binary dumps
+(little-endian, starting at traceBuffer) are accepted as well as Intel HEX, so
+the dump of a host simulation (tools/trace_host.c, e.g. tests/test_trace.c)
+converts the same way.
+"""
+
+import json
+import struct
+import sys
+
+TRACE_MAGIC = 0x31435254
+
+# Same order as TraceEvent in include/trace.h
+EVENTS = [
+    "CLOCK",
+    "KEY_PRESSED",
+    "KEY_DEBOUNCED",
+    "ADDCHAR",
+    "TOKENISE_BEGIN",
+    "TOKENISE_END",
+    "EVALUATE_BEGIN",
+    "EVALUATE_END",
+    "LCD_COMMAND",
+    "LCD_DATA",
+    "DELAY_BEGIN",
+    "DELAY_END",
+]
+
+# Begin/end pairs become duration slices, everything else an instant event
+SLICES = {
+    "TOKENISE_BEGIN": ("B", "tokenise"),
+    "TOKENISE_END": ("E", "tokenise"),
+    "EVALUATE_BEGIN": ("B", "evaluate"),
+    "EVALUATE_END": ("E", "evaluate"),
+    "DELAY_BEGIN": ("B", "delay"),
+    "DELAY_END": ("E", "delay"),
+}
+
+# One track per subsystem
+TRACKS = {
+    "KEY_PRESSED": 1, "KEY_DEBOUNCED": 1,
+    "ADDCHAR": 2, "TOKENISE_BEGIN": 2, "TOKENISE_END": 2, "EVALUATE_BEGIN": 2, "EVALUATE_END": 2,
+    "LCD_COMMAND": 3, "LCD_DATA": 3,
+    "DELAY_BEGIN": 4, "DELAY_END": 4,
+    "CLOCK": 5,
+}
+TRACK_NAMES = {1: "keypad", 2: "calc", 3: "lcd", 4: "delay", 5: "clock"}
+
+
+def read_dump(path):
+    """Returns the dump as bytes, decoding Intel HEX if the file looks like it."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(b":"):
+        return data
+
+    image = {}
+    base = 0
+    for line in data.decode("ascii").splitlines():
+        line = line.strip()
+        if not line.startswith(":"):
+            continue
+        record = bytes.fromhex(line[1:])
+        count, address, kind = record[0], (record[1] << 8) | record[2], record[3]
+        payload = record[4:4 + count]
+        if kind == 0x00:
+            for i, b in enumerate(payload):
+                image[base + address + i] = b
+        elif kind == 0x02:
+            base = ((payload[0] << 8) | payload[1]) << 4
+        elif kind == 0x04:
+            base = ((payload[0] << 8) | payload[1]) << 16
+        elif kind == 0x01:
+            break
+    if not image:
+        return b""
+    start = min(image)
+    return bytes(image.get(a, 0) for a in range(start, max(image) + 1))
+
+
+def decode(data):
+    """Returns (cycles, event name, argument) in recording order, oldest first."""
+    magic, capacity, head = struct.unpack_from("<III", data, 0)
+    if magic != TRACE_MAGIC:
+        raise ValueError("not a traceBuffer dump (magic 0x%08x)" % magic)
+
+    count = min(head, capacity)
+    records = []
+    for n in range(head - count, head):
+        cycles, word = struct.unpack_from("<II", data, 12 + 8 * (n % capacity))
+        event = word >> 24
+        name = EVENTS[event] if event < len(EVENTS) else "EVENT_%d" % event
+        records.append((cycles, name, word & 0xFFFFFF))
+    return records
+
+
+def to_chrome(records, start_mhz):
+    """Unwraps CYCCNT and converts to microseconds, following clock changes."""
+    events = [{"ph": "M", "pid": 1, "tid": tid, "name": "thread_name", "args": {"name": name}}
+              for tid, name in TRACK_NAMES.items()]
+
+    mhz = start_mhz
+    us = 0.0
+    previous = records[0][0] if records else 0
+    for cycles, name, arg in records:
+        us += ((cycles - previous) & 0xFFFFFFFF) / mhz
+        previous = cycles
+
+        event = {"pid": 1, "tid": TRACKS.get(name, 0), "ts": round(us, 3)}
+        if name == "CLOCK":
+            mhz = arg or mhz
+            event.update(ph="C", name="clock MHz", args={"MHz": mhz})
+        elif name in SLICES:
+            phase, slice_name = SLICES[name]
+            event.update(ph=phase, name=slice_name)
+            if phase == "B" and name == "DELAY_BEGIN":
+                event["args"] = {"us": arg}
+            if phase == "E" and name == "EVALUATE_END":
+                event["args"] = {"error": bool(arg)}
+        else:
+            label = name.lower()
+            if name in ("KEY_DEBOUNCED", "ADDCHAR", "LCD_DATA") and 0x20 <= arg < 0x7F:
+                label += " '%c'" % arg
+            elif name == "LCD_COMMAND":
+                label += " 0x%02x" % arg
+            elif name == "KEY_PRESSED":
+                label += " r%d c%d" % (arg >> 4, arg & 0xF)
+            event.update(ph="i", s="t", name=label)
+        events.append(event)
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+
+def main(argv):
+    if len(argv) < 2:
+        print("usage: trace2json.py DUMP [OUT.json] [--mhz N]", file=sys.stderr)
+        return 2
+
+    args = [a for a in argv[1:] if not a.startswith("--")]
+    mhz = 16
+    if "--mhz" in argv:
+        mhz = int(argv[argv.index("--mhz") + 1])
+        args.remove(str(mhz))
+
+    records = decode(read_dump(args[0]))
+    trace = to_chrome(records, mhz)
+    out = json.dumps(trace, indent=1)
+    if len(args) > 1:
+        with open(args[1], "w") as f:
+            f.write(out)
+    else:
+        print(out)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
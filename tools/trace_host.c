@@ -0,0 +1,39 @@
+/*
+Writes the host simulation's traceBuffer (src/trace.c, built with CALC_TRACE)
+as the target's debugger would save it, so tools/trace2json.py reads both.
+
+The dump is the target layout: 32-bit little-endian words for magic, capacity,
+head and each record. On the host an unsigned long is 64 bits, so the buffer
+in memory cannot be written as it is. CYCCNT keeps its low 32 bits, as the
+target's counter would wrap.
+*/
+
+#include "trace.h"
+#include "host.h"
+#include <stdio.h>
+
+static void putWord(FILE *f, unsigned long value)
+{
+    unsigned char bytes[4] = {
+        (unsigned char)value, (unsigned char)(value >> 8),
+        (unsigned char)(value >> 16), (unsigned char)(value >> 24)
+    };
+    fwrite(bytes, 1, sizeof(bytes), f);
+}
+
+int TraceHost_Dump(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+
+    if(f == NULL){
+        return -1;
+    }
+    putWord(f, traceBuffer.magic);
+    putWord(f, traceBuffer.capacity);
+    putWord(f, traceBuffer.head);
+    for(unsigned i=0; i<TRACE_RECORDS; i++){
+        putWord(f, traceBuffer.records[i].cycles);
+        putWord(f, traceBuffer.records[i].word);
+    }
+    return fclose(f);
+}
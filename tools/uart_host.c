@@ -0,0 +1,267 @@
+/*
+Host stand-in for UART0 and its two uDMA channels, for running console.c on a PC.
+
+Build console.c with UART_MOCK so its RX FIFO reads and TX-busy polls call in
+here. Everything else console.c does through the registers (periph_host.c
+memory) and its uDMA control table, which this model reads and updates the
+way the controller does:
+
+- UartHost_Receive() puts bytes on the line. They enter the 16-byte RX FIFO.
+  Whenever it holds a burst (8, the trigger level Console_Init sets) and
+  channel 8 is enabled, the burst moves into the block of the current
+  ping-pong structure. A finished block stops its structure, sets the
+  channel's completion in UDMA_CHIS_R and calls UART0_Handler, and the DMA
+  goes on with the other structure. A byte that finds the FIFO full is lost
+  (overrun).
+- UartHost_Idle() lets the line go quiet. If the FIFO still holds bytes, the
+  receive timeout interrupt fires, as after 32 idle bit times. An empty FIFO
+  raises nothing.
+- Channel 9 sends one byte per UartHost_Transmit() step. A TX-busy poll from
+  console.c also sends one byte, as time passes while it waits. The bytes
+  sent collect for UartHost_TakeSent(), or go to the pseudo-terminal.
+- Write-1-to-set/clear registers cannot be plain memory. The model keeps the
+  channel enables and writes them back to UDMA_ENASET_R. It clears
+  UDMA_CHIS_R and UART0_MIS_R once the handler returns.
+- UartHost_OpenPty() puts a pseudo-terminal on the line, so a terminal
+  program (or a benchmark) can talk to the console through its slave end.
+  UartHost_Pump() then moves bytes both ways, at most a FIFO's worth in per call,
+  so a caller that polls the console between pumps keeps up as the main loop does.
+*/
+
+#define _GNU_SOURCE
+#include "console.h"
+#include "host.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define FIFO_SIZE   16
+#define RX_BURST    8        // UART0_IFLS_R RX trigger at 1/2
+#define RX_BIT      (1UL << UDMA_CHAN_UART0RX)
+#define TX_BIT      (1UL << UDMA_CHAN_UART0TX)
+#define ALT_OFFSET  32
+#define SENT_SIZE   4096
+
+#define MODE_MASK   0x7UL
+#define XFER_SHIFT  4
+#define XFER_MASK   (0x3FFUL << XFER_SHIFT)
+
+/// uDMA channel control structure, the layout the controller reads (as in console.c)
+typedef struct {
+    volatile const void *srcEnd;
+    volatile void       *dstEnd;
+    volatile unsigned long control;
+    unsigned long        unused;
+} DmaControl;
+
+void UART0_Handler(void);
+
+static char          fifo[FIFO_SIZE];
+static int           fifoHead;
+static int           fifoCount;
+static unsigned long enabled;          // Channel enables, as UDMA_ENASET_R reads back
+static int           rxAlternate;      // Structure the RX channel fills next
+static unsigned long overruns;
+
+static char          sent[SENT_SIZE];
+static int           sentCount;
+static int           ptyMaster = -1;
+
+static DmaControl* channel(int number)
+{
+    return &((DmaControl *)UDMA_CTLBASE_R)[number];
+}
+
+/**
+ * @brief Takes up enables console.c has set since the last look, and shows the result
+ */
+static void syncEnables(void)
+{
+    enabled |= UDMA_ENASET_R & (RX_BIT | TX_BIT);
+    UDMA_ENASET_R = enabled;
+}
+
+/**
+ * @brief Enters the interrupt handler with the given status, then clears it
+ */
+static void interrupt(unsigned long channels, unsigned long uartStatus)
+{
+    UDMA_CHIS_R = channels;
+    UART0_MIS_R = uartStatus;
+    UART0_Handler();
+    UDMA_CHIS_R = 0;
+    UART0_MIS_R = 0;
+    syncEnables();
+}
+
+/**
+ * @brief Counts one transfer of n items done in a control word. Returns true when the structure finished
+ */
+static int transferDone(DmaControl *d, int n)
+{
+    int remaining = (int)((d->control & XFER_MASK) >> XFER_SHIFT) + 1 - n;
+
+    if(remaining == 0) {
+        d->control &= ~(XFER_MASK | MODE_MASK);  // Stopped
+        return 1;
+    }
+    d->control = (d->control & ~XFER_MASK) | ((unsigned long)(remaining - 1) << XFER_SHIFT);
+    return 0;
+}
+
+/**
+ * @brief Moves bursts from the FIFO into the RX blocks while the channel is enabled
+ */
+static void serviceRx(void)
+{
+    syncEnables();
+    while((enabled & RX_BIT) && fifoCount >= RX_BURST) {
+        DmaControl *d = channel(UDMA_CHAN_UART0RX + (rxAlternate ? ALT_OFFSET : 0));
+        if((d->control & MODE_MASK) == 0) {
+            enabled &= ~RX_BIT;  // Ping-pong ran into a stopped structure: the channel ends
+            UDMA_ENASET_R = enabled;
+            return;
+        }
+
+        int   remaining = (int)((d->control & XFER_MASK) >> XFER_SHIFT) + 1;
+        int   n = (remaining < RX_BURST) ? remaining : RX_BURST;
+        char *dst = (char *)d->dstEnd - remaining + 1;
+        for(int i = 0; i < n; i++) {
+            dst[i] = UartHost_RxRead();
+        }
+        if(transferDone(d, n)) {
+            rxAlternate ^= 1;
+            interrupt(RX_BIT, 0);
+        }
+    }
+}
+
+void UartHost_Receive(const char *data, int length)
+{
+    for(int i = 0; i < length; i++) {
+        if(fifoCount == FIFO_SIZE) {
+            overruns++;
+            continue;
+        }
+        fifo[(fifoHead + fifoCount) % FIFO_SIZE] = data[i];
+        fifoCount++;
+        serviceRx();
+    }
+}
+
+void UartHost_Idle(void)
+{
+    serviceRx();
+    if(fifoCount > 0) {
+        interrupt(0, UART_IM_RTIM);
+    }
+}
+
+int UartHost_Transmit(int count)
+{
+    int done = 0;
+
+    syncEnables();
+    while(done < count && (enabled & TX_BIT)) {
+        DmaControl *d = channel(UDMA_CHAN_UART0TX);
+        int remaining = (int)((d->control & XFER_MASK) >> XFER_SHIFT) + 1;
+        char c = ((const char *)d->srcEnd)[1 - remaining];
+
+        if(sentCount < SENT_SIZE) {
+            sent[sentCount++] = c;
+        }
+        done++;
+        if(transferDone(d, 1)) {
+            enabled &= ~TX_BIT;
+            UDMA_ENASET_R = enabled;
+            interrupt(TX_BIT, 0);
+        }
+    }
+    return done;
+}
+
+int UartHost_TakeSent(char *out, int size)
+{
+    int n = (sentCount < size - 1) ? sentCount : size - 1;
+
+    memcpy(out, sent, (size_t)n);
+    out[n] = '\0';
+    memmove(sent, sent + n, (size_t)(sentCount - n));
+    sentCount -= n;
+    return n;
+}
+
+unsigned long UartHost_Overruns(void)
+{
+    return overruns;
+}
+
+int UartHost_RxEmpty(void)
+{
+    return fifoCount == 0;
+}
+
+char UartHost_RxRead(void)
+{
+    char c = fifo[fifoHead];
+
+    if(fifoCount > 0) {
+        fifoHead = (fifoHead + 1) % FIFO_SIZE;
+        fifoCount--;
+    }
+    return c;
+}
+
+int UartHost_TxBusy(void)
+{
+    UartHost_Transmit(1);
+    return (enabled & TX_BIT) != 0;
+}
+
+const char* UartHost_OpenPty(void)
+{
+    struct termios raw;
+
+    ptyMaster = posix_openpt(O_RDWR | O_NOCTTY);
+    if(ptyMaster < 0 || grantpt(ptyMaster) != 0 || unlockpt(ptyMaster) != 0) {
+        perror("uart_host: pty");
+        exit(2);
+    }
+    fcntl(ptyMaster, F_SETFL, fcntl(ptyMaster, F_GETFL) | O_NONBLOCK);
+
+    // Bytes pass unchanged, as on the wire
+    tcgetattr(ptyMaster, &raw);
+    cfmakeraw(&raw);
+    tcsetattr(ptyMaster, TCSANOW, &raw);
+    return ptsname(ptyMaster);
+}
+
+int UartHost_Pump(void)
+{
+    char    data[FIFO_SIZE];
+    int     moved = 0;
+    ssize_t n;
+
+    // At most what the FIFO has room for per call, the rest waits in the pty like on the wire
+    n = read(ptyMaster, data, (size_t)(FIFO_SIZE - fifoCount));
+    if(n > 0) {
+        UartHost_Receive(data, (int)n);
+        moved += (int)n;
+    }
+    if(moved == 0) {
+        UartHost_Idle();
+    }
+
+    moved += UartHost_Transmit(SENT_SIZE);
+    if(sentCount > 0) {
+        n = write(ptyMaster, sent, (size_t)sentCount);
+        if(n > 0) {
+            memmove(sent, sent + n, (size_t)(sentCount - n));
+            sentCount -= (int)n;
+        }
+    }
+    return moved;
+}